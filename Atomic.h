@@ -0,0 +1,124 @@
+/**
+ * @file Atomic.h
+ *
+ * @brief Atomic operations on 32-bit words shared by the main loop and the interrupt handlers.
+ *
+ * A plain read-modify-write such as "count = count + 1" is a load, an add and a store.
+ * An interrupt handler that updates the same word between the load and the store loses
+ * its update. The functions below make the read-modify-write with the exclusive
+ * instructions of the Cortex-M4:
+ *
+ *     do
+ *     {
+ *         old = __LDREXW(address);               // load and mark the address
+ *     } while (__STREXW(old + 1, address));      // store only if it is still marked
+ *
+ * The core clears the mark on every exception entry and return, so STREXW fails when an
+ * interrupt was taken since LDREXW and the loop retries with the new value. Unlike a
+ * __disable_irq section, the interrupts are never held off.
+ *
+ * Atomic_Load and Atomic_Store add a DMB barrier, which orders the accesses to the other
+ * shared data around them: the data written before an Atomic_Store is visible before the
+ * word is, and the data read after an Atomic_Load is read after it.
+ *
+ * @note Single loads and stores of an aligned word are atomic on the Cortex-M4, the
+ * barriers are what the compiler would otherwise be free to reorder.
+ */
+
+// The header defines inline functions, so it is guarded against a second inclusion
+#ifndef ATOMIC_H
+#define ATOMIC_H
+
+#include "TM4C123GH6PM.h"
+
+/**
+ * @brief Reads a shared word, the accesses after it are made after it.
+ */
+__STATIC_INLINE uint32_t Atomic_Load(volatile uint32_t *address)
+{
+	uint32_t value = *address;
+	__DMB();
+	return value;
+}
+
+/**
+ * @brief Writes a shared word, the accesses before it are made before it.
+ */
+__STATIC_INLINE void Atomic_Store(volatile uint32_t *address, uint32_t value)
+{
+	__DMB();
+	*address = value;
+}
+
+/**
+ * @brief Adds a value to a shared word and returns the previous value.
+ */
+__STATIC_INLINE uint32_t Atomic_Fetch_Add(volatile uint32_t *address, uint32_t value)
+{
+	uint32_t previous;
+	do
+	{
+		previous = __LDREXW(address);
+	} while (__STREXW(previous + value, address));
+	return previous;
+}
+
+/**
+ * @brief Sets the bits of mask in a shared word and returns the previous value.
+ */
+__STATIC_INLINE uint32_t Atomic_Fetch_Or(volatile uint32_t *address, uint32_t mask)
+{
+	uint32_t previous;
+	do
+	{
+		previous = __LDREXW(address);
+	} while (__STREXW(previous | mask, address));
+	return previous;
+}
+
+/**
+ * @brief Clears the bits of mask in a shared word and returns the previous value.
+ */
+__STATIC_INLINE uint32_t Atomic_Fetch_And_Not(volatile uint32_t *address, uint32_t mask)
+{
+	uint32_t previous;
+	do
+	{
+		previous = __LDREXW(address);
+	} while (__STREXW(previous & ~mask, address));
+	return previous;
+}
+
+/**
+ * @brief Writes a shared word and returns the previous value.
+ */
+__STATIC_INLINE uint32_t Atomic_Exchange(volatile uint32_t *address, uint32_t value)
+{
+	uint32_t previous;
+	do
+	{
+		previous = __LDREXW(address);
+	} while (__STREXW(value, address));
+	return previous;
+}
+
+/**
+ * @brief Writes desired to a shared word if it still holds expected.
+ *
+ * @return Returns 1 if the word was written. Otherwise, returns 0.
+ */
+__STATIC_INLINE int Atomic_Compare_Exchange(volatile uint32_t *address, uint32_t expected, uint32_t desired)
+{
+	do
+	{
+		if (__LDREXW(address) != expected)
+		{
+			// Drop the mark, no store follows
+			__CLREX();
+			return 0;
+		}
+	} while (__STREXW(desired, address));
+	return 1;
+}
+
+#endif
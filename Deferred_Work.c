@@ -0,0 +1,126 @@
+/**
+ * @file Deferred_Work.c
+ *
+ * @brief Source code for the Deferred_Work module.
+ *
+ * The latency is measured with the DWT cycle counter, started by Latency_Benchmark_Init.
+ * The time of a post is only kept when no item was pending yet, so the latency is the
+ * one of the oldest item.
+ */
+
+#include "Deferred_Work.h"
+#include "Interrupt_Priorities.h"
+#include "Atomic.h"
+#include "Number_Format.h"
+
+#define DEFERRED_WORK_LINE_SIZE    96
+
+static void (*Deferred_Work_Functions[DEFERRED_WORK_COUNT])(void);
+
+// One bit per posted work item, set by the handlers and cleared by PendSV_Handler
+static volatile uint32_t Deferred_Work_Pending;
+
+// Cycle count of the first post since PendSV_Handler last ran
+static volatile uint32_t Deferred_Work_Posted_Cycles;
+
+// Only written by PendSV_Handler
+static Deferred_Work_Counters Deferred_Work_Stats;
+
+void Deferred_Work_Init(void)
+{
+	NVIC_SetPriority(PendSV_IRQn, INTERRUPT_PRIORITY_DEFERRED_WORK);
+
+	Deferred_Work_Reset();
+}
+
+void Deferred_Work_Register(Deferred_Work_ID id, void (*work)(void))
+{
+	Deferred_Work_Functions[id] = work;
+}
+
+void Deferred_Work_Post(Deferred_Work_ID id)
+{
+	uint32_t now = DWT->CYCCNT;
+
+	if (Atomic_Fetch_Or(&Deferred_Work_Pending, 1UL << id) == 0)
+	{
+		Deferred_Work_Posted_Cycles = now;
+	}
+
+	// PendSV runs once no handler of a higher priority is active
+	SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+}
+
+void Deferred_Work_Get(Deferred_Work_Counters *counters)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	*counters = Deferred_Work_Stats;
+
+	__set_PRIMASK(primask);
+}
+
+void Deferred_Work_Reset(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	Deferred_Work_Stats = (Deferred_Work_Counters){ 0 };
+
+	__set_PRIMASK(primask);
+}
+
+void Deferred_Work_Report(void)
+{
+	Deferred_Work_Counters counters;
+	char line[DEFERRED_WORK_LINE_SIZE];
+	char *limit = line + sizeof(line);
+	char *end = line;
+
+	Deferred_Work_Get(&counters);
+
+	end = Format_Append_Field(end, limit, "DEFER runs ", counters.runs);
+	end = Format_Append_Field(end, limit, " latency max ", counters.latency_max_cycles);
+	end = Format_Append_Field(end, limit, " run max ", counters.run_max_cycles);
+
+	Format_Report_Line(line);
+}
+
+void PendSV_Handler(void)
+{
+	uint32_t start = DWT->CYCCNT;
+
+	// Take the items posted so far, those posted from now on pend PendSV again
+	uint32_t pending = Atomic_Exchange(&Deferred_Work_Pending, 0);
+
+	// A post that was preempted between its OR and pending PendSV leaves nothing to run
+	if (pending == 0)
+	{
+		return;
+	}
+
+	uint32_t latency = start - Deferred_Work_Posted_Cycles;
+
+	for (uint32_t id = 0; pending != 0; id++, pending >>= 1)
+	{
+		if ((pending & 1) && Deferred_Work_Functions[id])
+		{
+			Deferred_Work_Functions[id]();
+		}
+	}
+
+	uint32_t run = DWT->CYCCNT - start;
+
+	Deferred_Work_Stats.runs++;
+
+	if (latency > Deferred_Work_Stats.latency_max_cycles)
+	{
+		Deferred_Work_Stats.latency_max_cycles = latency;
+	}
+
+	if (run > Deferred_Work_Stats.run_max_cycles)
+	{
+		Deferred_Work_Stats.run_max_cycles = run;
+	}
+}
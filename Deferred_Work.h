@@ -0,0 +1,114 @@
+/**
+ * @file Deferred_Work.h
+ *
+ * @brief Header file for the Deferred_Work module.
+ *
+ * This module splits the interrupt handling in two levels. A hard interrupt handler
+ * makes the register writes that cannot wait and posts the rest of its work, which runs
+ * in PendSV_Handler at the lowest priority (see Interrupt_Priorities.h):
+ *
+ *     void TIMER0A_Handler(void)                  // priority 1
+ *     {
+ *         ...output the half step...
+ *         Deferred_Work_Post(DEFERRED_WORK_STEPPER_MOTOR);
+ *     }
+ *
+ *     // Later, once no other handler is active: Stepper_Motor_Deferred()
+ *
+ * The deferred work still runs before the main loop, but every other interrupt can
+ * preempt it, so it no longer delays them.
+ *
+ * Each work item is a bit of a pending mask. Posting it sets its bit with an atomic OR
+ * and pends PendSV, so any handler can post at any time without disabling interrupts.
+ * An item posted again before it ran runs once: the work must pick up everything that
+ * was handed to it, for example by draining a queue.
+ *
+ * The module measures the latency from the first post to the start of PendSV_Handler,
+ * and the longest run. The BLE command "DEFER" sends them to the phone and to UART0,
+ * and "DEFER RESET" clears them:
+ *
+ *     DEFER runs <n> latency max <cycles> run max <cycles>
+ */
+
+#include "TM4C123GH6PM.h"
+
+typedef enum
+{
+	DEFERRED_WORK_STEPPER_MOTOR,    // step accounting and status of the stepper motor
+	DEFERRED_WORK_COUNT
+} Deferred_Work_ID;
+
+typedef struct
+{
+	uint32_t runs;
+	uint32_t latency_max_cycles;
+	uint32_t run_max_cycles;
+} Deferred_Work_Counters;
+
+/**
+ * @brief Sets PendSV to the lowest priority and clears the counters.
+ *
+ * Must be called before a work item is posted.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Deferred_Work_Init(void);
+
+/**
+ * @brief Sets the function that runs a work item.
+ *
+ * @param id The work item.
+ * @param work The function called from PendSV_Handler when the item has been posted.
+ *
+ * @return None
+ */
+void Deferred_Work_Register(Deferred_Work_ID id, void (*work)(void));
+
+/**
+ * @brief Marks a work item to run in PendSV_Handler.
+ *
+ * It can be called from any interrupt handler and from the main loop.
+ *
+ * @param id The work item.
+ *
+ * @return None
+ */
+void Deferred_Work_Post(Deferred_Work_ID id);
+
+/**
+ * @brief Copies the counters.
+ *
+ * @param counters Pointer to the structure that receives the counters.
+ *
+ * @return None
+ */
+void Deferred_Work_Get(Deferred_Work_Counters *counters);
+
+/**
+ * @brief Clears the counters.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Deferred_Work_Reset(void);
+
+/**
+ * @brief Sends the DEFER line to UART0 and to the phone.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Deferred_Work_Report(void);
+
+/**
+ * @brief The handler of PendSV, runs the posted work items in the order of their ID.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void PendSV_Handler(void);
@@ -0,0 +1,92 @@
+/**
+ * @file EEPROM.c
+ *
+ * @brief Source code for the EEPROM driver.
+ *
+ * The initialization follows the EEPROM initialization sequence of the TM4C123GH6PM
+ * datasheet: the EEPROM finishes any write that a power loss interrupted before it
+ * reports ready, and the peripheral is reset once that recovery has succeeded.
+ */
+
+#include "EEPROM.h"
+
+#define EEDONE_WORKING        0x01
+#define EEDONE_NOPERM         0x10
+
+#define EESUPP_ERETRY         0x04
+#define EESUPP_PRETRY         0x08
+
+/**
+ * @brief Waits until the EEPROM has finished its current operation.
+ */
+static void EEPROM_Wait(void)
+{
+	while ((EEPROM->EEDONE & EEDONE_WORKING) != 0);
+}
+
+/**
+ * @brief Returns 1 if the recovery of an interrupted write has failed.
+ */
+static uint8_t EEPROM_Recovery_Failed(void)
+{
+	return (EEPROM->EESUPP & (EESUPP_ERETRY | EESUPP_PRETRY)) != 0;
+}
+
+uint8_t EEPROM_Init(void)
+{
+	// Enable the clock to the EEPROM by setting the R0 bit (Bit 0) in the RCGCEEPROM register
+	SYSCTL->RCGCEEPROM |= 0x01;
+
+	// EEDONE is only valid once the EEPROM has been clocked for 6 cycles
+	while ((SYSCTL->PREEPROM & 0x01) == 0);
+	EEPROM_Wait();
+
+	if (EEPROM_Recovery_Failed())
+	{
+		return 0;
+	}
+
+	// Reset the EEPROM so the recovery takes effect
+	SYSCTL->SREEPROM |= 0x01;
+	SYSCTL->SREEPROM &= ~0x01;
+	while ((SYSCTL->PREEPROM & 0x01) == 0);
+	EEPROM_Wait();
+
+	return !EEPROM_Recovery_Failed();
+}
+
+uint32_t EEPROM_Read(uint32_t address)
+{
+	EEPROM->EEBLOCK = address / EEPROM_BLOCK_WORDS;
+	EEPROM->EEOFFSET = address % EEPROM_BLOCK_WORDS;
+
+	return EEPROM->EERDWR;
+}
+
+void EEPROM_Read_Words(uint32_t address, uint32_t *words, uint32_t count)
+{
+	while (count > 0)
+	{
+		EEPROM->EEBLOCK = address / EEPROM_BLOCK_WORDS;
+		EEPROM->EEOFFSET = address % EEPROM_BLOCK_WORDS;
+
+		// EERDWRINC moves to the next offset, but not to the next block
+		do
+		{
+			*words++ = EEPROM->EERDWRINC;
+			address++;
+			count--;
+		} while (count > 0 && (address % EEPROM_BLOCK_WORDS) != 0);
+	}
+}
+
+uint8_t EEPROM_Write(uint32_t address, uint32_t value)
+{
+	EEPROM->EEBLOCK = address / EEPROM_BLOCK_WORDS;
+	EEPROM->EEOFFSET = address % EEPROM_BLOCK_WORDS;
+	EEPROM->EERDWR = value;
+
+	EEPROM_Wait();
+
+	return (EEPROM->EEDONE & EEDONE_NOPERM) == 0;
+}
@@ -0,0 +1,62 @@
+/**
+ * @file EEPROM.h
+ *
+ * @brief Header file for the EEPROM driver.
+ *
+ * The TM4C123GH6PM has 2 KB of EEPROM: 32 blocks of 16 words. This driver addresses
+ * it as EEPROM_WORDS 32-bit words, word n being offset n % 16 of block n / 16. A read
+ * returns at once; a write keeps the EEPROM busy for a while, and EEPROM_Write waits
+ * until it has been programmed. An erased word reads EEPROM_ERASED.
+ *
+ * @note For more information regarding the EEPROM, refer to the Internal Memory section
+ * of the TM4C123GH6PM Microcontroller Datasheet.
+ * Link: https://www.ti.com/lit/gpn/TM4C123GH6PM
+ */
+
+#include "TM4C123GH6PM.h"
+
+#define EEPROM_WORDS                512
+#define EEPROM_BLOCK_WORDS          16
+
+#define EEPROM_ERASED               0xFFFFFFFF
+
+/**
+ * @brief Enables the clock of the EEPROM and waits until it has finished its power-up
+ * sequence.
+ *
+ * @param None
+ *
+ * @return Returns 1 when the EEPROM is ready. Returns 0 when it could not recover from
+ * a write that was interrupted by a power loss, and the EEPROM must not be used.
+ */
+uint8_t EEPROM_Init(void);
+
+/**
+ * @brief Reads a word.
+ *
+ * @param address The word address, from 0 to EEPROM_WORDS - 1.
+ *
+ * @return The word.
+ */
+uint32_t EEPROM_Read(uint32_t address);
+
+/**
+ * @brief Reads consecutive words, with one block selection per block.
+ *
+ * @param address The word address of the first word.
+ * @param words The array that receives the words.
+ * @param count The number of words, address + count must not exceed EEPROM_WORDS.
+ *
+ * @return None
+ */
+void EEPROM_Read_Words(uint32_t address, uint32_t *words, uint32_t count);
+
+/**
+ * @brief Writes a word and waits until it has been programmed.
+ *
+ * @param address The word address, from 0 to EEPROM_WORDS - 1.
+ * @param value The word.
+ *
+ * @return Returns 1 when the word was written, 0 when the block is write-protected.
+ */
+uint8_t EEPROM_Write(uint32_t address, uint32_t value);
@@ -0,0 +1,320 @@
+/**
+ * @file GPTM_Timer.c
+ *
+ * @brief Source code for the GPTM_Timer driver.
+ *
+ * The state of each sub-timer is in GPTM_Timer_Channels: its callback, the context of
+ * the callback and the interrupt bits it uses. Sub-timer B's bits are sub-timer A's
+ * shifted left by 8 in the IMR, RIS, MIS and ICR registers, and its IRQ number is
+ * sub-timer A's plus one on every timer.
+ *
+ * @note Refer to Table 2-9 (Interrupts) on pages 104 - 106 from the TM4C123G Microcontroller Datasheet
+ * to view the Vector Number, Interrupt Request (IRQ) Number, and the Vector Address
+ * for each peripheral.
+ */
+
+#include "GPTM_Timer.h"
+
+// GPTMCFG values
+#define GPTM_CFG_CONCATENATED       0x0
+#define GPTM_CFG_SPLIT              0x4
+
+// TnCMR bit of the GPTMTnMR register, selects edge-time instead of edge-count capture
+#define GPTM_TNMR_EDGE_TIME         0x04
+
+// TAEN bit and TAEVENT field of the GPTMCTL register, shifted by 8 for sub-timer B
+#define GPTM_CTL_ENABLE             0x001
+#define GPTM_CTL_EVENT_SHIFT        2
+
+// TATOIM and CAEIM bits of the GPTMIMR register, shifted by 8 for sub-timer B
+#define GPTM_INTERRUPT_TIME_OUT     0x001
+#define GPTM_INTERRUPT_CAPTURE      0x004
+
+typedef struct
+{
+	GPTM_Timer_Callback callback;
+	void *context;
+	uint32_t interrupts;            // IMR bits of the sub-timer, 0 when not configured
+	GPTM_Timer_Width width;
+} GPTM_Timer_Channel;
+
+static GPTM_Timer_Channel GPTM_Timer_Channels[GPTM_TIMER_COUNT][2];
+
+static TIMER0_Type *const GPTM_Timer_Registers[GPTM_TIMER_COUNT] =
+{
+	TIMER0, TIMER1, TIMER2, TIMER3, TIMER4, TIMER5,
+	(TIMER0_Type *)WTIMER0, (TIMER0_Type *)WTIMER1, (TIMER0_Type *)WTIMER2,
+	(TIMER0_Type *)WTIMER3, (TIMER0_Type *)WTIMER4, (TIMER0_Type *)WTIMER5
+};
+
+static const IRQn_Type GPTM_Timer_IRQs[GPTM_TIMER_COUNT] =
+{
+	TIMER0A_IRQn, TIMER1A_IRQn, TIMER2A_IRQn, TIMER3A_IRQn, TIMER4A_IRQn, TIMER5A_IRQn,
+	WTIMER0A_IRQn, WTIMER1A_IRQn, WTIMER2A_IRQn, WTIMER3A_IRQn, WTIMER4A_IRQn, WTIMER5A_IRQn
+};
+
+static uint8_t GPTM_Timer_Is_Wide(GPTM_Timer_ID id)
+{
+	return id >= GPTM_WIDE_TIMER_0;
+}
+
+/**
+ * @brief Returns the number of bits of the count of a sub-timer.
+ */
+static uint8_t GPTM_Timer_Bits(GPTM_Timer_ID id, GPTM_Timer_Width width)
+{
+	uint8_t bits = (width == GPTM_TIMER_WIDTH_FULL) ? 32 : 16;
+	return GPTM_Timer_Is_Wide(id) ? (bits * 2) : bits;
+}
+
+static void GPTM_Timer_Write_Period(GPTM_Timer_ID id, GPTM_Timer_Half half, uint64_t period)
+{
+	TIMER0_Type *timer = GPTM_Timer_Registers[id];
+	uint64_t load = period - 1;
+
+	if (half == GPTM_TIMER_B)
+	{
+		timer->TBILR = (uint32_t)load;
+	}
+	else
+	{
+		// The upper word of a 64-bit count is in TBILR
+		if (GPTM_Timer_Is_Wide(id) && GPTM_Timer_Channels[id][GPTM_TIMER_A].width == GPTM_TIMER_WIDTH_FULL)
+		{
+			timer->TBILR = (uint32_t)(load >> 32);
+		}
+		timer->TAILR = (uint32_t)load;
+	}
+}
+
+uint8_t GPTM_Timer_Init(GPTM_Timer_ID id, GPTM_Timer_Half half, const GPTM_Timer_Config *config)
+{
+	GPTM_Timer_Half other = (half == GPTM_TIMER_A) ? GPTM_TIMER_B : GPTM_TIMER_A;
+	uint8_t bits = GPTM_Timer_Bits(id, config->width);
+	uint8_t prescale_bits = GPTM_Timer_Is_Wide(id) ? 16 : 8;
+
+	if (id >= GPTM_TIMER_COUNT || config->period == 0)
+	{
+		return 0;
+	}
+	if (bits < 64 && config->period > (1ULL << bits))
+	{
+		return 0;
+	}
+	if (config->width == GPTM_TIMER_WIDTH_FULL &&
+		(half == GPTM_TIMER_B || config->mode == GPTM_TIMER_MODE_EDGE_TIME || config->prescale != 0))
+	{
+		return 0;
+	}
+	if (config->prescale >= (1UL << prescale_bits))
+	{
+		return 0;
+	}
+	// Both sub-timers share the GPTMCFG register
+	if (GPTM_Timer_Channels[id][other].interrupts != 0 && GPTM_Timer_Channels[id][other].width != config->width)
+	{
+		return 0;
+	}
+
+	TIMER0_Type *timer = GPTM_Timer_Registers[id];
+	GPTM_Timer_Channel *channel = &GPTM_Timer_Channels[id][half];
+	uint32_t shift = (half == GPTM_TIMER_B) ? 8 : 0;
+	uint32_t interrupt = (config->mode == GPTM_TIMER_MODE_EDGE_TIME) ? GPTM_INTERRUPT_CAPTURE : GPTM_INTERRUPT_TIME_OUT;
+
+	// Enable the clock of the timer in the RCGCTIMER or RCGCWTIMER register
+	if (GPTM_Timer_Is_Wide(id))
+	{
+		SYSCTL->RCGCWTIMER |= 1UL << (id - GPTM_WIDE_TIMER_0);
+	}
+	else
+	{
+		SYSCTL->RCGCTIMER |= 1UL << id;
+	}
+
+	// Disable the sub-timer while it is configured
+	timer->CTL &= ~(GPTM_CTL_ENABLE << shift);
+
+	// The other sub-timer may be running with the same configuration, leave it then
+	if (GPTM_Timer_Channels[id][other].interrupts == 0)
+	{
+		timer->CFG = (config->width == GPTM_TIMER_WIDTH_FULL) ? GPTM_CFG_CONCATENATED : GPTM_CFG_SPLIT;
+	}
+
+	// Count down in the selected mode
+	uint32_t mode = config->mode;
+	if (config->mode == GPTM_TIMER_MODE_EDGE_TIME)
+	{
+		mode |= GPTM_TNMR_EDGE_TIME;
+		timer->CTL = (timer->CTL & ~(0x3UL << (GPTM_CTL_EVENT_SHIFT + shift))) |
+			((uint32_t)config->edge << (GPTM_CTL_EVENT_SHIFT + shift));
+	}
+
+	channel->callback = config->callback;
+	channel->context = config->context;
+	channel->interrupts = interrupt << shift;
+	channel->width = config->width;
+
+	if (half == GPTM_TIMER_B)
+	{
+		timer->TBMR = mode;
+		timer->TBPR = config->prescale;
+	}
+	else
+	{
+		timer->TAMR = mode;
+		timer->TAPR = config->prescale;
+	}
+	GPTM_Timer_Write_Period(id, half, config->period);
+
+	// Clear a stale interrupt, then enable the interrupt of the sub-timer when it has a callback
+	timer->ICR = (GPTM_INTERRUPT_TIME_OUT | GPTM_INTERRUPT_CAPTURE) << shift;
+
+	IRQn_Type irq = (IRQn_Type)(GPTM_Timer_IRQs[id] + half);
+	if (config->callback)
+	{
+		timer->IMR |= channel->interrupts;
+		NVIC_SetPriority(irq, config->priority);
+		NVIC_EnableIRQ(irq);
+	}
+	else
+	{
+		timer->IMR &= ~((GPTM_INTERRUPT_TIME_OUT | GPTM_INTERRUPT_CAPTURE) << shift);
+		NVIC_DisableIRQ(irq);
+	}
+
+	return 1;
+}
+
+void GPTM_Timer_Start(GPTM_Timer_ID id, GPTM_Timer_Half half)
+{
+	TIMER0_Type *timer = GPTM_Timer_Registers[id];
+	uint32_t shift = (half == GPTM_TIMER_B) ? 8 : 0;
+
+	// Disabling and enabling the sub-timer reloads the count from TnILR
+	timer->CTL &= ~(GPTM_CTL_ENABLE << shift);
+	timer->ICR = GPTM_Timer_Channels[id][half].interrupts;
+	timer->CTL |= GPTM_CTL_ENABLE << shift;
+}
+
+void GPTM_Timer_Stop(GPTM_Timer_ID id, GPTM_Timer_Half half)
+{
+	TIMER0_Type *timer = GPTM_Timer_Registers[id];
+	uint32_t shift = (half == GPTM_TIMER_B) ? 8 : 0;
+
+	timer->CTL &= ~(GPTM_CTL_ENABLE << shift);
+	timer->ICR = GPTM_Timer_Channels[id][half].interrupts;
+}
+
+void GPTM_Timer_Set_Period(GPTM_Timer_ID id, GPTM_Timer_Half half, uint64_t period)
+{
+	GPTM_Timer_Write_Period(id, half, period);
+}
+
+void GPTM_Timer_Set_Prescale(GPTM_Timer_ID id, GPTM_Timer_Half half, uint32_t prescale)
+{
+	TIMER0_Type *timer = GPTM_Timer_Registers[id];
+
+	if (half == GPTM_TIMER_B)
+	{
+		timer->TBPR = prescale;
+	}
+	else
+	{
+		timer->TAPR = prescale;
+	}
+}
+
+uint64_t GPTM_Timer_Value(GPTM_Timer_ID id, GPTM_Timer_Half half)
+{
+	TIMER0_Type *timer = GPTM_Timer_Registers[id];
+	uint8_t wide = GPTM_Timer_Is_Wide(id);
+
+	// A split 16-bit count has the prescaler above it, drop it
+	uint32_t mask = (wide || GPTM_Timer_Channels[id][half].width == GPTM_TIMER_WIDTH_FULL) ? 0xFFFFFFFF : 0x0000FFFF;
+
+	if (half == GPTM_TIMER_B)
+	{
+		return timer->TBV & mask;
+	}
+
+	if (wide && GPTM_Timer_Channels[id][GPTM_TIMER_A].width == GPTM_TIMER_WIDTH_FULL)
+	{
+		// Read the upper word again if the lower word wrapped in between
+		uint32_t upper;
+		uint32_t lower;
+		do
+		{
+			upper = timer->TBV;
+			lower = timer->TAV;
+		} while (upper != timer->TBV);
+
+		return ((uint64_t)upper << 32) | lower;
+	}
+
+	return timer->TAV & mask;
+}
+
+uint64_t GPTM_Timer_Capture(GPTM_Timer_ID id, GPTM_Timer_Half half)
+{
+	TIMER0_Type *timer = GPTM_Timer_Registers[id];
+	uint32_t captured = (half == GPTM_TIMER_B) ? timer->TBR : timer->TAR;
+
+	// A wide timer keeps the prescaler bits of the capture in GPTMTnPS
+	if (GPTM_Timer_Is_Wide(id))
+	{
+		uint32_t prescale = (half == GPTM_TIMER_B) ? timer->TBPS : timer->TAPS;
+		return ((uint64_t)(prescale & 0xFFFF) << 32) | captured;
+	}
+
+	return captured & 0x00FFFFFF;
+}
+
+/**
+ * @brief Clears the interrupt of a sub-timer and runs its callback.
+ */
+static void GPTM_Timer_Handle(GPTM_Timer_ID id, GPTM_Timer_Half half)
+{
+	TIMER0_Type *timer = GPTM_Timer_Registers[id];
+	GPTM_Timer_Channel *channel = &GPTM_Timer_Channels[id][half];
+	uint32_t status = timer->MIS & channel->interrupts;
+
+	// The interrupt was cleared by a restart after it had been pended
+	if (status == 0)
+	{
+		return;
+	}
+
+	timer->ICR = status;
+	channel->callback(channel->context);
+}
+
+#define GPTM_TIMER_HANDLER(handler, id, half) \
+void handler(void)                            \
+{                                             \
+	GPTM_Timer_Handle(id, half);              \
+}
+
+GPTM_TIMER_HANDLER(TIMER0A_Handler, GPTM_TIMER_0, GPTM_TIMER_A)
+GPTM_TIMER_HANDLER(TIMER0B_Handler, GPTM_TIMER_0, GPTM_TIMER_B)
+GPTM_TIMER_HANDLER(TIMER1A_Handler, GPTM_TIMER_1, GPTM_TIMER_A)
+GPTM_TIMER_HANDLER(TIMER1B_Handler, GPTM_TIMER_1, GPTM_TIMER_B)
+GPTM_TIMER_HANDLER(TIMER2A_Handler, GPTM_TIMER_2, GPTM_TIMER_A)
+GPTM_TIMER_HANDLER(TIMER2B_Handler, GPTM_TIMER_2, GPTM_TIMER_B)
+GPTM_TIMER_HANDLER(TIMER3A_Handler, GPTM_TIMER_3, GPTM_TIMER_A)
+GPTM_TIMER_HANDLER(TIMER3B_Handler, GPTM_TIMER_3, GPTM_TIMER_B)
+GPTM_TIMER_HANDLER(TIMER4A_Handler, GPTM_TIMER_4, GPTM_TIMER_A)
+GPTM_TIMER_HANDLER(TIMER4B_Handler, GPTM_TIMER_4, GPTM_TIMER_B)
+GPTM_TIMER_HANDLER(TIMER5A_Handler, GPTM_TIMER_5, GPTM_TIMER_A)
+GPTM_TIMER_HANDLER(TIMER5B_Handler, GPTM_TIMER_5, GPTM_TIMER_B)
+GPTM_TIMER_HANDLER(WTIMER0A_Handler, GPTM_WIDE_TIMER_0, GPTM_TIMER_A)
+GPTM_TIMER_HANDLER(WTIMER0B_Handler, GPTM_WIDE_TIMER_0, GPTM_TIMER_B)
+GPTM_TIMER_HANDLER(WTIMER1A_Handler, GPTM_WIDE_TIMER_1, GPTM_TIMER_A)
+GPTM_TIMER_HANDLER(WTIMER1B_Handler, GPTM_WIDE_TIMER_1, GPTM_TIMER_B)
+GPTM_TIMER_HANDLER(WTIMER2A_Handler, GPTM_WIDE_TIMER_2, GPTM_TIMER_A)
+GPTM_TIMER_HANDLER(WTIMER2B_Handler, GPTM_WIDE_TIMER_2, GPTM_TIMER_B)
+GPTM_TIMER_HANDLER(WTIMER3A_Handler, GPTM_WIDE_TIMER_3, GPTM_TIMER_A)
+GPTM_TIMER_HANDLER(WTIMER3B_Handler, GPTM_WIDE_TIMER_3, GPTM_TIMER_B)
+GPTM_TIMER_HANDLER(WTIMER4A_Handler, GPTM_WIDE_TIMER_4, GPTM_TIMER_A)
+GPTM_TIMER_HANDLER(WTIMER4B_Handler, GPTM_WIDE_TIMER_4, GPTM_TIMER_B)
+GPTM_TIMER_HANDLER(WTIMER5A_Handler, GPTM_WIDE_TIMER_5, GPTM_TIMER_A)
+GPTM_TIMER_HANDLER(WTIMER5B_Handler, GPTM_WIDE_TIMER_5, GPTM_TIMER_B)
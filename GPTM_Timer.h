@@ -0,0 +1,185 @@
+/**
+ * @file GPTM_Timer.h
+ *
+ * @brief Header file for the GPTM_Timer driver.
+ *
+ * This driver runs the six 16/32-bit timers (Timers 0 to 5) and the six 32/64-bit wide
+ * timers (Wide Timers 0 to 5). Each timer has two sub-timers, A and B, which are used:
+ *
+ *  - split (GPTM_TIMER_WIDTH_HALF): A and B are independent 16-bit timers, or 32-bit
+ *    on a wide timer. In one-shot and periodic mode, the prescaler (8 bits, 16 on a
+ *    wide timer) divides the system clock, so a tick is (prescale + 1) clock cycles.
+ *  - concatenated (GPTM_TIMER_WIDTH_FULL): A and B form a single 32-bit timer, or
+ *    64-bit on a wide timer, that is used through sub-timer A. There is no prescaler.
+ *
+ * in one of these modes:
+ *
+ *  - GPTM_TIMER_MODE_ONE_SHOT: one time-out after period ticks, then the timer stops.
+ *  - GPTM_TIMER_MODE_PERIODIC: a time-out every period ticks.
+ *  - GPTM_TIMER_MODE_EDGE_TIME: the count is captured on each edge of the CCP pin, read
+ *    with GPTM_Timer_Capture. The pin must be configured for its timer function by the
+ *    caller (AFSEL and PCTL). Split only, where the prescaler extends the count to 24
+ *    bits (48 on a wide timer).
+ *
+ * The callback of a sub-timer runs in its own interrupt handler, with the context that
+ * was given to GPTM_Timer_Init, after the interrupt has been cleared:
+ *
+ *     static void Idle_Expired(void *context) { ... }
+ *
+ *     GPTM_Timer_Config config = { GPTM_TIMER_MODE_ONE_SHOT, GPTM_TIMER_WIDTH_FULL, 0,
+ *         SystemCoreClock / 1000, GPTM_TIMER_EDGE_RISING, Idle_Expired, &state, 2 };
+ *     GPTM_Timer_Init(GPTM_TIMER_1, GPTM_TIMER_A, &config);
+ *     GPTM_Timer_Start(GPTM_TIMER_1, GPTM_TIMER_A);
+ *
+ * Each of the 24 handlers goes straight to its sub-timer, so modules that own a timer
+ * each do not share a dispatch.
+ *
+ * Timers in use:
+ *  - Timer 0A: stepper motor half steps (Stepper_Motor.c)
+ *  - Timer 1A: UART1 line idle time-out (UART_BLE.c)
+ *  - Timers 2A and 2B, Wide Timer 0A: "TIMER TEST" checks of the other modes (GPTM_Timer_Test.c)
+ *
+ * @note For more information regarding the timers, refer to the General-Purpose Timers
+ * section of the TM4C123GH6PM Microcontroller Datasheet.
+ * Link: https://www.ti.com/lit/gpn/TM4C123GH6PM
+ */
+
+#include "TM4C123GH6PM.h"
+
+typedef enum
+{
+	GPTM_TIMER_0,
+	GPTM_TIMER_1,
+	GPTM_TIMER_2,
+	GPTM_TIMER_3,
+	GPTM_TIMER_4,
+	GPTM_TIMER_5,
+	GPTM_WIDE_TIMER_0,
+	GPTM_WIDE_TIMER_1,
+	GPTM_WIDE_TIMER_2,
+	GPTM_WIDE_TIMER_3,
+	GPTM_WIDE_TIMER_4,
+	GPTM_WIDE_TIMER_5,
+	GPTM_TIMER_COUNT
+} GPTM_Timer_ID;
+
+typedef enum
+{
+	GPTM_TIMER_A,
+	GPTM_TIMER_B
+} GPTM_Timer_Half;
+
+// Values of the TnMR field of the GPTMTnMR register
+typedef enum
+{
+	GPTM_TIMER_MODE_ONE_SHOT    = 0x1,
+	GPTM_TIMER_MODE_PERIODIC    = 0x2,
+	GPTM_TIMER_MODE_EDGE_TIME   = 0x3
+} GPTM_Timer_Mode;
+
+typedef enum
+{
+	GPTM_TIMER_WIDTH_HALF,      // 16 bits, 32 on a wide timer
+	GPTM_TIMER_WIDTH_FULL       // 32 bits, 64 on a wide timer, sub-timer A only
+} GPTM_Timer_Width;
+
+// Values of the TnEVENT field of the GPTMCTL register
+typedef enum
+{
+	GPTM_TIMER_EDGE_RISING      = 0x0,
+	GPTM_TIMER_EDGE_FALLING     = 0x1,
+	GPTM_TIMER_EDGE_BOTH        = 0x3
+} GPTM_Timer_Edge;
+
+typedef void (*GPTM_Timer_Callback)(void *context);
+
+typedef struct
+{
+	GPTM_Timer_Mode mode;
+	GPTM_Timer_Width width;
+	uint32_t prescale;              // split one-shot and periodic: tick = prescale + 1 cycles
+	uint64_t period;                // ticks per time-out, or the range of an edge-time count
+	GPTM_Timer_Edge edge;           // edge-time mode only
+	GPTM_Timer_Callback callback;   // time-out or capture, NULL for none
+	void *context;                  // passed to the callback
+	uint8_t priority;               // see Interrupt_Priorities.h
+} GPTM_Timer_Config;
+
+/**
+ * @brief Configures a sub-timer, which is left stopped.
+ *
+ * The clock of the timer is enabled, and its interrupt when a callback is given.
+ *
+ * @param id The timer.
+ * @param half The sub-timer, GPTM_TIMER_A for a concatenated timer.
+ * @param config The configuration, which is copied.
+ *
+ * @return Returns 1 if the configuration is valid. Otherwise, returns 0 and the timer is
+ * not changed: a period or a prescale out of range, a concatenated sub-timer B, an
+ * edge-time concatenated timer, or a width that differs from the other sub-timer's.
+ */
+uint8_t GPTM_Timer_Init(GPTM_Timer_ID id, GPTM_Timer_Half half, const GPTM_Timer_Config *config);
+
+/**
+ * @brief Starts a sub-timer for a full period, or restarts it if it is running.
+ *
+ * A time-out that expired before the restart is cleared, so its callback does not run.
+ *
+ * @param id The timer.
+ * @param half The sub-timer.
+ *
+ * @return None
+ */
+void GPTM_Timer_Start(GPTM_Timer_ID id, GPTM_Timer_Half half);
+
+/**
+ * @brief Stops a sub-timer and clears a time-out or a capture that is pending.
+ *
+ * @param id The timer.
+ * @param half The sub-timer.
+ *
+ * @return None
+ */
+void GPTM_Timer_Stop(GPTM_Timer_ID id, GPTM_Timer_Half half);
+
+/**
+ * @brief Changes the period of a sub-timer, from the next time-out or start.
+ *
+ * @param id The timer.
+ * @param half The sub-timer.
+ * @param period Ticks per time-out, it must fit the width of the sub-timer.
+ *
+ * @return None
+ */
+void GPTM_Timer_Set_Period(GPTM_Timer_ID id, GPTM_Timer_Half half, uint64_t period);
+
+/**
+ * @brief Changes the prescale value of a split sub-timer, from its next start.
+ *
+ * @param id The timer.
+ * @param half The sub-timer.
+ * @param prescale A tick becomes prescale + 1 system clock cycles.
+ *
+ * @return None
+ */
+void GPTM_Timer_Set_Prescale(GPTM_Timer_ID id, GPTM_Timer_Half half, uint32_t prescale);
+
+/**
+ * @brief Reads the current count of a sub-timer, which counts down from period - 1.
+ *
+ * @param id The timer.
+ * @param half The sub-timer.
+ *
+ * @return The count, 64 bits for a concatenated wide timer.
+ */
+uint64_t GPTM_Timer_Value(GPTM_Timer_ID id, GPTM_Timer_Half half);
+
+/**
+ * @brief Reads the count captured on the last edge in edge-time mode.
+ *
+ * @param id The timer.
+ * @param half The sub-timer.
+ *
+ * @return The captured count, 24 bits with the prescaler bits on top (48 bits on a wide timer).
+ */
+uint64_t GPTM_Timer_Capture(GPTM_Timer_ID id, GPTM_Timer_Half half);
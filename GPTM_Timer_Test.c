@@ -0,0 +1,172 @@
+/**
+ * @file GPTM_Timer_Test.c
+ *
+ * @brief Source code for the GPTM_Timer_Test module.
+ *
+ * The split timers tick every microsecond. SysTick_Delay1ms ends on a SysTick interrupt,
+ * so a delay of n ms lasts between n - 1 and n ms: the timers are started right after a
+ * 1 ms delay, and a periodic count is still allowed one time-out either way.
+ */
+
+#include "GPTM_Timer_Test.h"
+#include "GPTM_Timer.h"
+#include "Interrupt_Priorities.h"
+#include "SysTick_Delay.h"
+#include "UART0.h"
+
+extern uint32_t SystemCoreClock;
+
+// Time-outs counted by Timer_Test_Count, one per sub-timer under test
+static volatile uint32_t Timer_Test_Periodic_Count;
+static volatile uint32_t Timer_Test_One_Shot_Count;
+static volatile uint32_t Timer_Test_Wide_Count;
+
+static void Timer_Test_Count(void *context)
+{
+	(*(volatile uint32_t *)context)++;
+}
+
+static uint8_t Timer_Test_Report(char *name, uint8_t passed)
+{
+	UART0_Output_String("TIMER ");
+	UART0_Output_String(name);
+	if (passed)
+	{
+		UART0_Output_String(" PASS");
+	}
+	else
+	{
+		UART0_Output_String(" FAIL");
+	}
+	UART0_Output_Newline();
+
+	return passed;
+}
+
+/**
+ * @brief A configuration with a callback that counts into count.
+ */
+static GPTM_Timer_Config Timer_Test_Config(GPTM_Timer_Mode mode, GPTM_Timer_Width width, uint32_t prescale,
+	uint64_t period, volatile uint32_t *count)
+{
+	GPTM_Timer_Config config = { mode, width, prescale, period, GPTM_TIMER_EDGE_RISING,
+		Timer_Test_Count, (void *)count, INTERRUPT_PRIORITY_TIMER_TEST };
+
+	*count = 0;
+	return config;
+}
+
+static uint8_t Timer_Test_Reject(void)
+{
+	uint32_t prescale = SystemCoreClock / 1000000 - 1;
+	volatile uint32_t unused;
+	uint8_t passed = 1;
+
+	// Sub-timer B cannot be concatenated
+	GPTM_Timer_Config config = Timer_Test_Config(GPTM_TIMER_MODE_PERIODIC, GPTM_TIMER_WIDTH_FULL, 0, 1000, &unused);
+	passed &= !GPTM_Timer_Init(GPTM_TIMER_2, GPTM_TIMER_B, &config);
+
+	// A split 16-bit period, and an 8-bit prescale
+	config = Timer_Test_Config(GPTM_TIMER_MODE_PERIODIC, GPTM_TIMER_WIDTH_HALF, prescale, 65537, &unused);
+	passed &= !GPTM_Timer_Init(GPTM_TIMER_2, GPTM_TIMER_B, &config);
+	config = Timer_Test_Config(GPTM_TIMER_MODE_PERIODIC, GPTM_TIMER_WIDTH_HALF, 256, 1000, &unused);
+	passed &= !GPTM_Timer_Init(GPTM_TIMER_2, GPTM_TIMER_B, &config);
+
+	return Timer_Test_Report("reject", passed);
+}
+
+static uint8_t Timer_Test_Split(void)
+{
+	uint32_t prescale = SystemCoreClock / 1000000 - 1;
+	uint8_t passed = 1;
+
+	// Timer 2B: a time-out every 1 ms, Timer 2A: one after 3 ms
+	GPTM_Timer_Config periodic = Timer_Test_Config(GPTM_TIMER_MODE_PERIODIC, GPTM_TIMER_WIDTH_HALF, prescale, 1000,
+		&Timer_Test_Periodic_Count);
+	GPTM_Timer_Config one_shot = Timer_Test_Config(GPTM_TIMER_MODE_ONE_SHOT, GPTM_TIMER_WIDTH_HALF, prescale, 3000,
+		&Timer_Test_One_Shot_Count);
+	passed &= GPTM_Timer_Init(GPTM_TIMER_2, GPTM_TIMER_B, &periodic);
+	passed &= GPTM_Timer_Init(GPTM_TIMER_2, GPTM_TIMER_A, &one_shot);
+	if (!passed)
+	{
+		return Timer_Test_Report("init", 0);
+	}
+
+	SysTick_Delay1ms(1);
+	GPTM_Timer_Start(GPTM_TIMER_2, GPTM_TIMER_B);
+	GPTM_Timer_Start(GPTM_TIMER_2, GPTM_TIMER_A);
+	SysTick_Delay1ms(10);
+	GPTM_Timer_Stop(GPTM_TIMER_2, GPTM_TIMER_B);
+
+	uint32_t periodic_count = Timer_Test_Periodic_Count;
+	passed &= Timer_Test_Report("split B periodic", periodic_count >= 9 && periodic_count <= 11);
+	passed &= Timer_Test_Report("split A one-shot", Timer_Test_One_Shot_Count == 1);
+
+	// A start reloads the one-shot timer for another time-out
+	GPTM_Timer_Start(GPTM_TIMER_2, GPTM_TIMER_A);
+	SysTick_Delay1ms(5);
+	passed &= Timer_Test_Report("one-shot reload", Timer_Test_One_Shot_Count == 2);
+
+	// A stop before the time-out leaves nothing pending
+	GPTM_Timer_Start(GPTM_TIMER_2, GPTM_TIMER_A);
+	SysTick_Delay1ms(1);
+	GPTM_Timer_Stop(GPTM_TIMER_2, GPTM_TIMER_A);
+	SysTick_Delay1ms(5);
+	passed &= Timer_Test_Report("one-shot stop", Timer_Test_One_Shot_Count == 2);
+
+	return passed;
+}
+
+static uint8_t Timer_Test_Wide(void)
+{
+	uint32_t cycles_per_ms = SystemCoreClock / 1000;
+	uint8_t passed = 1;
+
+	GPTM_Timer_Config config = Timer_Test_Config(GPTM_TIMER_MODE_ONE_SHOT, GPTM_TIMER_WIDTH_FULL, 0, cycles_per_ms,
+		&Timer_Test_Wide_Count);
+	if (!GPTM_Timer_Init(GPTM_WIDE_TIMER_0, GPTM_TIMER_A, &config))
+	{
+		return Timer_Test_Report("wide init", 0);
+	}
+
+	GPTM_Timer_Start(GPTM_WIDE_TIMER_0, GPTM_TIMER_A);
+	SysTick_Delay1ms(3);
+	passed &= Timer_Test_Report("wide one-shot", Timer_Test_Wide_Count == 1);
+
+	// 2^33 cycles is almost three minutes, the count is only read: the upper word must
+	// be 1 and the count must go down by about a millisecond over a 1 ms delay
+	GPTM_Timer_Set_Period(GPTM_WIDE_TIMER_0, GPTM_TIMER_A, 1ULL << 33);
+	SysTick_Delay1ms(1);
+	GPTM_Timer_Start(GPTM_WIDE_TIMER_0, GPTM_TIMER_A);
+	uint64_t first = GPTM_Timer_Value(GPTM_WIDE_TIMER_0, GPTM_TIMER_A);
+	SysTick_Delay1ms(1);
+	uint64_t second = GPTM_Timer_Value(GPTM_WIDE_TIMER_0, GPTM_TIMER_A);
+	GPTM_Timer_Stop(GPTM_WIDE_TIMER_0, GPTM_TIMER_A);
+
+	uint64_t elapsed = first - second;
+	passed &= Timer_Test_Report("wide 64-bit count", (first >> 32) == 1 && second < first
+		&& elapsed >= cycles_per_ms / 2 && elapsed <= cycles_per_ms * 2);
+
+	return passed;
+}
+
+uint8_t GPTM_Timer_Test_Run(void)
+{
+	uint8_t passed = 1;
+
+	passed &= Timer_Test_Reject();
+	passed &= Timer_Test_Split();
+	passed &= Timer_Test_Wide();
+
+	if (passed)
+	{
+		UART0_Output_String("TIMER PASS");
+	}
+	else
+	{
+		UART0_Output_String("TIMER FAIL");
+	}
+	UART0_Output_Newline();
+
+	return passed;
+}
@@ -0,0 +1,35 @@
+/**
+ * @file GPTM_Timer_Test.h
+ *
+ * @brief Header file for the GPTM_Timer_Test module.
+ *
+ * This module checks the GPTM_Timer modes that the motor and the BLE idle timer do not
+ * use, on timers that nothing else uses:
+ *
+ *  - Timer 2B: split 16-bit periodic, with the prescaler, next to Timer 2A
+ *  - Timer 2A: split one-shot, which stops after its time-out, is reloaded by a new
+ *    start and does not time out after a stop
+ *  - Wide Timer 0A: concatenated 64-bit one-shot, with a time-out and a count above 2^32
+ *  - the configurations GPTM_Timer_Init must reject
+ *
+ * The time-outs are counted by the callbacks while the check waits with SysTick_Delay1ms,
+ * so the check blocks the main loop for about 40 ms.
+ *
+ * The report is printed over UART0:
+ *
+ *     TIMER <check> PASS | TIMER <check> FAIL
+ *     TIMER PASS | TIMER FAIL
+ */
+
+#include "TM4C123GH6PM.h"
+
+/**
+ * @brief Runs the checks and prints the report over UART0.
+ *
+ * The timers are left stopped.
+ *
+ * @param None
+ *
+ * @return 1 if every check passed, 0 otherwise.
+ */
+uint8_t GPTM_Timer_Test_Run(void);
@@ -0,0 +1,60 @@
+/**
+ * @file Interrupt_Priorities.h
+ *
+ * @brief Priorities of every interrupt source of the firmware.
+ *
+ * The TM4C123GH6PM implements 3 priority bits, 0 is the most urgent and 7 the least.
+ * A handler is preempted by the handlers with a smaller number, and handlers with the
+ * same number never preempt each other.
+ *
+ *     Priority  Source                Handler               Work done in the handler
+ *     0         SysTick               SysTick_Handler       uptime count, 1 ms
+ *     1         Timer 0A              TIMER0A_Handler       half step of the motor, 4.08 ms
+ *     2         UART1 (BLE) RX        UART1_Handler         receive FIFO to the ring buffer
+ *     2         Timer 1A (BLE idle)   TIMER1A_Handler       end of a line without '\n'
+ *     2         UART3 (Arduino) RX    UART3_Handler         receive FIFO to the ring buffer
+ *     3         UART0 TX              UART0_Handler         log frames to the transmit FIFO
+ *     3         Timers 2A, 2B, W0A    TIMER2A_Handler, ...  "TIMER TEST" time-out counts
+ *     7         PendSV                PendSV_Handler        deferred work (Deferred_Work.h)
+ *
+ * Simulator lower bounds of the worst-case interrupt latency, from the interrupt pending
+ * to the first instruction of its handler, in core clock cycles at 50 MHz, over the
+ * scenarios in Simulator/Scenarios (its report prints the "Max latency" of each handler).
+ * The simulator only charges register accesses and exception entry and exit, not the
+ * instructions in between, so the handlers that delay one another run longer on the
+ * board and its latencies are longer:
+ *
+ *     SysTick_Handler     39
+ *     TIMER0A_Handler     35
+ *     UART1_Handler       43
+ *     TIMER1A_Handler     52
+ *     UART3_Handler       35
+ *     UART0_Handler       35
+ *     PendSV_Handler      66
+ *
+ * The latency of a handler is bounded by the longest handler of the same or a higher
+ * priority and by the longest __disable_irq section of the main loop. Keeping the
+ * handlers short is what keeps it low, which is why the work that can wait is posted
+ * to PendSV.
+ */
+
+// Keeps the time base of the delays and of the uptime
+#define INTERRUPT_PRIORITY_SYSTICK          0
+
+// The motor steps must be evenly spaced
+#define INTERRUPT_PRIORITY_TIMER0A          1
+
+// UART1 and Timer 1A share a level, so the idle timer never splits a line being received
+#define INTERRUPT_PRIORITY_UART_BLE         2
+
+// The Arduino lines are short and end with '\n', nothing depends on their timing
+#define INTERRUPT_PRIORITY_UART3            2
+
+// Log output can wait, the frames stay in the buffer
+#define INTERRUPT_PRIORITY_UART0            3
+
+// The timer checks only count time-outs, over delays much longer than a handler
+#define INTERRUPT_PRIORITY_TIMER_TEST       3
+
+// Runs once no other handler is active
+#define INTERRUPT_PRIORITY_DEFERRED_WORK    7
@@ -0,0 +1,197 @@
+/**
+ * @file Latency_Benchmark.c
+ *
+ * @brief Source code for the Latency_Benchmark module.
+ *
+ * Timestamps are read from the DWT cycle counter (CYCCNT), which counts core clock
+ * cycles and wraps after about 85 seconds at 50 MHz. Latencies are stored in cycles
+ * and converted to microseconds with SystemCoreClock when the report is printed.
+ */
+
+#include "Latency_Benchmark.h"
+#include "UART0.h"
+
+extern uint32_t SystemCoreClock;
+
+static const char *const Latency_Stage_Names[LATENCY_STAGE_COUNT] =
+{
+	"echo",
+	"forward",
+	"first_step",
+	"motor_stop"
+};
+
+static const uint32_t Latency_Budgets_US[LATENCY_STAGE_COUNT] =
+{
+	LATENCY_BUDGET_UART0_ECHO_US,
+	LATENCY_BUDGET_UART3_FORWARD_US,
+	LATENCY_BUDGET_FIRST_STEP_US,
+	LATENCY_BUDGET_MOTOR_STOP_US
+};
+
+// Most recent latencies of each stage in cycles, written as a ring
+static uint32_t Latency_Samples[LATENCY_STAGE_COUNT][LATENCY_SAMPLES];
+
+// Number of latencies recorded for each stage since the last reset
+static uint32_t Latency_Counts[LATENCY_STAGE_COUNT];
+
+// Largest latency of each stage since the last reset, including the overwritten samples
+static uint32_t Latency_Max[LATENCY_STAGE_COUNT];
+
+// CYCCNT value when the current command arrived
+static volatile uint32_t Latency_Arrival;
+
+// Bit n stays set until stage n has been recorded for the current command
+static volatile uint8_t Latency_Pending;
+
+void Latency_Benchmark_Init(void)
+{
+	// Enable the DWT unit by setting the TRCENA bit (Bit 24) in the DEMCR register
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+
+	// Clear the cycle counter and start it by setting the CYCCNTENA bit (Bit 0)
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	Latency_Benchmark_Reset();
+}
+
+void Latency_Benchmark_Reset(void)
+{
+	for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+	{
+		Latency_Counts[stage] = 0;
+		Latency_Max[stage] = 0;
+	}
+
+	// No command is being measured until the next one arrives
+	Latency_Pending = 0;
+}
+
+void Latency_Benchmark_Command_Arrived(void)
+{
+	Latency_Arrival = DWT->CYCCNT;
+	Latency_Pending = (1 << LATENCY_STAGE_COUNT) - 1;
+}
+
+void Latency_Benchmark_Mark(Latency_Stage stage)
+{
+	Latency_Benchmark_Mark_At(stage, DWT->CYCCNT);
+}
+
+void Latency_Benchmark_Mark_At(Latency_Stage stage, uint32_t now)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	// The motor stages are marked from PendSV, so the check and the
+	// update of Latency_Pending must not be split by an interrupt
+	__disable_irq();
+
+	if (Latency_Pending & (1 << stage))
+	{
+		uint32_t latency = now - Latency_Arrival;
+
+		Latency_Pending &= ~(1 << stage);
+		Latency_Samples[stage][Latency_Counts[stage] % LATENCY_SAMPLES] = latency;
+		Latency_Counts[stage]++;
+
+		if (latency > Latency_Max[stage])
+		{
+			Latency_Max[stage] = latency;
+		}
+	}
+
+	__set_PRIMASK(primask);
+}
+
+/**
+ * @brief Returns the nearest-rank percentile of the sorted samples.
+ */
+static uint32_t Latency_Percentile(const uint32_t sorted[], uint32_t count, uint32_t percent)
+{
+	uint32_t rank = (count * percent + 99) / 100;
+
+	return sorted[(rank > 0) ? (rank - 1) : 0];
+}
+
+static uint32_t Latency_Cycles_To_US(uint32_t cycles)
+{
+	return cycles / (SystemCoreClock / 1000000);
+}
+
+static void Latency_Output_Field(uint32_t value)
+{
+	UART0_Output_Character(' ');
+	UART0_Output_Unsigned_Decimal(value);
+}
+
+uint8_t Latency_Benchmark_Report(void)
+{
+	uint32_t sorted[LATENCY_SAMPLES];
+	uint8_t passed = 1;
+
+	UART0_Output_String("LATENCY stage samples p50_us p99_us max_us budget_us");
+	UART0_Output_Newline();
+
+	for (int stage = 0; stage < LATENCY_STAGE_COUNT; stage++)
+	{
+		uint32_t count = (Latency_Counts[stage] < LATENCY_SAMPLES) ? Latency_Counts[stage] : LATENCY_SAMPLES;
+
+		UART0_Output_String("LATENCY ");
+		UART0_Output_String((char *)Latency_Stage_Names[stage]);
+		Latency_Output_Field(Latency_Counts[stage]);
+
+		if (count == 0)
+		{
+			UART0_Output_String(" - - -");
+			Latency_Output_Field(Latency_Budgets_US[stage]);
+			UART0_Output_String(" OK");
+			UART0_Output_Newline();
+			continue;
+		}
+
+		// Insertion sort of a copy, the ring keeps its order for the next samples
+		for (uint32_t i = 0; i < count; i++)
+		{
+			uint32_t value = Latency_Samples[stage][i];
+			uint32_t j = i;
+
+			while (j > 0 && sorted[j - 1] > value)
+			{
+				sorted[j] = sorted[j - 1];
+				j--;
+			}
+			sorted[j] = value;
+		}
+
+		uint32_t max_us = Latency_Cycles_To_US(Latency_Max[stage]);
+
+		Latency_Output_Field(Latency_Cycles_To_US(Latency_Percentile(sorted, count, 50)));
+		Latency_Output_Field(Latency_Cycles_To_US(Latency_Percentile(sorted, count, 99)));
+		Latency_Output_Field(max_us);
+		Latency_Output_Field(Latency_Budgets_US[stage]);
+
+		if (max_us > Latency_Budgets_US[stage])
+		{
+			UART0_Output_String(" OVER BUDGET");
+			passed = 0;
+		}
+		else
+		{
+			UART0_Output_String(" OK");
+		}
+		UART0_Output_Newline();
+	}
+
+	if (passed)
+	{
+		UART0_Output_String("LATENCY PASS");
+	}
+	else
+	{
+		UART0_Output_String("LATENCY FAIL");
+	}
+	UART0_Output_Newline();
+
+	return passed;
+}
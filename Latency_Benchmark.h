@@ -0,0 +1,117 @@
+/**
+ * @file Latency_Benchmark.h
+ *
+ * @brief Header file for the Latency_Benchmark module.
+ *
+ * This module measures the command-to-actuation latency of the music box with the
+ * DWT cycle counter. The main loop stamps the arrival of every BLE command, and each
+ * stage that follows is recorded once per command:
+ *  - UART0 echo: the log frame of the command has left the transmit buffer for the
+ *    UART0 FIFO, after the frames queued before it
+ *  - UART3 forward: the command has been sent to the Arduino MKR Zero
+ *  - First step: the stepper motor made its first step after being started
+ *  - Motor stop: the stepper motor has been stopped
+ *
+ * The last LATENCY_SAMPLES latencies of each stage are kept in RAM. The report
+ * prints the p50, p99 and max latency of every stage over UART0 and checks them
+ * against the budgets below, which can be overridden from the compiler command line.
+ *
+ * The arrival time is the first time the main loop sees the complete command
+ * frame from the UART_BLE driver, so the time the frame takes on the line is not
+ * included. A command that arrives while the main loop is busy is stamped late.
+ */
+
+#include "TM4C123GH6PM.h"
+
+// Number of samples kept per stage
+#define LATENCY_SAMPLES                 32
+
+// Latency budgets in microseconds
+#ifndef LATENCY_BUDGET_UART0_ECHO_US
+#define LATENCY_BUDGET_UART0_ECHO_US    100000
+#endif
+
+#ifndef LATENCY_BUDGET_UART3_FORWARD_US
+#define LATENCY_BUDGET_UART3_FORWARD_US 100000
+#endif
+
+#ifndef LATENCY_BUDGET_FIRST_STEP_US
+#define LATENCY_BUDGET_FIRST_STEP_US    2500000
+#endif
+
+#ifndef LATENCY_BUDGET_MOTOR_STOP_US
+#define LATENCY_BUDGET_MOTOR_STOP_US    2500000
+#endif
+
+typedef enum
+{
+	LATENCY_STAGE_UART0_ECHO,
+	LATENCY_STAGE_UART3_FORWARD,
+	LATENCY_STAGE_FIRST_STEP,
+	LATENCY_STAGE_MOTOR_STOP,
+	LATENCY_STAGE_COUNT
+} Latency_Stage;
+
+/**
+ * @brief Enables the DWT cycle counter and clears the recorded samples.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Latency_Benchmark_Init(void);
+
+/**
+ * @brief Clears the recorded samples.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Latency_Benchmark_Reset(void);
+
+/**
+ * @brief Stamps the arrival of a new BLE command.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Latency_Benchmark_Command_Arrived(void);
+
+/**
+ * @brief Records the latency of a stage for the current command.
+ *
+ * Only the first time a stage is reached after a command arrived is recorded.
+ * It can be called from an interrupt handler.
+ *
+ * @param stage The stage that has been reached.
+ *
+ * @return None
+ */
+void Latency_Benchmark_Mark(Latency_Stage stage);
+
+/**
+ * @brief Records the latency of a stage that was reached at an earlier time.
+ *
+ * It lets deferred work record a stage with the time at which a hard interrupt
+ * handler reached it.
+ *
+ * @param stage The stage that has been reached.
+ * @param cycles The DWT cycle count when the stage was reached.
+ *
+ * @return None
+ */
+void Latency_Benchmark_Mark_At(Latency_Stage stage, uint32_t cycles);
+
+/**
+ * @brief Prints the p50, p99 and max latency of every stage over UART0.
+ *
+ * Each stage line ends with OK or OVER BUDGET, and the last line is either
+ * "LATENCY PASS" or "LATENCY FAIL".
+ *
+ * @param None
+ *
+ * @return 1 if every stage is within its budget, 0 otherwise.
+ */
+uint8_t Latency_Benchmark_Report(void);
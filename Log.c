@@ -0,0 +1,265 @@
+/**
+ * @file Log.c
+ *
+ * @brief Source code for the Log module.
+ *
+ * The transmit buffer is a single-producer, single-consumer ring: the main loop
+ * advances Log_Head after copying a frame in, and the UART0 interrupt handler
+ * advances Log_Tail as it moves bytes into the transmit FIFO. Both indexes count
+ * bytes since reset and are masked when the buffer is accessed.
+ *
+ * The UART0 transmit interrupt fires when the FIFO drains down to the trigger
+ * level, so it is only enabled while the buffer holds bytes. A new frame is started
+ * by filling the FIFO directly.
+ */
+
+#include <stdarg.h>
+#include "Log.h"
+#include "Latency_Benchmark.h"
+#include "UART0.h"
+#include "UART_Stats.h"
+#include "Interrupt_Priorities.h"
+
+extern uint32_t SystemCoreClock;
+
+// TXIM / TXRIS / TXMIS bit of the UART0 IM, RIS, MIS and ICR registers
+#define LOG_UART0_TX_INTERRUPT  0x20
+
+// Sync byte, token, payload length and a payload that fits a one-byte length
+#define LOG_FRAME_MAX           (3 + 127)
+
+#define LOG_MESSAGE(token, level, types, format) types,
+static const char *const Log_Argument_Types[LOG_TOKEN_COUNT] =
+{
+#include "Log_Messages.h"
+};
+#undef LOG_MESSAGE
+
+static uint8_t Log_Buffer[LOG_BUFFER_SIZE];
+
+// Bytes written to the buffer by the main loop
+static volatile uint32_t Log_Head;
+
+// Bytes moved to the UART0 transmit FIFO by the interrupt handler
+static volatile uint32_t Log_Tail;
+
+// Messages dropped since reset, and those not reported with a LOG_DROPPED frame yet
+static uint32_t Log_Dropped_Total;
+static uint32_t Log_Dropped_Unreported;
+
+// Set when the last message written was dropped
+static uint8_t Log_Last_Dropped;
+
+// Set while the echo stage waits for Log_Tail to reach Log_Echo_End
+static volatile uint8_t Log_Echo_Pending;
+static volatile uint32_t Log_Echo_End;
+
+/**
+ * @brief Moves bytes from the buffer to the UART0 transmit FIFO until one of them is full or empty.
+ *
+ * Called from the UART0 interrupt handler, or from the main loop with interrupts disabled.
+ */
+static void Log_Fill_FIFO(void)
+{
+	uint32_t tail = Log_Tail;
+	uint32_t start = tail;
+
+	while (tail != Log_Head && (UART0->FR & UART0_TRANSMIT_FIFO_FULL_BIT_MASK) == 0)
+	{
+		UART0->DR = Log_Buffer[tail & (LOG_BUFFER_SIZE - 1)];
+		tail++;
+	}
+	Log_Tail = tail;
+	UART_Stats_Record_Transmit(UART_STATS_UART0, tail - start);
+
+	if (Log_Echo_Pending && (int32_t)(tail - Log_Echo_End) >= 0)
+	{
+		Log_Echo_Pending = 0;
+		Latency_Benchmark_Mark(LATENCY_STAGE_UART0_ECHO);
+	}
+
+	// Keep the transmit interrupt only while there are bytes left to send
+	if (tail != Log_Head)
+	{
+		UART0->IM |= LOG_UART0_TX_INTERRUPT;
+	}
+	else
+	{
+		UART0->IM &= ~LOG_UART0_TX_INTERRUPT;
+	}
+}
+
+static uint32_t Log_Encode_Varint(uint8_t *frame, uint32_t length, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		frame[length++] = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	frame[length++] = (uint8_t)value;
+
+	return length;
+}
+
+/**
+ * @brief Copies a frame into the buffer and starts sending it, or drops it when it does not fit.
+ */
+static uint8_t Log_Enqueue(const uint8_t *frame, uint32_t length)
+{
+	uint32_t head = Log_Head;
+
+	if (LOG_BUFFER_SIZE - (head - Log_Tail) < length)
+	{
+		return 0;
+	}
+
+	for (uint32_t i = 0; i < length; i++)
+	{
+		Log_Buffer[(head + i) & (LOG_BUFFER_SIZE - 1)] = frame[i];
+	}
+	Log_Head = head + length;
+
+	// Start the transmission if the interrupt handler is idle
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	if ((UART0->IM & LOG_UART0_TX_INTERRUPT) == 0)
+	{
+		Log_Fill_FIFO();
+	}
+	__set_PRIMASK(primask);
+
+	return 1;
+}
+
+void Log_Init(void)
+{
+	Log_Head = 0;
+	Log_Tail = 0;
+	Log_Dropped_Total = 0;
+	Log_Dropped_Unreported = 0;
+
+	NVIC_SetPriority(UART0_IRQn, INTERRUPT_PRIORITY_UART0);
+	NVIC_EnableIRQ(UART0_IRQn);
+
+	LOG(LOG_BOOT, SystemCoreClock);
+}
+
+void Log_Write(Log_Token token, ...)
+{
+	uint8_t frame[LOG_FRAME_MAX];
+	uint32_t length = 3;
+	const char *types = Log_Argument_Types[token];
+	va_list arguments;
+
+	// The buffer has a single producer, the main loop
+	if (__get_IPSR() != 0)
+	{
+		Log_Last_Dropped = 1;
+		Log_Dropped_Total++;
+		Log_Dropped_Unreported++;
+		return;
+	}
+
+	// Report the messages dropped earlier once there is room again
+	if (Log_Dropped_Unreported > 0)
+	{
+		uint8_t report[3 + 5];
+		uint32_t report_length = Log_Encode_Varint(report, 3, Log_Dropped_Unreported);
+
+		report[0] = LOG_FRAME_SYNC;
+		report[1] = (uint8_t)LOG_DROPPED;
+		report[2] = (uint8_t)(report_length - 3);
+
+		if (Log_Enqueue(report, report_length))
+		{
+			Log_Dropped_Unreported = 0;
+		}
+	}
+
+	frame[0] = LOG_FRAME_SYNC;
+	frame[1] = (uint8_t)token;
+
+	va_start(arguments, token);
+	for (; *types; types++)
+	{
+		if (*types == 's')
+		{
+			const char *string = va_arg(arguments, const char *);
+			uint32_t string_length = 0;
+
+			while (string[string_length] && string_length < LOG_STRING_MAX)
+			{
+				string_length++;
+			}
+
+			length = Log_Encode_Varint(frame, length, string_length);
+			for (uint32_t i = 0; i < string_length; i++)
+			{
+				frame[length++] = (uint8_t)string[i];
+			}
+		}
+		else if (*types == 'd')
+		{
+			int32_t value = va_arg(arguments, int32_t);
+			length = Log_Encode_Varint(frame, length, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+		}
+		else
+		{
+			length = Log_Encode_Varint(frame, length, va_arg(arguments, uint32_t));
+		}
+	}
+	va_end(arguments);
+
+	frame[2] = (uint8_t)(length - 3);
+
+	Log_Last_Dropped = !Log_Enqueue(frame, length);
+	if (Log_Last_Dropped)
+	{
+		Log_Dropped_Total++;
+		Log_Dropped_Unreported++;
+	}
+}
+
+void Log_Mark_Echo(void)
+{
+	if (Log_Last_Dropped)
+	{
+		return;
+	}
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	// The frame ends at Log_Head, it may already be in the FIFO
+	if ((int32_t)(Log_Tail - Log_Head) >= 0)
+	{
+		Latency_Benchmark_Mark(LATENCY_STAGE_UART0_ECHO);
+	}
+	else
+	{
+		Log_Echo_End = Log_Head;
+		Log_Echo_Pending = 1;
+	}
+
+	__set_PRIMASK(primask);
+}
+
+void Log_Flush(void)
+{
+	while (Log_Tail != Log_Head);
+}
+
+uint32_t Log_Dropped_Count(void)
+{
+	return Log_Dropped_Total;
+}
+
+void UART0_Handler(void)
+{
+	if (UART0->MIS & LOG_UART0_TX_INTERRUPT)
+	{
+		// Acknowledge the transmit interrupt and refill the FIFO
+		UART0->ICR = LOG_UART0_TX_INTERRUPT;
+		Log_Fill_FIFO();
+	}
+}
@@ -0,0 +1,131 @@
+/**
+ * @file Log.h
+ *
+ * @brief Header file for the Log module.
+ *
+ * This module replaces the text messages of the main loop on UART0 with tokenized
+ * frames. A message is written with the LOG macro and the token of its entry in
+ * Log_Messages.h:
+ *
+ *     LOG(LOG_BLE_COMMAND, UART_BLE_Buffer, string_size);
+ *
+ * The format string never reaches the firmware. Log_Write encodes the token and the
+ * raw arguments into a frame, copies it into a RAM buffer and returns; the UART0
+ * transmit interrupt sends the buffer in the background. When the buffer is full the
+ * message is dropped and counted, so logging never blocks the main loop.
+ *
+ * Frame format (integers are LEB128 varints, signed ones zigzag encoded first):
+ *
+ *     0xFE <token> <payload length> <argument> ...
+ *
+ * Strings are sent as a varint length followed by the characters. Text written with
+ * the UART0_Output functions (the LATENCY, PROFILE and TRACE reports) still goes out
+ * as ASCII between the frames, and tools/log_decode.py passes it through.
+ *
+ * Messages below LOG_LEVEL are removed at compile time together with their arguments.
+ *
+ * @note Log only from the main loop. UART0_Output_Character waits for the pending
+ * frames to be sent so that text is never written into the middle of one.
+ */
+
+#include "TM4C123GH6PM.h"
+
+#define LOG_LEVEL_ERROR         1
+#define LOG_LEVEL_WARNING       2
+#define LOG_LEVEL_INFO          3
+#define LOG_LEVEL_DEBUG         4
+
+// Messages with a level above this one are compiled out
+#ifndef LOG_LEVEL
+#define LOG_LEVEL               LOG_LEVEL_INFO
+#endif
+
+// Size of the transmit buffer in bytes, must be a power of two
+#ifndef LOG_BUFFER_SIZE
+#define LOG_BUFFER_SIZE         256
+#endif
+
+#if (LOG_BUFFER_SIZE & (LOG_BUFFER_SIZE - 1)) != 0
+#error "LOG_BUFFER_SIZE must be a power of two"
+#endif
+
+// Longest string argument sent, longer ones are truncated
+#define LOG_STRING_MAX          48
+
+// First byte of every frame, never sent by the text output
+#define LOG_FRAME_SYNC          0xFE
+
+#define LOG_MESSAGE(token, level, types, format) token,
+typedef enum
+{
+#include "Log_Messages.h"
+	LOG_TOKEN_COUNT
+} Log_Token;
+#undef LOG_MESSAGE
+
+// Level of each message, used to compile out the messages above LOG_LEVEL
+#define LOG_MESSAGE(token, level, types, format) token##_LEVEL = level,
+enum
+{
+#include "Log_Messages.h"
+};
+#undef LOG_MESSAGE
+
+#define LOG(token, ...) \
+	do { if (token##_LEVEL <= LOG_LEVEL) { Log_Write(token, ##__VA_ARGS__); } } while (0)
+
+/**
+ * @brief Enables the UART0 transmit interrupt that sends the log frames.
+ *
+ * UART0_Init must be called first.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Log_Init(void);
+
+/**
+ * @brief Encodes a message and queues it for transmission without waiting.
+ *
+ * Use the LOG macro instead of calling this function directly.
+ *
+ * @param token The message from Log_Messages.h.
+ *
+ * @param ... The arguments of the message, in the order of its argument types.
+ *
+ * @return None
+ */
+void Log_Write(Log_Token token, ...);
+
+/**
+ * @brief Records the UART0 echo stage of Latency_Benchmark once the last message
+ * written has been moved to the UART0 transmit FIFO.
+ *
+ * The stage is recorded by the UART0 interrupt handler when the frames queued before
+ * the message are still being sent, or at once when it is already in the FIFO.
+ * Nothing is recorded when the last message was dropped.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Log_Mark_Echo(void);
+
+/**
+ * @brief Waits until every queued frame has been written to the UART0 transmit FIFO.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Log_Flush(void);
+
+/**
+ * @brief Returns the number of messages dropped because the buffer was full.
+ *
+ * @param None
+ *
+ * @return The number of dropped messages since reset.
+ */
+uint32_t Log_Dropped_Count(void);
@@ -0,0 +1,34 @@
+/**
+ * @file Log_Messages.h
+ *
+ * @brief Dictionary of the tokenized log messages.
+ *
+ * Each line is LOG_MESSAGE(token, level, argument types, format). The firmware only
+ * keeps the token, the level and the argument types; the format strings stay on the
+ * host, where tools/log_dictionary.py turns this file into log_dictionary.json at
+ * build time and tools/log_decode.py prints the messages with them.
+ *
+ * Argument types, one character per conversion of the format:
+ *  - u: unsigned 32-bit integer (%u or %x)
+ *  - d: signed 32-bit integer (%d)
+ *  - s: null-terminated string (%s), truncated to LOG_STRING_MAX characters
+ *
+ * The arguments of a message must fit in 127 bytes, which leaves room for two strings.
+ *
+ * Tokens are numbered in the order of this file. Add new messages at the end so that
+ * captures taken with an older firmware still decode.
+ *
+ * @note This file is included several times on purpose, with a different LOG_MESSAGE each time.
+ */
+
+LOG_MESSAGE(LOG_BOOT,              LOG_LEVEL_INFO,    "u",  "Music box started, core clock %u Hz")
+LOG_MESSAGE(LOG_BLE_COMMAND,       LOG_LEVEL_INFO,    "su", "UART BLE Data: %s (%u characters)")
+LOG_MESSAGE(LOG_UART3_LINE,        LOG_LEVEL_INFO,    "s",  "UART3 Data: %s")
+LOG_MESSAGE(LOG_BLE_RESET_COMMAND, LOG_LEVEL_INFO,    "",   "UART BLE Reset Command Issued")
+LOG_MESSAGE(LOG_BLE_RESPONSE,      LOG_LEVEL_INFO,    "",   "UART BLE Response Received")
+LOG_MESSAGE(LOG_DROPPED,           LOG_LEVEL_WARNING, "u",  "%u log messages were dropped, the log buffer was full")
+LOG_MESSAGE(LOG_BLE_AT_TIMEOUT,    LOG_LEVEL_WARNING, "s",  "UART BLE AT command timed out: %s")
+LOG_MESSAGE(LOG_BLE_READY,         LOG_LEVEL_INFO,    "uu", "UART BLE ready %u ms after boot (AT status %u)")
+LOG_MESSAGE(LOG_STACK_LOW,         LOG_LEVEL_WARNING, "uu", "Stack peak %u of %u bytes, the stack is nearly full")
+LOG_MESSAGE(LOG_EEPROM_FAILED,     LOG_LEVEL_WARNING, "",   "EEPROM could not recover from a power loss, the settings are not saved")
+LOG_MESSAGE(LOG_ARDUINO_READY,     LOG_LEVEL_INFO,    "u",  "Arduino ready %u ms after boot")
@@ -0,0 +1,200 @@
+/**
+ * @file Number_Format.c
+ *
+ * @brief Source code for the Number_Format module.
+ *
+ * The length of a decimal number is found first by comparing it with the powers of
+ * ten, then the digits are written from the end of the buffer backwards. Dividing by
+ * 100 is done with the reciprocal 0x51EB851F / 2^37, which is exact for every 32-bit
+ * value, so the conversion takes a UMULL per digit pair even when the compiler does not
+ * optimize (the Keil project builds at -O0). Dividing by 10 uses 0xCCCCCCCD / 2^35
+ * the same way.
+ */
+
+#include "Number_Format.h"
+#include "UART0.h"
+#include "UART_BLE.h"
+
+static const char Format_Digit_Pairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static const uint32_t Format_Powers_Of_Ten[9] =
+{
+	10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+static const char Format_Hexadecimal_Digits[16] =
+{
+	'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
+};
+
+static uint8_t Format_Count_Digits(uint32_t value)
+{
+	uint8_t digits = 1;
+
+	while (digits < 10 && value >= Format_Powers_Of_Ten[digits - 1])
+	{
+		digits++;
+	}
+
+	return digits;
+}
+
+/**
+ * @brief Writes the last digits of a value backwards, ending just before end.
+ *
+ * Exactly digits characters are written, with leading zeros when the value is shorter.
+ */
+static void Format_Write_Digits(char *end, uint32_t value, uint8_t digits)
+{
+	while (digits >= 2)
+	{
+		uint32_t quotient = (uint32_t)(((uint64_t)value * 0x51EB851FU) >> 37);
+		uint32_t pair = (value - quotient * 100) * 2;
+
+		end -= 2;
+		end[0] = Format_Digit_Pairs[pair];
+		end[1] = Format_Digit_Pairs[pair + 1];
+		value = quotient;
+		digits -= 2;
+	}
+
+	if (digits)
+	{
+		uint32_t quotient = (uint32_t)(((uint64_t)value * 0xCCCCCCCDU) >> 35);
+		end[-1] = (char)('0' + (value - quotient * 10));
+	}
+}
+
+uint8_t Format_Unsigned_Decimal(char *buffer, uint32_t value)
+{
+	uint8_t digits = Format_Count_Digits(value);
+
+	Format_Write_Digits(buffer + digits, value, digits);
+	buffer[digits] = 0;
+
+	return digits;
+}
+
+uint8_t Format_Signed_Decimal(char *buffer, int32_t value)
+{
+	if (value < 0)
+	{
+		buffer[0] = '-';
+
+		// 0 - value in unsigned arithmetic also works for -2147483648
+		return 1 + Format_Unsigned_Decimal(buffer + 1, 0U - (uint32_t)value);
+	}
+
+	return Format_Unsigned_Decimal(buffer, (uint32_t)value);
+}
+
+uint8_t Format_Hexadecimal(char *buffer, uint32_t value, uint8_t min_digits)
+{
+	// Four bits per digit, rounded up, and at least one digit for zero
+	uint8_t digits = (uint8_t)((32 - __CLZ(value) + 3) / 4);
+
+	if (min_digits > 8)
+	{
+		min_digits = 8;
+	}
+	if (digits < min_digits)
+	{
+		digits = min_digits;
+	}
+	if (digits == 0)
+	{
+		digits = 1;
+	}
+
+	buffer[digits] = 0;
+	for (int i = digits - 1; i >= 0; i--)
+	{
+		buffer[i] = Format_Hexadecimal_Digits[value & 0x0F];
+		value >>= 4;
+	}
+
+	return digits;
+}
+
+uint8_t Format_Fixed_Point(char *buffer, int32_t value, uint8_t fraction_digits)
+{
+	uint8_t length = 0;
+	uint32_t magnitude = (uint32_t)value;
+
+	if (fraction_digits > 9)
+	{
+		fraction_digits = 9;
+	}
+
+	if (value < 0)
+	{
+		buffer[length++] = '-';
+		magnitude = 0U - (uint32_t)value;
+	}
+
+	if (fraction_digits == 0)
+	{
+		return length + Format_Unsigned_Decimal(buffer + length, magnitude);
+	}
+
+	// At least one digit before the point: 5 with 3 fraction digits is "0.005"
+	uint8_t digits = Format_Count_Digits(magnitude);
+	if (digits < fraction_digits + 1)
+	{
+		digits = fraction_digits + 1;
+	}
+
+	uint8_t integer_digits = digits - fraction_digits;
+	char *point = buffer + length + integer_digits;
+
+	Format_Write_Digits(point + 1 + fraction_digits, magnitude, fraction_digits);
+
+	// The digits left of the point are the quotient by 10^fraction_digits
+	Format_Write_Digits(point, magnitude / Format_Powers_Of_Ten[fraction_digits - 1], integer_digits);
+	*point = '.';
+
+	length += digits + 1;
+	buffer[length] = 0;
+
+	return length;
+}
+
+char *Format_Append(char *end, const char *limit, const char *text)
+{
+	// The last byte of the buffer is kept for the null terminator
+	while (*text && end < limit - 1)
+	{
+		*end++ = *text++;
+	}
+	*end = 0;
+
+	return end;
+}
+
+char *Format_Append_Field(char *end, const char *limit, const char *name, uint32_t value)
+{
+	char number[FORMAT_DECIMAL_SIZE];
+
+	Format_Unsigned_Decimal(number, value);
+	end = Format_Append(end, limit, name);
+	return Format_Append(end, limit, number);
+}
+
+void Format_Report_Line(char *line)
+{
+	UART0_Output_String(line);
+	UART0_Output_Newline();
+
+	UART_BLE_Output_String(line);
+	UART_BLE_Output_String("\n");
+}
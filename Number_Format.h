@@ -0,0 +1,112 @@
+/**
+ * @file Number_Format.h
+ *
+ * @brief Header file for the Number_Format module.
+ *
+ * This module converts integers to ASCII in a buffer provided by the caller, so that
+ * a UART driver can send a number with a single string write. The conversions do not
+ * recurse and do not divide per digit: decimal digits are produced two at a time from a table
+ * of digit pairs, using a multiplication by the reciprocal of 100, and hexadecimal
+ * digits with shifts.
+ *
+ * Every conversion writes a null-terminated string and returns its length.
+ *
+ * The report lines of the other modules ("STATS ...", "IDLE ...") are built with
+ * Format_Append and Format_Append_Field, which stop at the end of the line buffer, and
+ * sent with Format_Report_Line.
+ */
+
+#include "TM4C123GH6PM.h"
+
+// Buffer sizes, including the null terminator
+#define FORMAT_DECIMAL_SIZE         12      // "-2147483648" or "4294967295"
+#define FORMAT_HEXADECIMAL_SIZE     9       // "FFFFFFFF"
+#define FORMAT_FIXED_POINT_SIZE     13      // "-2.147483648"
+
+/**
+ * @brief Writes an unsigned number in decimal.
+ *
+ * @param buffer The destination, at least FORMAT_DECIMAL_SIZE bytes.
+ *
+ * @param value The number to convert.
+ *
+ * @return The number of characters written, without the null terminator.
+ */
+uint8_t Format_Unsigned_Decimal(char *buffer, uint32_t value);
+
+/**
+ * @brief Writes a signed number in decimal, with a '-' sign when it is negative.
+ *
+ * @param buffer The destination, at least FORMAT_DECIMAL_SIZE bytes.
+ *
+ * @param value The number to convert.
+ *
+ * @return The number of characters written, without the null terminator.
+ */
+uint8_t Format_Signed_Decimal(char *buffer, int32_t value);
+
+/**
+ * @brief Writes an unsigned number in uppercase hexadecimal, without a prefix.
+ *
+ * @param buffer The destination, at least FORMAT_HEXADECIMAL_SIZE bytes.
+ *
+ * @param value The number to convert.
+ *
+ * @param min_digits The minimum number of digits, padded with zeros (1 to 8).
+ *
+ * @return The number of characters written, without the null terminator.
+ */
+uint8_t Format_Hexadecimal(char *buffer, uint32_t value, uint8_t min_digits);
+
+/**
+ * @brief Writes a signed fixed-point number in decimal.
+ *
+ * The value is the number multiplied by 10^fraction_digits, for example
+ * (12345, 2) gives "123.45" and (-5, 3) gives "-0.005".
+ *
+ * @param buffer The destination, at least FORMAT_FIXED_POINT_SIZE bytes.
+ *
+ * @param value The scaled number to convert.
+ *
+ * @param fraction_digits The number of digits after the decimal point (0 to 9).
+ *
+ * @return The number of characters written, without the null terminator.
+ */
+uint8_t Format_Fixed_Point(char *buffer, int32_t value, uint8_t fraction_digits);
+
+/**
+ * @brief Appends text to a line, as much of it as fits.
+ *
+ * @param end The null terminator of the line, or its first character when it is empty.
+ *
+ * @param limit The end of the line buffer, one past its last byte.
+ *
+ * @param text The text to append.
+ *
+ * @return The new null terminator of the line.
+ */
+char *Format_Append(char *end, const char *limit, const char *text);
+
+/**
+ * @brief Appends a name and an unsigned number in decimal to a line, as much of them as fits.
+ *
+ * @param end The null terminator of the line, or its first character when it is empty.
+ *
+ * @param limit The end of the line buffer, one past its last byte.
+ *
+ * @param name The text written before the number, such as " in ".
+ *
+ * @param value The number.
+ *
+ * @return The new null terminator of the line.
+ */
+char *Format_Append_Field(char *end, const char *limit, const char *name, uint32_t value);
+
+/**
+ * @brief Sends a report line to the serial terminal (UART0) and to the phone (BLE).
+ *
+ * @param line The null-terminated line, without its line ending.
+ *
+ * @return None
+ */
+void Format_Report_Line(char *line);
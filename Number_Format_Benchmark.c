@@ -0,0 +1,188 @@
+/**
+ * @file Number_Format_Benchmark.c
+ *
+ * @brief Source code for the Number_Format_Benchmark module.
+ *
+ * The recursive conversions below are copies of the former UART0_Output_Unsigned_Decimal
+ * and UART0_Output_Unsigned_Hexadecimal with UART0_Output_Character replaced by a write
+ * to RAM. The recursive decimal version takes an int, so the decimal test values stay
+ * below 2^31.
+ */
+
+#include <string.h>
+#include "Number_Format_Benchmark.h"
+#include "Number_Format.h"
+#include "UART0.h"
+
+// Each value is converted this many times and the average is reported
+#define FORMAT_BENCHMARK_REPEAT     4
+
+static const uint32_t Format_Benchmark_Values[] =
+{
+	0, 7, 42, 999, 4080, 65535, 115200, 1000000, 9600000, 50000000, 123456789, 2147483647
+};
+
+#define FORMAT_BENCHMARK_VALUE_COUNT (sizeof(Format_Benchmark_Values) / sizeof(Format_Benchmark_Values[0]))
+
+static char Format_Benchmark_Output[FORMAT_DECIMAL_SIZE];
+static uint8_t Format_Benchmark_Length;
+
+static void Format_Benchmark_Output_Character(char data)
+{
+	Format_Benchmark_Output[Format_Benchmark_Length++] = data;
+}
+
+static void Format_Benchmark_Recursive_Decimal(int n)
+{
+	if (n >= 10)
+	{
+		Format_Benchmark_Recursive_Decimal(n / 10);
+		n = n % 10;
+	}
+
+	Format_Benchmark_Output_Character(n + '0');
+}
+
+static void Format_Benchmark_Recursive_Hexadecimal(uint32_t number)
+{
+	if (number >= 0x10)
+	{
+		Format_Benchmark_Recursive_Hexadecimal(number / 0x10);
+		Format_Benchmark_Recursive_Hexadecimal(number % 0x10);
+	}
+	else
+	{
+		if (number < 0xA)
+		{
+			Format_Benchmark_Output_Character(number + '0');
+		}
+		else
+		{
+			Format_Benchmark_Output_Character((number - 0x0A) + 'A');
+		}
+	}
+}
+
+/**
+ * @brief Prints one report line and returns 1 when both versions gave the same text for every value.
+ */
+static uint8_t Format_Benchmark_Compare(char *name, uint8_t hexadecimal)
+{
+	char buffer[FORMAT_FIXED_POINT_SIZE];
+	uint32_t recursive_cycles = 0;
+	uint32_t new_cycles = 0;
+	uint8_t matched = 1;
+
+	for (uint32_t i = 0; i < FORMAT_BENCHMARK_VALUE_COUNT; i++)
+	{
+		uint32_t value = Format_Benchmark_Values[i];
+
+		for (int repeat = 0; repeat < FORMAT_BENCHMARK_REPEAT; repeat++)
+		{
+			uint32_t primask = __get_PRIMASK();
+			__disable_irq();
+
+			Format_Benchmark_Length = 0;
+			uint32_t start = DWT->CYCCNT;
+			if (hexadecimal)
+			{
+				Format_Benchmark_Recursive_Hexadecimal(value);
+			}
+			else
+			{
+				Format_Benchmark_Recursive_Decimal((int)value);
+			}
+			uint32_t middle = DWT->CYCCNT;
+			if (hexadecimal)
+			{
+				Format_Hexadecimal(buffer, value, 1);
+			}
+			else
+			{
+				Format_Unsigned_Decimal(buffer, value);
+			}
+			uint32_t end = DWT->CYCCNT;
+
+			__set_PRIMASK(primask);
+
+			recursive_cycles += middle - start;
+			new_cycles += end - middle;
+
+			Format_Benchmark_Output[Format_Benchmark_Length] = 0;
+			if (strcmp(buffer, Format_Benchmark_Output) != 0)
+			{
+				matched = 0;
+			}
+		}
+	}
+
+	uint32_t samples = FORMAT_BENCHMARK_VALUE_COUNT * FORMAT_BENCHMARK_REPEAT;
+	recursive_cycles /= samples;
+	new_cycles /= samples;
+
+	UART0_Output_String("FORMAT ");
+	UART0_Output_String(name);
+	UART0_Output_Character(' ');
+	UART0_Output_Unsigned_Decimal(recursive_cycles);
+	UART0_Output_Character(' ');
+	UART0_Output_Unsigned_Decimal(new_cycles);
+	UART0_Output_Character(' ');
+
+	// Speedup with one decimal, printed with the fixed-point conversion
+	Format_Fixed_Point(buffer, (int32_t)((recursive_cycles * 10) / ((new_cycles > 0) ? new_cycles : 1)), 1);
+	UART0_Output_String(buffer);
+	UART0_Output_Character('x');
+	UART0_Output_Newline();
+
+	return matched;
+}
+
+/**
+ * @brief Checks the conversions that have no recursive counterpart against known strings.
+ */
+static uint8_t Format_Benchmark_Check_Variants(void)
+{
+	char buffer[FORMAT_FIXED_POINT_SIZE];
+	uint8_t matched = 1;
+
+	Format_Unsigned_Decimal(buffer, 4294967295U);
+	matched &= (strcmp(buffer, "4294967295") == 0);
+
+	Format_Signed_Decimal(buffer, -2147483647 - 1);
+	matched &= (strcmp(buffer, "-2147483648") == 0);
+
+	Format_Hexadecimal(buffer, 0xAB, 4);
+	matched &= (strcmp(buffer, "00AB") == 0);
+
+	Format_Fixed_Point(buffer, 12345, 2);
+	matched &= (strcmp(buffer, "123.45") == 0);
+
+	Format_Fixed_Point(buffer, -5, 3);
+	matched &= (strcmp(buffer, "-0.005") == 0);
+
+	return matched;
+}
+
+uint8_t Number_Format_Benchmark_Run(void)
+{
+	uint8_t passed = 1;
+
+	UART0_Output_String("FORMAT conversion recursive_cycles new_cycles speedup");
+	UART0_Output_Newline();
+
+	passed &= Format_Benchmark_Compare("decimal", 0);
+	passed &= Format_Benchmark_Compare("hexadecimal", 1);
+	passed &= Format_Benchmark_Check_Variants();
+
+	if (passed)
+	{
+		UART0_Output_String("FORMAT PASS");
+	}
+	else
+	{
+		UART0_Output_String("FORMAT FAIL");
+	}
+	UART0_Output_Newline();
+
+	return passed;
+}
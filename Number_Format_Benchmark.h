@@ -0,0 +1,34 @@
+/**
+ * @file Number_Format_Benchmark.h
+ *
+ * @brief Header file for the Number_Format_Benchmark module.
+ *
+ * This module compares the Number_Format conversions with the recursive ones the UART
+ * drivers used before (one call, one division and one character per digit). Both
+ * write into RAM so that only the conversion is measured, not the UART. Each conversion
+ * is timed with the DWT cycle counter and interrupts disabled, and the outputs of the
+ * two versions are compared.
+ *
+ * The report is printed over UART0:
+ *
+ *     FORMAT conversion recursive_cycles new_cycles speedup
+ *     FORMAT decimal <average cycles> <average cycles> <ratio>x
+ *     FORMAT hexadecimal <average cycles> <average cycles> <ratio>x
+ *     FORMAT PASS | FORMAT FAIL
+ *
+ * @note The simulator only charges cycles for register accesses, so it checks the
+ * outputs but the cycle counts are only meaningful on the board.
+ */
+
+#include "TM4C123GH6PM.h"
+
+/**
+ * @brief Runs the benchmark and prints the report over UART0.
+ *
+ * The DWT cycle counter must be running (Latency_Benchmark_Init or Profiler_Init).
+ *
+ * @param None
+ *
+ * @return 1 if the new conversions produced the same text as the recursive ones, 0 otherwise.
+ */
+uint8_t Number_Format_Benchmark_Run(void);
@@ -0,0 +1,136 @@
+/**
+ * @file Power_Idle.c
+ *
+ * @brief Source code for the Power_Idle module.
+ *
+ * The sleep time is measured with SysTick_Uptime_us, since SysTick runs from PIOSC
+ * while the core sleeps. When SysTick is the only interrupt pending after WFI, it woke
+ * the core, and its count since the reload is the wake-up latency. The wake-up service
+ * time is measured with the DWT cycle counter, started by Latency_Benchmark_Init.
+ */
+
+#include "Power_Idle.h"
+#include "SysTick_Delay.h"
+#include "Number_Format.h"
+
+extern uint32_t SystemCoreClock;
+
+#define POWER_IDLE_LINE_SIZE    128
+
+// Automatic clock gating: use the SCGC registers in sleep mode
+#define SYSCTL_RCC_ACG          0x08000000
+
+static Power_Idle_Counters Power_Idle_Stats;
+static uint32_t Power_Idle_Start_ms;
+
+void Power_Idle_Init(void)
+{
+	// Sleep, not deep-sleep, so the UARTs keep the system clock
+	SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+	SYSCTL->SCGCUART = POWER_IDLE_SLEEP_UART;
+	SYSCTL->SCGCTIMER = POWER_IDLE_SLEEP_TIMER;
+	SYSCTL->SCGCGPIO = POWER_IDLE_SLEEP_GPIO;
+	SYSCTL->RCC |= SYSCTL_RCC_ACG;
+
+	Power_Idle_Reset();
+}
+
+void Power_Idle_Sleep(void)
+{
+	uint32_t sleep_start = SysTick_Uptime_us();
+
+	__WFI();
+
+	// Read first: the count goes on until the handler runs
+	uint32_t systick_ticks = SysTick->VAL;
+	uint32_t icsr = SCB->ICSR;
+
+	uint32_t sleep_end = SysTick_Uptime_us();
+	uint32_t wake_cycles = DWT->CYCCNT;
+
+	if ((icsr & SCB_ICSR_PENDSTSET_Msk) && !(icsr & SCB_ICSR_ISRPENDING_Msk))
+	{
+		uint32_t latency = (SYSTICK_TICKS_PER_MS - 1 - systick_ticks) * (SystemCoreClock / 1000) / SYSTICK_TICKS_PER_MS;
+
+		Power_Idle_Stats.timed_wake_ups++;
+		Power_Idle_Stats.latency_total_cycles += latency;
+
+		if (latency > Power_Idle_Stats.latency_max_cycles)
+		{
+			Power_Idle_Stats.latency_max_cycles = latency;
+		}
+	}
+
+	// Serve the interrupts that woke the core
+	__enable_irq();
+	__disable_irq();
+
+	uint32_t service = DWT->CYCCNT - wake_cycles;
+
+	Power_Idle_Stats.sleep_us += sleep_end - sleep_start;
+	Power_Idle_Stats.wake_ups++;
+	Power_Idle_Stats.service_total_cycles += service;
+
+	if (service > Power_Idle_Stats.service_max_cycles)
+	{
+		Power_Idle_Stats.service_max_cycles = service;
+	}
+}
+
+void Power_Idle_Get(Power_Idle_Counters *counters)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	*counters = Power_Idle_Stats;
+	counters->elapsed_ms = SysTick_Uptime_ms() - Power_Idle_Start_ms;
+
+	__set_PRIMASK(primask);
+}
+
+void Power_Idle_Reset(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	Power_Idle_Stats = (Power_Idle_Counters){ 0 };
+	Power_Idle_Start_ms = SysTick_Uptime_ms();
+
+	__set_PRIMASK(primask);
+}
+
+void Power_Idle_Report(void)
+{
+	Power_Idle_Counters counters;
+	char line[POWER_IDLE_LINE_SIZE];
+	char *limit = line + sizeof(line);
+	char *end = line;
+	char percent[FORMAT_FIXED_POINT_SIZE];
+
+	Power_Idle_Get(&counters);
+
+	// Share of the time asleep in tenths of a percent
+	uint64_t elapsed_us = (uint64_t)counters.elapsed_ms * 1000;
+	uint32_t idle_permille = elapsed_us ? (uint32_t)((counters.sleep_us * 1000) / elapsed_us) : 0;
+	uint32_t latency_average = counters.timed_wake_ups ? (uint32_t)(counters.latency_total_cycles / counters.timed_wake_ups) : 0;
+	uint32_t service_average = counters.wake_ups ? (uint32_t)(counters.service_total_cycles / counters.wake_ups) : 0;
+
+	if (idle_permille > 1000)
+	{
+		idle_permille = 1000;
+	}
+
+	Format_Fixed_Point(percent, idle_permille, 1);
+
+	end = Format_Append(end, limit, "IDLE ");
+	end = Format_Append(end, limit, percent);
+	end = Format_Append_Field(end, limit, "% of ", counters.elapsed_ms);
+	end = Format_Append_Field(end, limit, " ms wakes ", counters.wake_ups);
+	end = Format_Append_Field(end, limit, " latency avg ", latency_average);
+	end = Format_Append_Field(end, limit, " max ", counters.latency_max_cycles);
+	end = Format_Append_Field(end, limit, " service avg ", service_average);
+	end = Format_Append_Field(end, limit, " max ", counters.service_max_cycles);
+
+	Format_Report_Line(line);
+}
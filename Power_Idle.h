@@ -0,0 +1,95 @@
+/**
+ * @file Power_Idle.h
+ *
+ * @brief Header file for the Power_Idle module.
+ *
+ * This module puts the core to sleep with WFI when the main loop has nothing to do,
+ * and during SysTick_Delay1ms. Any enabled interrupt wakes it up: the UART1 and UART3
+ * receive interrupts, the UART1 idle timer, the UART0 transmit interrupt, Timer 0A while
+ * the motor runs and SysTick every 1 ms.
+ *
+ * The core uses sleep mode, not deep-sleep: the UARTs are clocked by the system clock
+ * and must keep receiving. With the ACG bit of RCC set, the SCGC registers select the
+ * peripherals that keep their clock during sleep; the others are gated.
+ *
+ * The module records the share of the time spent asleep, the wake-up latency and the
+ * wake-up service time. The latency is the time from the interrupt to the core running
+ * again after WFI. The DWT cycle counter stops while the core sleeps, so the latency is
+ * taken from the SysTick count since its reload, for the wakes by SysTick alone, to
+ * one SysTick tick (12.5 cycles at 50 MHz). The service time is the cycles the
+ * interrupts that woke the core take to run before the main loop goes on. The BLE
+ * command "IDLE" sends them to the phone and to UART0, and "IDLE RESET" clears them:
+ *
+ *     IDLE <percent>% of <ms> ms wakes <n> latency avg <cycles> max <cycles> service avg <cycles> max <cycles>
+ */
+
+#include "TM4C123GH6PM.h"
+
+// Peripherals that keep their clock in sleep mode
+#define POWER_IDLE_SLEEP_UART     0x0B    // UART0, UART1 and UART3
+#define POWER_IDLE_SLEEP_TIMER    0x03    // Timer 0 (stepper motor) and Timer 1 (BLE idle)
+#define POWER_IDLE_SLEEP_GPIO     0x07    // Ports A, B and C, which carry the UART pins
+
+typedef struct
+{
+	uint32_t elapsed_ms;
+	uint64_t sleep_us;
+	uint32_t wake_ups;
+	uint32_t timed_wake_ups;
+	uint64_t latency_total_cycles;
+	uint32_t latency_max_cycles;
+	uint64_t service_total_cycles;
+	uint32_t service_max_cycles;
+} Power_Idle_Counters;
+
+/**
+ * @brief Selects sleep mode and the peripherals that are clocked while the core sleeps.
+ *
+ * Must be called after the drivers have been initialized.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Power_Idle_Init(void);
+
+/**
+ * @brief Sleeps until an interrupt, then serves it.
+ *
+ * Must be called with interrupts disabled, after checking that there is nothing to do:
+ * an interrupt that arrives after the check is still pending and ends the sleep at once.
+ * Interrupts are enabled to serve the ones that woke the core, and are disabled again
+ * on return.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Power_Idle_Sleep(void);
+
+/**
+ * @brief Returns the counters since the last reset.
+ *
+ * @param counters Filled with a copy of the counters.
+ *
+ * @return None
+ */
+void Power_Idle_Get(Power_Idle_Counters *counters);
+
+/**
+ * @brief Clears the counters.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Power_Idle_Reset(void);
+
+/**
+ * @brief Sends the IDLE line to UART0 and to the phone.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Power_Idle_Report(void);
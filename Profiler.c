@@ -0,0 +1,151 @@
+/**
+ * @file Profiler.c
+ *
+ * @brief Source code for the Profiler module.
+ *
+ * The statistics of a scope are only written by the context that records it, so
+ * Profiler_Record does not need to disable interrupts. The report copies the
+ * summary of each scope with interrupts disabled so that the count, min, max and
+ * total printed on a line belong together.
+ */
+
+#include "Profiler.h"
+#include "UART0.h"
+
+extern uint32_t SystemCoreClock;
+
+typedef struct
+{
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t total;
+	uint32_t bins[PROFILER_BINS];
+} Profiler_Statistics;
+
+static const char *const Profiler_Scope_Names[PROFILER_SCOPE_COUNT] =
+{
+	"timer0a_handler",
+	"systick_handler",
+	"uart_ble_input_string",
+	"process_uart_ble_data",
+	"uart0_output_string",
+	"uart3_output_string",
+	"uart_ble_output_string"
+};
+
+static Profiler_Statistics Profiler_Scopes[PROFILER_SCOPE_COUNT];
+
+void Profiler_Init(void)
+{
+	// Enable the DWT unit by setting the TRCENA bit (Bit 24) in the DEMCR register
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+
+	// Start the cycle counter by setting the CYCCNTENA bit (Bit 0), it may already be running
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	Profiler_Reset();
+}
+
+void Profiler_Reset(void)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+
+	for (int scope = 0; scope < PROFILER_SCOPE_COUNT; scope++)
+	{
+		Profiler_Statistics *statistics = &Profiler_Scopes[scope];
+
+		statistics->count = 0;
+		statistics->min = 0xFFFFFFFF;
+		statistics->max = 0;
+		statistics->total = 0;
+
+		for (int bin = 0; bin < PROFILER_BINS; bin++)
+		{
+			statistics->bins[bin] = 0;
+		}
+	}
+
+	__set_PRIMASK(primask);
+}
+
+void Profiler_Record(Profiler_Scope scope, uint32_t cycles)
+{
+	Profiler_Statistics *statistics = &Profiler_Scopes[scope];
+
+	// The bin is the number of significant bits of the cycle count
+	uint32_t bin = 32 - __CLZ(cycles);
+
+	if (bin >= PROFILER_BINS)
+	{
+		bin = PROFILER_BINS - 1;
+	}
+
+	statistics->count++;
+	statistics->total += cycles;
+	statistics->bins[bin]++;
+
+	if (cycles < statistics->min)
+	{
+		statistics->min = cycles;
+	}
+
+	if (cycles > statistics->max)
+	{
+		statistics->max = cycles;
+	}
+}
+
+static void Profiler_Output_Field(uint32_t value)
+{
+	UART0_Output_Character(',');
+	UART0_Output_Unsigned_Decimal(value);
+}
+
+void Profiler_Report(void)
+{
+	UART0_Output_String("PROFILE,core_clock_hz");
+	Profiler_Output_Field(SystemCoreClock);
+	UART0_Output_Newline();
+
+	UART0_Output_String("PROFILE,scope,count,min,mean,max");
+	for (int bin = 0; bin < PROFILER_BINS; bin++)
+	{
+		UART0_Output_String(",bin");
+		UART0_Output_Unsigned_Decimal(bin);
+	}
+	UART0_Output_Newline();
+
+	for (int scope = 0; scope < PROFILER_SCOPE_COUNT; scope++)
+	{
+		Profiler_Statistics *statistics = &Profiler_Scopes[scope];
+		uint32_t primask = __get_PRIMASK();
+
+		// Copy the summary, the scope may be recorded by an interrupt handler meanwhile
+		__disable_irq();
+		uint32_t count = statistics->count;
+		uint32_t min = statistics->min;
+		uint32_t max = statistics->max;
+		uint64_t total = statistics->total;
+		__set_PRIMASK(primask);
+
+		UART0_Output_String("PROFILE,");
+		UART0_Output_String((char *)Profiler_Scope_Names[scope]);
+		Profiler_Output_Field(count);
+		Profiler_Output_Field((count > 0) ? min : 0);
+		Profiler_Output_Field((count > 0) ? (uint32_t)(total / count) : 0);
+		Profiler_Output_Field(max);
+
+		// The bins are printed as they are now, they can be a few counts ahead of the summary
+		for (int bin = 0; bin < PROFILER_BINS; bin++)
+		{
+			Profiler_Output_Field(statistics->bins[bin]);
+		}
+		UART0_Output_Newline();
+	}
+
+	UART0_Output_String("PROFILE,END");
+	UART0_Output_Newline();
+}
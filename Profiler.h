@@ -0,0 +1,110 @@
+/**
+ * @file Profiler.h
+ *
+ * @brief Header file for the Profiler module.
+ *
+ * This module measures how many core clock cycles the firmware spends in a few
+ * scopes with the DWT cycle counter (CYCCNT). A scope is measured by reading the
+ * counter at its start and passing the reading to PROFILER_STOP at its end:
+ *
+ *     uint32_t profile_start = PROFILER_START();
+ *     ...
+ *     PROFILER_STOP(PROFILER_SCOPE_TIMER0A_HANDLER, profile_start);
+ *
+ * For every scope, the count, min, max and total of the cycles are kept in RAM
+ * together with a log2 histogram: bin 0 counts the scopes that took 0 cycles and
+ * bin n the scopes that took 2^(n-1) to 2^n - 1 cycles. The last bin also counts
+ * everything longer.
+ *
+ * Recording a scope costs a CYCCNT read, a count leading zeros instruction and a few
+ * additions, so the profiler can stay enabled. Set PROFILER_ENABLE to 0 on the
+ * compiler command line to remove it completely.
+ *
+ * @note The cycles are inclusive: they contain the nested scopes and the interrupts
+ * that preempted the scope. Each scope must only be recorded from one context
+ * (the main loop or one interrupt handler).
+ */
+
+#include "TM4C123GH6PM.h"
+
+#ifndef PROFILER_ENABLE
+#define PROFILER_ENABLE         1
+#endif
+
+// SysTick interrupts every 1 ms and its handler only counts the time, so measuring
+// it mostly fills the histogram with identical samples and is only done when this is set to 1
+#ifndef PROFILER_SYSTICK
+#define PROFILER_SYSTICK        0
+#endif
+
+// Number of log2 histogram bins per scope
+#define PROFILER_BINS           32
+
+typedef enum
+{
+	PROFILER_SCOPE_TIMER0A_HANDLER,
+	PROFILER_SCOPE_SYSTICK_HANDLER,
+	PROFILER_SCOPE_UART_BLE_INPUT_STRING,
+	PROFILER_SCOPE_PROCESS_UART_BLE_DATA,
+	PROFILER_SCOPE_UART0_OUTPUT_STRING,
+	PROFILER_SCOPE_UART3_OUTPUT_STRING,
+	PROFILER_SCOPE_UART_BLE_OUTPUT_STRING,
+	PROFILER_SCOPE_COUNT
+} Profiler_Scope;
+
+#if PROFILER_ENABLE
+#define PROFILER_START()                (DWT->CYCCNT)
+#define PROFILER_STOP(scope, start)     Profiler_Record((scope), DWT->CYCCNT - (start))
+#else
+#define PROFILER_START()                0
+#define PROFILER_STOP(scope, start)     ((void)(start))
+#endif
+
+/**
+ * @brief Enables the DWT cycle counter and clears the recorded statistics.
+ *
+ * The cycle counter is started if it is not running yet, but it is not cleared.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Profiler_Init(void);
+
+/**
+ * @brief Clears the recorded statistics of every scope.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Profiler_Reset(void);
+
+/**
+ * @brief Adds one measurement to the statistics of a scope.
+ *
+ * Use PROFILER_STOP instead of calling this function directly.
+ *
+ * @param scope The scope that has been measured.
+ *
+ * @param cycles The number of core clock cycles spent in the scope.
+ *
+ * @return None
+ */
+void Profiler_Record(Profiler_Scope scope, uint32_t cycles);
+
+/**
+ * @brief Prints the statistics of every scope over UART0 as CSV.
+ *
+ * The report starts with "PROFILE,core_clock_hz,<frequency>" and a header line, then
+ * prints one line per scope:
+ *
+ *     PROFILE,<scope>,<count>,<min>,<mean>,<max>,<bin 0>,...,<bin 31>
+ *
+ * All values are in core clock cycles. The report ends with "PROFILE,END".
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Profiler_Report(void);
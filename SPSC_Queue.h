@@ -0,0 +1,78 @@
+/**
+ * @file SPSC_Queue.h
+ *
+ * @brief Wait-free single-producer, single-consumer queue for passing items between
+ * the main loop and an interrupt handler.
+ *
+ * SPSC_QUEUE_DEFINE generates a queue type and its functions for one item type, the C
+ * counterpart of a class template:
+ *
+ *     SPSC_QUEUE_DEFINE(Command_Queue, uint8_t, 8)
+ *
+ *     static Command_Queue Commands;
+ *
+ *     Command_Queue_Push(&Commands, command);     // in the producer only
+ *     Command_Queue_Pop(&Commands, &command);     // in the consumer only
+ *
+ * head counts the items pushed and is only written by the producer, tail counts the
+ * items popped and is only written by the consumer. Neither side ever waits for the
+ * other or disables interrupts: a push or a pop is a bounded number of instructions,
+ * so the queue can be used from a handler of any priority. The item is written before
+ * head is advanced (and read before tail is), with a barrier in between, so the other
+ * side never sees a slot that is not complete.
+ *
+ * The counts run freely and wrap at 2^32, the slot is count % size. size must be a
+ * power of two.
+ *
+ * @note A zero-filled queue is empty, so a static queue needs no initialization.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include "Atomic.h"
+
+#define SPSC_QUEUE_DEFINE(name, type, size)                                            \
+                                                                                       \
+typedef char name##_Size_Is_A_Power_Of_Two[(((size) & ((size) - 1)) == 0) ? 1 : -1]; \
+                                                                                       \
+typedef struct                                                                         \
+{                                                                                      \
+	type items[size];                                                                  \
+	volatile uint32_t head;                                                            \
+	volatile uint32_t tail;                                                            \
+} name;                                                                                \
+                                                                                       \
+/* Adds an item at the head, returns 0 and leaves the queue unchanged when it is full */ \
+__STATIC_INLINE int name##_Push(name *queue, type item)                                \
+{                                                                                      \
+	uint32_t head = queue->head;                                                       \
+	if (head - Atomic_Load(&queue->tail) >= (size))                                    \
+	{                                                                                  \
+		return 0;                                                                      \
+	}                                                                                  \
+	queue->items[head & ((size) - 1)] = item;                                          \
+	Atomic_Store(&queue->head, head + 1);                                              \
+	return 1;                                                                          \
+}                                                                                      \
+                                                                                       \
+/* Removes the item at the tail, returns 0 when the queue is empty */                  \
+__STATIC_INLINE int name##_Pop(name *queue, type *item)                                \
+{                                                                                      \
+	uint32_t tail = queue->tail;                                                       \
+	if (Atomic_Load(&queue->head) == tail)                                             \
+	{                                                                                  \
+		return 0;                                                                      \
+	}                                                                                  \
+	*item = queue->items[tail & ((size) - 1)];                                         \
+	Atomic_Store(&queue->tail, tail + 1);                                              \
+	return 1;                                                                          \
+}                                                                                      \
+                                                                                       \
+/* Number of items in the queue, exact on either side, a snapshot anywhere else */     \
+__STATIC_INLINE uint32_t name##_Count(name *queue)                                     \
+{                                                                                      \
+	return queue->head - queue->tail;                                                  \
+}
+
+#endif
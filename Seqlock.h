@@ -0,0 +1,71 @@
+/**
+ * @file Seqlock.h
+ *
+ * @brief Sequence lock for publishing a multi-word state from an interrupt handler.
+ *
+ * A reader that copies a structure word by word can be interrupted halfway by the
+ * writer and end up with a mix of the old and the new state. With a sequence lock the
+ * writer makes the sequence odd while it updates the state and even again when it is
+ * done, and the reader copies the state until it got a copy with the same even
+ * sequence before and after it:
+ *
+ *     // writer (interrupt handler)             // reader (main loop)
+ *     Seqlock_Write_Begin(&lock);               do
+ *     state.a = a;                              {
+ *     state.b = b;                                  sequence = Seqlock_Read_Begin(&lock);
+ *     Seqlock_Write_End(&lock);                     copy = state;
+ *                                               } while (Seqlock_Read_Retry(&lock, sequence));
+ *
+ * The writer never waits, and neither side disables interrupts.
+ *
+ * @note There must be a single writer, and it must not be preempted by a reader: a
+ * reader would retry forever on the odd sequence. An interrupt handler that writes and
+ * the main loop that reads meet that.
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include "Atomic.h"
+
+typedef struct
+{
+	volatile uint32_t sequence;
+} Seqlock;
+
+/**
+ * @brief Marks the start of an update, the sequence becomes odd.
+ */
+__STATIC_INLINE void Seqlock_Write_Begin(Seqlock *lock)
+{
+	// The single writer owns the sequence, a plain increment is enough
+	lock->sequence = lock->sequence + 1;
+	__DMB();
+}
+
+/**
+ * @brief Marks the end of an update, the sequence becomes even.
+ */
+__STATIC_INLINE void Seqlock_Write_End(Seqlock *lock)
+{
+	Atomic_Store(&lock->sequence, lock->sequence + 1);
+}
+
+/**
+ * @brief Returns the sequence to pass to Seqlock_Read_Retry once the state is copied.
+ */
+__STATIC_INLINE uint32_t Seqlock_Read_Begin(Seqlock *lock)
+{
+	return Atomic_Load(&lock->sequence);
+}
+
+/**
+ * @brief Returns non-zero when the copy may be torn and must be made again.
+ */
+__STATIC_INLINE int Seqlock_Read_Retry(Seqlock *lock, uint32_t sequence)
+{
+	__DMB();
+	return (sequence & 1) || (lock->sequence != sequence);
+}
+
+#endif
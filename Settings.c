@@ -0,0 +1,289 @@
+/**
+ * @file Settings.c
+ *
+ * @brief Source code for the Settings module.
+ *
+ * Sequence numbers are 16 bits and wrap around. Every record is written with the next
+ * number at the next free slot, and a record the ring skips is copied forward at once,
+ * so the records in the ring are never much more than SETTINGS_RECORDS numbers apart
+ * and the difference of two of them, as a signed 16-bit number, tells which one is newer.
+ */
+
+#include "Settings.h"
+#include "EEPROM.h"
+#include "Number_Format.h"
+#include "string.h"
+
+#define SETTINGS_RECORDS          (EEPROM_WORDS / 2)
+#define SETTINGS_NO_SLOT          0xFFFF
+
+#define SETTINGS_LINE_SIZE        64
+
+extern uint32_t SystemCoreClock;
+
+// Newest value of each key, and the slot and the sequence number of its record
+static uint32_t Settings_Values[SETTINGS_KEY_COUNT];
+static uint16_t Settings_Slots[SETTINGS_KEY_COUNT];
+static uint16_t Settings_Sequences[SETTINGS_KEY_COUNT];
+
+// Slot and sequence number of the next record
+static uint16_t Settings_Next_Slot;
+static uint16_t Settings_Next_Sequence;
+
+static uint8_t Settings_EEPROM_Ready;
+static uint32_t Settings_Writes;
+static uint32_t Settings_Load_us;
+
+/**
+ * @brief CRC-8 (polynomial 0x07) of the value, the key and the sequence number of a record.
+ */
+static uint8_t Settings_CRC(uint32_t value, uint32_t header)
+{
+	// The 7 bytes, from the least significant: the value, the key and the sequence number
+	uint64_t bytes = ((uint64_t)(header >> 8) << 32) | value;
+	uint8_t crc = 0;
+
+	for (uint32_t i = 0; i < 7; i++)
+	{
+		crc ^= (uint8_t)(bytes >> (8 * i));
+		for (uint32_t bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+static uint32_t Settings_Header_Key(uint32_t header)
+{
+	return (header >> 8) & 0xFF;
+}
+
+/**
+ * @brief Writes the record of a key at a slot: the value first, then the header that makes it valid.
+ */
+static uint8_t Settings_Write_Record(uint16_t slot, Settings_Key key, uint32_t value)
+{
+	uint32_t header = ((uint32_t)Settings_Next_Sequence << 16) | ((uint32_t)key << 8);
+	header |= Settings_CRC(value, header);
+
+	// A slot that already holds the value only needs the header
+	if (EEPROM_Read(2 * slot) != value && !EEPROM_Write(2 * slot, value))
+	{
+		return 0;
+	}
+	if (!EEPROM_Write(2 * slot + 1, header))
+	{
+		return 0;
+	}
+
+	Settings_Values[key] = value;
+	Settings_Slots[key] = slot;
+	Settings_Sequences[key] = Settings_Next_Sequence;
+
+	Settings_Next_Sequence++;
+	Settings_Next_Slot = (slot + 1) % SETTINGS_RECORDS;
+	Settings_Writes++;
+
+	return 1;
+}
+
+uint8_t Settings_Init(void)
+{
+	uint32_t start = DWT->CYCCNT;
+	uint8_t found = 0;
+
+	for (uint32_t key = 0; key < SETTINGS_KEY_COUNT; key++)
+	{
+		Settings_Slots[key] = SETTINGS_NO_SLOT;
+	}
+	Settings_Next_Slot = 0;
+	Settings_Next_Sequence = 0;
+
+	Settings_EEPROM_Ready = EEPROM_Init();
+	if (!Settings_EEPROM_Ready)
+	{
+		return 0;
+	}
+
+	for (uint16_t slot = 0; slot < SETTINGS_RECORDS; slot++)
+	{
+		uint32_t record[2];
+		EEPROM_Read_Words(2 * slot, record, 2);
+
+		uint32_t key = Settings_Header_Key(record[1]);
+		uint16_t sequence = record[1] >> 16;
+
+		// Erased slots have the key 0xFF
+		if (key >= SETTINGS_KEY_COUNT || (record[1] & 0xFF) != Settings_CRC(record[0], record[1]))
+		{
+			continue;
+		}
+
+		if (Settings_Slots[key] == SETTINGS_NO_SLOT || (int16_t)(sequence - Settings_Sequences[key]) > 0)
+		{
+			Settings_Values[key] = record[0];
+			Settings_Slots[key] = slot;
+			Settings_Sequences[key] = sequence;
+		}
+
+		// The newest record of all marks where the ring goes on
+		if (!found || (int16_t)(sequence - Settings_Next_Sequence) >= 0)
+		{
+			Settings_Next_Sequence = sequence + 1;
+			Settings_Next_Slot = (slot + 1) % SETTINGS_RECORDS;
+			found = 1;
+		}
+	}
+
+	Settings_Load_us = (DWT->CYCCNT - start) / (SystemCoreClock / 1000000);
+
+	return 1;
+}
+
+uint8_t Settings_Get(Settings_Key key, uint32_t *value)
+{
+	if (Settings_Slots[key] == SETTINGS_NO_SLOT)
+	{
+		return 0;
+	}
+
+	*value = Settings_Values[key];
+	return 1;
+}
+
+uint8_t Settings_Set(Settings_Key key, uint32_t value)
+{
+	if (!Settings_EEPROM_Ready)
+	{
+		return 0;
+	}
+	if (Settings_Slots[key] != SETTINGS_NO_SLOT && Settings_Values[key] == value)
+	{
+		return 1;
+	}
+
+	// Records written by this change: the new one, then copies of the records skipped
+	// on the way, which stay valid until their copy is complete
+	Settings_Key pending[SETTINGS_KEY_COUNT];
+	uint32_t pending_count = 1;
+	uint32_t written = 0;
+
+	pending[0] = key;
+
+	while (written < pending_count)
+	{
+		uint16_t slot = Settings_Next_Slot;
+		uint32_t other = Settings_Header_Key(EEPROM_Read(2 * slot + 1));
+
+		// The newest record of a key is never overwritten, the ring moves past it
+		if (other < SETTINGS_KEY_COUNT && Settings_Slots[other] == slot)
+		{
+			Settings_Next_Slot = (slot + 1) % SETTINGS_RECORDS;
+			if (other != key)
+			{
+				pending[pending_count++] = (Settings_Key)other;
+			}
+			continue;
+		}
+
+		Settings_Key next = pending[written];
+		if (!Settings_Write_Record(slot, next, (next == key) ? value : Settings_Values[next]))
+		{
+			return 0;
+		}
+		written++;
+	}
+
+	return 1;
+}
+
+uint8_t Settings_Get_String(Settings_Key key, char *text)
+{
+	if (Settings_Slots[key] == SETTINGS_NO_SLOT)
+	{
+		return 0;
+	}
+
+	for (uint32_t i = 0; i < SETTINGS_STRING_SIZE; i++)
+	{
+		uint32_t word = 0;
+		Settings_Get((Settings_Key)(key + i / 4), &word);
+		text[i] = (char)(word >> (8 * (i % 4)));
+	}
+	text[SETTINGS_STRING_SIZE - 1] = 0;
+
+	return 1;
+}
+
+uint8_t Settings_Set_String(Settings_Key key, const char *text)
+{
+	if (strlen(text) >= SETTINGS_STRING_SIZE)
+	{
+		return 0;
+	}
+
+	// The words are packed little-endian and padded with zeros
+	uint32_t length = strlen(text);
+
+	for (uint32_t word_index = 0; word_index < SETTINGS_STRING_WORDS; word_index++)
+	{
+		uint32_t word = 0;
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			uint32_t position = 4 * word_index + i;
+			if (position < length)
+			{
+				word |= (uint32_t)(uint8_t)text[position] << (8 * i);
+			}
+		}
+
+		if (!Settings_Set((Settings_Key)(key + word_index), word))
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+uint32_t Settings_Checksum(Settings_Key key, uint32_t count)
+{
+	// FNV-1a over the values, an absent key counts as an erased word
+	uint32_t checksum = 2166136261UL;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t value = EEPROM_ERASED;
+		Settings_Get((Settings_Key)(key + i), &value);
+
+		for (uint32_t byte = 0; byte < 4; byte++)
+		{
+			checksum = (checksum ^ ((value >> (8 * byte)) & 0xFF)) * 16777619UL;
+		}
+	}
+
+	return checksum;
+}
+
+void Settings_Report(void)
+{
+	char line[SETTINGS_LINE_SIZE];
+	char *limit = line + sizeof(line);
+	char *end = line;
+	uint32_t stored = 0;
+
+	for (uint32_t key = 0; key < SETTINGS_KEY_COUNT; key++)
+	{
+		stored += (Settings_Slots[key] != SETTINGS_NO_SLOT);
+	}
+
+	end = Format_Append_Field(end, limit, "SETTINGS keys ", stored);
+	end = Format_Append_Field(end, limit, " of ", SETTINGS_KEY_COUNT);
+	end = Format_Append_Field(end, limit, " writes ", Settings_Writes);
+	end = Format_Append_Field(end, limit, " load ", Settings_Load_us);
+	end = Format_Append(end, limit, " us");
+
+	Format_Report_Line(line);
+}
@@ -0,0 +1,122 @@
+/**
+ * @file Settings.h
+ *
+ * @brief Header file for the Settings module.
+ *
+ * This module keeps the settings of the music box in the EEPROM (EEPROM.h) so they
+ * survive a power cycle. Each setting is a 32-bit value under a key; a string takes
+ * SETTINGS_STRING_WORDS consecutive keys.
+ *
+ * The EEPROM is used as a ring of 2-word records, value then header:
+ *
+ *     header = sequence (Bits 31 to 16) | key (Bits 15 to 8) | CRC-8 (Bits 7 to 0)
+ *
+ * A change appends a record at the next slot of the ring, so the writes are spread
+ * over the whole EEPROM instead of wearing the words of the busiest setting. The
+ * record of a key with the newest sequence number holds its value. The newest record
+ * of a key is never overwritten: when the ring comes back to one, it skips the slot and
+ * copies the record to the next free slot with a new sequence number. The header is
+ * written after the value and the CRC covers both, so a record cut short by a power
+ * loss is ignored and the previous value of its key stays.
+ *
+ * Settings_Init reads every record once at boot and keeps the values in RAM, so
+ * Settings_Get never reads the EEPROM. The BLE command "SETTINGS" sends the number of
+ * keys stored, the records written since boot and the time the boot scan took:
+ *
+ *     SETTINGS keys <n> of <n> writes <n> load <us> us
+ */
+
+#include "TM4C123GH6PM.h"
+
+// Words of a string setting, which holds up to 4 * SETTINGS_STRING_WORDS - 1 characters
+#define SETTINGS_STRING_WORDS     8
+#define SETTINGS_STRING_SIZE      (4 * SETTINGS_STRING_WORDS)
+
+typedef enum
+{
+	SETTINGS_VOLUME,                    // volume of the Arduino, 0 to 20
+	SETTINGS_MOTOR_STEP_PERIOD,         // period of the motor steps in microseconds
+	SETTINGS_MOTOR_DRIVE_MODE,          // Stepper_Motor_Drive_Mode
+	SETTINGS_BLE_CONFIG,                // checksum of the BLE settings below, once the module has taken them
+	SETTINGS_BLE_TX_POWER,              // TX power of the BLE module in dBm
+	SETTINGS_BLE_NAME,                  // string, name advertised by the BLE module
+	SETTINGS_LAST_SONG = SETTINGS_BLE_NAME + SETTINGS_STRING_WORDS,    // string, title of the last song played
+	SETTINGS_KEY_COUNT = SETTINGS_LAST_SONG + SETTINGS_STRING_WORDS
+} Settings_Key;
+
+/**
+ * @brief Initializes the EEPROM and loads the newest value of every key.
+ *
+ * Latency_Benchmark_Init must be called first, the load time is measured with the
+ * DWT cycle counter.
+ *
+ * @param None
+ *
+ * @return Returns 1 when the EEPROM is usable. Otherwise returns 0, every key reads as
+ * not stored and changes are not saved.
+ */
+uint8_t Settings_Init(void);
+
+/**
+ * @brief Reads a setting.
+ *
+ * @param key The key.
+ * @param value Pointer to the variable that receives the value, left unchanged when the
+ * key is not stored.
+ *
+ * @return Returns 1 when the key is stored, 0 otherwise.
+ */
+uint8_t Settings_Get(Settings_Key key, uint32_t *value);
+
+/**
+ * @brief Saves a setting, unless it already holds the value.
+ *
+ * A record takes two EEPROM writes, and the records still in use that the ring comes
+ * back to are written again first. The EEPROM_Write calls wait for each write.
+ *
+ * @param key The key.
+ * @param value The value.
+ *
+ * @return Returns 1 when the value is saved, 0 when the EEPROM could not be written.
+ */
+uint8_t Settings_Set(Settings_Key key, uint32_t value);
+
+/**
+ * @brief Reads a string setting.
+ *
+ * @param key The first key of the string.
+ * @param text The buffer that receives the string, at least SETTINGS_STRING_SIZE characters.
+ *
+ * @return Returns 1 when the string is stored, 0 otherwise.
+ */
+uint8_t Settings_Get_String(Settings_Key key, char *text);
+
+/**
+ * @brief Saves a string setting, only writing the words that change.
+ *
+ * @param key The first key of the string.
+ * @param text The string.
+ *
+ * @return Returns 1 when the string is saved, 0 when it is too long or the EEPROM
+ * could not be written.
+ */
+uint8_t Settings_Set_String(Settings_Key key, const char *text);
+
+/**
+ * @brief Computes a checksum of consecutive settings, to tell if any of them changed.
+ *
+ * @param key The first key.
+ * @param count The number of keys.
+ *
+ * @return The checksum, which also changes when a key is stored or not.
+ */
+uint32_t Settings_Checksum(Settings_Key key, uint32_t count);
+
+/**
+ * @brief Sends the SETTINGS line to UART0 and to the phone.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Settings_Report(void);
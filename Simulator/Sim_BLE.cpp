@@ -0,0 +1,165 @@
+/**
+ * @file Sim_BLE.cpp
+ *
+ * @brief Command mode of the Adafruit Bluefruit LE UART Friend on UART1.
+ *
+ * While the MOD pin (PB7) is driven high, the lines the firmware transmits on UART1 are
+ * AT commands for the module instead of data for the phone. Each one is answered on the
+ * peer side of UART1 like the module does: the response lines, then "OK\r\n" or
+ * "ERROR\r\n". ATZ answers once the module has restarted, SIM_BLE_RESET_TIME later.
+ *
+ * Supported commands: ATZ, AT, AT+GAPGETCONN, AT+BLEPOWERLEVEL[=dBm], AT+GAPDEVNAME[=name].
+ * The connection state is set with "config ble connected 0|1" in the scenario.
+ */
+
+#include "Simulator.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_BLE_UART           1
+#define SIM_BLE_MOD_PORT       1
+#define SIM_BLE_MOD_PIN        0x80
+
+#define SIM_BLE_LINE_SIZE      64
+#define SIM_BLE_REPLY_SIZE     128
+#define SIM_BLE_NAME_SIZE      32
+
+#define SIM_BLE_RESET_TIME     (1000 * SIM_MS)
+#define SIM_BLE_RESPONSE_TIME  (5 * SIM_MS)
+
+static char Sim_BLE_Line[SIM_BLE_LINE_SIZE];
+static int Sim_BLE_Line_Length;
+static int Sim_BLE_Connected = 1;
+static int Sim_BLE_Power_Level;
+static char Sim_BLE_Name[SIM_BLE_NAME_SIZE];
+
+Sim_BLE_Stats_Type Sim_BLE_Stats;
+
+void Sim_BLE_Reset(void)
+{
+	Sim_BLE_Line_Length = 0;
+	Sim_BLE_Power_Level = 0;
+	strcpy(Sim_BLE_Name, "Adafruit Bluefruit LE");
+	memset(&Sim_BLE_Stats, 0, sizeof(Sim_BLE_Stats));
+}
+
+void Sim_BLE_Set_Connected(int connected)
+{
+	Sim_BLE_Connected = connected;
+}
+
+static int Sim_BLE_Valid_Power_Level(int level)
+{
+	static const int levels[] = { -40, -20, -16, -12, -8, -4, 0, 4 };
+
+	for (unsigned int i = 0; i < sizeof(levels) / sizeof(levels[0]); i++)
+	{
+		if (levels[i] == level)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Builds the response to one AT command, returns 0 when the command fails
+ */
+static int Sim_BLE_Execute(const char *command, char *reply, uint64_t *delay)
+{
+	*delay = SIM_BLE_RESPONSE_TIME;
+	reply[0] = 0;
+
+	if (strcmp(command, "AT") == 0)
+	{
+		return 1;
+	}
+	if (strcmp(command, "ATZ") == 0)
+	{
+		*delay = SIM_BLE_RESET_TIME;
+		return 1;
+	}
+	if (strcmp(command, "AT+GAPGETCONN") == 0)
+	{
+		snprintf(reply, SIM_BLE_REPLY_SIZE, "%d\r\n", Sim_BLE_Connected);
+		return 1;
+	}
+	if (strcmp(command, "AT+BLEPOWERLEVEL") == 0)
+	{
+		snprintf(reply, SIM_BLE_REPLY_SIZE, "%d\r\n", Sim_BLE_Power_Level);
+		return 1;
+	}
+	if (strncmp(command, "AT+BLEPOWERLEVEL=", 17) == 0)
+	{
+		char *end;
+		long level = strtol(command + 17, &end, 10);
+
+		if (end == command + 17 || *end || !Sim_BLE_Valid_Power_Level((int)level))
+		{
+			return 0;
+		}
+		Sim_BLE_Power_Level = (int)level;
+		return 1;
+	}
+	if (strcmp(command, "AT+GAPDEVNAME") == 0)
+	{
+		snprintf(reply, SIM_BLE_REPLY_SIZE, "%s\r\n", Sim_BLE_Name);
+		return 1;
+	}
+	if (strncmp(command, "AT+GAPDEVNAME=", 14) == 0)
+	{
+		if (command[14] == 0 || strlen(command + 14) >= SIM_BLE_NAME_SIZE)
+		{
+			return 0;
+		}
+		strcpy(Sim_BLE_Name, command + 14);
+		return 1;
+	}
+	return 0;
+}
+
+void Sim_BLE_Firmware_Output(uint8_t data)
+{
+	if ((Sim_GPIO_Output(SIM_BLE_MOD_PORT) & SIM_BLE_MOD_PIN) == 0)
+	{
+		Sim_BLE_Line_Length = 0;
+		return;
+	}
+
+	if (data == '\r')
+	{
+		return;
+	}
+	if (data != '\n')
+	{
+		if (Sim_BLE_Line_Length < SIM_BLE_LINE_SIZE - 1)
+		{
+			Sim_BLE_Line[Sim_BLE_Line_Length++] = (char)data;
+		}
+		return;
+	}
+
+	Sim_BLE_Line[Sim_BLE_Line_Length] = 0;
+	Sim_BLE_Line_Length = 0;
+	if (Sim_BLE_Line[0] == 0)
+	{
+		return;
+	}
+
+	char reply[SIM_BLE_REPLY_SIZE + 16];
+	uint64_t delay;
+	int ok = Sim_BLE_Execute(Sim_BLE_Line, reply, &delay);
+
+	strcat(reply, ok ? "OK\r\n" : "ERROR\r\n");
+	Sim_BLE_Stats.commands++;
+	if (!ok)
+	{
+		Sim_BLE_Stats.errors++;
+	}
+	if (Sim_Options.trace)
+	{
+		Sim_Log("ble      AT \"%s\" -> %s", Sim_BLE_Line, ok ? "OK" : "ERROR");
+	}
+
+	Sim_UART_Peer_Send(SIM_BLE_UART, reply, (int)strlen(reply), Sim_Time + delay);
+}
@@ -0,0 +1,1177 @@
+/**
+ * @file Sim_Core.cpp
+ *
+ * @brief Virtual clock, event queue, NVIC / SCB / DWT model and interrupt dispatcher.
+ *
+ * Every register access made by the firmware lands in Sim_Register_Read or
+ * Sim_Register_Write. The access is charged SIM_ACCESS_CYCLES core cycles, the events
+ * that fall due in that time are run, pending interrupts are dispatched, and then the
+ * access is routed to the peripheral that owns the register.
+ *
+ * Two mechanisms keep busy-wait loops cheap on the host:
+ *  - Polling: when SIM_IDLE_READS reads in a row find the model unchanged, time skips
+ *    straight to the next scheduled event.
+ *  - Stalls: a loop that spins on a RAM variable (for example SysTick_Delay1ms waiting
+ *    for ms_elapsed) never reaches the model. A wall-clock watchdog (SIGALRM) notices
+ *    that no register was touched during a whole interval and advances virtual time by
+ *    one stall quantum from the signal handler, running the handlers that update the variable.
+ *
+ * @note Time spent in plain computation is not charged; only register accesses,
+ * exception entry / exit and sleeping move the clock.
+ */
+
+#include "Simulator.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#define SIM_PRIORITY_MASK        (0xFF << (8 - __NVIC_PRIO_BITS) & 0xFF)
+#define SIM_THREAD_PRIORITY      0x100
+#define SIM_EVENT_CAPACITY       4096
+#define SIM_ACTIVE_DEPTH         32
+
+#define SIM_BARRIER()            __asm__ __volatile__("" ::: "memory")
+
+UART0_Type Sim_UART[8];
+GPIOA_Type Sim_GPIO[6];
+TIMER0_Type Sim_Timer[6];
+WTIMER0_Type Sim_Wide_Timer[6];
+SYSCTL_Type Sim_SYSCTL;
+NVIC_Type Sim_NVIC;
+SCB_Type Sim_SCB;
+DWT_Type Sim_DWT;
+CoreDebug_Type Sim_CoreDebug;
+SysTick_Type Sim_SysTick;
+
+uint64_t Sim_Time;
+uint32_t Sim_Core_Hz;
+uint64_t Sim_Cycle_Time;
+uint64_t Sim_State_Version;
+Sim_Options_Type Sim_Options;
+Sim_Exception_Stats_Type Sim_Exception_Stats[SIM_EXCEPTION_COUNT];
+Sim_Stats_Type Sim_Stats;
+
+// Cycle counter at the last clock change, so the count stays continuous across clock switches
+static uint64_t Sim_Cycle_Base;
+static uint64_t Sim_Cycle_Base_Time;
+
+typedef struct {
+	uint64_t time;
+	uint64_t sequence;
+	Sim_Event_Handler handler;
+	void *context;
+	uint32_t argument;
+} Sim_Event;
+
+static Sim_Event Sim_Events[SIM_EVENT_CAPACITY];
+static int Sim_Event_Count;
+static uint64_t Sim_Event_Sequence;
+
+// Exception state, indexed by exception number
+static uint32_t Sim_Pending[SIM_EXCEPTION_COUNT / 32];
+static uint32_t Sim_Level[SIM_EXCEPTION_COUNT / 32];
+static int Sim_Active[SIM_ACTIVE_DEPTH];
+static int Sim_Active_Priority[SIM_ACTIVE_DEPTH];
+static int Sim_Active_Count;
+static uint32_t Sim_PRIMASK;
+static uint64_t Sim_Exceptions_Taken;
+
+// Local exclusive monitor: the address marked by the last LDREX, cleared by STREX, by
+// CLREX and on exception entry and return as on the Cortex-M4
+static volatile uint32_t *Sim_Exclusive_Address;
+
+/**
+ * @brief The .stack section of TM4C123GH6PM.ld, whose base the firmware finds as _sstack.
+ * The firmware's own frames live on the host stack; only the exception frames that the
+ * core pushes on entry are written here, so Stack_Monitor sees the exception nesting.
+ */
+uint32_t _sstack[SIM_STACK_SIZE / 4] __attribute__((aligned(8)));
+static uint32_t *Sim_MSP;
+
+/**
+ * @brief Writes a word of the stack, at a byte offset from its base, as a deeper call
+ * chain on the board would
+ */
+void Sim_Stack_Write(int offset, uint32_t value)
+{
+	_sstack[offset / 4] = value;
+	Sim_State_Version++;
+}
+
+// Non-zero while model code runs; the stall detector must not enter the model then
+static volatile int Sim_Busy;
+static volatile uint64_t Sim_Access_Count;
+static uint64_t Sim_Stall_Seen;
+static uint64_t Sim_DWT_Start_Cycles;
+
+// Polling detection
+static uint64_t Sim_Idle_Version;
+static int Sim_Idle_Reads;
+
+/**
+ * @brief Handlers named in RTE/Device/TM4C123GH6PM/startup_TM4C123.s for the modelled
+ * exceptions. They are weak so the firmware only has to define the ones it uses.
+ */
+#define SIM_VECTOR_LIST(X) \
+	X(11,  SVC_Handler) \
+	X(14,  PendSV_Handler) \
+	X(15,  SysTick_Handler) \
+	X(16,  GPIOA_Handler) \
+	X(17,  GPIOB_Handler) \
+	X(18,  GPIOC_Handler) \
+	X(19,  GPIOD_Handler) \
+	X(20,  GPIOE_Handler) \
+	X(21,  UART0_Handler) \
+	X(22,  UART1_Handler) \
+	X(35,  TIMER0A_Handler) \
+	X(36,  TIMER0B_Handler) \
+	X(37,  TIMER1A_Handler) \
+	X(38,  TIMER1B_Handler) \
+	X(39,  TIMER2A_Handler) \
+	X(40,  TIMER2B_Handler) \
+	X(44,  SYSCTL_Handler) \
+	X(46,  GPIOF_Handler) \
+	X(49,  UART2_Handler) \
+	X(51,  TIMER3A_Handler) \
+	X(52,  TIMER3B_Handler) \
+	X(75,  UART3_Handler) \
+	X(76,  UART4_Handler) \
+	X(77,  UART5_Handler) \
+	X(78,  UART6_Handler) \
+	X(79,  UART7_Handler) \
+	X(86,  TIMER4A_Handler) \
+	X(87,  TIMER4B_Handler) \
+	X(108, TIMER5A_Handler) \
+	X(109, TIMER5B_Handler) \
+	X(110, WTIMER0A_Handler) \
+	X(111, WTIMER0B_Handler) \
+	X(112, WTIMER1A_Handler) \
+	X(113, WTIMER1B_Handler) \
+	X(114, WTIMER2A_Handler) \
+	X(115, WTIMER2B_Handler) \
+	X(116, WTIMER3A_Handler) \
+	X(117, WTIMER3B_Handler) \
+	X(118, WTIMER4A_Handler) \
+	X(119, WTIMER4B_Handler) \
+	X(120, WTIMER5A_Handler) \
+	X(121, WTIMER5B_Handler)
+
+#define SIM_DECLARE_HANDLER(number, name) void name(void) __attribute__((weak));
+SIM_VECTOR_LIST(SIM_DECLARE_HANDLER)
+
+static void (*Sim_Vectors[SIM_EXCEPTION_COUNT])(void);
+static const char *Sim_Vector_Names[SIM_EXCEPTION_COUNT];
+
+static void Sim_Dispatch_Interrupts(void);
+
+static void Sim_Print_Prefix(FILE *stream)
+{
+	fprintf(stream, "[%14.6f ms] ", (double)Sim_Time / SIM_MS);
+}
+
+void Sim_Log(const char *format, ...)
+{
+	va_list arguments;
+
+	Sim_Print_Prefix(stdout);
+	va_start(arguments, format);
+	vfprintf(stdout, format, arguments);
+	va_end(arguments);
+	fputc('\n', stdout);
+}
+
+void Sim_Warning(const char *format, ...)
+{
+	va_list arguments;
+
+	Sim_Stats.warnings++;
+	fflush(stdout);
+	Sim_Print_Prefix(stderr);
+	fputs("warning: ", stderr);
+	va_start(arguments, format);
+	vfprintf(stderr, format, arguments);
+	va_end(arguments);
+	fputc('\n', stderr);
+}
+
+void Sim_Fatal(const char *format, ...)
+{
+	va_list arguments;
+
+	Sim_Stop_Stall_Detector();
+	fflush(stdout);
+	Sim_Print_Prefix(stderr);
+	fputs("error: ", stderr);
+	va_start(arguments, format);
+	vfprintf(stderr, format, arguments);
+	va_end(arguments);
+	fputc('\n', stderr);
+	exit(2);
+}
+
+const char *Sim_Exception_Name(int exception)
+{
+	if (exception >= 0 && exception < SIM_EXCEPTION_COUNT && Sim_Vector_Names[exception])
+	{
+		return Sim_Vector_Names[exception];
+	}
+	return "unknown exception";
+}
+
+void Sim_Init(void)
+{
+	memset(Sim_Events, 0, sizeof(Sim_Events));
+	Sim_Event_Count = 0;
+	Sim_Time = 0;
+	Sim_Cycle_Base = 0;
+	Sim_Cycle_Base_Time = 0;
+	Sim_Active_Count = 0;
+	Sim_PRIMASK = 0;
+	memset(_sstack, 0, sizeof(_sstack));
+	Sim_MSP = _sstack + SIM_STACK_SIZE / 4;
+	memset(Sim_Pending, 0, sizeof(Sim_Pending));
+	memset(Sim_Level, 0, sizeof(Sim_Level));
+	memset((void *)&Sim_NVIC, 0, sizeof(Sim_NVIC));
+	memset((void *)&Sim_SCB, 0, sizeof(Sim_SCB));
+	Sim_SCB.CPUID.raw = 0x410FC241;
+	memset((void *)&Sim_DWT, 0, sizeof(Sim_DWT));
+	memset((void *)&Sim_CoreDebug, 0, sizeof(Sim_CoreDebug));
+	Sim_DWT_Start_Cycles = 0;
+
+#define SIM_INSTALL_HANDLER(number, name) \
+	Sim_Vectors[number] = name; \
+	Sim_Vector_Names[number] = #name;
+	SIM_VECTOR_LIST(SIM_INSTALL_HANDLER)
+
+	if (Sim_Options.stall_quantum == 0)
+	{
+		Sim_Options.stall_quantum = 1 * SIM_MS;
+	}
+	if (Sim_Options.stall_interval_us == 0)
+	{
+		Sim_Options.stall_interval_us = 50;
+	}
+
+	Sim_SysCtl_Reset();
+	Sim_EEPROM_Reset();
+	Sim_UART_Reset();
+	Sim_GPIO_Reset();
+	Sim_BLE_Reset();
+	Sim_Timer_Reset();
+}
+
+void Sim_Set_Core_Clock(uint32_t hz)
+{
+	if (hz == Sim_Core_Hz)
+	{
+		return;
+	}
+
+	if (Sim_Core_Hz)
+	{
+		Sim_Cycle_Base = Sim_Cycle_Count();
+		Sim_Cycle_Base_Time = Sim_Time;
+		if (Sim_Options.trace)
+		{
+			Sim_Log("system clock %u Hz", hz);
+		}
+	}
+
+	Sim_Core_Hz = hz;
+	Sim_Cycle_Time = SIM_S / hz;
+}
+
+uint64_t Sim_Cycle_Count(void)
+{
+	return Sim_Cycle_Base + (Sim_Time - Sim_Cycle_Base_Time) / Sim_Cycle_Time;
+}
+
+static int Sim_Event_Before(const Sim_Event *a, const Sim_Event *b)
+{
+	return a->time < b->time || (a->time == b->time && a->sequence < b->sequence);
+}
+
+void Sim_Schedule(uint64_t time, Sim_Event_Handler handler, void *context, uint32_t argument)
+{
+	Sim_Busy++;
+	SIM_BARRIER();
+
+	if (Sim_Event_Count == SIM_EVENT_CAPACITY)
+	{
+		Sim_Fatal("event queue full");
+	}
+
+	// Insert into the binary min-heap ordered by time, then by scheduling order
+	int child = Sim_Event_Count++;
+	Sim_Event event = { time, Sim_Event_Sequence++, handler, context, argument };
+
+	while (child > 0)
+	{
+		int parent = (child - 1) / 2;
+		if (!Sim_Event_Before(&event, &Sim_Events[parent]))
+		{
+			break;
+		}
+		Sim_Events[child] = Sim_Events[parent];
+		child = parent;
+	}
+	Sim_Events[child] = event;
+
+	SIM_BARRIER();
+	Sim_Busy--;
+}
+
+static Sim_Event Sim_Pop_Event(void)
+{
+	Sim_Event first = Sim_Events[0];
+	Sim_Event last = Sim_Events[--Sim_Event_Count];
+	int parent = 0;
+
+	for (;;)
+	{
+		int child = 2 * parent + 1;
+		if (child >= Sim_Event_Count)
+		{
+			break;
+		}
+		if (child + 1 < Sim_Event_Count && Sim_Event_Before(&Sim_Events[child + 1], &Sim_Events[child]))
+		{
+			child++;
+		}
+		if (!Sim_Event_Before(&Sim_Events[child], &last))
+		{
+			break;
+		}
+		Sim_Events[parent] = Sim_Events[child];
+		parent = child;
+	}
+	if (Sim_Event_Count)
+	{
+		Sim_Events[parent] = last;
+	}
+
+	return first;
+}
+
+uint64_t Sim_Next_Event_Time(void)
+{
+	return Sim_Event_Count ? Sim_Events[0].time : SIM_NEVER;
+}
+
+void Sim_Run_Until(uint64_t time)
+{
+	Sim_Busy++;
+	SIM_BARRIER();
+
+	while (Sim_Event_Count && Sim_Events[0].time <= time)
+	{
+		Sim_Event event = Sim_Pop_Event();
+
+		if (event.time > Sim_Time)
+		{
+			Sim_Time = event.time;
+		}
+		Sim_State_Version++;
+		Sim_Stats.events++;
+		event.handler(event.context, event.argument);
+		Sim_Dispatch_Interrupts();
+	}
+
+	if (time > Sim_Time)
+	{
+		Sim_Time = time;
+	}
+	Sim_Dispatch_Interrupts();
+
+	SIM_BARRIER();
+	Sim_Busy--;
+}
+
+void Sim_Consume_Cycles(uint32_t cycles)
+{
+	Sim_Run_Until(Sim_Time + cycles * Sim_Cycle_Time);
+}
+
+static int Sim_Bit(const uint32_t *bits, int index)
+{
+	return (bits[index >> 5] >> (index & 0x1F)) & 1;
+}
+
+static void Sim_Set_Bit(uint32_t *bits, int index, int value)
+{
+	if (value)
+	{
+		bits[index >> 5] |= 1UL << (index & 0x1F);
+	}
+	else
+	{
+		bits[index >> 5] &= ~(1UL << (index & 0x1F));
+	}
+}
+
+void Sim_Exception_Pend(int exception)
+{
+	if (!Sim_Bit(Sim_Pending, exception))
+	{
+		Sim_Set_Bit(Sim_Pending, exception, 1);
+		Sim_Exception_Stats[exception].pend_time = Sim_Time;
+		Sim_Exception_Stats[exception].pend_time_valid = 1;
+	}
+	Sim_State_Version++;
+}
+
+void Sim_IRQ_Set_Level(int irq, int level)
+{
+	int exception = irq + SIM_EXCEPTION_IRQ0;
+
+	// A rising level pends the interrupt, as for the level-sensitive peripheral lines
+	if (level && !Sim_Bit(Sim_Level, exception))
+	{
+		Sim_Exception_Pend(exception);
+	}
+	Sim_Set_Bit(Sim_Level, exception, level);
+}
+
+static int Sim_Exception_Priority(int exception)
+{
+	if (exception >= SIM_EXCEPTION_IRQ0)
+	{
+		return Sim_NVIC.IPR[exception - SIM_EXCEPTION_IRQ0].raw & SIM_PRIORITY_MASK;
+	}
+	return Sim_SCB.SHPR[exception - 4].raw & SIM_PRIORITY_MASK;
+}
+
+static int Sim_Exception_Enabled(int exception)
+{
+	if (exception >= SIM_EXCEPTION_IRQ0)
+	{
+		int irq = exception - SIM_EXCEPTION_IRQ0;
+		return (Sim_NVIC.ISER[irq >> 5].raw >> (irq & 0x1F)) & 1;
+	}
+	return 1;
+}
+
+static int Sim_Running_Priority(void)
+{
+	return Sim_Active_Count ? Sim_Active_Priority[Sim_Active_Count - 1] : SIM_THREAD_PRIORITY;
+}
+
+/**
+ * @brief Finds the enabled pending exception with the highest priority (lowest value,
+ * lowest exception number on a tie). Returns -1 when nothing is pending.
+ */
+static int Sim_Highest_Pending(int *priority)
+{
+	int best = -1;
+	int best_priority = SIM_THREAD_PRIORITY;
+
+	for (int word = 0; word < SIM_EXCEPTION_COUNT / 32; word++)
+	{
+		uint32_t bits = Sim_Pending[word];
+		while (bits)
+		{
+			int exception = word * 32 + __builtin_ctz(bits);
+			bits &= bits - 1;
+
+			if (Sim_Exception_Enabled(exception))
+			{
+				int exception_priority = Sim_Exception_Priority(exception);
+				if (exception_priority < best_priority)
+				{
+					best = exception;
+					best_priority = exception_priority;
+				}
+			}
+		}
+	}
+
+	*priority = best_priority;
+	return best;
+}
+
+static void Sim_Take_Exception(int exception, int priority)
+{
+	Sim_Exception_Stats_Type *stats = &Sim_Exception_Stats[exception];
+
+	if (Sim_Active_Count == SIM_ACTIVE_DEPTH)
+	{
+		Sim_Fatal("exceptions nested more than %d deep", SIM_ACTIVE_DEPTH);
+	}
+
+	Sim_Set_Bit(Sim_Pending, exception, 0);
+	Sim_Active[Sim_Active_Count] = exception;
+	Sim_Active_Priority[Sim_Active_Count] = priority;
+	Sim_Active_Count++;
+	Sim_Exceptions_Taken++;
+	Sim_Exclusive_Address = NULL;
+
+	// Latency from pending to the first handler instruction, taken before the handler can pend it again
+	if (stats->pend_time_valid)
+	{
+		uint64_t latency = (Sim_Time - stats->pend_time) / Sim_Cycle_Time + SIM_EXCEPTION_ENTRY_CYCLES;
+		if (latency > stats->max_latency_cycles)
+		{
+			stats->max_latency_cycles = latency;
+		}
+		stats->pend_time_valid = 0;
+	}
+
+	// Push the exception frame: R0 to R3, R12, LR, the return address and xPSR
+	if (Sim_MSP - 8 < _sstack)
+	{
+		Sim_Fatal("the exception frame of %s overflows the %d byte stack", Sim_Exception_Name(exception), SIM_STACK_SIZE);
+	}
+	Sim_MSP -= 8;
+	for (int i = 0; i < 7; i++)
+	{
+		Sim_MSP[i] = 0;
+	}
+	Sim_MSP[7] = 0x01000000 | (Sim_Active_Count > 1 ? (uint32_t)Sim_Active[Sim_Active_Count - 2] : 0);
+
+	uint64_t start_cycles = Sim_Cycle_Count();
+	Sim_Consume_Cycles(SIM_EXCEPTION_ENTRY_CYCLES);
+
+	void (*handler)(void) = Sim_Vectors[exception];
+	if (handler)
+	{
+		int busy = Sim_Busy;
+		Sim_Busy = 0;
+		SIM_BARRIER();
+		handler();
+		SIM_BARRIER();
+		Sim_Busy = busy;
+	}
+	else
+	{
+		// The board would end up in the default handler's infinite loop
+		Sim_Warning("exception %d (%s) taken without a firmware handler, disabling it",
+			exception, Sim_Exception_Name(exception));
+		if (exception >= SIM_EXCEPTION_IRQ0)
+		{
+			Sim_Set_Bit((uint32_t *)&Sim_NVIC.ISER[0].raw, exception - SIM_EXCEPTION_IRQ0, 0);
+		}
+	}
+
+	Sim_Consume_Cycles(SIM_EXCEPTION_EXIT_CYCLES);
+	Sim_Active_Count--;
+	Sim_Exclusive_Address = NULL;
+	Sim_MSP += 8;
+
+	uint64_t cycles = Sim_Cycle_Count() - start_cycles;
+	stats->count++;
+	stats->total_cycles += cycles;
+	if (cycles > stats->max_cycles)
+	{
+		stats->max_cycles = cycles;
+	}
+
+	// A level-sensitive line that is still asserted pends the interrupt again
+	if (Sim_Bit(Sim_Level, exception))
+	{
+		Sim_Exception_Pend(exception);
+	}
+	Sim_State_Version++;
+}
+
+static void Sim_Dispatch_Interrupts(void)
+{
+	while (!Sim_PRIMASK)
+	{
+		int priority;
+		int exception = Sim_Highest_Pending(&priority);
+
+		if (exception < 0 || priority >= Sim_Running_Priority())
+		{
+			return;
+		}
+		Sim_Take_Exception(exception, priority);
+	}
+}
+
+/**
+ * @brief Charges a register access and detects polling loops that cannot make progress.
+ */
+static void Sim_Access(int is_read)
+{
+	Sim_Access_Count++;
+	Sim_Stats.register_accesses++;
+
+	if (is_read)
+	{
+		if (Sim_State_Version == Sim_Idle_Version)
+		{
+			if (++Sim_Idle_Reads >= SIM_IDLE_READS)
+			{
+				uint64_t next = Sim_Next_Event_Time();
+				Sim_Idle_Reads = 0;
+				if (next != SIM_NEVER && next > Sim_Time)
+				{
+					Sim_Stats.idle_skips++;
+					Sim_Run_Until(next);
+				}
+			}
+		}
+		else
+		{
+			Sim_Idle_Version = Sim_State_Version;
+			Sim_Idle_Reads = 0;
+		}
+	}
+
+	Sim_Consume_Cycles(SIM_ACCESS_CYCLES);
+}
+
+void Sim_Store(void *reg, unsigned int size, uint32_t value)
+{
+	if (size == 1)
+	{
+		*(uint8_t *)reg = (uint8_t)value;
+	}
+	else
+	{
+		*(uint32_t *)reg = value;
+	}
+}
+
+static uint32_t Sim_Load(const void *reg, unsigned int size)
+{
+	return (size == 1) ? *(const uint8_t *)reg : *(const uint32_t *)reg;
+}
+
+/**
+ * @brief Returns the index of reg in an array of peripherals, or -1.
+ */
+static int Sim_Instance(const void *reg, const void *array, size_t element_size, int count)
+{
+	const char *address = (const char *)reg;
+	const char *base = (const char *)array;
+
+	if (address >= base && address < base + element_size * count)
+	{
+		return (int)((address - base) / element_size);
+	}
+	return -1;
+}
+
+static int Sim_Within(const void *reg, const void *block, size_t size)
+{
+	return Sim_Instance(reg, block, size, 1) == 0;
+}
+
+static uint32_t Sim_IRQ_Word(const uint32_t *bits, int word)
+{
+	uint32_t value = 0;
+
+	for (int bit = 0; bit < 32; bit++)
+	{
+		int exception = word * 32 + bit + SIM_EXCEPTION_IRQ0;
+		if (exception < SIM_EXCEPTION_COUNT && Sim_Bit(bits, exception))
+		{
+			value |= 1UL << bit;
+		}
+	}
+	return value;
+}
+
+static uint32_t Sim_NVIC_Read(const void *reg, unsigned int size)
+{
+	for (int word = 0; word < 8; word++)
+	{
+		if (reg == &Sim_NVIC.ISER[word].raw || reg == &Sim_NVIC.ICER[word].raw)
+		{
+			return Sim_NVIC.ISER[word].raw;
+		}
+		if (reg == &Sim_NVIC.ISPR[word].raw || reg == &Sim_NVIC.ICPR[word].raw)
+		{
+			return Sim_IRQ_Word(Sim_Pending, word);
+		}
+		if (reg == &Sim_NVIC.IABR[word].raw)
+		{
+			uint32_t active[SIM_EXCEPTION_COUNT / 32] = { 0 };
+			for (int i = 0; i < Sim_Active_Count; i++)
+			{
+				Sim_Set_Bit(active, Sim_Active[i], 1);
+			}
+			return Sim_IRQ_Word(active, word);
+		}
+	}
+	return Sim_Load(reg, size);
+}
+
+static void Sim_NVIC_Write(void *reg, unsigned int size, uint32_t value)
+{
+	for (int word = 0; word < 8; word++)
+	{
+		for (int bit = 0; bit < 32; bit++)
+		{
+			int exception = word * 32 + bit + SIM_EXCEPTION_IRQ0;
+			if (!(value & (1UL << bit)) || exception >= SIM_EXCEPTION_COUNT)
+			{
+				continue;
+			}
+			if (reg == &Sim_NVIC.ISPR[word].raw)
+			{
+				Sim_Exception_Pend(exception);
+			}
+			else if (reg == &Sim_NVIC.ICPR[word].raw)
+			{
+				Sim_Set_Bit(Sim_Pending, exception, Sim_Bit(Sim_Level, exception));
+			}
+		}
+		if (reg == &Sim_NVIC.ISER[word].raw)
+		{
+			Sim_NVIC.ISER[word].raw |= value;
+			return;
+		}
+		if (reg == &Sim_NVIC.ICER[word].raw)
+		{
+			Sim_NVIC.ISER[word].raw &= ~value;
+			return;
+		}
+		if (reg == &Sim_NVIC.ISPR[word].raw || reg == &Sim_NVIC.ICPR[word].raw || reg == &Sim_NVIC.IABR[word].raw)
+		{
+			return;
+		}
+	}
+	if (reg == &Sim_NVIC.STIR.raw)
+	{
+		if ((value & 0x1FF) + SIM_EXCEPTION_IRQ0 < SIM_EXCEPTION_COUNT)
+		{
+			Sim_Exception_Pend((value & 0x1FF) + SIM_EXCEPTION_IRQ0);
+		}
+		return;
+	}
+	Sim_Store(reg, size, value);
+}
+
+static uint32_t Sim_SCB_Read(const void *reg, unsigned int size)
+{
+	if (reg == &Sim_SCB.ICSR.raw)
+	{
+		int priority;
+		int pending = Sim_Highest_Pending(&priority);
+		uint32_t value = 0;
+
+		if (Sim_Active_Count)
+		{
+			value |= Sim_Active[Sim_Active_Count - 1] & 0x1FF;
+		}
+		if (pending >= 0)
+		{
+			value |= (uint32_t)pending << 12;
+		}
+		for (int word = 0; word < 8; word++)
+		{
+			if (Sim_IRQ_Word(Sim_Pending, word))
+			{
+				value |= 1UL << 22;
+			}
+		}
+		if (Sim_Bit(Sim_Pending, SIM_EXCEPTION_SYSTICK))
+		{
+			value |= 1UL << 26;
+		}
+		if (Sim_Bit(Sim_Pending, SIM_EXCEPTION_PENDSV))
+		{
+			value |= 1UL << 28;
+		}
+		return value;
+	}
+	return Sim_Load(reg, size);
+}
+
+static void Sim_SCB_Write(void *reg, unsigned int size, uint32_t value)
+{
+	if (reg == &Sim_SCB.ICSR.raw)
+	{
+		if (value & (1UL << 28))
+		{
+			Sim_Exception_Pend(SIM_EXCEPTION_PENDSV);
+		}
+		if (value & (1UL << 27))
+		{
+			Sim_Set_Bit(Sim_Pending, SIM_EXCEPTION_PENDSV, 0);
+		}
+		if (value & (1UL << 26))
+		{
+			Sim_Exception_Pend(SIM_EXCEPTION_SYSTICK);
+		}
+		if (value & (1UL << 25))
+		{
+			Sim_Set_Bit(Sim_Pending, SIM_EXCEPTION_SYSTICK, 0);
+		}
+		return;
+	}
+	if (reg == &Sim_SCB.CPUID.raw)
+	{
+		return;
+	}
+	Sim_Store(reg, size, value);
+}
+
+/**
+ * @brief Returns 1 when the DWT cycle counter is counting.
+ */
+static int Sim_DWT_Counting(void)
+{
+	return (Sim_DWT.CTRL.raw & DWT_CTRL_CYCCNTENA_Msk) && (Sim_CoreDebug.DEMCR.raw & CoreDebug_DEMCR_TRCENA_Msk);
+}
+
+/**
+ * @brief Current CYCCNT: the stored value plus the core cycles since counting (re)started.
+ */
+static uint32_t Sim_DWT_Cycle_Counter(void)
+{
+	if (Sim_DWT_Counting())
+	{
+		return Sim_DWT.CYCCNT.raw + (uint32_t)(Sim_Cycle_Count() - Sim_DWT_Start_Cycles);
+	}
+	return Sim_DWT.CYCCNT.raw;
+}
+
+/**
+ * @brief Applies a write to DWT or DEMCR, keeping CYCCNT continuous across enable changes.
+ */
+static void Sim_DWT_Write(void *reg, uint32_t value)
+{
+	Sim_DWT.CYCCNT.raw = Sim_DWT_Cycle_Counter();
+
+	if (reg == &Sim_DWT.CTRL.raw)
+	{
+		// NOCYCCNT and the other ID fields are read-only
+		Sim_DWT.CTRL.raw = value & ~0xFFFF0000UL;
+	}
+	else
+	{
+		Sim_Store(reg, 4, value);
+	}
+	Sim_DWT_Start_Cycles = Sim_Cycle_Count();
+}
+
+static uint32_t Sim_Route_Read(const void *reg, unsigned int size)
+{
+	int index;
+
+	if ((index = Sim_Instance(reg, Sim_UART, sizeof(Sim_UART[0]), 8)) >= 0)
+	{
+		return Sim_UART_Read(index, reg);
+	}
+	if ((index = Sim_Instance(reg, Sim_GPIO, sizeof(Sim_GPIO[0]), 6)) >= 0)
+	{
+		return Sim_GPIO_Read(index, reg);
+	}
+	if ((index = Sim_Instance(reg, Sim_Timer, sizeof(Sim_Timer[0]), 6)) >= 0)
+	{
+		return Sim_Timer_Read(0, index, reg);
+	}
+	if ((index = Sim_Instance(reg, Sim_Wide_Timer, sizeof(Sim_Wide_Timer[0]), 6)) >= 0)
+	{
+		return Sim_Timer_Read(1, index, reg);
+	}
+	if (Sim_Within(reg, &Sim_SysTick, sizeof(Sim_SysTick)))
+	{
+		return Sim_SysTick_Read(reg);
+	}
+	if (Sim_Within(reg, &Sim_SYSCTL, sizeof(Sim_SYSCTL)))
+	{
+		return Sim_SysCtl_Read(reg);
+	}
+	if (Sim_Within(reg, &Sim_EEPROM, sizeof(Sim_EEPROM)))
+	{
+		return Sim_EEPROM_Read(reg);
+	}
+	if (Sim_Within(reg, &Sim_NVIC, sizeof(Sim_NVIC)))
+	{
+		return Sim_NVIC_Read(reg, size);
+	}
+	if (Sim_Within(reg, &Sim_SCB, sizeof(Sim_SCB)))
+	{
+		return Sim_SCB_Read(reg, size);
+	}
+	if (reg == &Sim_DWT.CYCCNT.raw)
+	{
+		return Sim_DWT_Cycle_Counter();
+	}
+	return Sim_Load(reg, size);
+}
+
+static void Sim_Route_Write(void *reg, unsigned int size, uint32_t value)
+{
+	int index;
+
+	if ((index = Sim_Instance(reg, Sim_UART, sizeof(Sim_UART[0]), 8)) >= 0)
+	{
+		Sim_UART_Write(index, reg, value);
+	}
+	else if ((index = Sim_Instance(reg, Sim_GPIO, sizeof(Sim_GPIO[0]), 6)) >= 0)
+	{
+		Sim_GPIO_Write(index, reg, value);
+	}
+	else if ((index = Sim_Instance(reg, Sim_Timer, sizeof(Sim_Timer[0]), 6)) >= 0)
+	{
+		Sim_Timer_Write(0, index, reg, value);
+	}
+	else if ((index = Sim_Instance(reg, Sim_Wide_Timer, sizeof(Sim_Wide_Timer[0]), 6)) >= 0)
+	{
+		Sim_Timer_Write(1, index, reg, value);
+	}
+	else if (Sim_Within(reg, &Sim_SysTick, sizeof(Sim_SysTick)))
+	{
+		Sim_SysTick_Write(reg, value);
+	}
+	else if (Sim_Within(reg, &Sim_SYSCTL, sizeof(Sim_SYSCTL)))
+	{
+		Sim_SysCtl_Write(reg, value);
+	}
+	else if (Sim_Within(reg, &Sim_EEPROM, sizeof(Sim_EEPROM)))
+	{
+		Sim_EEPROM_Write(reg, value);
+	}
+	else if (Sim_Within(reg, &Sim_NVIC, sizeof(Sim_NVIC)))
+	{
+		Sim_NVIC_Write(reg, size, value);
+	}
+	else if (Sim_Within(reg, &Sim_SCB, sizeof(Sim_SCB)))
+	{
+		Sim_SCB_Write(reg, size, value);
+	}
+	else if (Sim_Within(reg, &Sim_DWT, sizeof(Sim_DWT)) || reg == &Sim_CoreDebug.DEMCR.raw)
+	{
+		Sim_DWT_Write(reg, value);
+	}
+	else
+	{
+		Sim_Store(reg, size, value);
+	}
+}
+
+uint32_t Sim_Register_Read(const void *reg, unsigned int size)
+{
+	uint32_t value;
+
+	Sim_Busy++;
+	SIM_BARRIER();
+	Sim_Access(1);
+	value = Sim_Route_Read(reg, size);
+	SIM_BARRIER();
+	Sim_Busy--;
+
+	return value;
+}
+
+void Sim_Register_Write(void *reg, unsigned int size, uint32_t value)
+{
+	Sim_Busy++;
+	SIM_BARRIER();
+	Sim_Access(0);
+	Sim_Route_Write(reg, size, value);
+	Sim_State_Version++;
+	Sim_Dispatch_Interrupts();
+	SIM_BARRIER();
+	Sim_Busy--;
+}
+
+void __enable_irq(void)
+{
+	Sim_Busy++;
+	SIM_BARRIER();
+	Sim_PRIMASK = 0;
+	Sim_Consume_Cycles(1);
+	SIM_BARRIER();
+	Sim_Busy--;
+}
+
+void __disable_irq(void)
+{
+	Sim_Busy++;
+	SIM_BARRIER();
+	Sim_Consume_Cycles(1);
+	Sim_PRIMASK = 1;
+	SIM_BARRIER();
+	Sim_Busy--;
+}
+
+uint32_t __get_PRIMASK(void)
+{
+	return Sim_PRIMASK;
+}
+
+void __set_PRIMASK(uint32_t primask)
+{
+	if (primask & 1)
+	{
+		__disable_irq();
+	}
+	else
+	{
+		__enable_irq();
+	}
+}
+
+uint32_t __get_IPSR(void)
+{
+	return Sim_Active_Count ? (uint32_t)Sim_Active[Sim_Active_Count - 1] : 0;
+}
+
+/**
+ * @brief Returns non-zero when an enabled interrupt could preempt the current context,
+ * ignoring PRIMASK, which is the condition that ends WFI.
+ */
+static int Sim_Wake_Pending(void)
+{
+	int priority;
+	return Sim_Highest_Pending(&priority) >= 0 && priority < Sim_Running_Priority();
+}
+
+void __WFI(void)
+{
+	Sim_Busy++;
+	SIM_BARRIER();
+
+	Sim_Consume_Cycles(1);
+
+	uint64_t taken = Sim_Exceptions_Taken;
+	uint64_t start = Sim_Time;
+
+	while (!Sim_Wake_Pending() && Sim_Exceptions_Taken == taken)
+	{
+		uint64_t next = Sim_Next_Event_Time();
+		if (next == SIM_NEVER)
+		{
+			Sim_Fatal("WFI with no event left that could wake the core");
+		}
+		Sim_Run_Until(next);
+	}
+	Sim_Stats.sleep_time += Sim_Time - start;
+	Sim_Dispatch_Interrupts();
+
+	SIM_BARRIER();
+	Sim_Busy--;
+}
+
+void __WFE(void)
+{
+	__WFI();
+}
+
+void __NOP(void)
+{
+}
+
+void __DSB(void)
+{
+}
+
+void __ISB(void)
+{
+}
+
+void __DMB(void)
+{
+}
+
+uint32_t __LDREXW(volatile uint32_t *address)
+{
+	Sim_Busy++;
+	SIM_BARRIER();
+
+	Sim_Consume_Cycles(2);
+	uint32_t value = *address;
+	Sim_Exclusive_Address = address;
+
+	SIM_BARRIER();
+	Sim_Busy--;
+	return value;
+}
+
+uint32_t __STREXW(uint32_t value, volatile uint32_t *address)
+{
+	Sim_Busy++;
+	SIM_BARRIER();
+
+	// An exception taken before the store clears the monitor, and the store fails
+	Sim_Consume_Cycles(1);
+	uint32_t failed = (Sim_Exclusive_Address != address);
+	if (!failed)
+	{
+		*address = value;
+	}
+	Sim_Exclusive_Address = NULL;
+	Sim_Consume_Cycles(1);
+
+	SIM_BARRIER();
+	Sim_Busy--;
+	return failed;
+}
+
+void __CLREX(void)
+{
+	Sim_Exclusive_Address = NULL;
+}
+
+/**
+ * @brief Arms the one-shot stall timer.
+ *
+ * The timer is re-armed at the end of every SIGALRM handler instead of being periodic:
+ * a stall quantum can take longer on the host than the interval, and a periodic timer
+ * would then deliver the next signal before the firmware ran a single instruction.
+ */
+static void Sim_Arm_Stall_Timer(void)
+{
+	struct itimerval interval;
+
+	memset(&interval, 0, sizeof(interval));
+	interval.it_value.tv_sec = Sim_Options.stall_interval_us / 1000000;
+	interval.it_value.tv_usec = Sim_Options.stall_interval_us % 1000000;
+	setitimer(ITIMER_REAL, &interval, NULL);
+}
+
+/**
+ * @brief SIGALRM handler: advances time when the firmware spins without touching a register.
+ *
+ * Only a thread-mode loop is treated as a stall. Advancing from inside a handler would
+ * pend the handler's own interrupt again without running it and lose its ticks.
+ */
+static void Sim_Stall_Handler(int signal_number)
+{
+	(void)signal_number;
+
+	if (!Sim_Busy && Sim_Active_Count == 0)
+	{
+		if (Sim_Access_Count == Sim_Stall_Seen)
+		{
+			Sim_Busy++;
+			SIM_BARRIER();
+			Sim_Stats.stall_advances++;
+			Sim_Run_Until(Sim_Time + Sim_Options.stall_quantum);
+			SIM_BARRIER();
+			Sim_Busy--;
+		}
+		Sim_Stall_Seen = Sim_Access_Count;
+	}
+
+	Sim_Arm_Stall_Timer();
+}
+
+void Sim_Start_Stall_Detector(void)
+{
+	struct sigaction action;
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = Sim_Stall_Handler;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGALRM, &action, NULL);
+
+	Sim_Arm_Stall_Timer();
+}
+
+void Sim_Stop_Stall_Detector(void)
+{
+	struct itimerval interval;
+
+	memset(&interval, 0, sizeof(interval));
+	setitimer(ITIMER_REAL, &interval, NULL);
+}
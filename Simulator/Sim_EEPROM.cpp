@@ -0,0 +1,198 @@
+/**
+ * @file Sim_EEPROM.cpp
+ *
+ * @brief EEPROM model: 2 KB in 32 blocks of 16 words.
+ *
+ * EERDWR reads and writes the word selected by EEBLOCK and EEOFFSET, EERDWRINC does the
+ * same and then moves EEOFFSET to the next word of the block. A write keeps EEDONE
+ * WORKING set for SIM_EEPROM_WRITE_TIME, and the word only changes once it is done.
+ * Power-loss recovery always succeeds: EESUPP reads 0.
+ *
+ * The contents start erased, or are loaded from an image file with "config eeprom FILE"
+ * or --eeprom FILE, so a scenario can boot with the settings another run saved. The image
+ * holds one "address value" line, in hexadecimal, per word that is not erased.
+ * Every completed write is passed to Sim_EEPROM_Write_Hook.
+ */
+
+#include "Simulator.h"
+#include <string.h>
+
+#define SIM_EEPROM_WORDS          512
+#define SIM_EEPROM_BLOCK_WORDS    16
+#define SIM_EEPROM_ERASED         0xFFFFFFFFUL
+
+#define SIM_EEPROM_WRITE_TIME     (100 * SIM_US)
+
+#define SIM_EEPROM_EEDONE_WORKING 0x01
+
+EEPROM_Type Sim_EEPROM;
+
+Sim_EEPROM_Stats_Type Sim_EEPROM_Stats;
+
+void (*Sim_EEPROM_Write_Hook)(int address, uint32_t value);
+
+static uint32_t Sim_EEPROM_Words[SIM_EEPROM_WORDS];
+static int Sim_EEPROM_Busy;
+
+void Sim_EEPROM_Reset(void)
+{
+	memset((void *)&Sim_EEPROM, 0, sizeof(Sim_EEPROM));
+	Sim_EEPROM.EESIZE.raw = (SIM_EEPROM_WORDS / SIM_EEPROM_BLOCK_WORDS) << 16 | SIM_EEPROM_WORDS;
+	Sim_EEPROM_Busy = 0;
+
+	for (int i = 0; i < SIM_EEPROM_WORDS; i++)
+	{
+		Sim_EEPROM_Words[i] = SIM_EEPROM_ERASED;
+	}
+	memset(&Sim_EEPROM_Stats, 0, sizeof(Sim_EEPROM_Stats));
+}
+
+int Sim_EEPROM_Load(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	unsigned int address;
+	unsigned int value;
+
+	if (file == NULL)
+	{
+		return 0;
+	}
+
+	while (fscanf(file, "%x %x", &address, &value) == 2)
+	{
+		if (address < SIM_EEPROM_WORDS)
+		{
+			Sim_EEPROM_Words[address] = value;
+		}
+	}
+
+	fclose(file);
+	return 1;
+}
+
+int Sim_EEPROM_Save(const char *path)
+{
+	FILE *file = fopen(path, "w");
+
+	if (file == NULL)
+	{
+		return 0;
+	}
+
+	for (int i = 0; i < SIM_EEPROM_WORDS; i++)
+	{
+		if (Sim_EEPROM_Words[i] != SIM_EEPROM_ERASED)
+		{
+			fprintf(file, "%03x %08x\n", i, Sim_EEPROM_Words[i]);
+		}
+	}
+
+	fclose(file);
+	return 1;
+}
+
+uint32_t Sim_EEPROM_Word(int address)
+{
+	return Sim_EEPROM_Words[address % SIM_EEPROM_WORDS];
+}
+
+static int Sim_EEPROM_Address(void)
+{
+	return (Sim_EEPROM.EEBLOCK.raw % (SIM_EEPROM_WORDS / SIM_EEPROM_BLOCK_WORDS)) * SIM_EEPROM_BLOCK_WORDS
+		+ Sim_EEPROM.EEOFFSET.raw % SIM_EEPROM_BLOCK_WORDS;
+}
+
+static void Sim_EEPROM_Next_Offset(void)
+{
+	Sim_EEPROM.EEOFFSET.raw = (Sim_EEPROM.EEOFFSET.raw + 1) % SIM_EEPROM_BLOCK_WORDS;
+}
+
+static void Sim_EEPROM_Write_Done(void *context, uint32_t argument)
+{
+	(void)context;
+
+	Sim_EEPROM_Words[argument >> 16] = Sim_EEPROM.EERDWR.raw;
+	Sim_EEPROM_Busy = 0;
+	Sim_State_Version++;
+
+	if (Sim_EEPROM_Write_Hook)
+	{
+		Sim_EEPROM_Write_Hook(argument >> 16, Sim_EEPROM.EERDWR.raw);
+	}
+}
+
+static void Sim_EEPROM_Program(uint32_t value)
+{
+	int address = Sim_EEPROM_Address();
+
+	if (Sim_EEPROM_Busy)
+	{
+		Sim_Warning("EEPROM written while a write is in progress, the write is lost");
+		return;
+	}
+
+	// The word is held in EERDWR.raw until the write completes
+	Sim_EEPROM.EERDWR.raw = value;
+	Sim_EEPROM_Busy = 1;
+	Sim_EEPROM_Stats.writes++;
+	Sim_Schedule(Sim_Time + SIM_EEPROM_WRITE_TIME, Sim_EEPROM_Write_Done, NULL, (uint32_t)address << 16);
+}
+
+uint32_t Sim_EEPROM_Read(const void *reg)
+{
+	if (!Sim_SysCtl_Clock_Enabled(&Sim_SYSCTL.RCGCEEPROM, 0))
+	{
+		Sim_Warning("EEPROM accessed while its clock is disabled (bus fault on the board)");
+	}
+
+	if (reg == &Sim_EEPROM.EEDONE.raw)
+	{
+		return Sim_EEPROM_Busy ? SIM_EEPROM_EEDONE_WORKING : 0;
+	}
+	if (reg == &Sim_EEPROM.EERDWR.raw || reg == &Sim_EEPROM.EERDWRINC.raw)
+	{
+		uint32_t value = Sim_EEPROM_Words[Sim_EEPROM_Address()];
+
+		if (Sim_EEPROM_Busy)
+		{
+			Sim_Warning("EEPROM read while a write is in progress");
+		}
+		if (reg == &Sim_EEPROM.EERDWRINC.raw)
+		{
+			Sim_EEPROM_Next_Offset();
+		}
+		Sim_EEPROM_Stats.reads++;
+		return value;
+	}
+
+	return *(const uint32_t *)reg;
+}
+
+void Sim_EEPROM_Write(void *reg, uint32_t value)
+{
+	if (!Sim_SysCtl_Clock_Enabled(&Sim_SYSCTL.RCGCEEPROM, 0))
+	{
+		Sim_Warning("EEPROM accessed while its clock is disabled (bus fault on the board)");
+	}
+
+	if (reg == &Sim_EEPROM.EERDWR.raw || reg == &Sim_EEPROM.EERDWRINC.raw)
+	{
+		Sim_EEPROM_Program(value);
+		if (reg == &Sim_EEPROM.EERDWRINC.raw)
+		{
+			Sim_EEPROM_Next_Offset();
+		}
+	}
+	else if (reg == &Sim_EEPROM.EEBLOCK.raw || reg == &Sim_EEPROM.EEOFFSET.raw)
+	{
+		if (Sim_EEPROM_Busy)
+		{
+			Sim_Warning("EEPROM address changed while a write is in progress");
+		}
+		Sim_Store(reg, 4, value);
+	}
+	else if (reg != &Sim_EEPROM.EESIZE.raw && reg != &Sim_EEPROM.EEDONE.raw && reg != &Sim_EEPROM.EESUPP.raw)
+	{
+		Sim_Store(reg, 4, value);
+	}
+}
@@ -0,0 +1,111 @@
+/**
+ * @file Sim_GPIO.cpp
+ *
+ * @brief GPIO Ports A to F.
+ *
+ * A pin is driven by the DATA register when it is a digital output: DIR set, AFSEL
+ * clear and DEN set. Every change of the driven value is passed to Sim_GPIO_Output_Hook,
+ * which the scenario runner uses for waveform assertions and the VCD dump.
+ * Input pins read the level set by the scenario (Sim_GPIO_Set_Input).
+ *
+ * @note The address-masked DATA_Bits aliases and the GPIO interrupts are not modelled.
+ */
+
+#include "Simulator.h"
+#include <string.h>
+
+void (*Sim_GPIO_Output_Hook)(int port, uint32_t previous, uint32_t current);
+
+static uint32_t Sim_GPIO_Driven[SIM_GPIO_COUNT];
+static uint32_t Sim_GPIO_Input[SIM_GPIO_COUNT];
+static uint8_t Sim_GPIO_Warned[SIM_GPIO_COUNT];
+
+static uint32_t Sim_GPIO_Compute_Output(int port)
+{
+	GPIOA_Type *gpio = &Sim_GPIO[port];
+	uint32_t outputs = gpio->DIR.raw & ~gpio->AFSEL.raw & gpio->DEN.raw & 0xFF;
+
+	return gpio->DATA.raw & outputs;
+}
+
+static void Sim_GPIO_Update(int port)
+{
+	uint32_t previous = Sim_GPIO_Driven[port];
+	uint32_t current = Sim_GPIO_Compute_Output(port);
+
+	if (current != previous)
+	{
+		Sim_GPIO_Driven[port] = current;
+		if (Sim_GPIO_Output_Hook)
+		{
+			Sim_GPIO_Output_Hook(port, previous, current);
+		}
+	}
+}
+
+static void Sim_GPIO_Check_Clock(int port)
+{
+	if (!Sim_SysCtl_Clock_Enabled(&Sim_SYSCTL.RCGCGPIO, port) && !Sim_GPIO_Warned[port])
+	{
+		Sim_GPIO_Warned[port] = 1;
+		Sim_Warning("GPIO Port %c accessed while its clock is disabled in RCGCGPIO (bus fault on the board)", 'A' + port);
+	}
+}
+
+void Sim_GPIO_Reset(void)
+{
+	memset((void *)Sim_GPIO, 0, sizeof(Sim_GPIO));
+	memset(Sim_GPIO_Driven, 0, sizeof(Sim_GPIO_Driven));
+	memset(Sim_GPIO_Input, 0, sizeof(Sim_GPIO_Input));
+	memset(Sim_GPIO_Warned, 0, sizeof(Sim_GPIO_Warned));
+
+	for (int port = 0; port < SIM_GPIO_COUNT; port++)
+	{
+		Sim_GPIO[port].LOCK.raw = 0x01;
+		Sim_GPIO[port].CR.raw = 0xFF;
+	}
+}
+
+uint32_t Sim_GPIO_Read(int port, const void *reg)
+{
+	GPIOA_Type *gpio = &Sim_GPIO[port];
+
+	Sim_GPIO_Check_Clock(port);
+
+	if (reg == &gpio->DATA.raw)
+	{
+		return (gpio->DATA.raw & gpio->DIR.raw) | (Sim_GPIO_Input[port] & ~gpio->DIR.raw & 0xFF);
+	}
+	return *(const uint32_t *)reg;
+}
+
+void Sim_GPIO_Write(int port, void *reg, uint32_t value)
+{
+	GPIOA_Type *gpio = &Sim_GPIO[port];
+
+	Sim_GPIO_Check_Clock(port);
+
+	if (reg == &gpio->LOCK.raw)
+	{
+		gpio->LOCK.raw = (value == 0x4C4F434B) ? 0x00 : 0x01;
+		return;
+	}
+
+	Sim_Store(reg, 4, value);
+
+	if (reg == &gpio->DATA.raw || reg == &gpio->DIR.raw || reg == &gpio->AFSEL.raw || reg == &gpio->DEN.raw)
+	{
+		Sim_GPIO_Update(port);
+	}
+}
+
+uint32_t Sim_GPIO_Output(int port)
+{
+	return Sim_GPIO_Driven[port];
+}
+
+void Sim_GPIO_Set_Input(int port, uint32_t mask, uint32_t value)
+{
+	Sim_GPIO_Input[port] = (Sim_GPIO_Input[port] & ~mask) | (value & mask);
+	Sim_State_Version++;
+}
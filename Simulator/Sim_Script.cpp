@@ -0,0 +1,1111 @@
+/**
+ * @file Sim_Script.cpp
+ *
+ * @brief Scenario scripts, assertions, run report and main() of the simulator.
+ *
+ * A scenario is a text file with one command per line. Commands are placed on a
+ * timeline: "wait" moves the script cursor forward, every other command happens at
+ * the cursor. Assertions are armed at the cursor and resolve on their own, so several
+ * can be pending while the firmware runs.
+ *
+ *   # comment
+ *   config baud ble 9600                 peer baud rate of a channel
+ *   config ble connected 0               state reported by the BLE module to AT+GAPGETCONN
+ *   config stall_quantum 1 ms            time advanced when the firmware spins on RAM
+ *   config trace on                      log every line sent or received
+ *   config eeprom warm_start.eeprom      EEPROM contents at power-up, relative to the scenario
+ *   wait 1500 ms                         units: ns, us, ms, s
+ *   send ble "PAUSE\n"                   the peer transmits (escapes: \r \n \t \\ \" \xHH)
+ *   input gpio F 0x11 0x00               drive input pins
+ *   input stack 0x100 0x0                write the stack word at a byte offset from its base
+ *   expect arduino "PAUSE" within 50 ms  the firmware must transmit the text in time
+ *   reject arduino "RESUME" for 2 s      the firmware must not transmit the text
+ *   expect gpio A 0x3C == 0x00 within 2 s
+ *   expect gpio A 0x3C changes within 2 s
+ *   expect gpio A 0x3C stepping 3.9 ms to 4.2 ms for 20 steps within 2 s
+ *   expect motor stopped | running | stepping ... (gpio A 0x3C)
+ *   expect eeprom 0x002 == 0x8 within 10 ms  the EEPROM word at the address must hold the value
+ *   end                                  print the report and exit
+ *
+ * Channels: console (UART0), ble (UART1), arduino (UART3), or uart0 to uart7.
+ *
+ * Usage: music_box_sim [--trace] [--vcd FILE] [--capture FILE] [--eeprom FILE] [--werror] [--stall-us N] SCENARIO
+ *   --trace         same as "config trace on"
+ *   --vcd FILE      dump the GPIO outputs as a value change dump for GTKWave
+ *   --capture FILE  write the raw bytes sent on UART0, for tools/log_decode.py
+ *   --eeprom FILE   load the EEPROM from FILE if it exists, and save it there at the end
+ *   --werror        fail the run when the model reported a warning (overrun, clock gating, ...)
+ *   --stall-us N    host microseconds without a register access before a stall is assumed
+ *
+ * The exit status is 0 when every assertion passed, 1 when one failed and 2 when the
+ * scenario or the model hit an error.
+ */
+
+#include "Simulator.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#define SIM_SCRIPT_MAX_ACTIONS   512
+#define SIM_SCRIPT_MAX_TOKENS    24
+#define SIM_SCRIPT_MAX_TEXT      240
+#define SIM_HISTORY_SIZE         256
+#define SIM_LINE_SIZE            160
+
+#define SIM_MOTOR_PORT           0
+#define SIM_MOTOR_MASK           0x3C
+
+typedef enum {
+	SIM_ACTION_SEND,
+	SIM_ACTION_INPUT,
+	SIM_ACTION_EXPECT_TEXT,
+	SIM_ACTION_REJECT_TEXT,
+	SIM_ACTION_EXPECT_VALUE,
+	SIM_ACTION_EXPECT_CHANGE,
+	SIM_ACTION_EXPECT_STEPPING,
+	SIM_ACTION_EXPECT_EEPROM,
+	SIM_ACTION_END
+} Sim_Action_Type;
+
+typedef enum {
+	SIM_PENDING,
+	SIM_ARMED,
+	SIM_PASSED,
+	SIM_FAILED
+} Sim_Result;
+
+typedef struct {
+	Sim_Action_Type type;
+	int line;
+	uint64_t time;
+	int channel;
+	char text[SIM_SCRIPT_MAX_TEXT];
+	int length;
+	uint64_t duration;
+	int port;
+	int address;
+	uint32_t mask;
+	uint32_t value;
+	uint64_t interval_min;
+	uint64_t interval_max;
+	int steps;
+
+	// Run-time state of an assertion
+	Sim_Result result;
+	uint64_t armed_time;
+	uint64_t armed_count;
+	uint64_t resolved_time;
+	uint64_t last_change;
+	int steps_seen;
+	uint64_t interval_seen_min;
+	uint64_t interval_seen_max;
+	uint64_t interval_total;
+	char detail[96];
+} Sim_Action;
+
+static Sim_Action Sim_Actions[SIM_SCRIPT_MAX_ACTIONS];
+static int Sim_Action_Count;
+static const char *Sim_Scenario_Name;
+static FILE *Sim_VCD;
+static FILE *Sim_Capture;
+static const char *Sim_EEPROM_Image;
+static struct timespec Sim_Host_Start;
+
+// Everything each UART transmitted, for the text assertions and the transcript
+static uint8_t Sim_History[SIM_UART_COUNT][SIM_HISTORY_SIZE];
+static uint64_t Sim_History_Count[SIM_UART_COUNT];
+static char Sim_Line[SIM_UART_COUNT][SIM_LINE_SIZE];
+static int Sim_Line_Length[SIM_UART_COUNT];
+
+static const char *Sim_Channel_Names[SIM_UART_COUNT] = {
+	"console", "ble", "uart2", "arduino", "uart4", "uart5", "uart6", "uart7"
+};
+
+static void __attribute__((noreturn)) Sim_Script_Error(int line, const char *message, const char *token)
+{
+	fprintf(stderr, "%s:%d: %s%s%s\n", Sim_Scenario_Name, line, message, token ? ": " : "", token ? token : "");
+	exit(2);
+}
+
+static void Sim_Format_Text(char *output, size_t size, const char *text, int length)
+{
+	size_t used = 0;
+
+	for (int i = 0; i < length && used + 5 < size; i++)
+	{
+		unsigned char character = (unsigned char)text[i];
+		if (character == '\n')
+		{
+			used += snprintf(output + used, size - used, "\\n");
+		}
+		else if (character == '\r')
+		{
+			used += snprintf(output + used, size - used, "\\r");
+		}
+		else if (character < 0x20 || character >= 0x7F)
+		{
+			used += snprintf(output + used, size - used, "\\x%02X", character);
+		}
+		else
+		{
+			output[used++] = (char)character;
+		}
+	}
+	output[used] = 0;
+}
+
+/**
+ * @brief Splits a script line into tokens. Quoted strings keep their escapes decoded
+ * and are marked with a leading '"' so they cannot be confused with keywords.
+ */
+static int Sim_Tokenize(char *line, int line_number, char tokens[][SIM_SCRIPT_MAX_TEXT + 1], int *lengths)
+{
+	int count = 0;
+	char *p = line;
+
+	for (;;)
+	{
+		while (isspace((unsigned char)*p))
+		{
+			p++;
+		}
+		if (*p == 0 || *p == '#')
+		{
+			return count;
+		}
+		if (count == SIM_SCRIPT_MAX_TOKENS)
+		{
+			Sim_Script_Error(line_number, "too many words", NULL);
+		}
+
+		char *token = tokens[count];
+		int length = 0;
+
+		if (*p == '"')
+		{
+			token[length++] = '"';
+			p++;
+			while (*p && *p != '"')
+			{
+				char character = *p++;
+				if (character == '\\')
+				{
+					character = *p++;
+					switch (character)
+					{
+						case 'n': character = '\n'; break;
+						case 'r': character = '\r'; break;
+						case 't': character = '\t'; break;
+						case '0': character = 0; break;
+						case 'x':
+						{
+							char hex[3] = { p[0], p[0] ? p[1] : (char)0, 0 };
+							character = (char)strtoul(hex, NULL, 16);
+							p += strlen(hex);
+							break;
+						}
+						case 0:
+							Sim_Script_Error(line_number, "unterminated string", NULL);
+						default:
+							break;
+					}
+				}
+				if (length > SIM_SCRIPT_MAX_TEXT - 1)
+				{
+					Sim_Script_Error(line_number, "string too long", NULL);
+				}
+				token[length++] = character;
+			}
+			if (*p != '"')
+			{
+				Sim_Script_Error(line_number, "unterminated string", NULL);
+			}
+			p++;
+		}
+		else
+		{
+			while (*p && !isspace((unsigned char)*p) && length < SIM_SCRIPT_MAX_TEXT)
+			{
+				token[length++] = *p++;
+			}
+		}
+		token[length] = 0;
+		lengths[count] = length;
+		count++;
+	}
+}
+
+static uint64_t Sim_Parse_Duration(char tokens[][SIM_SCRIPT_MAX_TEXT + 1], int count, int *index, int line)
+{
+	if (*index + 1 >= count)
+	{
+		Sim_Script_Error(line, "expected a duration such as \"10 ms\"", NULL);
+	}
+
+	char *end;
+	double value = strtod(tokens[*index], &end);
+	const char *unit = tokens[*index + 1];
+	uint64_t scale;
+
+	if (*end || value < 0)
+	{
+		Sim_Script_Error(line, "bad number", tokens[*index]);
+	}
+
+	if (strcmp(unit, "ns") == 0)
+	{
+		scale = SIM_NS;
+	}
+	else if (strcmp(unit, "us") == 0)
+	{
+		scale = SIM_US;
+	}
+	else if (strcmp(unit, "ms") == 0)
+	{
+		scale = SIM_MS;
+	}
+	else if (strcmp(unit, "s") == 0)
+	{
+		scale = SIM_S;
+	}
+	else
+	{
+		Sim_Script_Error(line, "unknown time unit", unit);
+	}
+
+	*index += 2;
+	return (uint64_t)(value * (double)scale + 0.5);
+}
+
+static uint32_t Sim_Parse_Number(const char *token, int line)
+{
+	char *end;
+	unsigned long value = strtoul(token, &end, 0);
+
+	if (*end || !*token)
+	{
+		Sim_Script_Error(line, "bad number", token);
+	}
+	return (uint32_t)value;
+}
+
+static int Sim_Parse_Channel(const char *token, int line)
+{
+	for (int index = 0; index < SIM_UART_COUNT; index++)
+	{
+		char alias[8];
+		snprintf(alias, sizeof(alias), "uart%d", index);
+		if (strcmp(token, Sim_Channel_Names[index]) == 0 || strcmp(token, alias) == 0)
+		{
+			return index;
+		}
+	}
+	Sim_Script_Error(line, "unknown channel", token);
+}
+
+static int Sim_Parse_Port(const char *token, int line)
+{
+	if (strlen(token) == 1 && toupper((unsigned char)token[0]) >= 'A' && toupper((unsigned char)token[0]) <= 'F')
+	{
+		return toupper((unsigned char)token[0]) - 'A';
+	}
+	Sim_Script_Error(line, "unknown GPIO port", token);
+}
+
+static const char *Sim_Expect_Word(char tokens[][SIM_SCRIPT_MAX_TEXT + 1], int count, int index, int line)
+{
+	if (index >= count)
+	{
+		Sim_Script_Error(line, "line ends too early", NULL);
+	}
+	return tokens[index];
+}
+
+static void Sim_Parse_Text(Sim_Action *action, char tokens[][SIM_SCRIPT_MAX_TEXT + 1], int *lengths, int count, int index, int line)
+{
+	if (index >= count || tokens[index][0] != '"')
+	{
+		Sim_Script_Error(line, "expected a quoted string", NULL);
+	}
+	action->length = lengths[index] - 1;
+	memcpy(action->text, tokens[index] + 1, action->length);
+	action->text[action->length] = 0;
+}
+
+/**
+ * @brief Parses the GPIO condition of an expect command, starting after the port and mask.
+ */
+static int Sim_Parse_GPIO_Condition(Sim_Action *action, char tokens[][SIM_SCRIPT_MAX_TEXT + 1], int count, int index, int line)
+{
+	const char *word = Sim_Expect_Word(tokens, count, index, line);
+
+	if (strcmp(word, "==") == 0)
+	{
+		action->type = SIM_ACTION_EXPECT_VALUE;
+		action->value = Sim_Parse_Number(Sim_Expect_Word(tokens, count, index + 1, line), line);
+		return index + 2;
+	}
+	if (strcmp(word, "changes") == 0)
+	{
+		action->type = SIM_ACTION_EXPECT_CHANGE;
+		return index + 1;
+	}
+	if (strcmp(word, "stepping") == 0)
+	{
+		index++;
+		action->type = SIM_ACTION_EXPECT_STEPPING;
+		action->interval_min = Sim_Parse_Duration(tokens, count, &index, line);
+		if (strcmp(Sim_Expect_Word(tokens, count, index, line), "to") != 0)
+		{
+			Sim_Script_Error(line, "expected \"to\"", tokens[index]);
+		}
+		index++;
+		action->interval_max = Sim_Parse_Duration(tokens, count, &index, line);
+		if (strcmp(Sim_Expect_Word(tokens, count, index, line), "for") != 0)
+		{
+			Sim_Script_Error(line, "expected \"for\"", tokens[index]);
+		}
+		action->steps = (int)Sim_Parse_Number(Sim_Expect_Word(tokens, count, index + 1, line), line);
+		if (strcmp(Sim_Expect_Word(tokens, count, index + 2, line), "steps") != 0)
+		{
+			Sim_Script_Error(line, "expected \"steps\"", tokens[index + 2]);
+		}
+		return index + 3;
+	}
+	Sim_Script_Error(line, "unknown GPIO condition", word);
+}
+
+static void Sim_Parse_Within(Sim_Action *action, char tokens[][SIM_SCRIPT_MAX_TEXT + 1], int count, int index, int line, const char *keyword)
+{
+	if (strcmp(Sim_Expect_Word(tokens, count, index, line), keyword) != 0)
+	{
+		Sim_Script_Error(line, keyword[0] == 'w' ? "expected \"within\"" : "expected \"for\"", tokens[index]);
+	}
+	index++;
+	action->duration = Sim_Parse_Duration(tokens, count, &index, line);
+	if (index != count)
+	{
+		Sim_Script_Error(line, "unexpected word", tokens[index]);
+	}
+}
+
+static Sim_Action *Sim_New_Action(Sim_Action_Type type, int line, uint64_t time)
+{
+	if (Sim_Action_Count == SIM_SCRIPT_MAX_ACTIONS)
+	{
+		Sim_Script_Error(line, "too many commands", NULL);
+	}
+
+	Sim_Action *action = &Sim_Actions[Sim_Action_Count++];
+	memset(action, 0, sizeof(*action));
+	action->type = type;
+	action->line = line;
+	action->time = time;
+	return action;
+}
+
+static void Sim_Load_Scenario(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	char line[1024];
+	static char tokens[SIM_SCRIPT_MAX_TOKENS][SIM_SCRIPT_MAX_TEXT + 1];
+	int lengths[SIM_SCRIPT_MAX_TOKENS];
+	int line_number = 0;
+	uint64_t cursor = 0;
+	int ended = 0;
+
+	if (!file)
+	{
+		fprintf(stderr, "cannot open scenario %s\n", path);
+		exit(2);
+	}
+
+	while (fgets(line, sizeof(line), file))
+	{
+		line_number++;
+		int count = Sim_Tokenize(line, line_number, tokens, lengths);
+		if (count == 0)
+		{
+			continue;
+		}
+		if (ended)
+		{
+			Sim_Script_Error(line_number, "command after end", tokens[0]);
+		}
+
+		const char *command = tokens[0];
+
+		if (strcmp(command, "wait") == 0)
+		{
+			int index = 1;
+			cursor += Sim_Parse_Duration(tokens, count, &index, line_number);
+		}
+		else if (strcmp(command, "config") == 0)
+		{
+			const char *option = Sim_Expect_Word(tokens, count, 1, line_number);
+			if (strcmp(option, "baud") == 0)
+			{
+				int channel = Sim_Parse_Channel(Sim_Expect_Word(tokens, count, 2, line_number), line_number);
+				Sim_UART_Set_Peer_Baud(channel, Sim_Parse_Number(Sim_Expect_Word(tokens, count, 3, line_number), line_number));
+			}
+			else if (strcmp(option, "stall_quantum") == 0)
+			{
+				int index = 2;
+				Sim_Options.stall_quantum = Sim_Parse_Duration(tokens, count, &index, line_number);
+			}
+			else if (strcmp(option, "ble") == 0)
+			{
+				if (strcmp(Sim_Expect_Word(tokens, count, 2, line_number), "connected") != 0)
+				{
+					Sim_Script_Error(line_number, "expected \"connected\"", tokens[2]);
+				}
+				Sim_BLE_Set_Connected(Sim_Parse_Number(Sim_Expect_Word(tokens, count, 3, line_number), line_number) != 0);
+			}
+			else if (strcmp(option, "trace") == 0)
+			{
+				Sim_Options.trace = (strcmp(Sim_Expect_Word(tokens, count, 2, line_number), "on") == 0);
+			}
+			else if (strcmp(option, "eeprom") == 0)
+			{
+				char image[1024];
+				const char *name = Sim_Expect_Word(tokens, count, 2, line_number);
+				const char *slash = strrchr(path, '/');
+
+				snprintf(image, sizeof(image), "%.*s%s", slash ? (int)(slash - path + 1) : 0, path, name);
+				if (!Sim_EEPROM_Load(image))
+				{
+					Sim_Script_Error(line_number, "cannot open EEPROM image", name);
+				}
+			}
+			else
+			{
+				Sim_Script_Error(line_number, "unknown option", option);
+			}
+		}
+		else if (strcmp(command, "send") == 0)
+		{
+			Sim_Action *action = Sim_New_Action(SIM_ACTION_SEND, line_number, cursor);
+			action->channel = Sim_Parse_Channel(Sim_Expect_Word(tokens, count, 1, line_number), line_number);
+			Sim_Parse_Text(action, tokens, lengths, count, 2, line_number);
+		}
+		else if (strcmp(command, "input") == 0)
+		{
+			Sim_Action *action = Sim_New_Action(SIM_ACTION_INPUT, line_number, cursor);
+			const char *target = Sim_Expect_Word(tokens, count, 1, line_number);
+			if (strcmp(target, "stack") == 0)
+			{
+				// No GPIO port, the address is a byte offset into _sstack
+				action->port = -1;
+				action->address = (int)Sim_Parse_Number(Sim_Expect_Word(tokens, count, 2, line_number), line_number);
+				if (action->address % 4 != 0 || action->address >= SIM_STACK_SIZE)
+				{
+					Sim_Script_Error(line_number, "expected a word offset into the stack", tokens[2]);
+				}
+				action->value = Sim_Parse_Number(Sim_Expect_Word(tokens, count, 3, line_number), line_number);
+			}
+			else if (strcmp(target, "gpio") == 0)
+			{
+				action->port = Sim_Parse_Port(Sim_Expect_Word(tokens, count, 2, line_number), line_number);
+				action->mask = Sim_Parse_Number(Sim_Expect_Word(tokens, count, 3, line_number), line_number);
+				action->value = Sim_Parse_Number(Sim_Expect_Word(tokens, count, 4, line_number), line_number);
+			}
+			else
+			{
+				Sim_Script_Error(line_number, "expected \"gpio\" or \"stack\"", target);
+			}
+		}
+		else if (strcmp(command, "expect") == 0 || strcmp(command, "reject") == 0)
+		{
+			int reject = (command[0] == 'r');
+			const char *subject = Sim_Expect_Word(tokens, count, 1, line_number);
+			Sim_Action *action = Sim_New_Action(reject ? SIM_ACTION_REJECT_TEXT : SIM_ACTION_EXPECT_TEXT, line_number, cursor);
+
+			if (strcmp(subject, "gpio") == 0 || strcmp(subject, "motor") == 0)
+			{
+				int index;
+				if (reject)
+				{
+					Sim_Script_Error(line_number, "reject only applies to channels", NULL);
+				}
+				if (subject[0] == 'g')
+				{
+					action->port = Sim_Parse_Port(Sim_Expect_Word(tokens, count, 2, line_number), line_number);
+					action->mask = Sim_Parse_Number(Sim_Expect_Word(tokens, count, 3, line_number), line_number);
+					index = Sim_Parse_GPIO_Condition(action, tokens, count, 4, line_number);
+				}
+				else
+				{
+					const char *state = Sim_Expect_Word(tokens, count, 2, line_number);
+					action->port = SIM_MOTOR_PORT;
+					action->mask = SIM_MOTOR_MASK;
+					index = 3;
+					if (strcmp(state, "stopped") == 0)
+					{
+						action->type = SIM_ACTION_EXPECT_VALUE;
+						action->value = 0;
+					}
+					else if (strcmp(state, "running") == 0)
+					{
+						action->type = SIM_ACTION_EXPECT_CHANGE;
+					}
+					else
+					{
+						index = Sim_Parse_GPIO_Condition(action, tokens, count, 2, line_number);
+					}
+				}
+				Sim_Parse_Within(action, tokens, count, index, line_number, "within");
+			}
+			else if (strcmp(subject, "eeprom") == 0)
+			{
+				if (reject)
+				{
+					Sim_Script_Error(line_number, "reject only applies to channels", NULL);
+				}
+				action->type = SIM_ACTION_EXPECT_EEPROM;
+				action->address = (int)Sim_Parse_Number(Sim_Expect_Word(tokens, count, 2, line_number), line_number);
+				if (strcmp(Sim_Expect_Word(tokens, count, 3, line_number), "==") != 0)
+				{
+					Sim_Script_Error(line_number, "expected \"==\"", tokens[3]);
+				}
+				action->value = Sim_Parse_Number(Sim_Expect_Word(tokens, count, 4, line_number), line_number);
+				Sim_Parse_Within(action, tokens, count, 5, line_number, "within");
+			}
+			else
+			{
+				action->channel = Sim_Parse_Channel(subject, line_number);
+				Sim_Parse_Text(action, tokens, lengths, count, 2, line_number);
+				Sim_Parse_Within(action, tokens, count, 3, line_number, reject ? "for" : "within");
+			}
+		}
+		else if (strcmp(command, "end") == 0)
+		{
+			Sim_New_Action(SIM_ACTION_END, line_number, cursor);
+			ended = 1;
+		}
+		else
+		{
+			Sim_Script_Error(line_number, "unknown command", command);
+		}
+	}
+	fclose(file);
+
+	if (!ended)
+	{
+		Sim_New_Action(SIM_ACTION_END, line_number, cursor);
+	}
+}
+
+static void Sim_Resolve(Sim_Action *action, Sim_Result result)
+{
+	if (action->result != SIM_ARMED)
+	{
+		return;
+	}
+	action->result = result;
+	action->resolved_time = Sim_Time;
+	if (Sim_Options.trace || result == SIM_FAILED)
+	{
+		Sim_Log("%s line %d", result == SIM_PASSED ? "PASS" : "FAIL", action->line);
+	}
+}
+
+static int Sim_History_Ends_With(int channel, const Sim_Action *action)
+{
+	uint64_t count = Sim_History_Count[channel];
+
+	if (count - action->armed_count < (uint64_t)action->length)
+	{
+		return 0;
+	}
+	for (int i = 0; i < action->length; i++)
+	{
+		uint64_t position = count - action->length + i;
+		if (Sim_History[channel][position % SIM_HISTORY_SIZE] != (uint8_t)action->text[i])
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static void Sim_Script_UART_Output(int index, uint8_t data)
+{
+	Sim_History[index][Sim_History_Count[index] % SIM_HISTORY_SIZE] = data;
+	Sim_History_Count[index]++;
+
+	if (Sim_Capture && index == 0)
+	{
+		fputc(data, Sim_Capture);
+	}
+
+	if (Sim_Options.trace)
+	{
+		if (data == '\n' || Sim_Line_Length[index] == SIM_LINE_SIZE - 1)
+		{
+			char text[SIM_LINE_SIZE * 4];
+			Sim_Format_Text(text, sizeof(text), Sim_Line[index], Sim_Line_Length[index]);
+			Sim_Log("%-8s <- \"%s\"", Sim_Channel_Names[index], text);
+			Sim_Line_Length[index] = 0;
+		}
+		else if (data != '\r')
+		{
+			Sim_Line[index][Sim_Line_Length[index]++] = (char)data;
+		}
+	}
+
+	for (int i = 0; i < Sim_Action_Count; i++)
+	{
+		Sim_Action *action = &Sim_Actions[i];
+		if (action->result != SIM_ARMED || action->channel != index)
+		{
+			continue;
+		}
+		if ((action->type == SIM_ACTION_EXPECT_TEXT || action->type == SIM_ACTION_REJECT_TEXT) && Sim_History_Ends_With(index, action))
+		{
+			Sim_Resolve(action, action->type == SIM_ACTION_EXPECT_TEXT ? SIM_PASSED : SIM_FAILED);
+		}
+	}
+}
+
+static void Sim_Check_GPIO(Sim_Action *action, int changed)
+{
+	uint32_t value = Sim_GPIO_Output(action->port) & action->mask;
+
+	switch (action->type)
+	{
+		case SIM_ACTION_EXPECT_VALUE:
+			if (value == (action->value & action->mask))
+			{
+				Sim_Resolve(action, SIM_PASSED);
+			}
+			break;
+
+		case SIM_ACTION_EXPECT_CHANGE:
+			if (changed)
+			{
+				Sim_Resolve(action, SIM_PASSED);
+			}
+			break;
+
+		case SIM_ACTION_EXPECT_STEPPING:
+			if (!changed)
+			{
+				break;
+			}
+			if (action->last_change)
+			{
+				uint64_t interval = Sim_Time - action->last_change;
+				if (action->steps_seen == 0 || interval < action->interval_seen_min)
+				{
+					action->interval_seen_min = interval;
+				}
+				if (interval > action->interval_seen_max)
+				{
+					action->interval_seen_max = interval;
+				}
+				action->interval_total += interval;
+				action->steps_seen++;
+
+				if (interval < action->interval_min || interval > action->interval_max)
+				{
+					snprintf(action->detail, sizeof(action->detail), "step %d came after %.3f ms",
+						action->steps_seen, (double)interval / SIM_MS);
+					Sim_Resolve(action, SIM_FAILED);
+				}
+				else if (action->steps_seen == action->steps)
+				{
+					Sim_Resolve(action, SIM_PASSED);
+				}
+			}
+			action->last_change = Sim_Time;
+			break;
+
+		default:
+			break;
+	}
+}
+
+static void Sim_Script_GPIO_Output(int port, uint32_t previous, uint32_t current)
+{
+	if (Sim_VCD)
+	{
+		fprintf(Sim_VCD, "#%llu\nb", (unsigned long long)(Sim_Time / SIM_NS));
+		for (int bit = 7; bit >= 0; bit--)
+		{
+			fputc((current >> bit) & 1 ? '1' : '0', Sim_VCD);
+		}
+		fprintf(Sim_VCD, " %c\n", '!' + port);
+	}
+
+	for (int i = 0; i < Sim_Action_Count; i++)
+	{
+		Sim_Action *action = &Sim_Actions[i];
+		if (action->result == SIM_ARMED && action->port == port &&
+			(action->type == SIM_ACTION_EXPECT_VALUE || action->type == SIM_ACTION_EXPECT_CHANGE || action->type == SIM_ACTION_EXPECT_STEPPING))
+		{
+			Sim_Check_GPIO(action, ((previous ^ current) & action->mask) != 0);
+		}
+	}
+}
+
+static void Sim_Check_EEPROM(Sim_Action *action)
+{
+	if (Sim_EEPROM_Word(action->address) == action->value)
+	{
+		Sim_Resolve(action, SIM_PASSED);
+	}
+}
+
+static void Sim_Script_EEPROM_Write(int address, uint32_t value)
+{
+	(void)value;
+
+	for (int i = 0; i < Sim_Action_Count; i++)
+	{
+		Sim_Action *action = &Sim_Actions[i];
+		if (action->result == SIM_ARMED && action->type == SIM_ACTION_EXPECT_EEPROM && action->address == address)
+		{
+			Sim_Check_EEPROM(action);
+		}
+	}
+}
+
+static void Sim_Deadline(void *context, uint32_t argument)
+{
+	Sim_Action *action = (Sim_Action *)context;
+	(void)argument;
+
+	if (action->type == SIM_ACTION_REJECT_TEXT)
+	{
+		Sim_Resolve(action, SIM_PASSED);
+	}
+	else if (action->result == SIM_ARMED && action->type == SIM_ACTION_EXPECT_STEPPING && action->steps_seen)
+	{
+		snprintf(action->detail, sizeof(action->detail), "only %d of %d steps", action->steps_seen, action->steps);
+		Sim_Resolve(action, SIM_FAILED);
+	}
+	else
+	{
+		Sim_Resolve(action, SIM_FAILED);
+	}
+}
+
+static void Sim_Print_Report(void)
+{
+	struct timespec now;
+	int passed = 0;
+	int failed = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	double host = (double)(now.tv_sec - Sim_Host_Start.tv_sec) + (now.tv_nsec - Sim_Host_Start.tv_nsec) / 1e9;
+	double virtual_seconds = (double)Sim_Time / SIM_S;
+
+	printf("\nScenario %s\n", Sim_Scenario_Name);
+	for (int i = 0; i < Sim_Action_Count; i++)
+	{
+		Sim_Action *action = &Sim_Actions[i];
+		char text[SIM_SCRIPT_MAX_TEXT * 4];
+
+		if (action->type == SIM_ACTION_SEND || action->type == SIM_ACTION_INPUT || action->type == SIM_ACTION_END)
+		{
+			continue;
+		}
+
+		if (action->result == SIM_PASSED)
+		{
+			passed++;
+		}
+		else
+		{
+			failed++;
+		}
+
+		printf("  %s  line %-4d ", action->result == SIM_PASSED ? "PASS" : "FAIL", action->line);
+		switch (action->type)
+		{
+			case SIM_ACTION_EXPECT_TEXT:
+			case SIM_ACTION_REJECT_TEXT:
+				Sim_Format_Text(text, sizeof(text), action->text, action->length);
+				printf("%s %s \"%s\"", action->type == SIM_ACTION_REJECT_TEXT ? "no" : "", Sim_Channel_Names[action->channel], text);
+				break;
+			case SIM_ACTION_EXPECT_VALUE:
+				printf("GPIO%c & 0x%02X == 0x%02X", 'A' + action->port, action->mask, action->value);
+				break;
+			case SIM_ACTION_EXPECT_CHANGE:
+				printf("GPIO%c & 0x%02X changes", 'A' + action->port, action->mask);
+				break;
+			case SIM_ACTION_EXPECT_STEPPING:
+				printf("GPIO%c & 0x%02X steps", 'A' + action->port, action->mask);
+				if (action->steps_seen)
+				{
+					printf(" every %.3f ms (%.3f to %.3f ms over %d steps)",
+						(double)action->interval_total / action->steps_seen / SIM_MS,
+						(double)action->interval_seen_min / SIM_MS, (double)action->interval_seen_max / SIM_MS, action->steps_seen);
+				}
+				break;
+			case SIM_ACTION_EXPECT_EEPROM:
+				printf("EEPROM word 0x%03X == 0x%08X", action->address, action->value);
+				break;
+			default:
+				break;
+		}
+
+		if (action->result == SIM_PASSED && action->type != SIM_ACTION_REJECT_TEXT)
+		{
+			printf(" after %.3f ms (limit %.3f ms)", (double)(action->resolved_time - action->armed_time) / SIM_MS,
+				(double)action->duration / SIM_MS);
+		}
+		else if (action->result == SIM_FAILED && action->type == SIM_ACTION_REJECT_TEXT)
+		{
+			printf(" seen after %.3f ms", (double)(action->resolved_time - action->armed_time) / SIM_MS);
+		}
+		else if (action->result != SIM_PASSED && action->type != SIM_ACTION_REJECT_TEXT)
+		{
+			printf(" not within %.3f ms", (double)action->duration / SIM_MS);
+		}
+		if (action->detail[0])
+		{
+			printf(": %s", action->detail);
+		}
+		printf("\n");
+	}
+	printf("  %d passed, %d failed\n", passed, failed);
+
+	printf("\nVirtual time %.3f ms, %llu cycles at %u Hz, host time %.3f s (%.1fx real time)\n",
+		virtual_seconds * 1e3, (unsigned long long)Sim_Cycle_Count(), Sim_Core_Hz, host,
+		host > 0 ? virtual_seconds / host : 0.0);
+	printf("CPU asleep %.1f %% of the time\n", Sim_Time ? 100.0 * (double)Sim_Stats.sleep_time / (double)Sim_Time : 0.0);
+
+	printf("\n%-20s %12s %12s %12s %14s\n", "Exception", "Count", "Avg cycles", "Max cycles", "Max latency");
+	for (int exception = 0; exception < SIM_EXCEPTION_COUNT; exception++)
+	{
+		Sim_Exception_Stats_Type *stats = &Sim_Exception_Stats[exception];
+		if (stats->count)
+		{
+			printf("%-20s %12llu %12llu %12llu %14llu\n", Sim_Exception_Name(exception),
+				(unsigned long long)stats->count, (unsigned long long)(stats->total_cycles / stats->count),
+				(unsigned long long)stats->max_cycles, (unsigned long long)stats->max_latency_cycles);
+		}
+	}
+
+	printf("\n%-10s %10s %10s %10s %10s %10s\n", "UART", "TX bytes", "RX bytes", "Overruns", "Framing", "TX dropped");
+	for (int index = 0; index < SIM_UART_COUNT; index++)
+	{
+		Sim_UART_Stats_Type *stats = &Sim_UART_Stats[index];
+		if (stats->tx_bytes || stats->rx_bytes || stats->rx_overruns)
+		{
+			printf("%-10s %10llu %10llu %10llu %10llu %10llu\n", Sim_Channel_Names[index],
+				(unsigned long long)stats->tx_bytes, (unsigned long long)stats->rx_bytes,
+				(unsigned long long)stats->rx_overruns, (unsigned long long)stats->rx_framing_errors,
+				(unsigned long long)stats->tx_dropped);
+		}
+	}
+
+	if (Sim_BLE_Stats.commands)
+	{
+		printf("\nBLE module: %llu AT commands, %llu answered ERROR\n",
+			(unsigned long long)Sim_BLE_Stats.commands, (unsigned long long)Sim_BLE_Stats.errors);
+	}
+
+	if (Sim_EEPROM_Stats.reads || Sim_EEPROM_Stats.writes)
+	{
+		printf("\nEEPROM: %llu words read, %llu words written\n",
+			(unsigned long long)Sim_EEPROM_Stats.reads, (unsigned long long)Sim_EEPROM_Stats.writes);
+	}
+	if (Sim_EEPROM_Image && !Sim_EEPROM_Save(Sim_EEPROM_Image))
+	{
+		fprintf(stderr, "cannot write %s\n", Sim_EEPROM_Image);
+	}
+
+	printf("\nModel: %llu register accesses, %llu events, %llu idle skips, %llu stall advances, %llu warnings\n",
+		(unsigned long long)Sim_Stats.register_accesses, (unsigned long long)Sim_Stats.events,
+		(unsigned long long)Sim_Stats.idle_skips, (unsigned long long)Sim_Stats.stall_advances,
+		(unsigned long long)Sim_Stats.warnings);
+
+	fflush(stdout);
+	if (Sim_VCD)
+	{
+		fclose(Sim_VCD);
+	}
+	if (Sim_Capture)
+	{
+		fclose(Sim_Capture);
+	}
+
+	exit((failed || (Sim_Options.warnings_as_errors && Sim_Stats.warnings)) ? 1 : 0);
+}
+
+static void Sim_Run_Action(void *context, uint32_t argument)
+{
+	Sim_Action *action = (Sim_Action *)context;
+	char text[SIM_SCRIPT_MAX_TEXT * 4];
+	(void)argument;
+
+	switch (action->type)
+	{
+		case SIM_ACTION_SEND:
+			if (Sim_Options.trace)
+			{
+				Sim_Format_Text(text, sizeof(text), action->text, action->length);
+				Sim_Log("%-8s -> \"%s\"", Sim_Channel_Names[action->channel], text);
+			}
+			Sim_UART_Peer_Send(action->channel, action->text, action->length, Sim_Time);
+			break;
+
+		case SIM_ACTION_INPUT:
+			if (action->port < 0)
+			{
+				Sim_Stack_Write(action->address, action->value);
+			}
+			else
+			{
+				Sim_GPIO_Set_Input(action->port, action->mask, action->value);
+			}
+			break;
+
+		case SIM_ACTION_END:
+			// A reject window that closes at the end of the scenario was not violated,
+			// even when its deadline event is queued behind this one
+			for (int i = 0; i < Sim_Action_Count; i++)
+			{
+				Sim_Action *other = &Sim_Actions[i];
+				if (other->type == SIM_ACTION_REJECT_TEXT && other->armed_time + other->duration <= Sim_Time)
+				{
+					Sim_Resolve(other, SIM_PASSED);
+				}
+			}
+			Sim_Stop_Stall_Detector();
+			Sim_Print_Report();
+			break;
+
+		default:
+			action->result = SIM_ARMED;
+			action->armed_time = Sim_Time;
+			action->armed_count = Sim_History_Count[action->channel];
+			Sim_Schedule(Sim_Time + action->duration, Sim_Deadline, action, 0);
+			if (action->type == SIM_ACTION_EXPECT_VALUE)
+			{
+				Sim_Check_GPIO(action, 0);
+			}
+			else if (action->type == SIM_ACTION_EXPECT_EEPROM)
+			{
+				Sim_Check_EEPROM(action);
+			}
+			break;
+	}
+}
+
+static void Sim_Open_VCD(const char *path)
+{
+	Sim_VCD = fopen(path, "w");
+	if (!Sim_VCD)
+	{
+		fprintf(stderr, "cannot create %s\n", path);
+		exit(2);
+	}
+
+	fprintf(Sim_VCD, "$timescale 1 ns $end\n$scope module tm4c123 $end\n");
+	for (int port = 0; port < SIM_GPIO_COUNT; port++)
+	{
+		fprintf(Sim_VCD, "$var wire 8 %c GPIO%c $end\n", '!' + port, 'A' + port);
+	}
+	fprintf(Sim_VCD, "$upscope $end\n$enddefinitions $end\n#0\n");
+	for (int port = 0; port < SIM_GPIO_COUNT; port++)
+	{
+		fprintf(Sim_VCD, "b00000000 %c\n", '!' + port);
+	}
+}
+
+static void Sim_Usage(const char *program)
+{
+	fprintf(stderr,
+		"usage: %s [options] scenario.sim\n"
+		"  --trace            log every line sent and received\n"
+		"  --vcd FILE         write the GPIO waveforms to a VCD file\n"
+		"  --capture FILE     write the raw bytes sent on UART0 (console) to FILE\n"
+		"  --eeprom FILE      load the EEPROM from FILE if it exists and save it there at the end\n"
+		"  --werror           exit with status 1 when the model reported a warning\n"
+		"  --stall-us N       wall-clock interval of the stall detector (default 50)\n",
+		program);
+	exit(2);
+}
+
+int main(int argc, char **argv)
+{
+	const char *vcd = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--trace") == 0)
+		{
+			Sim_Options.trace = 1;
+		}
+		else if (strcmp(argv[i], "--werror") == 0)
+		{
+			Sim_Options.warnings_as_errors = 1;
+		}
+		else if (strcmp(argv[i], "--vcd") == 0 && i + 1 < argc)
+		{
+			vcd = argv[++i];
+		}
+		else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc)
+		{
+			Sim_Capture = fopen(argv[++i], "wb");
+			if (!Sim_Capture)
+			{
+				fprintf(stderr, "cannot create %s\n", argv[i]);
+				exit(2);
+			}
+		}
+		else if (strcmp(argv[i], "--eeprom") == 0 && i + 1 < argc)
+		{
+			Sim_EEPROM_Image = argv[++i];
+		}
+		else if (strcmp(argv[i], "--stall-us") == 0 && i + 1 < argc)
+		{
+			Sim_Options.stall_interval_us = (uint32_t)strtoul(argv[++i], NULL, 0);
+		}
+		else if (argv[i][0] == '-' || Sim_Scenario_Name)
+		{
+			Sim_Usage(argv[0]);
+		}
+		else
+		{
+			Sim_Scenario_Name = argv[i];
+		}
+	}
+	if (!Sim_Scenario_Name)
+	{
+		Sim_Usage(argv[0]);
+	}
+
+	setvbuf(stdout, NULL, _IOLBF, 0);
+	clock_gettime(CLOCK_MONOTONIC, &Sim_Host_Start);
+
+	Sim_Init();
+	Sim_Load_Scenario(Sim_Scenario_Name);
+	if (Sim_EEPROM_Image)
+	{
+		Sim_EEPROM_Load(Sim_EEPROM_Image);
+	}
+	if (vcd)
+	{
+		Sim_Open_VCD(vcd);
+	}
+
+	Sim_UART_Output_Hook = Sim_Script_UART_Output;
+	Sim_GPIO_Output_Hook = Sim_Script_GPIO_Output;
+	Sim_EEPROM_Write_Hook = Sim_Script_EEPROM_Write;
+	for (int i = 0; i < Sim_Action_Count; i++)
+	{
+		Sim_Schedule(Sim_Actions[i].time, Sim_Run_Action, &Sim_Actions[i], 0);
+	}
+
+	// Reset_Handler: SystemInit, then main
+	Sim_Start_Stall_Detector();
+	SystemInit();
+	Firmware_Main();
+
+	Sim_Fatal("the firmware returned from main");
+}
@@ -0,0 +1,157 @@
+/**
+ * @file Sim_SysCtl.cpp
+ *
+ * @brief System Control model: run-mode clock gating and system clock selection.
+ *
+ * The system clock is recomputed from RCC / RCC2 whenever either register is written,
+ * so SystemInit (RTE/Device/TM4C123GH6PM/system_TM4C123.c) switches the model from
+ * the 16 MHz PIOSC it resets to, over to the PLL exactly as it does on the board.
+ * The PLL reports lock immediately and every peripheral is ready as soon as its
+ * clock is enabled.
+ */
+
+#include "Simulator.h"
+#include <string.h>
+
+#define SIM_PLL_HZ   400000000UL
+#define SIM_PIOSC_HZ  16000000UL
+
+/**
+ * @brief Crystal frequencies selected by the RCC XTAL field
+ */
+static const uint32_t Sim_Crystal_Hz[] = {
+	1000000, 1843200, 2000000, 2457600, 3579545, 3686400, 4000000, 4096000,
+	4915200, 5000000, 5120000, 6000000, 6144000, 7372800, 8000000, 8192000,
+	10000000, 12000000, 12288000, 13560000, 14318180, 16000000, 16384000, 18000000,
+	20000000, 24000000, 25000000
+};
+
+static uint32_t Sim_SysCtl_Oscillator(uint32_t xtal, uint32_t source)
+{
+	switch (source)
+	{
+		case 0:
+			return (xtal < sizeof(Sim_Crystal_Hz) / sizeof(Sim_Crystal_Hz[0])) ? Sim_Crystal_Hz[xtal] : SIM_PIOSC_HZ;
+		case 2:
+			return SIM_PIOSC_HZ / 4;
+		case 3:
+			return 30000;
+		case 7:
+			return 32768;
+		default:
+			return SIM_PIOSC_HZ;
+	}
+}
+
+static void Sim_SysCtl_Update_Clock(void)
+{
+	uint32_t rcc = Sim_SYSCTL.RCC.raw;
+	uint32_t rcc2 = Sim_SYSCTL.RCC2.raw;
+	uint32_t xtal = (rcc >> 6) & 0x1F;
+	uint32_t hz;
+
+	if (rcc2 & (1UL << 31))
+	{
+		int bypass = (rcc2 >> 11) & 1;
+		uint32_t divisor = ((rcc2 >> 23) & 0x3F) + 1;
+
+		if (bypass)
+		{
+			hz = Sim_SysCtl_Oscillator(xtal, (rcc2 >> 4) & 0x07);
+			hz = (rcc & (1UL << 22)) ? hz / divisor : hz;
+		}
+		else if (rcc2 & (1UL << 30))
+		{
+			// DIV400: SYSDIV2 and SYSDIV2LSB divide the 400 MHz PLL output directly
+			hz = SIM_PLL_HZ / ((((rcc2 >> 22) & 0x7F)) + 1);
+		}
+		else
+		{
+			hz = SIM_PLL_HZ / 2 / divisor;
+		}
+	}
+	else
+	{
+		int bypass = (rcc >> 11) & 1;
+		uint32_t divisor = ((rcc >> 23) & 0x0F) + 1;
+
+		if (bypass)
+		{
+			hz = Sim_SysCtl_Oscillator(xtal, (rcc >> 4) & 0x03);
+			hz = (rcc & (1UL << 22)) ? hz / divisor : hz;
+		}
+		else
+		{
+			// The system clock divider is always applied to the PLL
+			hz = SIM_PLL_HZ / 2 / divisor;
+		}
+	}
+
+	Sim_Set_Core_Clock(hz);
+}
+
+void Sim_SysCtl_Reset(void)
+{
+	memset((void *)&Sim_SYSCTL, 0, sizeof(Sim_SYSCTL));
+	Sim_SYSCTL.DID0.raw = 0x18050103;
+	Sim_SYSCTL.DID1.raw = 0x10A1606E;
+	Sim_SYSCTL.RCC.raw = 0x078E3AD1;
+	Sim_SYSCTL.RCC2.raw = 0x07C06810;
+	Sim_SysCtl_Update_Clock();
+}
+
+int Sim_SysCtl_Clock_Enabled(const Sim_Register *rcgc, int index)
+{
+	return (rcgc->raw >> index) & 1;
+}
+
+uint32_t Sim_SysCtl_Read(const void *reg)
+{
+	// Raw interrupt status: the PLL is always locked
+	if (reg == &Sim_SYSCTL.RIS.raw)
+	{
+		return Sim_SYSCTL.RIS.raw | 0x40;
+	}
+	if (reg == &Sim_SYSCTL.PLLSTAT.raw)
+	{
+		return 0x01;
+	}
+
+	// Peripheral ready registers follow the run-mode clock gating registers
+	if (reg == &Sim_SYSCTL.PRWD.raw)
+	{
+		return Sim_SYSCTL.RCGCWD.raw;
+	}
+	if (reg == &Sim_SYSCTL.PRTIMER.raw)
+	{
+		return Sim_SYSCTL.RCGCTIMER.raw;
+	}
+	if (reg == &Sim_SYSCTL.PRGPIO.raw)
+	{
+		return Sim_SYSCTL.RCGCGPIO.raw;
+	}
+	if (reg == &Sim_SYSCTL.PRUART.raw)
+	{
+		return Sim_SYSCTL.RCGCUART.raw;
+	}
+	if (reg == &Sim_SYSCTL.PREEPROM.raw)
+	{
+		return Sim_SYSCTL.RCGCEEPROM.raw;
+	}
+	if (reg == &Sim_SYSCTL.PRWTIMER.raw)
+	{
+		return Sim_SYSCTL.RCGCWTIMER.raw;
+	}
+
+	return *(const uint32_t *)reg;
+}
+
+void Sim_SysCtl_Write(void *reg, uint32_t value)
+{
+	Sim_Store(reg, 4, value);
+
+	if (reg == &Sim_SYSCTL.RCC.raw || reg == &Sim_SYSCTL.RCC2.raw)
+	{
+		Sim_SysCtl_Update_Clock();
+	}
+}
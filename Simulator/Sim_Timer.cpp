@@ -0,0 +1,402 @@
+/**
+ * @file Sim_Timer.cpp
+ *
+ * @brief GPTM Timers 0 to 5, Wide Timers 0 to 5 and the SysTick timer.
+ *
+ * The one-shot and periodic modes are modelled for both sub-timers, in the
+ * concatenated (CFG = 0x0) and split (CFG = 0x4) configurations, counting up or down.
+ * In split mode the prescaler extends the count as on the board, so the time-out
+ * period is (TnILR + 1) * (TnPR + 1) system clock cycles. Each time-out is an event;
+ * TnR / TnV are computed from the virtual time when they are read.
+ *
+ * SysTick counts either the core clock (CLKSOURCE = 1) or PIOSC / 4 (4 MHz) and pends
+ * the SysTick exception on every wrap when TICKINT is set.
+ *
+ * @note Capture, PWM and RTC modes are not modelled.
+ */
+
+#include "Simulator.h"
+#include <string.h>
+
+#define SIM_PIOSC_DIV4_TICK   (SIM_S / 4000000ULL)
+
+typedef struct {
+	uint64_t start;
+	uint64_t tick;
+	uint64_t ticks;
+	uint32_t generation;
+	uint8_t running;
+} Sim_Counter;
+
+typedef struct {
+	Sim_Counter half[2];
+	uint8_t warned;
+} Sim_Timer_State;
+
+static Sim_Timer_State Sim_Timer_States[2][SIM_TIMER_COUNT];
+static Sim_Counter Sim_SysTick_Counter;
+
+static const int Sim_Timer_IRQ[2][SIM_TIMER_COUNT] = {
+	{ TIMER0A_IRQn, TIMER1A_IRQn, TIMER2A_IRQn, TIMER3A_IRQn, TIMER4A_IRQn, TIMER5A_IRQn },
+	{ WTIMER0A_IRQn, WTIMER1A_IRQn, WTIMER2A_IRQn, WTIMER3A_IRQn, WTIMER4A_IRQn, WTIMER5A_IRQn }
+};
+
+static TIMER0_Type *Sim_Timer_Registers(int wide, int index)
+{
+	return wide ? &Sim_Wide_Timer[index] : &Sim_Timer[index];
+}
+
+static int Sim_Timer_Split(TIMER0_Type *timer)
+{
+	return (timer->CFG.raw & 0x07) == 0x04;
+}
+
+static uint32_t Sim_Timer_Mode(TIMER0_Type *timer, int half)
+{
+	return (half ? timer->TBMR.raw : timer->TAMR.raw);
+}
+
+/**
+ * @brief Number of counter ticks in one time-out period of a sub-timer
+ */
+static uint64_t Sim_Timer_Period_Ticks(int wide, TIMER0_Type *timer, int half)
+{
+	uint32_t load = half ? timer->TBILR.raw : timer->TAILR.raw;
+
+	if (Sim_Timer_Split(timer))
+	{
+		return (uint64_t)(wide ? load : (load & 0xFFFF)) + 1;
+	}
+	if (wide)
+	{
+		return (((uint64_t)timer->TBILR.raw << 32) | timer->TAILR.raw) + 1;
+	}
+	return (uint64_t)load + 1;
+}
+
+static uint64_t Sim_Timer_Tick(int wide, TIMER0_Type *timer, int half)
+{
+	uint32_t prescale = 0;
+
+	if (Sim_Timer_Split(timer))
+	{
+		prescale = (half ? timer->TBPR.raw : timer->TAPR.raw) & (wide ? 0xFFFF : 0xFF);
+	}
+	return Sim_Cycle_Time * (prescale + 1);
+}
+
+static void Sim_Timer_Update_IRQ(int wide, int index)
+{
+	TIMER0_Type *timer = Sim_Timer_Registers(wide, index);
+	uint32_t masked = timer->RIS.raw & timer->IMR.raw;
+
+	Sim_IRQ_Set_Level(Sim_Timer_IRQ[wide][index], (masked & 0x001F) != 0);
+	Sim_IRQ_Set_Level(Sim_Timer_IRQ[wide][index] + 1, (masked & 0x0F00) != 0);
+}
+
+static void Sim_Timer_Timeout(void *context, uint32_t argument);
+
+static void Sim_Timer_Start(int wide, int index, int half)
+{
+	TIMER0_Type *timer = Sim_Timer_Registers(wide, index);
+	Sim_Counter *counter = &Sim_Timer_States[wide][index].half[half];
+	uint32_t mode = Sim_Timer_Mode(timer, half) & 0x03;
+
+	counter->generation++;
+	counter->running = 0;
+
+	if (mode != 0x01 && mode != 0x02)
+	{
+		Sim_Warning("%sTIMER%d%c enabled in mode %u, only one-shot and periodic are modelled",
+			wide ? "W" : "", index, half ? 'B' : 'A', (unsigned int)mode);
+		return;
+	}
+
+	counter->running = 1;
+	counter->start = Sim_Time;
+	counter->tick = Sim_Timer_Tick(wide, timer, half);
+	counter->ticks = Sim_Timer_Period_Ticks(wide, timer, half);
+	Sim_Schedule(counter->start + counter->tick * counter->ticks, Sim_Timer_Timeout, counter,
+		(counter->generation << 8) | (wide << 7) | (index << 1) | half);
+}
+
+static void Sim_Timer_Timeout(void *context, uint32_t argument)
+{
+	Sim_Counter *counter = (Sim_Counter *)context;
+	int half = argument & 0x01;
+	int index = (argument >> 1) & 0x3F;
+	int wide = (argument >> 7) & 0x01;
+	TIMER0_Type *timer = Sim_Timer_Registers(wide, index);
+
+	if (!counter->running || (counter->generation & 0xFFFFFF) != (argument >> 8))
+	{
+		return;
+	}
+
+	timer->RIS.raw |= half ? 0x100 : 0x001;
+
+	if ((Sim_Timer_Mode(timer, half) & 0x03) == 0x02)
+	{
+		// Periodic: reload from TnILR and keep the period phase-locked to the first start
+		counter->start += counter->tick * counter->ticks;
+		counter->ticks = Sim_Timer_Period_Ticks(wide, timer, half);
+		Sim_Schedule(counter->start + counter->tick * counter->ticks, Sim_Timer_Timeout, counter, argument);
+	}
+	else
+	{
+		counter->running = 0;
+		timer->CTL.raw &= ~(half ? 0x100 : 0x001);
+	}
+
+	Sim_Timer_Update_IRQ(wide, index);
+}
+
+static uint64_t Sim_Timer_Value(int wide, TIMER0_Type *timer, Sim_Counter *counter, int half)
+{
+	if (!counter->running)
+	{
+		if (wide && !Sim_Timer_Split(timer) && !half)
+		{
+			return ((uint64_t)timer->TBILR.raw << 32) | timer->TAILR.raw;
+		}
+		return half ? timer->TBILR.raw : timer->TAILR.raw;
+	}
+
+	uint64_t elapsed = (Sim_Time - counter->start) / counter->tick;
+	if (elapsed >= counter->ticks)
+	{
+		elapsed = counter->ticks - 1;
+	}
+
+	// TnCDIR (Bit 4) selects counting up from 0 instead of down from TnILR
+	if (Sim_Timer_Mode(timer, half) & 0x10)
+	{
+		return elapsed;
+	}
+	return counter->ticks - 1 - elapsed;
+}
+
+void Sim_Timer_Reset(void)
+{
+	memset((void *)Sim_Timer, 0, sizeof(Sim_Timer));
+	memset((void *)Sim_Wide_Timer, 0, sizeof(Sim_Wide_Timer));
+	memset(Sim_Timer_States, 0, sizeof(Sim_Timer_States));
+	memset((void *)&Sim_SysTick, 0, sizeof(Sim_SysTick));
+	memset(&Sim_SysTick_Counter, 0, sizeof(Sim_SysTick_Counter));
+
+	for (int index = 0; index < SIM_TIMER_COUNT; index++)
+	{
+		Sim_Timer[index].TAILR.raw = 0xFFFFFFFF;
+		Sim_Timer[index].TBILR.raw = 0x0000FFFF;
+		Sim_Wide_Timer[index].TAILR.raw = 0xFFFFFFFF;
+		Sim_Wide_Timer[index].TBILR.raw = 0xFFFFFFFF;
+	}
+	Sim_SysTick.CALIB.raw = 0xC0000000;
+}
+
+static void Sim_Timer_Check_Clock(int wide, int index)
+{
+	Sim_Timer_State *state = &Sim_Timer_States[wide][index];
+	const Sim_Register *rcgc = wide ? &Sim_SYSCTL.RCGCWTIMER : &Sim_SYSCTL.RCGCTIMER;
+
+	if (!Sim_SysCtl_Clock_Enabled(rcgc, index) && !state->warned)
+	{
+		state->warned = 1;
+		Sim_Warning("%sTIMER%d accessed while its clock is disabled (bus fault on the board)", wide ? "W" : "", index);
+	}
+}
+
+uint32_t Sim_Timer_Read(int wide, int index, const void *reg)
+{
+	TIMER0_Type *timer = Sim_Timer_Registers(wide, index);
+	Sim_Timer_State *state = &Sim_Timer_States[wide][index];
+
+	Sim_Timer_Check_Clock(wide, index);
+
+	if (reg == &timer->MIS.raw)
+	{
+		return timer->RIS.raw & timer->IMR.raw;
+	}
+	if (reg == &timer->TAR.raw || reg == &timer->TAV.raw)
+	{
+		Sim_State_Version++;
+		return (uint32_t)Sim_Timer_Value(wide, timer, &state->half[0], 0);
+	}
+	if (reg == &timer->TBR.raw || reg == &timer->TBV.raw)
+	{
+		Sim_State_Version++;
+
+		// A concatenated wide timer counts 64 bits in sub-timer A, TnB holds the upper word
+		if (wide && !Sim_Timer_Split(timer))
+		{
+			return (uint32_t)(Sim_Timer_Value(wide, timer, &state->half[0], 0) >> 32);
+		}
+		return (uint32_t)Sim_Timer_Value(wide, timer, &state->half[1], 1);
+	}
+	return *(const uint32_t *)reg;
+}
+
+void Sim_Timer_Write(int wide, int index, void *reg, uint32_t value)
+{
+	TIMER0_Type *timer = Sim_Timer_Registers(wide, index);
+	Sim_Timer_State *state = &Sim_Timer_States[wide][index];
+
+	Sim_Timer_Check_Clock(wide, index);
+
+	if (reg == &timer->ICR.raw)
+	{
+		timer->RIS.raw &= ~value;
+		Sim_Timer_Update_IRQ(wide, index);
+		return;
+	}
+	if (reg == &timer->RIS.raw || reg == &timer->MIS.raw)
+	{
+		return;
+	}
+
+	uint32_t previous_ctl = timer->CTL.raw;
+	Sim_Store(reg, 4, value);
+
+	if (reg == &timer->CTL.raw)
+	{
+		for (int half = 0; half < 2; half++)
+		{
+			uint32_t enable = half ? 0x100 : 0x001;
+
+			if ((value & enable) && !(previous_ctl & enable))
+			{
+				Sim_Timer_Start(wide, index, half);
+			}
+			else if (!(value & enable) && (previous_ctl & enable))
+			{
+				state->half[half].running = 0;
+				state->half[half].generation++;
+			}
+		}
+	}
+	else if (reg == &timer->TAILR.raw || reg == &timer->TBILR.raw)
+	{
+		// Without TnILD (Bit 8 of TnMR) a new load value takes effect on the next clock
+		int half = (reg == &timer->TBILR.raw);
+		if (state->half[half].running && !(Sim_Timer_Mode(timer, half) & 0x100))
+		{
+			Sim_Timer_Start(wide, index, half);
+		}
+	}
+	else if (reg == &timer->IMR.raw)
+	{
+		Sim_Timer_Update_IRQ(wide, index);
+	}
+}
+
+static uint64_t Sim_SysTick_Tick(void)
+{
+	return (Sim_SysTick.CTRL.raw & 0x04) ? Sim_Cycle_Time : SIM_PIOSC_DIV4_TICK;
+}
+
+static void Sim_SysTick_Wrap(void *context, uint32_t argument);
+
+static void Sim_SysTick_Start(void)
+{
+	Sim_Counter *counter = &Sim_SysTick_Counter;
+
+	counter->generation++;
+	counter->running = 0;
+
+	// A reload value of 0 disables the counter on its next wrap
+	if (!(Sim_SysTick.CTRL.raw & 0x01) || (Sim_SysTick.LOAD.raw & 0xFFFFFF) == 0)
+	{
+		return;
+	}
+
+	counter->running = 1;
+	counter->start = Sim_Time;
+	counter->tick = Sim_SysTick_Tick();
+	counter->ticks = (Sim_SysTick.LOAD.raw & 0xFFFFFF) + 1;
+	Sim_Schedule(counter->start + counter->tick * counter->ticks, Sim_SysTick_Wrap, counter, counter->generation);
+}
+
+static void Sim_SysTick_Wrap(void *context, uint32_t argument)
+{
+	Sim_Counter *counter = (Sim_Counter *)context;
+
+	if (!counter->running || counter->generation != argument)
+	{
+		return;
+	}
+
+	// COUNTFLAG (Bit 16) is set on every wrap, the exception is pended when TICKINT is set
+	Sim_SysTick.CTRL.raw |= 0x10000;
+	if (Sim_SysTick.CTRL.raw & 0x02)
+	{
+		Sim_Exception_Pend(SIM_EXCEPTION_SYSTICK);
+	}
+
+	counter->start += counter->tick * counter->ticks;
+	counter->ticks = (Sim_SysTick.LOAD.raw & 0xFFFFFF) + 1;
+	if (counter->ticks == 1)
+	{
+		counter->running = 0;
+		return;
+	}
+	Sim_Schedule(counter->start + counter->tick * counter->ticks, Sim_SysTick_Wrap, counter, argument);
+}
+
+uint32_t Sim_SysTick_Read(const void *reg)
+{
+	Sim_Counter *counter = &Sim_SysTick_Counter;
+
+	if (reg == &Sim_SysTick.CTRL.raw)
+	{
+		// Reading CTRL clears COUNTFLAG
+		uint32_t value = Sim_SysTick.CTRL.raw;
+		if (value & 0x10000)
+		{
+			Sim_SysTick.CTRL.raw &= ~0x10000;
+			Sim_State_Version++;
+		}
+		return value;
+	}
+	if (reg == &Sim_SysTick.VAL.raw)
+	{
+		if (!counter->running)
+		{
+			return Sim_SysTick.VAL.raw;
+		}
+		Sim_State_Version++;
+		uint64_t elapsed = (Sim_Time - counter->start) / counter->tick;
+		return (elapsed >= counter->ticks) ? 0 : (uint32_t)(counter->ticks - 1 - elapsed);
+	}
+	return *(const uint32_t *)reg;
+}
+
+void Sim_SysTick_Write(void *reg, uint32_t value)
+{
+	if (reg == &Sim_SysTick.CTRL.raw)
+	{
+		uint32_t previous = Sim_SysTick.CTRL.raw;
+		Sim_SysTick.CTRL.raw = (previous & 0x10000) | (value & 0x07);
+		if ((previous ^ value) & 0x07)
+		{
+			Sim_SysTick_Start();
+		}
+	}
+	else if (reg == &Sim_SysTick.VAL.raw)
+	{
+		// Any write clears the counter and COUNTFLAG
+		Sim_SysTick.VAL.raw = 0;
+		Sim_SysTick.CTRL.raw &= ~0x10000;
+		if (Sim_SysTick_Counter.running)
+		{
+			Sim_SysTick_Start();
+		}
+	}
+	else if (reg == &Sim_SysTick.LOAD.raw)
+	{
+		Sim_SysTick.LOAD.raw = value & 0xFFFFFF;
+		if (!Sim_SysTick_Counter.running && (Sim_SysTick.CTRL.raw & 0x01))
+		{
+			Sim_SysTick_Start();
+		}
+	}
+}
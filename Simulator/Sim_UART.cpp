@@ -0,0 +1,463 @@
+/**
+ * @file Sim_UART.cpp
+ *
+ * @brief UART0 to UART7: FIFOs, baud timing, interrupt flags and the peer side of each link.
+ *
+ * Character timing follows the divisors the firmware programs:
+ *   bit time = 16 * (IBRD + FBRD / 64) UART clock cycles
+ * and a frame is the start bit, the data bits, the optional parity bit and the stop bits
+ * selected in LCRH. A transmitted character leaves the shift register one frame time
+ * after it started and is then passed to Sim_UART_Output_Hook.
+ *
+ * The peer of each link (the BLE module, the Arduino, the serial terminal) transmits 8N1
+ * at its own baud rate. Characters arrive one peer frame apart; when the two rates differ
+ * by more than 5 % they are flagged with a framing error, and a character that finds the
+ * receive FIFO full is lost and flags an overrun, as on the board.
+ *
+ * The RX, TX and receive time-out (32 bit times without a new character) interrupt flags
+ * follow the IFLS trigger levels, and the interrupt line is RIS & IM.
+ */
+
+#include "Simulator.h"
+#include <string.h>
+
+#define SIM_UART_FIFO_DEPTH    16
+
+#define SIM_UART_CTL_UARTEN    0x001
+#define SIM_UART_CTL_EOT       0x010
+#define SIM_UART_CTL_TXE       0x100
+#define SIM_UART_CTL_RXE       0x200
+
+#define SIM_UART_INT_RX        0x010
+#define SIM_UART_INT_TX        0x020
+#define SIM_UART_INT_RT        0x040
+#define SIM_UART_INT_FE        0x080
+#define SIM_UART_INT_OE        0x400
+
+#define SIM_UART_DR_FE         0x100
+#define SIM_UART_DR_OE         0x800
+
+typedef struct {
+	uint8_t tx_fifo[SIM_UART_FIFO_DEPTH];
+	int tx_head;
+	int tx_count;
+	uint8_t tx_shift;
+	uint8_t tx_busy;
+	uint16_t rx_fifo[SIM_UART_FIFO_DEPTH];
+	int rx_head;
+	int rx_count;
+	uint32_t rx_generation;
+	uint32_t rsr;
+	uint32_t pending_error;
+	uint32_t peer_baud;
+	uint64_t peer_free;
+	uint8_t warned_clock;
+	uint8_t warned_baud;
+	uint8_t warned_overrun;
+} Sim_UART_State;
+
+static Sim_UART_State Sim_UART_States[SIM_UART_COUNT];
+
+Sim_UART_Stats_Type Sim_UART_Stats[SIM_UART_COUNT];
+void (*Sim_UART_Output_Hook)(int index, uint8_t data);
+
+static const int Sim_UART_IRQ[SIM_UART_COUNT] = {
+	UART0_IRQn, UART1_IRQn, UART2_IRQn, UART3_IRQn, UART4_IRQn, UART5_IRQn, UART6_IRQn, UART7_IRQn
+};
+
+/**
+ * @brief FIFO trigger levels selected by the IFLS TXIFLSEL and RXIFLSEL fields (1/8 to 7/8)
+ */
+static const int Sim_UART_Trigger_Level[8] = { 2, 4, 8, 12, 14, 14, 14, 14 };
+
+static int Sim_UART_Depth(int index)
+{
+	return (Sim_UART[index].LCRH.raw & 0x10) ? SIM_UART_FIFO_DEPTH : 1;
+}
+
+static int Sim_UART_TX_Trigger(int index)
+{
+	return (Sim_UART_Depth(index) == 1) ? 0 : Sim_UART_Trigger_Level[Sim_UART[index].IFLS.raw & 0x07];
+}
+
+static int Sim_UART_RX_Trigger(int index)
+{
+	return (Sim_UART_Depth(index) == 1) ? 1 : Sim_UART_Trigger_Level[(Sim_UART[index].IFLS.raw >> 3) & 0x07];
+}
+
+/**
+ * @brief Length of one bit on the line, 0 while the divisors are not programmed
+ */
+static uint64_t Sim_UART_Bit_Time(int index)
+{
+	UART0_Type *uart = &Sim_UART[index];
+	uint64_t divisor = (uint64_t)(uart->IBRD.raw & 0xFFFF) * 64 + (uart->FBRD.raw & 0x3F);
+	uint64_t clock = ((uart->CC.raw & 0x0F) == 0x05) ? (SIM_S / 16000000ULL) : Sim_Cycle_Time;
+
+	// HSE (Bit 5 of CTL) selects 8x oversampling instead of 16x
+	uint64_t oversampling = (uart->CTL.raw & 0x20) ? 8 : 16;
+
+	return clock * divisor * oversampling / 64;
+}
+
+static int Sim_UART_Frame_Bits(int index)
+{
+	uint32_t lcrh = Sim_UART[index].LCRH.raw;
+
+	return 1 + (5 + ((lcrh >> 5) & 0x03)) + ((lcrh & 0x02) ? 1 : 0) + ((lcrh & 0x08) ? 2 : 1);
+}
+
+static uint64_t Sim_UART_Peer_Bit_Time(int index)
+{
+	return SIM_S / Sim_UART_States[index].peer_baud;
+}
+
+/**
+ * @brief Difference between the programmed and the peer baud rate, in tenths of a percent
+ */
+static uint64_t Sim_UART_Baud_Error(int index)
+{
+	uint64_t bit = Sim_UART_Bit_Time(index);
+	uint64_t peer = Sim_UART_Peer_Bit_Time(index);
+
+	if (bit == 0)
+	{
+		return 1000;
+	}
+	return ((bit > peer) ? (bit - peer) : (peer - bit)) * 1000 / peer;
+}
+
+static void Sim_UART_Check_Baud(int index)
+{
+	Sim_UART_State *state = &Sim_UART_States[index];
+	uint64_t error = Sim_UART_Baud_Error(index);
+
+	if (error > 25 && !state->warned_baud)
+	{
+		uint64_t bit = Sim_UART_Bit_Time(index);
+		state->warned_baud = 1;
+		Sim_Warning("UART%d runs at %llu baud but its peer uses %u baud (%llu.%llu %% off)", index,
+			(unsigned long long)(bit ? SIM_S / bit : 0), state->peer_baud,
+			(unsigned long long)(error / 10), (unsigned long long)(error % 10));
+	}
+}
+
+static void Sim_UART_Check_Clock(int index)
+{
+	Sim_UART_State *state = &Sim_UART_States[index];
+
+	if (!Sim_SysCtl_Clock_Enabled(&Sim_SYSCTL.RCGCUART, index) && !state->warned_clock)
+	{
+		state->warned_clock = 1;
+		Sim_Warning("UART%d accessed while its clock is disabled in RCGCUART (bus fault on the board)", index);
+	}
+}
+
+static void Sim_UART_Update_IRQ(int index)
+{
+	UART0_Type *uart = &Sim_UART[index];
+
+	Sim_IRQ_Set_Level(Sim_UART_IRQ[index], (uart->RIS.raw & uart->IM.raw & 0x7F0) != 0);
+}
+
+static void Sim_UART_Transmit_Done(void *context, uint32_t argument);
+
+static void Sim_UART_Start_Transmit(int index)
+{
+	UART0_Type *uart = &Sim_UART[index];
+	Sim_UART_State *state = &Sim_UART_States[index];
+	uint32_t enabled = SIM_UART_CTL_UARTEN | SIM_UART_CTL_TXE;
+
+	if (state->tx_busy || state->tx_count == 0 || (uart->CTL.raw & enabled) != enabled)
+	{
+		return;
+	}
+
+	uint64_t bit = Sim_UART_Bit_Time(index);
+	if (bit == 0)
+	{
+		return;
+	}
+
+	int previous = state->tx_count;
+	state->tx_shift = state->tx_fifo[state->tx_head];
+	state->tx_head = (state->tx_head + 1) % SIM_UART_FIFO_DEPTH;
+	state->tx_count--;
+	state->tx_busy = 1;
+
+	// The TX interrupt fires when the FIFO drains down to the trigger level
+	int trigger = Sim_UART_TX_Trigger(index);
+	if (previous > trigger && state->tx_count <= trigger && !(uart->CTL.raw & SIM_UART_CTL_EOT))
+	{
+		uart->RIS.raw |= SIM_UART_INT_TX;
+	}
+
+	Sim_Schedule(Sim_Time + bit * Sim_UART_Frame_Bits(index), Sim_UART_Transmit_Done, state, index);
+	Sim_UART_Update_IRQ(index);
+}
+
+static void Sim_UART_Transmit_Done(void *context, uint32_t argument)
+{
+	Sim_UART_State *state = (Sim_UART_State *)context;
+	int index = (int)argument;
+	UART0_Type *uart = &Sim_UART[index];
+
+	state->tx_busy = 0;
+	Sim_UART_Stats[index].tx_bytes++;
+
+	if (index == 1)
+	{
+		Sim_BLE_Firmware_Output(state->tx_shift);
+	}
+	if (Sim_UART_Output_Hook)
+	{
+		Sim_UART_Output_Hook(index, state->tx_shift);
+	}
+
+	// With EOT set, the TX interrupt waits until the last bit has left the shift register
+	if (state->tx_count == 0 && (uart->CTL.raw & SIM_UART_CTL_EOT))
+	{
+		uart->RIS.raw |= SIM_UART_INT_TX;
+	}
+
+	Sim_UART_Start_Transmit(index);
+	Sim_UART_Update_IRQ(index);
+}
+
+static void Sim_UART_Receive_Timeout(void *context, uint32_t argument)
+{
+	Sim_UART_State *state = (Sim_UART_State *)context;
+	int index = argument & 0xFF;
+
+	if ((state->rx_generation & 0xFFFFFF) != (argument >> 8) || state->rx_count == 0)
+	{
+		return;
+	}
+
+	Sim_UART[index].RIS.raw |= SIM_UART_INT_RT;
+	Sim_UART_Update_IRQ(index);
+}
+
+static void Sim_UART_Receive(void *context, uint32_t argument)
+{
+	Sim_UART_State *state = (Sim_UART_State *)context;
+	int index = argument & 0xFF;
+	UART0_Type *uart = &Sim_UART[index];
+	uint32_t enabled = SIM_UART_CTL_UARTEN | SIM_UART_CTL_RXE;
+	uint16_t entry = (argument >> 8) & 0xFF;
+
+	if ((uart->CTL.raw & enabled) != enabled || !Sim_SysCtl_Clock_Enabled(&Sim_SYSCTL.RCGCUART, index))
+	{
+		return;
+	}
+
+	Sim_UART_Check_Baud(index);
+	entry |= state->pending_error;
+	state->pending_error = 0;
+
+	if (Sim_UART_Baud_Error(index) > 50)
+	{
+		entry |= SIM_UART_DR_FE;
+		uart->RIS.raw |= SIM_UART_INT_FE;
+		Sim_UART_Stats[index].rx_framing_errors++;
+	}
+
+	if (state->rx_count == Sim_UART_Depth(index))
+	{
+		// The character is lost; OE is reported with the next character that fits
+		state->rsr |= 0x08;
+		state->pending_error |= SIM_UART_DR_OE;
+		uart->RIS.raw |= SIM_UART_INT_OE;
+		Sim_UART_Stats[index].rx_overruns++;
+		if (!state->warned_overrun)
+		{
+			state->warned_overrun = 1;
+			Sim_Warning("UART%d receive FIFO overrun, characters are being lost", index);
+		}
+	}
+	else
+	{
+		int previous = state->rx_count;
+		state->rx_fifo[(state->rx_head + state->rx_count) % SIM_UART_FIFO_DEPTH] = entry;
+		state->rx_count++;
+		Sim_UART_Stats[index].rx_bytes++;
+
+		int trigger = Sim_UART_RX_Trigger(index);
+		if (previous < trigger && state->rx_count >= trigger)
+		{
+			uart->RIS.raw |= SIM_UART_INT_RX;
+		}
+	}
+
+	uint64_t bit = Sim_UART_Bit_Time(index);
+	state->rx_generation++;
+	if (bit)
+	{
+		Sim_Schedule(Sim_Time + 32 * bit, Sim_UART_Receive_Timeout, state,
+			((state->rx_generation & 0xFFFFFF) << 8) | index);
+	}
+
+	Sim_UART_Update_IRQ(index);
+}
+
+void Sim_UART_Reset(void)
+{
+	memset((void *)Sim_UART, 0, sizeof(Sim_UART));
+	memset(Sim_UART_States, 0, sizeof(Sim_UART_States));
+	memset(Sim_UART_Stats, 0, sizeof(Sim_UART_Stats));
+
+	for (int index = 0; index < SIM_UART_COUNT; index++)
+	{
+		Sim_UART[index].CTL.raw = SIM_UART_CTL_TXE | SIM_UART_CTL_RXE;
+		Sim_UART[index].IFLS.raw = 0x12;
+		Sim_UART_States[index].peer_baud = (index == 0) ? 115200 : 9600;
+	}
+}
+
+void Sim_UART_Set_Peer_Baud(int index, uint32_t baud)
+{
+	Sim_UART_States[index].peer_baud = baud;
+	Sim_UART_States[index].warned_baud = 0;
+}
+
+uint64_t Sim_UART_Peer_Send(int index, const char *data, int length, uint64_t start)
+{
+	Sim_UART_State *state = &Sim_UART_States[index];
+	uint64_t frame = 10 * Sim_UART_Peer_Bit_Time(index);
+	uint64_t time = start;
+
+	if (time < Sim_Time)
+	{
+		time = Sim_Time;
+	}
+	if (time < state->peer_free)
+	{
+		time = state->peer_free;
+	}
+
+	for (int i = 0; i < length; i++)
+	{
+		time += frame;
+		Sim_Schedule(time, Sim_UART_Receive, state, ((uint32_t)(uint8_t)data[i] << 8) | index);
+	}
+	state->peer_free = time;
+
+	return time;
+}
+
+uint32_t Sim_UART_Read(int index, const void *reg)
+{
+	UART0_Type *uart = &Sim_UART[index];
+	Sim_UART_State *state = &Sim_UART_States[index];
+
+	Sim_UART_Check_Clock(index);
+
+	if (reg == &uart->DR.raw)
+	{
+		if (state->rx_count == 0)
+		{
+			return uart->DR.raw;
+		}
+
+		uint16_t entry = state->rx_fifo[state->rx_head];
+		state->rx_head = (state->rx_head + 1) % SIM_UART_FIFO_DEPTH;
+		state->rx_count--;
+		state->rsr = (state->rsr & 0x08) | ((entry >> 8) & 0x07);
+		uart->DR.raw = entry;
+
+		// RX clears once the FIFO drops below the trigger level, RT once it is empty
+		if (state->rx_count < Sim_UART_RX_Trigger(index))
+		{
+			uart->RIS.raw &= ~SIM_UART_INT_RX;
+		}
+		if (state->rx_count == 0)
+		{
+			uart->RIS.raw &= ~SIM_UART_INT_RT;
+		}
+		Sim_UART_Update_IRQ(index);
+		Sim_State_Version++;
+
+		return entry;
+	}
+	if (reg == &uart->RSR.raw)
+	{
+		return state->rsr;
+	}
+	if (reg == &uart->FR.raw)
+	{
+		int depth = Sim_UART_Depth(index);
+		uint32_t flags = 0;
+
+		flags |= (state->tx_count == 0) ? 0x80 : 0;
+		flags |= (state->rx_count == depth) ? 0x40 : 0;
+		flags |= (state->tx_count == depth) ? 0x20 : 0;
+		flags |= (state->rx_count == 0) ? 0x10 : 0;
+		flags |= (state->tx_busy || state->tx_count) ? 0x08 : 0;
+		return flags;
+	}
+	if (reg == &uart->MIS.raw)
+	{
+		return uart->RIS.raw & uart->IM.raw;
+	}
+	return *(const uint32_t *)reg;
+}
+
+void Sim_UART_Write(int index, void *reg, uint32_t value)
+{
+	UART0_Type *uart = &Sim_UART[index];
+	Sim_UART_State *state = &Sim_UART_States[index];
+
+	Sim_UART_Check_Clock(index);
+
+	if (reg == &uart->DR.raw)
+	{
+		int depth = Sim_UART_Depth(index);
+
+		if (state->tx_count == depth)
+		{
+			Sim_UART_Stats[index].tx_dropped++;
+			return;
+		}
+
+		state->tx_fifo[(state->tx_head + state->tx_count) % SIM_UART_FIFO_DEPTH] = (uint8_t)value;
+		state->tx_count++;
+		if (state->tx_count > Sim_UART_TX_Trigger(index))
+		{
+			uart->RIS.raw &= ~SIM_UART_INT_TX;
+		}
+		Sim_UART_Start_Transmit(index);
+		Sim_UART_Update_IRQ(index);
+		return;
+	}
+	if (reg == &uart->RSR.raw)
+	{
+		state->rsr = 0;
+		return;
+	}
+	if (reg == &uart->ICR.raw)
+	{
+		uart->RIS.raw &= ~value;
+		Sim_UART_Update_IRQ(index);
+		return;
+	}
+	if (reg == &uart->FR.raw || reg == &uart->RIS.raw || reg == &uart->MIS.raw)
+	{
+		return;
+	}
+
+	uint32_t previous_ctl = uart->CTL.raw;
+	Sim_Store(reg, 4, value);
+
+	if (reg == &uart->CTL.raw)
+	{
+		if ((value & SIM_UART_CTL_UARTEN) && !(previous_ctl & SIM_UART_CTL_UARTEN))
+		{
+			Sim_UART_Check_Baud(index);
+		}
+		Sim_UART_Start_Transmit(index);
+	}
+	else if (reg == &uart->IM.raw)
+	{
+		Sim_UART_Update_IRQ(index);
+	}
+}
@@ -0,0 +1,236 @@
+/**
+ * @file Simulator.h
+ *
+ * @brief Internal interface of the host-side TM4C123GH6PM peripheral model.
+ *
+ * The model is event driven. Virtual time is kept in picoseconds and only moves
+ * forward when the firmware touches a register (every access costs a few core cycles),
+ * executes WFI, or stops touching registers altogether while it spins on a RAM variable
+ * that an interrupt handler updates (detected by a wall-clock watchdog, see Sim_Core.cpp).
+ * Peripherals schedule events (a UART character finishing, a timer time-out, a SysTick
+ * wrap) and raise interrupt lines; the dispatcher calls the firmware's handlers by
+ * priority, nested, the same way the NVIC would.
+ *
+ * Modules:
+ *  - Sim_Core.cpp: virtual clock, event queue, NVIC / SCB, interrupt dispatch, register routing
+ *  - Sim_SysCtl.cpp: System Control clock gating and RCC / RCC2 system clock selection
+ *  - Sim_UART.cpp: UART FIFOs, baud timing, interrupt flags and the peer side of each link
+ *  - Sim_GPIO.cpp: GPIO Ports A to F and the pin waveform log
+ *  - Sim_Timer.cpp: GPTM timers and SysTick
+ *  - Sim_EEPROM.cpp: EEPROM words, write timing and the image files that keep them between runs
+ *  - Sim_BLE.cpp: AT command mode of the Bluefruit LE module on UART1
+ *  - Sim_Script.cpp: scenario scripts, assertions, report and main()
+ */
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include "TM4C123GH6PM.h"
+#include <stdio.h>
+
+/**
+ * @brief Virtual time units in picoseconds
+ */
+#define SIM_NS         1000ULL
+#define SIM_US         1000000ULL
+#define SIM_MS         1000000000ULL
+#define SIM_S          1000000000000ULL
+#define SIM_NEVER      UINT64_MAX
+
+/**
+ * @brief Cost model, in core cycles
+ */
+#define SIM_ACCESS_CYCLES           4
+#define SIM_EXCEPTION_ENTRY_CYCLES  12
+#define SIM_EXCEPTION_EXIT_CYCLES   10
+
+/**
+ * @brief Size of the stack, STACK_SIZE in TM4C123GH6PM.ld
+ */
+#define SIM_STACK_SIZE              0x200
+
+/**
+ * @brief Number of reads that find the model unchanged before time skips to the next event
+ */
+#define SIM_IDLE_READS              8
+
+/**
+ * @brief Exception numbers of the core exceptions handled by the dispatcher
+ */
+#define SIM_EXCEPTION_SVCALL        11
+#define SIM_EXCEPTION_PENDSV        14
+#define SIM_EXCEPTION_SYSTICK       15
+#define SIM_EXCEPTION_IRQ0          16
+#define SIM_EXCEPTION_COUNT         256
+
+typedef void (*Sim_Event_Handler)(void *context, uint32_t argument);
+
+/**
+ * @brief Current virtual time in picoseconds
+ */
+extern uint64_t Sim_Time;
+
+/**
+ * @brief Core clock frequency and the length of one core cycle
+ */
+extern uint32_t Sim_Core_Hz;
+extern uint64_t Sim_Cycle_Time;
+
+/**
+ * @brief Incremented whenever the model changes state, used to detect polling loops
+ */
+extern uint64_t Sim_State_Version;
+
+/**
+ * @brief Run-time options set by the scenario or the command line
+ */
+typedef struct {
+	uint64_t stall_quantum;
+	uint32_t stall_interval_us;
+	int trace;
+	int warnings_as_errors;
+} Sim_Options_Type;
+
+extern Sim_Options_Type Sim_Options;
+
+/**
+ * @brief Per-exception statistics collected by the dispatcher
+ */
+typedef struct {
+	uint64_t count;
+	uint64_t total_cycles;
+	uint64_t max_cycles;
+	uint64_t max_latency_cycles;
+	uint64_t pend_time;
+	uint8_t pend_time_valid;
+} Sim_Exception_Stats_Type;
+
+extern Sim_Exception_Stats_Type Sim_Exception_Stats[SIM_EXCEPTION_COUNT];
+
+/**
+ * @brief Global statistics reported at the end of a run
+ */
+typedef struct {
+	uint64_t register_accesses;
+	uint64_t events;
+	uint64_t idle_skips;
+	uint64_t stall_advances;
+	uint64_t sleep_time;
+	uint64_t warnings;
+} Sim_Stats_Type;
+
+extern Sim_Stats_Type Sim_Stats;
+
+/**
+ * @brief Sim_Core.cpp
+ */
+void Sim_Init(void);
+void Sim_Set_Core_Clock(uint32_t hz);
+uint64_t Sim_Cycle_Count(void);
+void Sim_Schedule(uint64_t time, Sim_Event_Handler handler, void *context, uint32_t argument);
+uint64_t Sim_Next_Event_Time(void);
+void Sim_Run_Until(uint64_t time);
+void Sim_Consume_Cycles(uint32_t cycles);
+void Sim_Store(void *reg, unsigned int size, uint32_t value);
+void Sim_IRQ_Set_Level(int irq, int level);
+void Sim_Exception_Pend(int exception);
+void Sim_Stack_Write(int offset, uint32_t value);
+void Sim_Start_Stall_Detector(void);
+void Sim_Stop_Stall_Detector(void);
+const char *Sim_Exception_Name(int exception);
+void Sim_Warning(const char *format, ...) __attribute__((format(printf, 1, 2)));
+void Sim_Fatal(const char *format, ...) __attribute__((format(printf, 1, 2), noreturn));
+void Sim_Log(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+/**
+ * @brief Sim_SysCtl.cpp
+ */
+void Sim_SysCtl_Reset(void);
+uint32_t Sim_SysCtl_Read(const void *reg);
+void Sim_SysCtl_Write(void *reg, uint32_t value);
+int Sim_SysCtl_Clock_Enabled(const Sim_Register *rcgc, int index);
+
+/**
+ * @brief Sim_UART.cpp
+ */
+#define SIM_UART_COUNT 8
+
+typedef struct {
+	uint64_t tx_bytes;
+	uint64_t rx_bytes;
+	uint64_t rx_overruns;
+	uint64_t rx_framing_errors;
+	uint64_t tx_dropped;
+} Sim_UART_Stats_Type;
+
+extern Sim_UART_Stats_Type Sim_UART_Stats[SIM_UART_COUNT];
+extern void (*Sim_UART_Output_Hook)(int index, uint8_t data);
+
+void Sim_UART_Reset(void);
+uint32_t Sim_UART_Read(int index, const void *reg);
+void Sim_UART_Write(int index, void *reg, uint32_t value);
+void Sim_UART_Set_Peer_Baud(int index, uint32_t baud);
+uint64_t Sim_UART_Peer_Send(int index, const char *data, int length, uint64_t start);
+
+/**
+ * @brief Sim_GPIO.cpp
+ */
+#define SIM_GPIO_COUNT 6
+
+extern void (*Sim_GPIO_Output_Hook)(int port, uint32_t previous, uint32_t current);
+
+void Sim_GPIO_Reset(void);
+uint32_t Sim_GPIO_Read(int port, const void *reg);
+void Sim_GPIO_Write(int port, void *reg, uint32_t value);
+uint32_t Sim_GPIO_Output(int port);
+void Sim_GPIO_Set_Input(int port, uint32_t mask, uint32_t value);
+
+/**
+ * @brief Sim_Timer.cpp
+ */
+#define SIM_TIMER_COUNT 6
+
+void Sim_Timer_Reset(void);
+uint32_t Sim_Timer_Read(int wide, int index, const void *reg);
+void Sim_Timer_Write(int wide, int index, void *reg, uint32_t value);
+uint32_t Sim_SysTick_Read(const void *reg);
+void Sim_SysTick_Write(void *reg, uint32_t value);
+
+/**
+ * @brief Sim_EEPROM.cpp
+ */
+typedef struct {
+	uint64_t reads;
+	uint64_t writes;
+} Sim_EEPROM_Stats_Type;
+
+extern Sim_EEPROM_Stats_Type Sim_EEPROM_Stats;
+
+void Sim_EEPROM_Reset(void);
+uint32_t Sim_EEPROM_Read(const void *reg);
+void Sim_EEPROM_Write(void *reg, uint32_t value);
+int Sim_EEPROM_Load(const char *path);
+int Sim_EEPROM_Save(const char *path);
+uint32_t Sim_EEPROM_Word(int address);
+extern void (*Sim_EEPROM_Write_Hook)(int address, uint32_t value);
+
+/**
+ * @brief Sim_BLE.cpp
+ */
+typedef struct {
+	uint64_t commands;
+	uint64_t errors;
+} Sim_BLE_Stats_Type;
+
+extern Sim_BLE_Stats_Type Sim_BLE_Stats;
+
+void Sim_BLE_Reset(void);
+void Sim_BLE_Set_Connected(int connected);
+void Sim_BLE_Firmware_Output(uint8_t data);
+
+/**
+ * @brief Firmware entry points
+ */
+int Firmware_Main(void);
+
+#endif
@@ -0,0 +1,11 @@
+/**
+ * @file TM4C123.h
+ *
+ * @brief Simulated CMSIS device header used by RTE/Device/TM4C123GH6PM/system_TM4C123.c.
+ *
+ * The Keil RTE component includes the family header TM4C123.h, which on the board
+ * resolves to the TM4C123GH6PM definitions. The host build forwards it to the
+ * simulated TM4C123GH6PM.h so SystemInit programs the modelled RCC / RCC2 registers.
+ */
+
+#include "TM4C123GH6PM.h"
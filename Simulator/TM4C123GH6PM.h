@@ -0,0 +1,655 @@
+/**
+ * @file TM4C123GH6PM.h
+ *
+ * @brief Simulated TM4C123GH6PM device header for the host build of the firmware.
+ *
+ * This header replaces the Keil TM4C123GH6PM.h device header when the firmware is
+ * compiled on Linux. The peripheral types, register names, instance names and IRQ
+ * numbers match the real header, so the drivers compile unchanged. Every register is
+ * a Sim_Register object: reading or writing it calls into the peripheral model
+ * (see Simulator.h), which charges the access to a virtual cycle clock and applies
+ * the side effects of the access (FIFO pops, interrupt flags, timer reloads, ...).
+ *
+ * The following peripherals are modelled:
+ *  - UART0 to UART7
+ *  - GPIO Ports A to F
+ *  - GPTM Timers 0 to 5 and Wide Timers 0 to 5
+ *  - System Control (clock gating, RCC / RCC2 clock selection)
+ *  - EEPROM
+ *  - NVIC, SCB and SysTick
+ *  - DWT cycle counter and CoreDebug DEMCR
+ *
+ * @note The firmware must be compiled as C++ against this header.
+ *
+ * @note Like the CMSIS 6 core header, NVIC->IPR and SCB->SHPR are arrays of 8-bit
+ * registers, so firmware that writes them as 32-bit words behaves as it does on the board.
+ */
+
+#ifndef TM4C123GH6PM_H
+#define TM4C123GH6PM_H
+
+#ifndef __cplusplus
+#error "The simulated TM4C123GH6PM.h requires the firmware to be compiled as C++"
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define __CM4_REV                 0x0102
+#define __MPU_PRESENT             1
+#define __NVIC_PRIO_BITS          3
+#define __Vendor_SysTickConfig    0
+#define __FPU_PRESENT             1
+#define __FPU_USED                1
+
+#define __I      volatile const
+#define __O      volatile
+#define __IO     volatile
+#define __IM     volatile const
+#define __OM     volatile
+#define __IOM    volatile
+
+#define __INLINE          inline
+#define __STATIC_INLINE   static inline
+
+/**
+ * @brief Interrupt numbers of the TM4C123GH6PM (Table 2-9 of the datasheet).
+ */
+typedef enum {
+	Reset_IRQn              = -15,
+	NonMaskableInt_IRQn     = -14,
+	HardFault_IRQn          = -13,
+	MemoryManagement_IRQn   = -12,
+	BusFault_IRQn           = -11,
+	UsageFault_IRQn         = -10,
+	SVCall_IRQn             =  -5,
+	DebugMonitor_IRQn       =  -4,
+	PendSV_IRQn             =  -2,
+	SysTick_IRQn            =  -1,
+	GPIOA_IRQn              =   0,
+	GPIOB_IRQn              =   1,
+	GPIOC_IRQn              =   2,
+	GPIOD_IRQn              =   3,
+	GPIOE_IRQn              =   4,
+	UART0_IRQn              =   5,
+	UART1_IRQn              =   6,
+	SSI0_IRQn               =   7,
+	I2C0_IRQn               =   8,
+	PWM0_FAULT_IRQn         =   9,
+	PWM0_0_IRQn             =  10,
+	PWM0_1_IRQn             =  11,
+	PWM0_2_IRQn             =  12,
+	QEI0_IRQn               =  13,
+	ADC0SS0_IRQn            =  14,
+	ADC0SS1_IRQn            =  15,
+	ADC0SS2_IRQn            =  16,
+	ADC0SS3_IRQn            =  17,
+	WATCHDOG0_IRQn          =  18,
+	TIMER0A_IRQn            =  19,
+	TIMER0B_IRQn            =  20,
+	TIMER1A_IRQn            =  21,
+	TIMER1B_IRQn            =  22,
+	TIMER2A_IRQn            =  23,
+	TIMER2B_IRQn            =  24,
+	COMP0_IRQn              =  25,
+	COMP1_IRQn              =  26,
+	SYSCTL_IRQn             =  28,
+	FLASH_CTRL_IRQn         =  29,
+	GPIOF_IRQn              =  30,
+	UART2_IRQn              =  33,
+	SSI1_IRQn               =  34,
+	TIMER3A_IRQn            =  35,
+	TIMER3B_IRQn            =  36,
+	I2C1_IRQn               =  37,
+	QEI1_IRQn               =  38,
+	CAN0_IRQn               =  39,
+	CAN1_IRQn               =  40,
+	HIB_IRQn                =  43,
+	USB0_IRQn               =  44,
+	PWM0_3_IRQn             =  45,
+	UDMA_IRQn               =  46,
+	UDMAERR_IRQn            =  47,
+	ADC1SS0_IRQn            =  48,
+	ADC1SS1_IRQn            =  49,
+	ADC1SS2_IRQn            =  50,
+	ADC1SS3_IRQn            =  51,
+	SSI2_IRQn               =  57,
+	SSI3_IRQn               =  58,
+	UART3_IRQn              =  59,
+	UART4_IRQn              =  60,
+	UART5_IRQn              =  61,
+	UART6_IRQn              =  62,
+	UART7_IRQn              =  63,
+	I2C2_IRQn               =  68,
+	I2C3_IRQn               =  69,
+	TIMER4A_IRQn            =  70,
+	TIMER4B_IRQn            =  71,
+	TIMER5A_IRQn            =  92,
+	TIMER5B_IRQn            =  93,
+	WTIMER0A_IRQn           =  94,
+	WTIMER0B_IRQn           =  95,
+	WTIMER1A_IRQn           =  96,
+	WTIMER1B_IRQn           =  97,
+	WTIMER2A_IRQn           =  98,
+	WTIMER2B_IRQn           =  99,
+	WTIMER3A_IRQn           = 100,
+	WTIMER3B_IRQn           = 101,
+	WTIMER4A_IRQn           = 102,
+	WTIMER4B_IRQn           = 103,
+	WTIMER5A_IRQn           = 104,
+	WTIMER5B_IRQn           = 105,
+	SYSEXC_IRQn             = 106,
+	PWM1_0_IRQn             = 134,
+	PWM1_1_IRQn             = 135,
+	PWM1_2_IRQn             = 136,
+	PWM1_3_IRQn             = 137,
+	PWM1_FAULT_IRQn         = 138
+} IRQn_Type;
+
+/**
+ * @brief Register access hooks implemented by the peripheral model (Sim_Core.cpp).
+ */
+uint32_t Sim_Register_Read(const void *reg, unsigned int size);
+void Sim_Register_Write(void *reg, unsigned int size, uint32_t value);
+
+/**
+ * @brief A memory-mapped register of the simulated device.
+ *
+ * The raw member holds the stored register value. Reads and writes made by the
+ * firmware go through the peripheral model; the model itself uses raw directly.
+ */
+template <typename T>
+struct Sim_Register_Type
+{
+	T raw;
+
+	operator T() const
+	{
+		return (T)Sim_Register_Read(&raw, sizeof(T));
+	}
+
+	Sim_Register_Type &operator=(uint32_t value)
+	{
+		Sim_Register_Write(&raw, sizeof(T), value);
+		return *this;
+	}
+
+	Sim_Register_Type &operator=(const Sim_Register_Type &other)
+	{
+		return *this = (uint32_t)(T)other;
+	}
+
+	Sim_Register_Type &operator|=(uint32_t value) { return *this = (uint32_t)((T)*this | value); }
+	Sim_Register_Type &operator&=(uint32_t value) { return *this = (uint32_t)((T)*this & value); }
+	Sim_Register_Type &operator^=(uint32_t value) { return *this = (uint32_t)((T)*this ^ value); }
+	Sim_Register_Type &operator+=(uint32_t value) { return *this = (uint32_t)((T)*this + value); }
+	Sim_Register_Type &operator-=(uint32_t value) { return *this = (uint32_t)((T)*this - value); }
+	Sim_Register_Type &operator<<=(unsigned int shift) { return *this = (uint32_t)((T)*this << shift); }
+	Sim_Register_Type &operator>>=(unsigned int shift) { return *this = (uint32_t)((T)*this >> shift); }
+};
+
+typedef Sim_Register_Type<uint32_t> Sim_Register;
+typedef Sim_Register_Type<uint8_t> Sim_Register8;
+
+/**
+ * @brief UART0 to UART7 (UARTs section of the datasheet)
+ */
+typedef struct {
+	Sim_Register DR;
+	union {
+		Sim_Register RSR;
+		Sim_Register ECR;
+	};
+	Sim_Register FR;
+	Sim_Register ILPR;
+	Sim_Register IBRD;
+	Sim_Register FBRD;
+	Sim_Register LCRH;
+	Sim_Register CTL;
+	Sim_Register IFLS;
+	Sim_Register IM;
+	Sim_Register RIS;
+	Sim_Register MIS;
+	Sim_Register ICR;
+	Sim_Register DMACTL;
+	Sim_Register _9BITADDR;
+	Sim_Register _9BITAMASK;
+	Sim_Register PP;
+	Sim_Register CC;
+} UART0_Type;
+
+/**
+ * @brief GPIO Ports A to F (General-Purpose Input/Outputs section of the datasheet)
+ */
+typedef struct {
+	Sim_Register DATA;
+	Sim_Register DIR;
+	Sim_Register IS;
+	Sim_Register IBE;
+	Sim_Register IEV;
+	Sim_Register IM;
+	Sim_Register RIS;
+	Sim_Register MIS;
+	Sim_Register ICR;
+	Sim_Register AFSEL;
+	Sim_Register DR2R;
+	Sim_Register DR4R;
+	Sim_Register DR8R;
+	Sim_Register ODR;
+	Sim_Register PUR;
+	Sim_Register PDR;
+	Sim_Register SLR;
+	Sim_Register DEN;
+	Sim_Register LOCK;
+	Sim_Register CR;
+	Sim_Register AMSEL;
+	Sim_Register PCTL;
+	Sim_Register ADCCTL;
+	Sim_Register DMACTL;
+} GPIOA_Type;
+
+/**
+ * @brief 16/32-bit and 32/64-bit General-Purpose Timers (GPTM)
+ */
+typedef struct {
+	Sim_Register CFG;
+	Sim_Register TAMR;
+	Sim_Register TBMR;
+	Sim_Register CTL;
+	Sim_Register SYNC;
+	Sim_Register IMR;
+	Sim_Register RIS;
+	Sim_Register MIS;
+	Sim_Register ICR;
+	Sim_Register TAILR;
+	Sim_Register TBILR;
+	Sim_Register TAMATCHR;
+	Sim_Register TBMATCHR;
+	Sim_Register TAPR;
+	Sim_Register TBPR;
+	Sim_Register TAPMR;
+	Sim_Register TBPMR;
+	Sim_Register TAR;
+	Sim_Register TBR;
+	Sim_Register TAV;
+	Sim_Register TBV;
+	Sim_Register RTCPD;
+	Sim_Register TAPS;
+	Sim_Register TBPS;
+	Sim_Register TAPV;
+	Sim_Register TBPV;
+	Sim_Register PP;
+} TIMER0_Type;
+
+typedef TIMER0_Type WTIMER0_Type;
+
+/**
+ * @brief System Control
+ */
+typedef struct {
+	Sim_Register DID0;
+	Sim_Register DID1;
+	Sim_Register PBORCTL;
+	Sim_Register RIS;
+	Sim_Register IMC;
+	Sim_Register MISC;
+	Sim_Register RESC;
+	Sim_Register RCC;
+	Sim_Register GPIOHBCTL;
+	Sim_Register RCC2;
+	Sim_Register MOSCCTL;
+	Sim_Register DSLPCLKCFG;
+	Sim_Register SYSPROP;
+	Sim_Register PIOSCCAL;
+	Sim_Register PIOSCSTAT;
+	Sim_Register PLLFREQ0;
+	Sim_Register PLLFREQ1;
+	Sim_Register PLLSTAT;
+	Sim_Register SLPPWRCFG;
+	Sim_Register DSLPPWRCFG;
+	Sim_Register LDOSPCTL;
+	Sim_Register LDOSPCAL;
+	Sim_Register LDODPCTL;
+	Sim_Register LDODPCAL;
+	Sim_Register SDPMST;
+	Sim_Register SRWD;
+	Sim_Register SRTIMER;
+	Sim_Register SRGPIO;
+	Sim_Register SRUART;
+	Sim_Register SREEPROM;
+	Sim_Register SRWTIMER;
+	Sim_Register RCGCWD;
+	Sim_Register RCGCTIMER;
+	Sim_Register RCGCGPIO;
+	Sim_Register RCGCDMA;
+	Sim_Register RCGCHIB;
+	Sim_Register RCGCUART;
+	Sim_Register RCGCSSI;
+	Sim_Register RCGCI2C;
+	Sim_Register RCGCUSB;
+	Sim_Register RCGCCAN;
+	Sim_Register RCGCADC;
+	Sim_Register RCGCACMP;
+	Sim_Register RCGCPWM;
+	Sim_Register RCGCQEI;
+	Sim_Register RCGCEEPROM;
+	Sim_Register RCGCWTIMER;
+	Sim_Register SCGCTIMER;
+	Sim_Register SCGCGPIO;
+	Sim_Register SCGCUART;
+	Sim_Register SCGCEEPROM;
+	Sim_Register SCGCWTIMER;
+	Sim_Register DCGCTIMER;
+	Sim_Register DCGCGPIO;
+	Sim_Register DCGCUART;
+	Sim_Register DCGCEEPROM;
+	Sim_Register DCGCWTIMER;
+	Sim_Register PRWD;
+	Sim_Register PRTIMER;
+	Sim_Register PRGPIO;
+	Sim_Register PRUART;
+	Sim_Register PREEPROM;
+	Sim_Register PRWTIMER;
+} SYSCTL_Type;
+
+/**
+ * @brief EEPROM (Internal Memory section of the datasheet)
+ *
+ * Only the registers up to EEHIDE are kept, the model does not implement protection.
+ */
+typedef struct {
+	Sim_Register EESIZE;
+	Sim_Register EEBLOCK;
+	Sim_Register EEOFFSET;
+	Sim_Register RESERVED0[1];
+	Sim_Register EERDWR;
+	Sim_Register EERDWRINC;
+	Sim_Register EEDONE;
+	Sim_Register EESUPP;
+	Sim_Register EEUNLOCK;
+	Sim_Register RESERVED1[3];
+	Sim_Register EEPROT;
+	Sim_Register EEPASS0;
+	Sim_Register EEPASS1;
+	Sim_Register EEPASS2;
+	Sim_Register EEINT;
+	Sim_Register RESERVED2[3];
+	Sim_Register EEHIDE;
+} EEPROM_Type;
+
+/**
+ * @brief Nested Vectored Interrupt Controller (CMSIS core_cm4.h layout)
+ */
+typedef struct {
+	Sim_Register ISER[8];
+	Sim_Register ICER[8];
+	Sim_Register ISPR[8];
+	Sim_Register ICPR[8];
+	Sim_Register IABR[8];
+	Sim_Register8 IPR[240];
+	Sim_Register STIR;
+} NVIC_Type;
+
+/**
+ * @brief System Control Block (CMSIS core_cm4.h layout)
+ */
+typedef struct {
+	Sim_Register CPUID;
+	Sim_Register ICSR;
+	Sim_Register VTOR;
+	Sim_Register AIRCR;
+	Sim_Register SCR;
+	Sim_Register CCR;
+	Sim_Register8 SHPR[12];
+	Sim_Register SHCSR;
+	Sim_Register CFSR;
+	Sim_Register HFSR;
+	Sim_Register DFSR;
+	Sim_Register MMFAR;
+	Sim_Register BFAR;
+	Sim_Register AFSR;
+	Sim_Register CPACR;
+} SCB_Type;
+
+#define SCB_ICSR_ISRPENDING_Pos         22
+#define SCB_ICSR_ISRPENDING_Msk         ((uint32_t)(1UL << SCB_ICSR_ISRPENDING_Pos))
+#define SCB_ICSR_PENDSTSET_Pos          26
+#define SCB_ICSR_PENDSTSET_Msk          ((uint32_t)(1UL << SCB_ICSR_PENDSTSET_Pos))
+#define SCB_ICSR_PENDSVSET_Pos          28
+#define SCB_ICSR_PENDSVSET_Msk          ((uint32_t)(1UL << SCB_ICSR_PENDSVSET_Pos))
+#define SCB_SCR_SLEEPDEEP_Pos           2
+#define SCB_SCR_SLEEPDEEP_Msk           ((uint32_t)(1UL << SCB_SCR_SLEEPDEEP_Pos))
+
+/**
+ * @brief System Timer (CMSIS core_cm4.h layout)
+ */
+typedef struct {
+	Sim_Register CTRL;
+	Sim_Register LOAD;
+	Sim_Register VAL;
+	Sim_Register CALIB;
+} SysTick_Type;
+
+/**
+ * @brief Data Watchpoint and Trace unit (CMSIS core_cm4.h layout)
+ *
+ * Only the cycle counter is modelled: CYCCNT counts core cycles while CTRL.CYCCNTENA
+ * and CoreDebug DEMCR.TRCENA are set.
+ */
+typedef struct {
+	Sim_Register CTRL;
+	Sim_Register CYCCNT;
+	Sim_Register CPICNT;
+	Sim_Register EXCCNT;
+	Sim_Register SLEEPCNT;
+	Sim_Register LSUCNT;
+	Sim_Register FOLDCNT;
+	Sim_Register PCSR;
+	Sim_Register COMP0;
+	Sim_Register MASK0;
+	Sim_Register FUNCTION0;
+	Sim_Register RESERVED0[1];
+	Sim_Register COMP1;
+	Sim_Register MASK1;
+	Sim_Register FUNCTION1;
+	Sim_Register RESERVED1[1];
+	Sim_Register COMP2;
+	Sim_Register MASK2;
+	Sim_Register FUNCTION2;
+	Sim_Register RESERVED2[1];
+	Sim_Register COMP3;
+	Sim_Register MASK3;
+	Sim_Register FUNCTION3;
+} DWT_Type;
+
+#define DWT_CTRL_NOCYCCNT_Pos           25
+#define DWT_CTRL_NOCYCCNT_Msk           (1UL << DWT_CTRL_NOCYCCNT_Pos)
+#define DWT_CTRL_CYCCNTENA_Pos          0
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << DWT_CTRL_CYCCNTENA_Pos)
+
+/**
+ * @brief Core Debug registers (CMSIS core_cm4.h layout)
+ */
+typedef struct {
+	Sim_Register DHCSR;
+	Sim_Register DCRSR;
+	Sim_Register DCRDR;
+	Sim_Register DEMCR;
+} CoreDebug_Type;
+
+#define CoreDebug_DEMCR_TRCENA_Pos      24
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << CoreDebug_DEMCR_TRCENA_Pos)
+
+/**
+ * @brief Peripheral instances owned by the model
+ */
+extern UART0_Type Sim_UART[8];
+extern GPIOA_Type Sim_GPIO[6];
+extern TIMER0_Type Sim_Timer[6];
+extern WTIMER0_Type Sim_Wide_Timer[6];
+extern SYSCTL_Type Sim_SYSCTL;
+extern EEPROM_Type Sim_EEPROM;
+extern NVIC_Type Sim_NVIC;
+extern SCB_Type Sim_SCB;
+extern SysTick_Type Sim_SysTick;
+extern DWT_Type Sim_DWT;
+extern CoreDebug_Type Sim_CoreDebug;
+
+#define UART0       (&Sim_UART[0])
+#define UART1       (&Sim_UART[1])
+#define UART2       (&Sim_UART[2])
+#define UART3       (&Sim_UART[3])
+#define UART4       (&Sim_UART[4])
+#define UART5       (&Sim_UART[5])
+#define UART6       (&Sim_UART[6])
+#define UART7       (&Sim_UART[7])
+
+#define GPIOA       (&Sim_GPIO[0])
+#define GPIOB       (&Sim_GPIO[1])
+#define GPIOC       (&Sim_GPIO[2])
+#define GPIOD       (&Sim_GPIO[3])
+#define GPIOE       (&Sim_GPIO[4])
+#define GPIOF       (&Sim_GPIO[5])
+
+#define TIMER0      (&Sim_Timer[0])
+#define TIMER1      (&Sim_Timer[1])
+#define TIMER2      (&Sim_Timer[2])
+#define TIMER3      (&Sim_Timer[3])
+#define TIMER4      (&Sim_Timer[4])
+#define TIMER5      (&Sim_Timer[5])
+
+#define WTIMER0     (&Sim_Wide_Timer[0])
+#define WTIMER1     (&Sim_Wide_Timer[1])
+#define WTIMER2     (&Sim_Wide_Timer[2])
+#define WTIMER3     (&Sim_Wide_Timer[3])
+#define WTIMER4     (&Sim_Wide_Timer[4])
+#define WTIMER5     (&Sim_Wide_Timer[5])
+
+#define SYSCTL      (&Sim_SYSCTL)
+#define EEPROM      (&Sim_EEPROM)
+#define NVIC        (&Sim_NVIC)
+#define SCB         (&Sim_SCB)
+#define SysTick     (&Sim_SysTick)
+#define DWT         (&Sim_DWT)
+#define CoreDebug   (&Sim_CoreDebug)
+
+/**
+ * @brief Core intrinsics implemented by the model (Sim_Core.cpp)
+ */
+void __enable_irq(void);
+void __disable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+uint32_t __get_IPSR(void);
+void __WFI(void);
+void __WFE(void);
+void __NOP(void);
+void __DSB(void);
+void __ISB(void);
+void __DMB(void);
+uint32_t __LDREXW(volatile uint32_t *address);
+uint32_t __STREXW(uint32_t value, volatile uint32_t *address);
+void __CLREX(void);
+
+/**
+ * @brief Count leading zeros, a single CLZ instruction on the Cortex-M4
+ */
+__STATIC_INLINE uint8_t __CLZ(uint32_t value)
+{
+	return (value == 0) ? 32 : (uint8_t)__builtin_clz(value);
+}
+
+/**
+ * @brief CMSIS NVIC and SysTick functions, written in terms of the registers as in core_cm4.h
+ */
+__STATIC_INLINE void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+	if ((int32_t)IRQn >= 0)
+	{
+		NVIC->ISER[((uint32_t)IRQn) >> 5] = (1UL << (((uint32_t)IRQn) & 0x1F));
+	}
+}
+
+__STATIC_INLINE void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+	if ((int32_t)IRQn >= 0)
+	{
+		NVIC->ICER[((uint32_t)IRQn) >> 5] = (1UL << (((uint32_t)IRQn) & 0x1F));
+		__DSB();
+		__ISB();
+	}
+}
+
+__STATIC_INLINE uint32_t NVIC_GetEnableIRQ(IRQn_Type IRQn)
+{
+	if ((int32_t)IRQn >= 0)
+	{
+		return ((NVIC->ISER[((uint32_t)IRQn) >> 5] & (1UL << (((uint32_t)IRQn) & 0x1F))) != 0) ? 1 : 0;
+	}
+	return 0;
+}
+
+__STATIC_INLINE void NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+	if ((int32_t)IRQn >= 0)
+	{
+		NVIC->ISPR[((uint32_t)IRQn) >> 5] = (1UL << (((uint32_t)IRQn) & 0x1F));
+	}
+}
+
+__STATIC_INLINE void NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+	if ((int32_t)IRQn >= 0)
+	{
+		NVIC->ICPR[((uint32_t)IRQn) >> 5] = (1UL << (((uint32_t)IRQn) & 0x1F));
+	}
+}
+
+__STATIC_INLINE uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn)
+{
+	if ((int32_t)IRQn >= 0)
+	{
+		return ((NVIC->ISPR[((uint32_t)IRQn) >> 5] & (1UL << (((uint32_t)IRQn) & 0x1F))) != 0) ? 1 : 0;
+	}
+	return 0;
+}
+
+__STATIC_INLINE void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+	if ((int32_t)IRQn >= 0)
+	{
+		NVIC->IPR[((uint32_t)IRQn)] = (uint8_t)((priority << (8 - __NVIC_PRIO_BITS)) & 0xFF);
+	}
+	else
+	{
+		SCB->SHPR[(((uint32_t)IRQn) & 0xF) - 4] = (uint8_t)((priority << (8 - __NVIC_PRIO_BITS)) & 0xFF);
+	}
+}
+
+__STATIC_INLINE uint32_t NVIC_GetPriority(IRQn_Type IRQn)
+{
+	if ((int32_t)IRQn >= 0)
+	{
+		return ((uint32_t)NVIC->IPR[((uint32_t)IRQn)] >> (8 - __NVIC_PRIO_BITS));
+	}
+	return ((uint32_t)SCB->SHPR[(((uint32_t)IRQn) & 0xF) - 4] >> (8 - __NVIC_PRIO_BITS));
+}
+
+__STATIC_INLINE uint32_t SysTick_Config(uint32_t ticks)
+{
+	if ((ticks - 1) > 0xFFFFFF)
+	{
+		return 1;
+	}
+	SysTick->LOAD = (uint32_t)(ticks - 1);
+	NVIC_SetPriority(SysTick_IRQn, (1UL << __NVIC_PRIO_BITS) - 1);
+	SysTick->VAL = 0;
+	SysTick->CTRL = 0x07;
+	return 0;
+}
+
+extern uint32_t SystemCoreClock;
+void SystemInit(void);
+void SystemCoreClockUpdate(void);
+
+#endif
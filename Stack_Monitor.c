@@ -0,0 +1,81 @@
+/**
+ * @file Stack_Monitor.c
+ *
+ * @brief Source code for the Stack_Monitor module.
+ *
+ * The bottom of the stack is the base of the STACK section of startup_TM4C123.s with
+ * the Keil toolchain, and _sstack, defined in TM4C123GH6PM.ld, with GCC.
+ */
+
+#include "Stack_Monitor.h"
+#include "Log.h"
+#include "Number_Format.h"
+
+#define STACK_MONITOR_LINE_SIZE    64
+
+#if defined(__ARMCC_VERSION)
+extern uint32_t STACK$$Base;
+#define STACK_MONITOR_BOTTOM       (&STACK$$Base)
+#else
+extern uint32_t _sstack[];
+#define STACK_MONITOR_BOTTOM       (_sstack)
+#endif
+
+static uint8_t Stack_Monitor_Warned;
+
+void Stack_Monitor_Init(void)
+{
+	uint32_t *word = STACK_MONITOR_BOTTOM;
+	uint32_t *top = STACK_MONITOR_BOTTOM + (STACK_MONITOR_SIZE / 4);
+
+	// A local variable marks the stack in use. Stop 64 bytes below it to stay clear of the
+	// rest of this function's frame, which makes the peak at least that much deeper than main.
+	uint32_t marker = 0;
+	uint32_t *in_use = &marker - 16;
+
+	while (word < top && word < in_use)
+	{
+		*word++ = STACK_MONITOR_PATTERN;
+	}
+
+	Stack_Monitor_Warned = 0;
+}
+
+uint32_t Stack_Monitor_Peak(void)
+{
+	uint32_t *word = STACK_MONITOR_BOTTOM;
+	uint32_t *top = STACK_MONITOR_BOTTOM + (STACK_MONITOR_SIZE / 4);
+
+	while (word < top && *word == STACK_MONITOR_PATTERN)
+	{
+		word++;
+	}
+
+	return (uint32_t)(top - word) * 4;
+}
+
+void Stack_Monitor_Check(void)
+{
+	uint32_t peak = Stack_Monitor_Peak();
+
+	if (!Stack_Monitor_Warned && (STACK_MONITOR_SIZE - peak) < STACK_MONITOR_MARGIN)
+	{
+		Stack_Monitor_Warned = 1;
+		LOG(LOG_STACK_LOW, peak, STACK_MONITOR_SIZE);
+	}
+}
+
+void Stack_Monitor_Report(void)
+{
+	uint32_t peak = Stack_Monitor_Peak();
+	char line[STACK_MONITOR_LINE_SIZE];
+	char *limit = line + sizeof(line);
+	char *end = line;
+
+	end = Format_Append_Field(end, limit, "STACK peak ", peak);
+	end = Format_Append_Field(end, limit, " of ", STACK_MONITOR_SIZE);
+	end = Format_Append_Field(end, limit, " bytes, ", STACK_MONITOR_SIZE - peak);
+	end = Format_Append(end, limit, " free");
+
+	Format_Report_Line(line);
+}
@@ -0,0 +1,70 @@
+/**
+ * @file Stack_Monitor.h
+ *
+ * @brief Header file for the Stack_Monitor module.
+ *
+ * This module measures the peak stack usage at run time. Stack_Monitor_Init fills the
+ * unused part of the stack with a known pattern, and the peak is the distance from the
+ * top of the stack to the lowest word that no longer holds the pattern. The stack is
+ * the only RAM that grows at run time, since the firmware has no heap.
+ *
+ * The stack is STACK_MONITOR_SIZE bytes, Stack_Size in startup_TM4C123.s for the Keil
+ * build and STACK_SIZE in TM4C123GH6PM.ld for the GCC build. The build reports the
+ * worst case computed from the call graph next to each image (tools/stack_usage.py).
+ *
+ * The BLE command "STACK" sends the peak to the phone and to UART0:
+ *
+ *     STACK peak <bytes> of <size> bytes, <bytes> free
+ *
+ * Stack_Monitor_Check logs a warning the first time less than STACK_MONITOR_MARGIN
+ * bytes have stayed free.
+ */
+
+#include "TM4C123GH6PM.h"
+
+// Size of the stack in bytes, must match the startup file and the linker script
+#define STACK_MONITOR_SIZE      0x200
+
+// Free bytes below which Stack_Monitor_Check logs a warning
+#define STACK_MONITOR_MARGIN    64
+
+// Pattern written to the unused stack
+#define STACK_MONITOR_PATTERN   0xDEADBEEF
+
+/**
+ * @brief Fills the stack below the part in use with the pattern.
+ *
+ * Call it first in main, before any interrupt is enabled.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Stack_Monitor_Init(void);
+
+/**
+ * @brief Returns the peak stack usage since Stack_Monitor_Init.
+ *
+ * @param None
+ *
+ * @return The number of bytes used at the peak.
+ */
+uint32_t Stack_Monitor_Peak(void);
+
+/**
+ * @brief Logs a warning the first time the free stack falls below STACK_MONITOR_MARGIN.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Stack_Monitor_Check(void);
+
+/**
+ * @brief Sends the STACK line to UART0 and to the phone.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Stack_Monitor_Report(void);
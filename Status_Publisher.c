@@ -0,0 +1,275 @@
+/**
+ * @file Status_Publisher.c
+ *
+ * @brief Source code for the Status_Publisher module.
+ *
+ * An update compares the status with the copy of what the phone was last sent, writes
+ * the frames of the fields that differ into Status_Frames and updates the copy.
+ * Status_Publisher_Process then sends those frames one per call.
+ */
+
+#include "Status_Publisher.h"
+#include "UART_BLE.h"
+#include "SysTick_Delay.h"
+#include "Number_Format.h"
+#include "string.h"
+
+#define STATUS_PUBLISHER_INTERVAL_MS    (1000 / STATUS_PUBLISHER_RATE)
+
+// Characters of a title in one frame: "#t=" and the line feed take the rest
+#define STATUS_PUBLISHER_TITLE_CHUNK    (STATUS_PUBLISHER_FRAME_SIZE - 4)
+
+// Frames of the longest title, and of the other fields: "#s=pause v=20 p=1000" is
+// already one character too long, so they take two frames at most
+#define STATUS_PUBLISHER_TITLE_FRAMES   ((STATUS_PUBLISHER_TITLE_SIZE + STATUS_PUBLISHER_TITLE_CHUNK - 2) / STATUS_PUBLISHER_TITLE_CHUNK)
+#define STATUS_PUBLISHER_FRAMES         (STATUS_PUBLISHER_TITLE_FRAMES + 2)
+
+#define STATUS_FIELD_TITLE              0x01
+#define STATUS_FIELD_STATE              0x02
+#define STATUS_FIELD_VOLUME             0x04
+#define STATUS_FIELD_POSITION           0x08
+#define STATUS_FIELD_ALL                0x0F
+
+typedef struct
+{
+	char title[STATUS_PUBLISHER_TITLE_SIZE];
+	Status_Publisher_State state;
+	uint32_t volume;
+
+	// Position at position_time, it advances from there while playing
+	uint32_t position_ms;
+	uint32_t position_time;
+} Status_Publisher_Status;
+
+static const char *const Status_Publisher_State_Names[] = { "stop", "play", "pause" };
+
+// The status, and what the phone was last sent
+static Status_Publisher_Status Status_Current;
+static Status_Publisher_Status Status_Sent;
+
+// Fields sent at the next update even if they did not change
+static uint8_t Status_Forced;
+
+static uint8_t Status_Started;
+static uint32_t Status_Last_Update;
+
+// Frames of the update in progress, and the next one to send
+static char Status_Frames[STATUS_PUBLISHER_FRAMES * STATUS_PUBLISHER_FRAME_SIZE + 1];
+static char *Status_Frame_Next = Status_Frames;
+
+static uint32_t Status_Publisher_Position(const Status_Publisher_Status *status, uint32_t now)
+{
+	if (status->state == STATUS_PUBLISHER_PLAYING)
+	{
+		return status->position_ms + (now - status->position_time);
+	}
+
+	return status->position_ms;
+}
+
+/**
+ * @brief Adds a field to the last frame, or starts a new frame if it does not fit.
+ */
+static char *Status_Publisher_Append_Field(char *frame, char *end, const char *name, const char *value)
+{
+	uint32_t length = strlen(name) + strlen(value);
+
+	// A frame in progress ends with its line feed, the field goes before it
+	if (end > frame && end - frame + 1 + length <= STATUS_PUBLISHER_FRAME_SIZE)
+	{
+		end[-1] = ' ';
+	}
+	else
+	{
+		frame = end;
+		*end++ = '#';
+	}
+
+	strcpy(end, name);
+	strcat(end, value);
+	end += length;
+	*end++ = '\n';
+	*end = 0;
+
+	return end;
+}
+
+/**
+ * @brief Writes the frames of the fields that changed, returns 0 when nothing did.
+ */
+static uint8_t Status_Publisher_Update(uint32_t now)
+{
+	uint8_t fields = Status_Forced;
+	uint32_t position_ms = Status_Publisher_Position(&Status_Current, now);
+	uint32_t phone_position_ms = Status_Publisher_Position(&Status_Sent, now);
+	uint32_t drift_ms = (position_ms > phone_position_ms) ? position_ms - phone_position_ms : phone_position_ms - position_ms;
+	char *end = Status_Frames;
+	char value[FORMAT_DECIMAL_SIZE];
+
+	if (strcmp(Status_Current.title, Status_Sent.title) != 0)
+	{
+		fields |= STATUS_FIELD_TITLE;
+	}
+	if (Status_Current.state != Status_Sent.state)
+	{
+		// The phone stops or starts advancing the position with the state
+		fields |= STATUS_FIELD_STATE | STATUS_FIELD_POSITION;
+	}
+	if (Status_Current.volume != Status_Sent.volume)
+	{
+		fields |= STATUS_FIELD_VOLUME;
+	}
+	if (drift_ms >= 1000 || (Status_Current.state == STATUS_PUBLISHER_PLAYING
+		&& now - Status_Sent.position_time >= STATUS_PUBLISHER_POSITION_SYNC_MS))
+	{
+		fields |= STATUS_FIELD_POSITION;
+	}
+
+	if (fields == 0)
+	{
+		return 0;
+	}
+
+	if (fields & STATUS_FIELD_TITLE)
+	{
+		const char *title = Status_Current.title;
+		const char *prefix = "#t=";
+
+		do
+		{
+			uint32_t length = strlen(title);
+
+			if (length > STATUS_PUBLISHER_TITLE_CHUNK)
+			{
+				length = STATUS_PUBLISHER_TITLE_CHUNK;
+			}
+
+			strcpy(end, prefix);
+			end += 3;
+			memcpy(end, title, length);
+			end += length;
+			*end++ = '\n';
+
+			title += length;
+			prefix = "#t+";
+		} while (*title);
+
+		*end = 0;
+		strcpy(Status_Sent.title, Status_Current.title);
+	}
+
+	char *frame = end;
+
+	if (fields & STATUS_FIELD_STATE)
+	{
+		end = Status_Publisher_Append_Field(frame, end, "s=", Status_Publisher_State_Names[Status_Current.state]);
+		Status_Sent.state = Status_Current.state;
+	}
+
+	if (fields & STATUS_FIELD_VOLUME)
+	{
+		Format_Unsigned_Decimal(value, Status_Current.volume);
+		end = Status_Publisher_Append_Field(frame, end, "v=", value);
+		Status_Sent.volume = Status_Current.volume;
+	}
+
+	if (fields & STATUS_FIELD_POSITION)
+	{
+		// The phone counts from the whole second it is sent
+		Format_Unsigned_Decimal(value, position_ms / 1000);
+		end = Status_Publisher_Append_Field(frame, end, "p=", value);
+		Status_Sent.position_ms = position_ms - position_ms % 1000;
+		Status_Sent.position_time = now;
+	}
+
+	Status_Forced = 0;
+	Status_Frame_Next = Status_Frames;
+
+	return 1;
+}
+
+void Status_Publisher_Init(void)
+{
+	memset(&Status_Current, 0, sizeof(Status_Current));
+	memset(&Status_Sent, 0, sizeof(Status_Sent));
+
+	Status_Forced = STATUS_FIELD_ALL;
+	Status_Started = 0;
+	Status_Frames[0] = 0;
+	Status_Frame_Next = Status_Frames;
+}
+
+void Status_Publisher_Start(void)
+{
+	Status_Started = 1;
+	Status_Last_Update = SysTick_Uptime_ms() - STATUS_PUBLISHER_INTERVAL_MS;
+}
+
+void Status_Publisher_Set_Title(const char *title)
+{
+	strncpy(Status_Current.title, title, STATUS_PUBLISHER_TITLE_SIZE - 1);
+	Status_Current.title[STATUS_PUBLISHER_TITLE_SIZE - 1] = 0;
+}
+
+void Status_Publisher_Set_State(Status_Publisher_State state)
+{
+	uint32_t now = SysTick_Uptime_ms();
+
+	Status_Current.position_ms = (state == STATUS_PUBLISHER_STOPPED) ? 0 : Status_Publisher_Position(&Status_Current, now);
+	Status_Current.position_time = now;
+	Status_Current.state = state;
+}
+
+Status_Publisher_State Status_Publisher_Get_State(void)
+{
+	return Status_Current.state;
+}
+
+void Status_Publisher_Set_Volume(uint32_t volume)
+{
+	Status_Current.volume = volume;
+}
+
+void Status_Publisher_Set_Position(uint32_t seconds)
+{
+	Status_Current.position_ms = seconds * 1000;
+	Status_Current.position_time = SysTick_Uptime_ms();
+}
+
+void Status_Publisher_Refresh(void)
+{
+	Status_Forced = STATUS_FIELD_ALL;
+}
+
+void Status_Publisher_Process(void)
+{
+	if (!Status_Started)
+	{
+		return;
+	}
+
+	// The changes made until the next update are coalesced into it
+	if (*Status_Frame_Next == 0)
+	{
+		uint32_t now = SysTick_Uptime_ms();
+
+		if (now - Status_Last_Update < STATUS_PUBLISHER_INTERVAL_MS || !Status_Publisher_Update(now))
+		{
+			return;
+		}
+		Status_Last_Update = now;
+	}
+
+	if (!UART_BLE_Transmit_Empty())
+	{
+		return;
+	}
+
+	// One frame, up to its line feed
+	char data;
+	do
+	{
+		data = *Status_Frame_Next++;
+		UART_BLE_Output_Character(data);
+	} while (data != '\n');
+}
@@ -0,0 +1,139 @@
+/**
+ * @file Status_Publisher.h
+ *
+ * @brief Header file for the Status_Publisher module.
+ *
+ * This module keeps the phone up to date with what the music box is doing: the song
+ * playing, the playback state, the volume and the position in the song. The main loop
+ * reports changes as they happen, and Status_Publisher_Process sends them to the phone
+ * in status frames:
+ *
+ *     #s=<play|pause|stop> v=<volume> p=<seconds>
+ *     #t=<title>
+ *
+ * Only the fields that changed since the last frame are sent. The changes are
+ * coalesced into at most STATUS_PUBLISHER_RATE updates per second, so a burst of
+ * commands costs one update with the final values.
+ *
+ * A frame is at most STATUS_PUBLISHER_FRAME_SIZE characters with its line feed, the
+ * payload of one notification of the BLE module, so the phone never receives part of a
+ * frame. Short fields share a frame. A title that does not fit is split into "#t="
+ * then "#t+" frames that the phone appends to it.
+ *
+ * The phone advances the position on its own while the state is play. The position is
+ * only sent when it differs by a second or more from what the phone shows, after a
+ * seek or a new song for instance, and every STATUS_PUBLISHER_POSITION_SYNC_MS while
+ * playing to correct the drift.
+ *
+ * A frame is only written to an empty transmit FIFO and one frame at a time, so the
+ * answer to a command waits behind one frame at most. The BLE command "STATUS" sends
+ * every field again, for a phone that has just connected.
+ */
+
+#include "TM4C123GH6PM.h"
+
+// Updates per second at most
+#define STATUS_PUBLISHER_RATE              2
+
+// Characters of a frame with its line feed, the payload of a BLE notification
+#define STATUS_PUBLISHER_FRAME_SIZE        20
+
+// Longest title kept, with its null terminator
+#define STATUS_PUBLISHER_TITLE_SIZE        32
+
+// Period of the position frames while playing, when nothing else changes
+#define STATUS_PUBLISHER_POSITION_SYNC_MS  5000
+
+typedef enum
+{
+	STATUS_PUBLISHER_STOPPED,
+	STATUS_PUBLISHER_PLAYING,
+	STATUS_PUBLISHER_PAUSED
+} Status_Publisher_State;
+
+/**
+ * @brief Clears the status and schedules every field to be sent.
+ *
+ * Nothing is sent before Status_Publisher_Start.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Status_Publisher_Init(void);
+
+/**
+ * @brief Allows the frames to be sent, once the BLE module is in data mode.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Status_Publisher_Start(void);
+
+/**
+ * @brief Sets the title of the song playing, truncated to STATUS_PUBLISHER_TITLE_SIZE - 1
+ * characters.
+ *
+ * @param title The title, empty when it is not known.
+ *
+ * @return None
+ */
+void Status_Publisher_Set_Title(const char *title);
+
+/**
+ * @brief Sets the playback state. The position stops or starts advancing with it.
+ *
+ * @param state The state.
+ *
+ * @return None
+ */
+void Status_Publisher_Set_State(Status_Publisher_State state);
+
+/**
+ * @brief Returns the playback state last set.
+ *
+ * @param None
+ *
+ * @return The state.
+ */
+Status_Publisher_State Status_Publisher_Get_State(void);
+
+/**
+ * @brief Sets the volume.
+ *
+ * @param volume The volume, from 0 to 20.
+ *
+ * @return None
+ */
+void Status_Publisher_Set_Volume(uint32_t volume);
+
+/**
+ * @brief Sets the position in the song, which then advances while the state is playing.
+ *
+ * @param seconds The position in seconds.
+ *
+ * @return None
+ */
+void Status_Publisher_Set_Position(uint32_t seconds);
+
+/**
+ * @brief Schedules every field to be sent again.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Status_Publisher_Refresh(void);
+
+/**
+ * @brief Sends the next status frame if an update is due and the transmit FIFO is empty.
+ *
+ * Call it from the main loop while no AT exchange is running, since the frames would be
+ * read as AT commands in command mode.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Status_Publisher_Process(void);
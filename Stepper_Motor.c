@@ -11,11 +11,63 @@
  *  - ULN2003 Stepper Motor Driver
  *  - 3.3V / 5V Breadboard Power Supply Module (External Power Source)
  *
+ * The main loop does not touch the coils: Start_Stepper_Motor and Stop_Stepper_Motor post
+ * a command to the Timer 0A handler through a single-producer, single-consumer queue.
+ * The handler, which owns the coils, only outputs the half step. It queues what it did
+ * for Stepper_Motor_Deferred, which runs in PendSV (see Deferred_Work.h), records the
+ * latencies and publishes the state of the motor under a sequence lock.
+ *
+ * Timer 0A only runs while the motor does, so it does not wake the core every step
+ * while nothing plays. Start_Stepper_Motor starts it after posting the command, and
+ * the handler stops it once it has applied a stop and no command is left.
+ *
  * @author Aaron Nanas and Evelyn Dominguez
  */
 
 #include "Stepper_Motor.h"
 #include "SysTick_Delay.h"
+#include "Trace.h"
+#include "Latency_Benchmark.h"
+#include "SPSC_Queue.h"
+#include "Seqlock.h"
+#include "Deferred_Work.h"
+#include "GPTM_Timer.h"
+#include "Interrupt_Priorities.h"
+#include "System_Clock.h"
+#include "Profiler.h"
+
+static void Stepper_Motor_Deferred(void);
+static void Stepper_Motor_Timer_Expired(void *context);
+
+// Set by the main loop when it starts Timer 0A, cleared by the handler when it stops it
+static volatile uint8_t Stepper_Motor_Timer_Running = 0;
+
+/**
+ * @brief Returns the prescale value for a 1 MHz timer clock at the current system clock.
+ */
+static uint32_t Stepper_Motor_Prescale(void)
+{
+	return (SystemCoreClock / 1000000) - 1;
+}
+
+static void Stepper_Motor_Clock_Changed(System_Clock_Event event, uint32_t clock_hz)
+{
+	if (event == SYSTEM_CLOCK_CHANGED)
+	{
+		// The handler must not stop the timer between the test and the restart
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		
+		// Restart the period with the new prescale value
+		GPTM_Timer_Set_Prescale(STEPPER_MOTOR_TIMER, GPTM_TIMER_A, Stepper_Motor_Prescale());
+		if (Stepper_Motor_Timer_Running)
+		{
+			GPTM_Timer_Start(STEPPER_MOTOR_TIMER, GPTM_TIMER_A);
+		}
+		
+		__set_PRIMASK(primask);
+	}
+}
  
 void Stepper_Motor_Init()
 {
@@ -35,17 +87,260 @@ void Stepper_Motor_Init()
 	GPIOF -> AFSEL &= ~0x0C;
 	GPIOF->DEN |= 0x0C;
 	GPIOF->DATA |= 0x0C;
+	
+	// Start with the coils off, Timer 0A is not running yet
+	GPIOA->DATA &= ~0x3C;
+	
+	Deferred_Work_Register(DEFERRED_WORK_STEPPER_MOTOR, Stepper_Motor_Deferred);
+	
+	// Output a step every STEPPER_MOTOR_STEP_PERIOD_US with Timer 0A in 16-bit
+	// periodic mode, prescaled to a 1 MHz clock. It is started with the motor.
+	GPTM_Timer_Config timer_config =
+	{
+		GPTM_TIMER_MODE_PERIODIC,
+		GPTM_TIMER_WIDTH_HALF,
+		Stepper_Motor_Prescale(),
+		STEPPER_MOTOR_STEP_PERIOD_US,
+		GPTM_TIMER_EDGE_RISING,
+		Stepper_Motor_Timer_Expired,
+		NULL,
+		INTERRUPT_PRIORITY_TIMER0A
+	};
+	GPTM_Timer_Init(STEPPER_MOTOR_TIMER, GPTM_TIMER_A, &timer_config);
+	
+	// Keep the period when the system clock changes
+	System_Clock_Register_Callback(Stepper_Motor_Clock_Changed);
+}
+
+// A drive mode is posted as STEPPER_MOTOR_COMMAND_DRIVE_MODE + mode
+typedef enum
+{
+	STEPPER_MOTOR_COMMAND_STOP,
+	STEPPER_MOTOR_COMMAND_START,
+	STEPPER_MOTOR_COMMAND_DRIVE_MODE
+} Stepper_Motor_Command;
+
+// Commands from the main loop to Stepper_Motor_Step, at most one per state change
+SPSC_QUEUE_DEFINE(Stepper_Motor_Queue, uint8_t, 8)
+static Stepper_Motor_Queue Stepper_Motor_Commands;
+
+// State last requested by the main loop, only used by the main loop
+static uint8_t Stepper_Motor_Requested = 0;
+static uint32_t Stepper_Motor_Step_Period_us = STEPPER_MOTOR_STEP_PERIOD_US;
+static Stepper_Motor_Drive_Mode Stepper_Motor_Mode = STEPPER_MOTOR_HALF_STEP;
+
+// State published by Stepper_Motor_Deferred for Stepper_Motor_Get_Status
+static Seqlock Stepper_Motor_Status_Lock;
+static Stepper_Motor_Status Stepper_Motor_Published;
+
+static const uint8_t half_step[] = {0x04, 0x0C, 0x08, 0x18, 0x10, 0x30, 0x20, 0x24};
+
+typedef enum
+{
+	STEPPER_MOTOR_EVENT_STEP,
+	STEPPER_MOTOR_EVENT_FIRST_STEP,
+	STEPPER_MOTOR_EVENT_STOP
+} Stepper_Motor_Event_Type;
+
+typedef struct
+{
+	uint32_t cycles;                // DWT cycle count when the coils were written
+	uint8_t type;
+	uint8_t step_index;             // half step output, or the last one before the stop
+} Stepper_Motor_Event;
+
+// What Stepper_Motor_Step did, for the accounting in Stepper_Motor_Deferred.
+// It only fills up if the handlers above PendSV keep it from running for 8 steps (33 ms).
+SPSC_QUEUE_DEFINE(Stepper_Motor_Event_Queue, Stepper_Motor_Event, 8)
+static Stepper_Motor_Event_Queue Stepper_Motor_Events;
+
+static void Stepper_Motor_Defer(Stepper_Motor_Event_Type type, uint8_t step_index)
+{
+	Stepper_Motor_Event event = { DWT->CYCCNT, (uint8_t)type, step_index };
+	
+	Stepper_Motor_Event_Queue_Push(&Stepper_Motor_Events, event);
+	Deferred_Work_Post(DEFERRED_WORK_STEPPER_MOTOR);
 }
 
-//default: motor off
-int motorActive = 0;
+static void Stepper_Motor_Post(uint8_t command)
+{
+	// The handler drains the queue every step, so it is only full for a burst of changes
+	while (!Stepper_Motor_Queue_Push(&Stepper_Motor_Commands, command));
+}
 
 //controls the stop of the motor
 void Stop_Stepper_Motor(void) {
-	GPIOA->DATA &= ~0x3C;
-	motorActive = 0;
+	if (Stepper_Motor_Requested) {
+		TRACE(TRACE_MOTOR_STOP, 0);
+		Stepper_Motor_Requested = 0;
+		Stepper_Motor_Post(STEPPER_MOTOR_COMMAND_STOP);
+	}
 }
 //controls the start of the motor
 void Start_Stepper_Motor(void) {
-	motorActive = 1;
+	if (!Stepper_Motor_Requested) {
+		TRACE(TRACE_MOTOR_START, 0);
+		Stepper_Motor_Requested = 1;
+		Stepper_Motor_Post(STEPPER_MOTOR_COMMAND_START);
+		
+		// Once stopped, the handler does not run again until the timer is started
+		if (!Stepper_Motor_Timer_Running)
+		{
+			Stepper_Motor_Timer_Running = 1;
+			GPTM_Timer_Start(STEPPER_MOTOR_TIMER, GPTM_TIMER_A);
+		}
+	}
+}
+
+uint8_t Stepper_Motor_Set_Step_Period(uint32_t period_us)
+{
+	if (period_us < STEPPER_MOTOR_STEP_PERIOD_MIN_US || period_us > STEPPER_MOTOR_STEP_PERIOD_MAX_US)
+	{
+		return 0;
+	}
+	
+	// The timer reloads the new period at its next time-out
+	Stepper_Motor_Step_Period_us = period_us;
+	GPTM_Timer_Set_Period(STEPPER_MOTOR_TIMER, GPTM_TIMER_A, period_us);
+	
+	return 1;
+}
+
+uint32_t Stepper_Motor_Get_Step_Period(void)
+{
+	return Stepper_Motor_Step_Period_us;
+}
+
+uint8_t Stepper_Motor_Set_Drive_Mode(Stepper_Motor_Drive_Mode mode)
+{
+	if (mode >= STEPPER_MOTOR_DRIVE_MODE_COUNT)
+	{
+		return 0;
+	}
+	
+	if (mode != Stepper_Motor_Mode)
+	{
+		Stepper_Motor_Mode = mode;
+		Stepper_Motor_Post(STEPPER_MOTOR_COMMAND_DRIVE_MODE + mode);
+	}
+	
+	return 1;
+}
+
+Stepper_Motor_Drive_Mode Stepper_Motor_Get_Drive_Mode(void)
+{
+	return Stepper_Motor_Mode;
+}
+
+void Stepper_Motor_Get_Status(Stepper_Motor_Status *status)
+{
+	uint32_t sequence;
+	do
+	{
+		sequence = Seqlock_Read_Begin(&Stepper_Motor_Status_Lock);
+		*status = Stepper_Motor_Published;
+	} while (Seqlock_Read_Retry(&Stepper_Motor_Status_Lock, sequence));
+}
+
+/**
+ * @brief Applies the commands posted by Start_Stepper_Motor and Stop_Stepper_Motor
+ * and outputs the next half step while the motor runs.
+ */
+static void Stepper_Motor_Step(void)
+{
+	// Owned by the handler, so they can stay in registers while it runs
+	static uint8_t motor_active = 0;
+	static uint8_t first_step = 0;
+	static uint8_t step_index = 0;
+	static uint8_t drive_mode = STEPPER_MOTOR_HALF_STEP;
+	
+	uint8_t command;
+	while (Stepper_Motor_Queue_Pop(&Stepper_Motor_Commands, &command))
+	{
+		if (command == STEPPER_MOTOR_COMMAND_START)
+		{
+			first_step = !motor_active;
+			motor_active = 1;
+		}
+		else if (command == STEPPER_MOTOR_COMMAND_STOP)
+		{
+			if (motor_active)
+			{
+				GPIOA->DATA &= ~0x3C;
+				motor_active = 0;
+				Stepper_Motor_Defer(STEPPER_MOTOR_EVENT_STOP, step_index);
+			}
+		}
+		else
+		{
+			drive_mode = command - STEPPER_MOTOR_COMMAND_DRIVE_MODE;
+		}
+	}
+	
+	if (motor_active) {
+		// Full steps are the odd entries of half_step (two coils), wave drive the even ones
+		if (drive_mode == STEPPER_MOTOR_FULL_STEP) {
+			step_index |= 1;
+		}
+		else if (drive_mode == STEPPER_MOTOR_WAVE_DRIVE) {
+			step_index &= ~1;
+		}
+		if (step_index >= 8) {
+			step_index = step_index - 8;
+		}
+		GPIOA->DATA = (GPIOA->DATA & ~0x3C) | half_step[step_index];
+		TRACE(TRACE_STEP, step_index);
+		
+		// The first step after the motor was started completes a command
+		Stepper_Motor_Defer(first_step ? STEPPER_MOTOR_EVENT_FIRST_STEP : STEPPER_MOTOR_EVENT_STEP, step_index);
+		first_step = 0;
+		step_index = step_index + ((drive_mode == STEPPER_MOTOR_HALF_STEP) ? 1 : 2);
+	}
+	
+	// The commands were all applied above, Start_Stepper_Motor starts the timer again
+	else
+	{
+		GPTM_Timer_Stop(STEPPER_MOTOR_TIMER, GPTM_TIMER_A);
+		Stepper_Motor_Timer_Running = 0;
+	}
+}
+
+static void Stepper_Motor_Timer_Expired(void *context)
+{
+	uint32_t profile_start = PROFILER_START();
+	TRACE(TRACE_TIMER0A_BEGIN, 0);
+	
+	Stepper_Motor_Step();
+	
+	TRACE(TRACE_TIMER0A_END, 0);
+	PROFILER_STOP(PROFILER_SCOPE_TIMER0A_HANDLER, profile_start);
+}
+
+static void Stepper_Motor_Deferred(void)
+{
+	// Owned by the deferred work, which is the only writer of the published state
+	static uint32_t steps = 0;
+	
+	Stepper_Motor_Event event;
+	while (Stepper_Motor_Event_Queue_Pop(&Stepper_Motor_Events, &event))
+	{
+		if (event.type == STEPPER_MOTOR_EVENT_STOP)
+		{
+			Latency_Benchmark_Mark_At(LATENCY_STAGE_MOTOR_STOP, event.cycles);
+		}
+		else
+		{
+			if (event.type == STEPPER_MOTOR_EVENT_FIRST_STEP)
+			{
+				Latency_Benchmark_Mark_At(LATENCY_STAGE_FIRST_STEP, event.cycles);
+			}
+			steps = steps + 1;
+		}
+		
+		Seqlock_Write_Begin(&Stepper_Motor_Status_Lock);
+		Stepper_Motor_Published.active = (event.type != STEPPER_MOTOR_EVENT_STOP);
+		Stepper_Motor_Published.step_index = event.step_index;
+		Stepper_Motor_Published.steps = steps;
+		Seqlock_Write_End(&Stepper_Motor_Status_Lock);
+	}
 }
@@ -16,6 +16,37 @@
 
 #include "TM4C123GH6PM.h"
 
+// Timer that outputs the half steps, sub-timer A (see GPTM_Timer.h)
+#define STEPPER_MOTOR_TIMER             GPTM_TIMER_0
+
+// Period of the steps in microseconds at power-up, and its limits. The 28BYJ-48 stalls
+// when it is stepped much faster, and the 16-bit timer at 1 MHz sets the upper limit.
+#define STEPPER_MOTOR_STEP_PERIOD_US        4080
+#define STEPPER_MOTOR_STEP_PERIOD_MIN_US    2000
+#define STEPPER_MOTOR_STEP_PERIOD_MAX_US    65535
+
+/**
+ * @brief Coil sequences. The full step and wave drive sequences take every other entry
+ * of the half step one, so the motor turns twice as fast for the same step period.
+ */
+typedef enum
+{
+	STEPPER_MOTOR_HALF_STEP,        // one and two coils alternately, 8 steps per cycle
+	STEPPER_MOTOR_FULL_STEP,        // two coils at a time, 4 steps per cycle, the most torque
+	STEPPER_MOTOR_WAVE_DRIVE,       // one coil at a time, 4 steps per cycle, the least current
+	STEPPER_MOTOR_DRIVE_MODE_COUNT
+} Stepper_Motor_Drive_Mode;
+
+/**
+ * @brief State of the motor as last published by the deferred work of the step timer
+ */
+typedef struct
+{
+	uint8_t active;                 // 1 while the motor steps
+	uint8_t step_index;             // index of the last half step output
+	uint32_t steps;                 // half steps output since power-up
+} Stepper_Motor_Status;
+
 
 /**
  * @brief Initializes stepper motor
@@ -29,6 +60,8 @@ void Stepper_Motor_Init();
 /**
  * @brief Controls the stop of the motor
  *
+ * The coils are released at the next interrupt of the step timer.
+ *
  * @param void
  *
  * @return None
@@ -37,8 +70,59 @@ void Stop_Stepper_Motor(void);
 /**
  * @brief Controls the start of the motor
  *
+ * The first step is output at the next interrupt of the step timer.
+ *
  * @param void
  *
  * @return None
  */
-void Start_Stepper_Motor(void);
\ No newline at end of file
+void Start_Stepper_Motor(void);
+
+/**
+ * @brief Copies the state of the motor without a torn read.
+ *
+ * The state is published in PendSV after every step, so it lags a
+ * Start_Stepper_Motor or Stop_Stepper_Motor by up to one step.
+ *
+ * @param status Pointer to the structure that receives the state.
+ *
+ * @return None
+ */
+void Stepper_Motor_Get_Status(Stepper_Motor_Status *status);
+
+/**
+ * @brief Changes the period of the steps, from the next step.
+ *
+ * @param period_us The period in microseconds, from STEPPER_MOTOR_STEP_PERIOD_MIN_US
+ * to STEPPER_MOTOR_STEP_PERIOD_MAX_US.
+ *
+ * @return Returns 1 if the period was changed, 0 if it is out of range.
+ */
+uint8_t Stepper_Motor_Set_Step_Period(uint32_t period_us);
+
+/**
+ * @brief Returns the period of the steps in microseconds.
+ *
+ * @param None
+ *
+ * @return The period last set.
+ */
+uint32_t Stepper_Motor_Get_Step_Period(void);
+
+/**
+ * @brief Changes the coil sequence, from the next step.
+ *
+ * @param mode The sequence.
+ *
+ * @return Returns 1 if the sequence was changed, 0 if it is not a drive mode.
+ */
+uint8_t Stepper_Motor_Set_Drive_Mode(Stepper_Motor_Drive_Mode mode);
+
+/**
+ * @brief Returns the coil sequence.
+ *
+ * @param None
+ *
+ * @return The drive mode last set.
+ */
+Stepper_Motor_Drive_Mode Stepper_Motor_Get_Drive_Mode(void);
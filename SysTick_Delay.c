@@ -3,9 +3,10 @@
  *
  * @brief Source code for the SysTick_Delay driver.
  *
- * It provides two blocking functions, SysTick_Delay1ms and SysTick_Delay1us,
- * to create a delay with a busy-wait loop. It uses the SysTick timer with 
- * a specified reload value to generate interrupts every 1 us.
+ * It provides two blocking functions, SysTick_Delay1ms and SysTick_Delay1us.
+ * It uses the SysTick timer with a specified reload value to generate interrupts
+ * every 1 ms: SysTick_Delay1ms sleeps between them, and SysTick_Delay1us
+ * busy-waits on the count of the timer.
  * 
  * In addition, it uses the Peripheral Internal Oscillator (PIOSC) 
  * as the clock source. The PIOSC provides 16 MHz which is then divided by 4. 
@@ -15,25 +16,26 @@
  */
 
 #include "SysTick_Delay.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "Power_Idle.h"
+#include "Interrupt_Priorities.h"
 
-// Global variable used to keep track of elapsed time in microseconds
-static uint32_t us_elapsed = 0;
-
-// Global variable used to keep track of elapsed time in milliseconds
-static uint32_t ms_elapsed = 0;
-
-// Global flag used to indicate if milliseconds delay is active
-static uint8_t ms_active = 0;
+// Time since SysTick_Delay_Init in milliseconds, only written by SysTick_Handler.
+// The delays measure from it instead of clearing a counter that the handler increments.
+static volatile uint32_t uptime_ms = 0;
 
 void SysTick_Delay_Init(void)
 {	
-	// Set the SysTick timer reload value for 1 us intervals
+	// Set the SysTick timer reload value for 1 ms intervals
 	// Each clock cycle is (1 / 4 MHz) = 0.25 us
-	SysTick->LOAD = (4 - 1);
+	SysTick->LOAD = (SYSTICK_TICKS_PER_MS - 1);
 	
 	// Clear the VAL register by writing any value to it
 	SysTick->VAL = 0;
 	
+	NVIC_SetPriority(SysTick_IRQn, INTERRUPT_PRIORITY_SYSTICK);
+	
 	// Enable the SysTick timer and its interrupt
 	// with the Peripheral Internal Oscillator (PIOSC) as the clock source
 	SysTick->CTRL |= 0x03;
@@ -41,41 +43,73 @@ void SysTick_Delay_Init(void)
 
 void SysTick_Delay1us(uint32_t delay_in_us)
 {
-	// Reset the global variable, us_elapsed
-	us_elapsed = 0;
+	uint32_t ticks_left = delay_in_us * SYSTICK_TICKS_PER_US;
+	uint32_t previous = SysTick->VAL;
 	
-	// Wait until ms_value reaches the specified delay_in_ms
-	while (delay_in_us > us_elapsed);
+	// Count the ticks of the down counter, which restarts from LOAD every millisecond
+	while (ticks_left > 0)
+	{
+		uint32_t current = SysTick->VAL;
+		uint32_t elapsed = (previous >= current) ? (previous - current) : (previous + SYSTICK_TICKS_PER_MS - current);
+		
+		ticks_left = (elapsed >= ticks_left) ? 0 : (ticks_left - elapsed);
+		previous = current;
+	}
 }
 
 void SysTick_Delay1ms(uint32_t delay_in_ms)
 {
-	// Reset the global variables, us_elapsed and ms_elapsed
-	us_elapsed = 0;
-	ms_elapsed = 0;
+	TRACE(TRACE_DELAY_BEGIN, delay_in_ms);
 	
-	// Set the ms_active global flag
-	ms_active = 0x01;
+	uint32_t start = uptime_ms;
 	
-	// Wait until ms_elapsed reaches the specified delay_in_ms
-	while (delay_in_ms > ms_elapsed);
+	// Sleep until delay_in_ms have passed since start, the SysTick interrupt wakes the core.
+	// The difference is right when uptime_ms wraps around.
+	__disable_irq();
+	while ((uptime_ms - start) < delay_in_ms)
+	{
+		Power_Idle_Sleep();
+	}
+	__enable_irq();
 	
-	// Reset the ms_active global flag
-	ms_active = 0x00;
+	TRACE(TRACE_DELAY_END, delay_in_ms);
 }
 
-void SysTick_Handler(void)
+uint32_t SysTick_Uptime_ms(void)
+{
+	return uptime_ms;
+}
+
+uint32_t SysTick_Uptime_us(void)
 {
-	// Increment the global variable, us_elapsed
-	us_elapsed = us_elapsed + 1;
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
 	
-	// Check if us_elapsed has reached 1000 (1 millisecond) and if milliseconds delay is active
-	if (us_elapsed == 1000 && (ms_active == 0x01))
+	uint32_t ms = uptime_ms;
+	uint32_t ticks = SysTick->VAL;
+	
+	// The counter has restarted but the handler has not counted that millisecond yet
+	if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
 	{
-		// Reset us_elapsed
-		us_elapsed = 0;
-		
-		// Increment ms_elapsed to indicate that 1 millisecond has passed
-		ms_elapsed = ms_elapsed + 1;
+		ms = ms + 1;
+		ticks = SysTick->VAL;
 	}
-}
\ No newline at end of file
+	
+	__set_PRIMASK(primask);
+	
+	return (ms * 1000) + ((SYSTICK_TICKS_PER_MS - 1 - ticks) / SYSTICK_TICKS_PER_US);
+}
+
+void SysTick_Handler(void)
+{
+#if PROFILER_SYSTICK
+	uint32_t profile_start = PROFILER_START();
+#endif
+	
+	// Increment the global variable, uptime_ms, to indicate that 1 millisecond has passed
+	uptime_ms = uptime_ms + 1;
+	
+#if PROFILER_SYSTICK
+	PROFILER_STOP(PROFILER_SCOPE_SYSTICK_HANDLER, profile_start);
+#endif
+}
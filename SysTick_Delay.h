@@ -3,9 +3,10 @@
  *
  * @brief Header file for the SysTick_Delay driver.
  *
- * It provides two blocking functions, SysTick_Delay1ms and SysTick_Delay1us,
- * to create a delay with a busy-wait loop. It uses the SysTick timer with 
- * a specified reload value to generate interrupts every 1 us.
+ * It provides two blocking functions, SysTick_Delay1ms and SysTick_Delay1us.
+ * It uses the SysTick timer with a specified reload value to generate interrupts
+ * every 1 ms: SysTick_Delay1ms sleeps between them, and SysTick_Delay1us
+ * busy-waits on the count of the timer.
  * 
  * In addition, it uses the Peripheral Internal Oscillator (PIOSC) 
  * as the clock source. The PIOSC provides 16 MHz which is then divided by 4. 
@@ -16,11 +17,15 @@
  
 #include "TM4C123GH6PM.h"
 
+// SysTick counts PIOSC / 4 = 4 MHz
+#define SYSTICK_TICKS_PER_US    4
+#define SYSTICK_TICKS_PER_MS    4000
+
 /**
  * @brief The SysTick_Delay_Init function initializes the SysTick timer to be used for a blocking delay function.
  *
  * This function configures the SysTick timer and its interrupt with a specified reload value to 
- * generate interrupts every 1 us. It uses the Peripheral Internal Oscillator (PIOSC) as the clock source.
+ * generate interrupts every 1 ms. It uses the Peripheral Internal Oscillator (PIOSC) as the clock source.
  * The PIOSC provides 16 MHz which is then divided by 4. The timer is used for creating delays in either 
  * microseconds or milliseconds.
  *
@@ -33,8 +38,9 @@ void SysTick_Delay_Init(void);
 /**
  * @brief The SysTick_Delay1us function provides a blocking delay in microseconds using the SysTick timer.
  *
- * This function resets the global variable, us_elapsed, to zero and waits until us_elapsed reaches 
- * the specified delay_in_us.
+ * This function busy-waits while counting the ticks of the SysTick timer until
+ * the specified delay_in_us has passed. Interrupts are not disabled, so the delay
+ * can be longer than requested.
  *
  * @param delay_in_us The delay time in microseconds.
  *
@@ -45,9 +51,8 @@ void SysTick_Delay1us(uint32_t delay_in_us);
 /**
  * @brief The SysTick_Delay1ms function provides a blocking delay in milliseconds using the SysTick timer.
  *
- * This function clears the global variables, us_elapsed and ms_elapsed, to zero and sets ms_active flag to 0x01 
- * indicating that milliseconds delay is active. It then waits until ms_elapsed reaches the specified delay_in_ms.
- * After the delay, it clears ms_active flag back to 0x00.
+ * This function notes the uptime and sleeps with Power_Idle_Sleep until delay_in_ms
+ * milliseconds have passed since then. The other interrupts are served during the delay.
  *
  * @param delay_in_ms The delay time in milliseconds.
  *
@@ -55,12 +60,36 @@ void SysTick_Delay1us(uint32_t delay_in_us);
  */
 void SysTick_Delay1ms(uint32_t delay_in_ms);
 
+/**
+ * @brief The SysTick_Uptime_ms function returns the time elapsed since SysTick_Delay_Init.
+ *
+ * It lets the main loop wait for a time-out without blocking: store the uptime when the wait
+ * starts and compare the difference with the time-out, which also works when the count wraps
+ * after about 49 days.
+ *
+ * @param None
+ *
+ * @return The uptime in milliseconds.
+ */
+uint32_t SysTick_Uptime_ms(void);
+
+/**
+ * @brief The SysTick_Uptime_us function returns the time elapsed since SysTick_Delay_Init in microseconds.
+ *
+ * It can be called with interrupts disabled. The count wraps after about 71 minutes,
+ * so only the difference between two values is meaningful.
+ *
+ * @param None
+ *
+ * @return The uptime in microseconds.
+ */
+uint32_t SysTick_Uptime_us(void);
+
 /**
  * @brief The SysTick_Handler function is the interrupt service routine for the SysTick timer.
  *
  * This function is called whenever the SysTick timer generates an interrupt. It increments the global variable
- * us_elapsed by 1, indicating that 1 microsecond has passed. Additionally, if us_elapsed reaches 1000 and ms_active
- * flag is set to 0x01, it resets us_elapsed and increments ms_elapsed by 1, indicating that 1 millisecond has passed.
+ * uptime_ms by 1, indicating that 1 millisecond has passed.
  *
  * @param None
  *
@@ -0,0 +1,126 @@
+/**
+ * @file System_Clock.c
+ *
+ * @brief Source code for the System_Clock module.
+ *
+ * The clock is switched with RCC2, following the PLL initialization sequence of the
+ * TM4C123GH6PM datasheet: bypass the PLL, change the oscillator source and the divider,
+ * wait for the PLL to lock, then remove the bypass.
+ */
+
+#include "System_Clock.h"
+
+#define RCC_USESYSDIV        0x00400000
+
+#define RCC2_USERCC2         0x80000000
+#define RCC2_DIV400          0x40000000
+#define RCC2_SYSDIV2_MASK    0x1FC00000
+#define RCC2_PWRDN2          0x00002000
+#define RCC2_BYPASS2         0x00000800
+#define RCC2_OSCSRC2_MASK    0x00000070
+
+#define SYSCTL_PLL_LOCK      0x40
+
+extern uint32_t SystemCoreClock;
+
+static System_Clock_Callback System_Clock_Callbacks[SYSTEM_CLOCK_CALLBACKS];
+static uint32_t System_Clock_Callback_Count;
+
+uint8_t System_Clock_Register_Callback(System_Clock_Callback callback)
+{
+	if (System_Clock_Callback_Count >= SYSTEM_CLOCK_CALLBACKS)
+	{
+		return 0;
+	}
+
+	System_Clock_Callbacks[System_Clock_Callback_Count++] = callback;
+	return 1;
+}
+
+static void System_Clock_Notify(System_Clock_Event event)
+{
+	for (uint32_t i = 0; i < System_Clock_Callback_Count; i++)
+	{
+		System_Clock_Callbacks[i](event, SystemCoreClock);
+	}
+}
+
+/**
+ * @brief Programs RCC and RCC2 for one of the supported frequencies.
+ */
+static void System_Clock_Configure(uint32_t clock_hz)
+{
+	// Use RCC2 for the 7-bit divider, and run from the oscillator while the PLL changes
+	SYSCTL->RCC2 |= RCC2_USERCC2;
+	SYSCTL->RCC2 |= RCC2_BYPASS2;
+
+	// Select the main oscillator (the 16 MHz crystal set in the XTAL field of RCC)
+	SYSCTL->RCC2 &= ~RCC2_OSCSRC2_MASK;
+
+	if (clock_hz == 16000000)
+	{
+		// Use the oscillator directly and power down the PLL
+		SYSCTL->RCC &= ~RCC_USESYSDIV;
+		SYSCTL->RCC2 |= RCC2_PWRDN2;
+		return;
+	}
+
+	uint32_t rcc2 = SYSCTL->RCC2 & ~(RCC2_DIV400 | RCC2_SYSDIV2_MASK | RCC2_PWRDN2);
+
+	if (clock_hz == 80000000)
+	{
+		// 400 MHz / (SYSDIV2:SYSDIV2LSB + 1) = 400 MHz / 5
+		rcc2 |= RCC2_DIV400 | (4 << 22);
+	}
+	else
+	{
+		// 400 MHz / 2 / (SYSDIV2 + 1) = 200 MHz / 4
+		rcc2 |= (3 << 23);
+	}
+
+	// Clear the PLL lock flag, then power up the PLL with the new divider
+	SYSCTL->MISC = SYSCTL_PLL_LOCK;
+	SYSCTL->RCC2 = rcc2;
+	SYSCTL->RCC |= RCC_USESYSDIV;
+
+	while ((SYSCTL->RIS & SYSCTL_PLL_LOCK) == 0);
+
+	SYSCTL->RCC2 &= ~RCC2_BYPASS2;
+}
+
+uint8_t System_Clock_Set_Frequency(uint32_t clock_hz)
+{
+	if (clock_hz != 80000000 && clock_hz != 50000000 && clock_hz != 16000000)
+	{
+		return 0;
+	}
+
+	if (clock_hz == SystemCoreClock)
+	{
+		return 1;
+	}
+
+	System_Clock_Notify(SYSTEM_CLOCK_CHANGING);
+
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	System_Clock_Configure(clock_hz);
+	SystemCoreClock = clock_hz;
+	System_Clock_Notify(SYSTEM_CLOCK_CHANGED);
+
+	__set_PRIMASK(primask);
+
+	return 1;
+}
+
+uint32_t System_Clock_Get_Frequency(void)
+{
+	return SystemCoreClock;
+}
+
+uint32_t System_Clock_UART_Divisor(uint32_t baud_rate)
+{
+	// 64 * clock / (16 * baud) = 4 * clock / baud, computed with one more bit for the rounding
+	return ((SystemCoreClock * 8 / baud_rate) + 1) / 2;
+}
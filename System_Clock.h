@@ -0,0 +1,75 @@
+/**
+ * @file System_Clock.h
+ *
+ * @brief Header file for the System_Clock module.
+ *
+ * This module changes the system clock at run time and keeps the peripherals that
+ * depend on it in step. SystemInit (RTE/Device/TM4C123GH6PM/system_TM4C123.c) starts the
+ * core at 50 MHz: the 400 MHz PLL output divided by 2, then by SYSDIV = 4. The supported
+ * frequencies are:
+ *  - 80 MHz: 400 MHz PLL output divided by 5 (DIV400 in RCC2)
+ *  - 50 MHz: the frequency set by SystemInit
+ *  - 16 MHz: the main oscillator with the PLL bypassed and powered down, to save power
+ *
+ * Drivers whose registers depend on the clock (UART baud rate divisors, timer prescale and
+ * load values) register a callback, which is called twice for each change:
+ *  - SYSTEM_CLOCK_CHANGING, at the old frequency: finish the transfer in progress
+ *  - SYSTEM_CLOCK_CHANGED, at the new frequency, with interrupts disabled: reprogram the divisors
+ *
+ * SystemCoreClock always holds the current frequency. SysTick runs from PIOSC / 4 and
+ * does not depend on the system clock.
+ */
+
+#include "TM4C123GH6PM.h"
+
+// Callbacks that can be registered
+#define SYSTEM_CLOCK_CALLBACKS    8
+
+typedef enum
+{
+	SYSTEM_CLOCK_CHANGING,
+	SYSTEM_CLOCK_CHANGED
+} System_Clock_Event;
+
+typedef void (*System_Clock_Callback)(System_Clock_Event event, uint32_t clock_hz);
+
+/**
+ * @brief Registers a callback for the clock changes.
+ *
+ * @param callback Called before and after every change of the system clock.
+ *
+ * @return 1 if the callback was registered, 0 if the table is full.
+ */
+uint8_t System_Clock_Register_Callback(System_Clock_Callback callback);
+
+/**
+ * @brief Switches the system clock to one of the supported frequencies.
+ *
+ * Must be called from the main loop, since the callbacks wait for the transfers in progress.
+ *
+ * @param clock_hz 80000000, 50000000 or 16000000.
+ *
+ * @return 1 if the clock was switched, 0 if the frequency is not supported.
+ */
+uint8_t System_Clock_Set_Frequency(uint32_t clock_hz);
+
+/**
+ * @brief Returns the current frequency of the system clock.
+ *
+ * @param None
+ *
+ * @return The frequency in Hz.
+ */
+uint32_t System_Clock_Get_Frequency(void);
+
+/**
+ * @brief Computes the UART baud rate divisor for the current system clock.
+ *
+ * The divisor is 64 * (System Clock Frequency) / (16 * Baud Rate), rounded to the nearest
+ * integer: bits 21 to 6 go to IBRD and bits 5 to 0 to FBRD.
+ *
+ * @param baud_rate The baud rate.
+ *
+ * @return The divisor in 1/64 units.
+ */
+uint32_t System_Clock_UART_Divisor(uint32_t baud_rate);
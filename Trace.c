@@ -0,0 +1,99 @@
+/**
+ * @file Trace.c
+ *
+ * @brief Source code for the Trace module.
+ *
+ * Trace_Head counts the records written since the last reset. A writer claims the
+ * slot Trace_Head % TRACE_RECORDS and fills it in, so an interrupt handler that
+ * preempts a writer gets the next slot. Records are therefore in claim order, and
+ * their timestamps can be a few cycles out of order.
+ *
+ * The dump runs in the main loop with tracing paused. Every writer that could still
+ * be filling a slot is an interrupt handler that preempted the main loop, and it has
+ * finished before the dump starts.
+ */
+
+#include "Trace.h"
+#include "UART0.h"
+#include "Atomic.h"
+
+extern uint32_t SystemCoreClock;
+
+static Trace_Record Trace_Buffer[TRACE_RECORDS];
+
+// Number of records written since the last reset
+static volatile uint32_t Trace_Head;
+
+// Tracing is paused while the buffer is printed
+static volatile uint8_t Trace_Enabled;
+
+void Trace_Init(void)
+{
+	// Enable the DWT unit by setting the TRCENA bit (Bit 24) in the DEMCR register
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+
+	// Start the cycle counter by setting the CYCCNTENA bit (Bit 0), it may already be running
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	Trace_Reset();
+}
+
+void Trace_Reset(void)
+{
+	Trace_Enabled = 0;
+	Trace_Head = 0;
+	Trace_Enabled = 1;
+}
+
+void Trace_Event(Trace_Event_ID event, uint16_t argument)
+{
+	if (!Trace_Enabled)
+	{
+		return;
+	}
+
+	// Claim a slot, an LDREX / STREX loop that retries when an interrupt intervened
+	uint32_t index = Atomic_Fetch_Add(&Trace_Head, 1);
+	Trace_Record *record = &Trace_Buffer[index & (TRACE_RECORDS - 1)];
+
+	record->timestamp = DWT->CYCCNT;
+	record->event = event;
+	record->context = __get_IPSR();
+	record->argument = argument;
+}
+
+void Trace_Dump(void)
+{
+	Trace_Enabled = 0;
+
+	uint32_t head = Trace_Head;
+	uint32_t count = (head < TRACE_RECORDS) ? head : TRACE_RECORDS;
+
+	UART0_Output_String("TRACE BEGIN ");
+	UART0_Output_Unsigned_Decimal(SystemCoreClock);
+	UART0_Output_Character(' ');
+	UART0_Output_Unsigned_Decimal(count);
+	UART0_Output_Character(' ');
+	UART0_Output_Unsigned_Decimal(head);
+	UART0_Output_Newline();
+
+	for (uint32_t index = head - count; index != head; index++)
+	{
+		Trace_Record *record = &Trace_Buffer[index & (TRACE_RECORDS - 1)];
+
+		UART0_Output_String("T ");
+		UART0_Output_Unsigned_Hexadecimal(record->timestamp);
+		UART0_Output_Character(' ');
+		UART0_Output_Unsigned_Decimal(record->event);
+		UART0_Output_Character(' ');
+		UART0_Output_Unsigned_Decimal(record->context);
+		UART0_Output_Character(' ');
+		UART0_Output_Unsigned_Decimal(record->argument);
+		UART0_Output_Newline();
+	}
+
+	UART0_Output_String("TRACE END");
+	UART0_Output_Newline();
+
+	Trace_Enabled = 1;
+}
@@ -0,0 +1,126 @@
+/**
+ * @file Trace.h
+ *
+ * @brief Header file for the Trace module.
+ *
+ * This module keeps the last TRACE_RECORDS events of the firmware in a RAM ring buffer,
+ * so timing problems can be looked at without adding UART0 prints that change the timing.
+ * An event is recorded with the TRACE macro from the main loop or from any interrupt handler:
+ *
+ *     TRACE(TRACE_STEP, step_index);
+ *
+ * Each record takes 8 bytes: the DWT cycle counter (CYCCNT), the event, the active
+ * exception number (0 in the main loop) and a 16-bit argument. A slot is claimed with
+ * an atomic increment of the write index (LDREX / STREX on the Cortex-M4), so writers
+ * never disable interrupts and never wait for each other. When the buffer is full the
+ * oldest records are overwritten.
+ *
+ * The BLE command "TRACE" prints the buffer over UART0:
+ *
+ *     TRACE BEGIN <core clock in Hz> <records printed> <records written since reset>
+ *     T <timestamp in hex> <event> <exception number> <argument>
+ *     ...
+ *     TRACE END
+ *
+ * tools/trace_decode.py turns a capture of this dump into a Chrome trace (chrome://tracing
+ * or ui.perfetto.dev). It reads the event names from the enum below, so events ending in
+ * _BEGIN and _END become durations and the others instant events.
+ *
+ * @note Set TRACE_ENABLE to 0 on the compiler command line to remove the trace calls.
+ */
+
+#include "TM4C123GH6PM.h"
+
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE            1
+#endif
+
+// Number of records in the ring buffer, must be a power of two
+#ifndef TRACE_RECORDS
+#define TRACE_RECORDS           1024
+#endif
+
+#if (TRACE_RECORDS & (TRACE_RECORDS - 1)) != 0
+#error "TRACE_RECORDS must be a power of two"
+#endif
+
+typedef enum
+{
+	TRACE_TIMER0A_BEGIN,
+	TRACE_TIMER0A_END,
+	TRACE_STEP,                     // argument: index of the half step that was output
+	TRACE_MOTOR_START,
+	TRACE_MOTOR_STOP,
+	TRACE_DELAY_BEGIN,              // argument: delay in ms
+	TRACE_DELAY_END,
+	TRACE_UART_BLE_INPUT_BEGIN,
+	TRACE_UART_BLE_INPUT_END,       // argument: number of characters read
+	TRACE_COMMAND_BEGIN,
+	TRACE_COMMAND_END,
+	TRACE_UART0_OUTPUT_BEGIN,
+	TRACE_UART0_OUTPUT_END,
+	TRACE_UART3_OUTPUT_BEGIN,
+	TRACE_UART3_OUTPUT_END,
+	TRACE_UART_BLE_OUTPUT_BEGIN,
+	TRACE_UART_BLE_OUTPUT_END,
+	TRACE_UART3_INPUT_LINE,         // argument: number of characters read
+	TRACE_EVENT_COUNT
+} Trace_Event_ID;
+
+typedef struct
+{
+	uint32_t timestamp;
+	uint8_t event;
+	uint8_t context;
+	uint16_t argument;
+} Trace_Record;
+
+#if TRACE_ENABLE
+#define TRACE(event, argument)  Trace_Event((event), (uint16_t)(argument))
+#else
+#define TRACE(event, argument)  ((void)0)
+#endif
+
+/**
+ * @brief Starts the DWT cycle counter and clears the trace buffer.
+ *
+ * The cycle counter is started if it is not running yet, but it is not cleared.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Trace_Init(void);
+
+/**
+ * @brief Clears the trace buffer and enables tracing.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Trace_Reset(void);
+
+/**
+ * @brief Records an event in the trace buffer.
+ *
+ * Use the TRACE macro instead of calling this function directly.
+ *
+ * @param event The event to record.
+ *
+ * @param argument A value stored with the event.
+ *
+ * @return None
+ */
+void Trace_Event(Trace_Event_ID event, uint16_t argument);
+
+/**
+ * @brief Prints the trace buffer over UART0, oldest record first.
+ *
+ * Tracing is paused while the buffer is printed and resumes afterwards.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void Trace_Dump(void);
@@ -10,12 +10,47 @@
  * of the TM4C123GH6PM Microcontroller Datasheet.
  * Link: https://www.ti.com/lit/gpn/TM4C123GH6PM
  *
- * @note Assumes that the system clock (50 MHz) is used.
+ * @note The baud rate divisors follow the system clock (see System_Clock.h).
  *
  * @author Aaron Nanas
  */
 
 #include "UART0.h"
+#include "Number_Format.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "UART_Stats.h"
+#include "System_Clock.h"
+#include "Log.h"
+
+/**
+ * @brief Programs the baud rate divisors for the current system clock.
+ */
+static void UART0_Set_Baud_Rate(void)
+{
+	uint32_t divisor = System_Clock_UART_Divisor(UART0_BAUD_RATE);
+	
+	UART0->IBRD = divisor >> 6;
+	UART0->FBRD = divisor & 0x3F;
+}
+
+static void UART0_Clock_Changed(System_Clock_Event event, uint32_t clock_hz)
+{
+	if (event == SYSTEM_CLOCK_CHANGING)
+	{
+		// Send the queued log frames and let the last character leave at the old baud rate
+		Log_Flush();
+		while((UART0->FR & UART0_BUSY_BIT_MASK) != 0);
+	}
+	else
+	{
+		// The new divisors take effect when LCRH is written
+		UART0->CTL &= ~0x01;
+		UART0_Set_Baud_Rate();
+		UART0->LCRH = UART0->LCRH;
+		UART0->CTL |= 0x01;
+	}
+}
 
 void UART0_Init(void)
 {
@@ -33,13 +68,9 @@ void UART0_Init(void)
 	
 	// Set the baud rate by writing to the DIVINT field (Bits 15 to 0)
 	// and the DIVFRAC field (Bits 5 to 0) in the IBRD and FBRD registers, respectively.
-	// The integer part of the calculated constant will be written to the IBRD register,
-	// while the fractional part will be written to the FBRD register.
-	// N = (System Clock Frequency) / (16 * Baud Rate)
-	// N = (50,000,000) / (16 * 115200) = 27.12673611 (N = 27)
-	// F = ((0.12673611 * 64) + 0.5) = 8.611 (F = 8)
-	UART0->IBRD = 27;
-	UART0->FBRD = 8;
+	// N = (System Clock Frequency) / (16 * Baud Rate), for example
+	// N = (50,000,000) / (16 * 115200) = 27.12673611 (IBRD = 27, FBRD = 8)
+	UART0_Set_Baud_Rate();
 	
 	// Configure the data word length of the UART packet to be 8 bits by 
 	// writing a value of 0x3 to the WLEN field (Bits 6 to 5) in the LCRH register
@@ -79,19 +110,32 @@ void UART0_Init(void)
 	// Enable the digital functionality for the PA1 and PA0 pins
 	// by setting Bits 1 to 0 in the DEN register
 	GPIOA->DEN |= 0x03;
+	
+	// Reprogram the baud rate divisors whenever the system clock changes
+	System_Clock_Register_Callback(UART0_Clock_Changed);
 }
 
 char UART0_Input_Character(void)
 {
+	uint8_t was_waiting = ((UART0->FR & UART0_RECEIVE_FIFO_EMPTY_BIT_MASK) == 0);
+	
 	while((UART0->FR & UART0_RECEIVE_FIFO_EMPTY_BIT_MASK) != 0);
 	
-	return (char)(UART0->DR & 0xFF);
+	// Read the character once, together with its error bits
+	uint32_t data = UART0->DR;
+	UART_Stats_Record_Receive(UART_STATS_UART0, data, was_waiting);
+	
+	return (char)(data & 0xFF);
 }
 
 void UART0_Output_Character(char data)
 {
+	// Let the queued log frames go first so the character does not land inside one
+	Log_Flush();
+	
 	while((UART0->FR & UART0_TRANSMIT_FIFO_FULL_BIT_MASK) != 0);
 	UART0->DR = data;
+	UART_Stats_Record_Transmit(UART_STATS_UART0, 1);
 }
 
 void UART0_Input_String(char *buffer_pointer, uint16_t buffer_size) 
@@ -124,11 +168,17 @@ void UART0_Input_String(char *buffer_pointer, uint16_t buffer_size)
 
 void UART0_Output_String(char *pt)
 {
+	uint32_t profile_start = PROFILER_START();
+	TRACE(TRACE_UART0_OUTPUT_BEGIN, 0);
+	
 	while(*pt)
 	{
 		UART0_Output_Character(*pt);
 		pt++;
 	}
+	
+	TRACE(TRACE_UART0_OUTPUT_END, 0);
+	PROFILER_STOP(PROFILER_SCOPE_UART0_OUTPUT_STRING, profile_start);
 }
 
 uint32_t UART0_Input_Unsigned_Decimal(void)
@@ -165,18 +215,21 @@ uint32_t UART0_Input_Unsigned_Decimal(void)
 	return number;
 }
 
-void UART0_Output_Unsigned_Decimal(int n)
+void UART0_Output_Unsigned_Decimal(uint32_t n)
 {
-	// Use recursion to convert decimal number
-	// of unspecified length as an ASCII string
-  if (n >= 10)
-	{
-    UART0_Output_Unsigned_Decimal(n / 10);
-    n = n % 10;
-  }
+	// Convert the number into a buffer and send it with a single string write
+	char buffer[FORMAT_DECIMAL_SIZE];
 	
-	// n is between 0 and 9
-  UART0_Output_Character(n + '0');
+	Format_Unsigned_Decimal(buffer, n);
+	UART0_Output_String(buffer);
+}
+
+void UART0_Output_Signed_Decimal(int32_t n)
+{
+	char buffer[FORMAT_DECIMAL_SIZE];
+	
+	Format_Signed_Decimal(buffer, n);
+	UART0_Output_String(buffer);
 }
 
 uint32_t UART0_Input_Unsigned_Hexadecimal(void)
@@ -227,24 +280,10 @@ uint32_t UART0_Input_Unsigned_Hexadecimal(void)
 
 void UART0_Output_Unsigned_Hexadecimal(uint32_t number)
 {
-	// Use recursion to convert the number of
-	// unspecified length as an ASCII string
-	if (number >= 0x10)
-	{
-		UART0_Output_Unsigned_Hexadecimal(number / 0x10);
-		UART0_Output_Unsigned_Hexadecimal(number % 0x10);
-	}
-	else
-	{
-		if (number < 0xA)
-		{
-			UART0_Output_Character(number + '0');
-		}
-		else
-		{
-			UART0_Output_Character((number - 0x0A) + 'A');
-		}
-	}
+	char buffer[FORMAT_HEXADECIMAL_SIZE];
+	
+	Format_Hexadecimal(buffer, number, 1);
+	UART0_Output_String(buffer);
 }
 
 void UART0_Output_Newline(void)
@@ -10,7 +10,7 @@
  * of the TM4C123GH6PM Microcontroller Datasheet.
  * Link: https://www.ti.com/lit/gpn/TM4C123GH6PM
  *
- * @note Assumes that the system clock (50 MHz) is used.
+ * @note The baud rate divisors follow the system clock (see System_Clock.h).
  *
  * @author Aaron Nanas
  */
@@ -19,6 +19,10 @@
 
 #define UART0_RECEIVE_FIFO_EMPTY_BIT_MASK 0x10
 #define UART0_TRANSMIT_FIFO_FULL_BIT_MASK 0x20
+#define UART0_BUSY_BIT_MASK 0x08
+
+// Baud rate, the divisors are computed from the system clock
+#define UART0_BAUD_RATE 115200
 
 /**
  * @brief Carriage return character
@@ -137,7 +141,18 @@ uint32_t UART0_Input_Unsigned_Decimal(void);
  *
  * @return None
  */
-void UART0_Output_Unsigned_Decimal(int n);
+void UART0_Output_Unsigned_Decimal(uint32_t n);
+
+/**
+ * @brief The UART0_Output_Signed_Decimal function transmits a signed decimal number via UART.
+ *
+ * A '-' sign is transmitted before the digits when the number is negative.
+ *
+ * @param n The signed decimal number to be transmitted.
+ *
+ * @return None
+ */
+void UART0_Output_Signed_Decimal(int32_t n);
 
 /**
  * @brief The UART0_Input_Unsigned_Hexadecimal function reads an unsigned hexadecimal number from the UART receive buffer.
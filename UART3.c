@@ -13,9 +13,57 @@
 */
 
 #include "UART3.h"
+#include "Number_Format.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "UART_Stats.h"
+#include "System_Clock.h"
 #include "TM4C123GH6PM.h"
 #include "Stepper_Motor.h"
+#include "Interrupt_Priorities.h"
 
+#define UART3_RX_INTERRUPT            0x10
+#define UART3_RX_TIMEOUT_INTERRUPT    0x40
+
+// Characters written by UART3_Handler and read by the main loop
+static uint8_t UART3_RX_Buffer[UART3_RX_BUFFER_SIZE];
+static volatile uint32_t UART3_RX_Head;
+static volatile uint32_t UART3_RX_Tail;
+
+// Lines ended by UART3_Handler, and lines read by the main loop
+static volatile uint32_t UART3_Lines_Received;
+static uint32_t UART3_Lines_Read;
+
+// Set when characters were lost because the ring buffer was full
+static volatile uint8_t UART3_RX_Overflow;
+
+/**
+ * @brief Programs the baud rate divisors for the current system clock.
+ */
+static void UART3_Set_Baud_Rate(void)
+{
+	uint32_t divisor = System_Clock_UART_Divisor(UART3_BAUD_RATE);
+	
+	UART3->IBRD = divisor >> 6;
+	UART3->FBRD = divisor & 0x3F;
+}
+
+static void UART3_Clock_Changed(System_Clock_Event event, uint32_t clock_hz)
+{
+	if (event == SYSTEM_CLOCK_CHANGING)
+	{
+		// Let the last character leave at the old baud rate
+		while((UART3->FR & UART3_BUSY_BIT_MASK) != 0);
+	}
+	else
+	{
+		// The new divisors take effect when LCRH is written
+		UART3->CTL &= ~0x01;
+		UART3_Set_Baud_Rate();
+		UART3->LCRH = UART3->LCRH;
+		UART3->CTL |= 0x01;
+	}
+}
 
 void UART3_Init(void)
 {
@@ -31,13 +79,9 @@ void UART3_Init(void)
 	
 	// Set the baud rate by writing to the DIVINT field (Bits 15 to 0)
 	// and the DIVFRAC field (Bits 5 to 0) in the IBRD and FBRD registers, respectively.
-	// The integer part of the calculated constant will be written to the IBRD register,
-	// while the fractional part will be written to the FBRD register.
-	// N = (System Clock Frequency) / (16 * Baud Rate)
-	// N = (50,000,000) / (16 * 115200) = 27.12673611 (N = 27)
-	// F = ((0.12673611 * 64) + 0.5) = 8.611 (F = 8)
-	UART3->IBRD = 325; //27
-	UART3->FBRD = 33; //8
+	// N = (System Clock Frequency) / (16 * Baud Rate), for example
+	// N = (50,000,000) / (16 * 9600) = 325.5208333 (IBRD = 325, FBRD = 33)
+	UART3_Set_Baud_Rate();
 	
 	// Configure the data word length of the UART packet to be 8 bits by 
 	UART3->LCRH |= 0x60;
@@ -69,19 +113,88 @@ void UART3_Init(void)
 	
 	// Enable the digital functionality for the PC7 and PC6 pins
 	GPIOC->DEN |= 0xC0;
+	
+	UART3_RX_Head = 0;
+	UART3_RX_Tail = 0;
+	UART3_Lines_Received = 0;
+	UART3_Lines_Read = 0;
+	UART3_RX_Overflow = 0;
+	
+	// Raise the receive interrupt when the FIFO holds 2 characters (1/8 full) by
+	// clearing the RXIFLSEL field (Bits 5 to 3) in the IFLS register
+	UART3->IFLS &= ~0x38;
+	
+	// Enable the receive and receive time-out interrupts by setting
+	// the RXIM bit (Bit 4) and the RTIM bit (Bit 6) in the IM register
+	UART3->ICR = UART3_RX_INTERRUPT | UART3_RX_TIMEOUT_INTERRUPT;
+	UART3->IM |= UART3_RX_INTERRUPT | UART3_RX_TIMEOUT_INTERRUPT;
+	
+	NVIC_SetPriority(UART3_IRQn, INTERRUPT_PRIORITY_UART3);
+	NVIC_EnableIRQ(UART3_IRQn);
+	
+	// Reprogram the baud rate divisors whenever the system clock changes
+	System_Clock_Register_Callback(UART3_Clock_Changed);
+}
+
+/**
+ * @brief Moves the characters in the receive FIFO to the ring buffer.
+ *
+ * A character other than a line feed is only stored when it leaves one free slot in
+ * the ring buffer, so there is always room for the line feed that ends the line.
+ */
+void UART3_Handler(void)
+{
+	uint32_t status = UART3->MIS;
+	uint32_t count = 0;
+
+	while ((UART3->FR & UART3_RECEIVE_FIFO_EMPTY_BIT_MASK) == 0)
+	{
+		// Read the character once, together with its error bits
+		uint32_t data = UART3->DR;
+		uint8_t character = (uint8_t)(data & 0xFF);
+		uint32_t head = UART3_RX_Head;
+		uint32_t space = UART3_RX_BUFFER_SIZE - (head - UART3_RX_Tail);
+
+		// The characters read in one pass were all waiting in the FIFO
+		UART_Stats_Record_Receive(UART_STATS_UART3, data, count > 0);
+		count++;
+
+		if (space >= 2 || (character == UART3_LF && space >= 1))
+		{
+			UART3_RX_Buffer[head & (UART3_RX_BUFFER_SIZE - 1)] = character;
+			UART3_RX_Head = head + 1;
+
+			if (character == UART3_LF)
+			{
+				UART3_Lines_Received++;
+			}
+		}
+		else
+		{
+			UART3_RX_Overflow = 1;
+		}
+	}
+
+	UART3->ICR = status & (UART3_RX_INTERRUPT | UART3_RX_TIMEOUT_INTERRUPT);
 }
 
 char UART3_Input_Character(void)
 {
-	while((UART3->FR & UART3_RECEIVE_FIFO_EMPTY_BIT_MASK) != 0);
+	uint32_t tail = UART3_RX_Tail;
 	
-	return (char)(UART3->DR & 0xFF);
+	while(UART3_RX_Head == tail);
+	
+	char character = (char)UART3_RX_Buffer[tail & (UART3_RX_BUFFER_SIZE - 1)];
+	UART3_RX_Tail = tail + 1;
+	
+	return character;
 }
 
 void UART3_Output_Character(char data)
 {
 	while((UART3->FR & UART3_TRANSMIT_FIFO_FULL_BIT_MASK) != 0);
 	UART3->DR = data;
+	UART_Stats_Record_Transmit(UART_STATS_UART3, 1);
 }
 
 void UART3_Input_String(char *buffer_pointer, uint16_t buffer_size) 
@@ -115,6 +228,9 @@ void UART3_Input_String(char *buffer_pointer, uint16_t buffer_size)
 
 void UART3_Output_String(char *pt)
 {
+	uint32_t profile_start = PROFILER_START();
+	TRACE(TRACE_UART3_OUTPUT_BEGIN, 0);
+	
 	while(*pt)
 	{
 		//starts motor
@@ -122,6 +238,19 @@ void UART3_Output_String(char *pt)
 		UART3_Output_Character(*pt);
 		pt++;
 	}
+	
+	TRACE(TRACE_UART3_OUTPUT_END, 0);
+	PROFILER_STOP(PROFILER_SCOPE_UART3_OUTPUT_STRING, profile_start);
+}
+
+void UART3_Output_Line(const char *pt)
+{
+	while (*pt)
+	{
+		UART3_Output_Character(*pt);
+		pt++;
+	}
+	UART3_Output_Newline();
 }
 
 uint32_t UART3_Input_Unsigned_Decimal(void)
@@ -158,18 +287,28 @@ uint32_t UART3_Input_Unsigned_Decimal(void)
 	return number;
 }
 
-void UART3_Output_Unsigned_Decimal(int n)
+void UART3_Output_Unsigned_Decimal(uint32_t n)
 {
-	// Use recursion to convert decimal number
-	// of unspecified length as an ASCII string
-  if (n >= 10)
+	// Convert the number into a buffer and send it in one pass
+	// UART3_Output_String is not used because it also starts the motor
+	char buffer[FORMAT_DECIMAL_SIZE];
+	uint8_t length = Format_Unsigned_Decimal(buffer, n);
+	
+	for (int i = 0; i < length; i++)
 	{
-    UART3_Output_Unsigned_Decimal(n / 10);
-    n = n % 10;
-  }
+		UART3_Output_Character(buffer[i]);
+	}
+}
+
+void UART3_Output_Signed_Decimal(int32_t n)
+{
+	char buffer[FORMAT_DECIMAL_SIZE];
+	uint8_t length = Format_Signed_Decimal(buffer, n);
 	
-	// n is between 0 and 9
-  UART3_Output_Character(n + '0');
+	for (int i = 0; i < length; i++)
+	{
+		UART3_Output_Character(buffer[i]);
+	}
 }
 
 uint32_t UART3_Input_Unsigned_Hexadecimal(void)
@@ -220,31 +359,57 @@ uint32_t UART3_Input_Unsigned_Hexadecimal(void)
 
 void UART3_Output_Unsigned_Hexadecimal(uint32_t number)
 {
-	// Use recursion to convert the number of
-	// unspecified length as an ASCII string
-	if (number >= 0x10)
+	char buffer[FORMAT_HEXADECIMAL_SIZE];
+	uint8_t length = Format_Hexadecimal(buffer, number, 1);
+	
+	for (int i = 0; i < length; i++)
 	{
-		UART3_Output_Unsigned_Hexadecimal(number / 0x10);
-		UART3_Output_Unsigned_Hexadecimal(number % 0x10);
+		UART3_Output_Character(buffer[i]);
 	}
-	else
+}
+
+void UART3_Output_Newline(void)
+{
+	UART3_Output_Character(UART3_CR);
+	UART3_Output_Character(UART3_LF);
+}
+
+int UART3_Input_Line(char *buffer_pointer, uint16_t buffer_size)
+{
+	int length = 0;
+	uint8_t truncated = 0;
+	char character = UART3_Input_Character();
+	
+	// Keep one byte for the null terminator
+	while(character != UART3_LF)
 	{
-		if (number < 0xA)
+		if (length < (buffer_size - 1) && character != UART3_CR)
 		{
-			UART3_Output_Character(number + '0');
+			*buffer_pointer = character;
+			buffer_pointer++;
+			length++;
 		}
-		else
+		else if (character != UART3_CR)
 		{
-			UART3_Output_Character((number - 0x0A) + 'A');
+			truncated = 1;
 		}
+		character = UART3_Input_Character();
 	}
+	*buffer_pointer = 0;
+	UART3_Lines_Read++;
+	
+	// Characters that did not fit in the ring buffer were lost from this line
+	if (UART3_RX_Overflow)
+	{
+		UART3_RX_Overflow = 0;
+		truncated = 1;
+	}
+	UART_Stats_Record_Line(UART_STATS_UART3, truncated);
+	TRACE(TRACE_UART3_INPUT_LINE, length);
+	return length;
 }
 
-void UART3_Output_Newline(void)
+int UART3_Available(void)
 {
-	UART3_Output_Character(UART3_CR);
-	UART3_Output_Character(UART3_LF);
+	return (UART3_Lines_Received != UART3_Lines_Read);
 }
-
-
-
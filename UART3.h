@@ -5,6 +5,10 @@
 *
 * @note Enabling UART3 for the Arduino MKR Zero soundboard
 *
+* Received characters are moved from the UART3 receive FIFO to a ring buffer by the
+* receive and receive time-out interrupts, so the lines the Arduino sends while the
+* main loop is busy, for example in a SysTick_Delay1ms, are kept.
+*
 * @author Evelyn Dominguez
 */
 
@@ -12,6 +16,19 @@
 
 #define UART3_RECEIVE_FIFO_EMPTY_BIT_MASK 0x10
 #define UART3_TRANSMIT_FIFO_FULL_BIT_MASK 0x20
+#define UART3_BUSY_BIT_MASK 0x08
+
+// Baud rate, the divisors are computed from the system clock
+#define UART3_BAUD_RATE 9600
+
+// Size of the receive ring buffer in characters, must be a power of two
+#ifndef UART3_RX_BUFFER_SIZE
+#define UART3_RX_BUFFER_SIZE 128
+#endif
+
+#if (UART3_RX_BUFFER_SIZE & (UART3_RX_BUFFER_SIZE - 1)) != 0
+#error "UART3_RX_BUFFER_SIZE must be a power of two"
+#endif
 
 /**
  * @brief Carriage return character
@@ -58,10 +75,10 @@
 void UART3_Init(void);
 
 /**
- * @brief The UART0_Input_Character function reads a character from the UART data register.
+ * @brief The UART3_Input_Character function reads a character from the receive ring buffer.
  *
- * This function waits until a character is available in the UART receive buffer
- * from the serial terminal input and returns the received character as a char type.
+ * This function waits until a character is available in the ring buffer
+ * and returns the received character as a char type.
  *
  * @param None
  *
@@ -108,6 +125,18 @@ void UART3_Input_String(char *buffer_pointer, uint16_t buffer_size);
  */
 void UART3_Output_String(char *pt);
 
+/**
+ * @brief The UART3_Output_Line function transmits a null-terminated string followed by CR and LF.
+ *
+ * Unlike UART3_Output_String, it leaves the stepper motor as it is, for the lines that
+ * do not change the playback.
+ *
+ * @param pt Pointer to the null-terminated string to be transmitted.
+ *
+ * @return None
+ */
+void UART3_Output_Line(const char *pt);
+
 /**
  * @brief The UART0_Input_Unsigned_Decimal function reads an unsigned decimal number from the UART receive buffer.
  *
@@ -131,7 +160,18 @@ uint32_t UART3_Input_Unsigned_Decimal(void);
  *
  * @return None
  */
-void UART3_Output_Unsigned_Decimal(int n);
+void UART3_Output_Unsigned_Decimal(uint32_t n);
+
+/**
+ * @brief The UART3_Output_Signed_Decimal function transmits a signed decimal number via UART.
+ *
+ * A '-' sign is transmitted before the digits when the number is negative.
+ *
+ * @param n The signed decimal number to be transmitted.
+ *
+ * @return None
+ */
+void UART3_Output_Signed_Decimal(int32_t n);
 
 /**
  * @brief The UART0_Input_Unsigned_Hexadecimal function reads an unsigned hexadecimal number from the UART receive buffer.
@@ -168,3 +208,27 @@ void UART3_Output_Unsigned_Hexadecimal(uint32_t number);
  * @return None
  */
 void UART3_Output_Newline(void);
+
+/**
+ * @brief The UART3_Input_Line function reads a line sent by the Arduino MKR Zero.
+ *
+ * This function reads characters from the UART3 receive buffer until a line feed (LF)
+ * character is encountered. Carriage return (CR) characters are dropped and, unlike
+ * UART3_Input_String, nothing is echoed back to the Arduino.
+ * The characters are stored in the provided buffer (buffer_pointer) up to the specified maximum length (buffer_size).
+ *
+ * @param buffer_pointer Pointer to the buffer where the received line will be stored.
+ * @param buffer_size Maximum length of the buffer.
+ *
+ * @return Returns the number of characters stored in the buffer.
+ */
+int UART3_Input_Line(char *buffer_pointer, uint16_t buffer_size);
+
+/**
+ * @brief The UART3_Available function checks if the Arduino MKR Zero has sent a whole line.
+ *
+ * @param None
+ *
+ * @return Returns 1 if a line ended by a line feed is in the ring buffer. Otherwise, returns 0.
+ */
+int UART3_Available(void);
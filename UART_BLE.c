@@ -10,7 +10,7 @@
  * of the TM4C123GH6PM Microcontroller Datasheet.
  * Link: https://www.ti.com/lit/gpn/TM4C123GH6PM
  *
- * @note Assumes that the system clock (50 MHz) is used.
+ * @note The baud rate divisors follow the system clock (see System_Clock.h).
  *
  * The Adafruit BLE UART module uses the following pinout:
  *  - BLE UART MOD (Pin 1)  <-->  Tiva LaunchPad Pin PB7
@@ -30,6 +30,68 @@
  */
 
 #include "UART_BLE.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "UART_Stats.h"
+#include "System_Clock.h"
+#include "Interrupt_Priorities.h"
+#include "GPTM_Timer.h"
+
+#define UART1_RX_INTERRUPT            0x10
+#define UART1_RX_TIMEOUT_INTERRUPT    0x40
+
+// Bit times without a new character before the receive time-out interrupt
+#define UART1_RX_TIMEOUT_BIT_TIMES    32
+
+// Measures the idle time of the line, in system clock cycles
+#define UART_BLE_IDLE_TIMER           GPTM_TIMER_1
+
+extern uint32_t SystemCoreClock;
+
+// Characters written by the interrupt handlers and read by the main loop
+static uint8_t UART_BLE_RX_Buffer[UART_BLE_RX_BUFFER_SIZE];
+static volatile uint32_t UART_BLE_RX_Head;
+static volatile uint32_t UART_BLE_RX_Tail;
+
+// Frames ended by the interrupt handlers, and frames read by the main loop
+static volatile uint32_t UART_BLE_Frames_Received;
+static uint32_t UART_BLE_Frames_Read;
+
+// Characters of the frame in progress in the ring buffer
+static uint32_t UART_BLE_Frame_Length;
+
+// Set when characters were lost because the ring buffer was full
+static volatile uint8_t UART_BLE_RX_Overflow;
+
+static void UART_BLE_Idle_Expired(void *context);
+
+/**
+ * @brief Programs the baud rate divisors for the current system clock.
+ */
+static void UART_BLE_Set_Baud_Rate(void)
+{
+	uint32_t divisor = System_Clock_UART_Divisor(UART1_BAUD_RATE);
+	
+	UART1->IBRD = divisor >> 6;
+	UART1->FBRD = divisor & 0x3F;
+}
+
+static void UART_BLE_Clock_Changed(System_Clock_Event event, uint32_t clock_hz)
+{
+	if (event == SYSTEM_CLOCK_CHANGING)
+	{
+		// Let the last character leave at the old baud rate
+		while((UART1->FR & UART1_BUSY_BIT_MASK) != 0);
+	}
+	else
+	{
+		// The new divisors take effect when LCRH is written
+		UART1->CTL &= ~0x01;
+		UART_BLE_Set_Baud_Rate();
+		UART1->LCRH = UART1->LCRH;
+		UART1->CTL |= 0x01;
+	}
+}
 
 void UART_BLE_Init(void)
 {
@@ -46,14 +108,10 @@ void UART_BLE_Init(void)
 	UART1->CTL &= ~0x01;
 	
 	// Set the baud rate by writing to the DIVINT field (Bits 15 to 0)
-	// and the DIVFRAC field (Bits 15 to 0) in the IBRD and FBRD registers, respectively.
-	// The integer part of the calculated constant will be written to the IBRD register,
-	// while the fractional part will be written to the FBRD register.
-	// N = (System Clock Frequency) / (16 * Baud Rate)
-	// N = (50,000,000) / (16 * 9600) = 325.5208333 (N = 325)
-	// F = ((0.5208333 * 64) + 0.5) = 33.8333312 (F = 33)
-	UART1->IBRD = 325;
-	UART1->FBRD = 33;
+	// and the DIVFRAC field (Bits 5 to 0) in the IBRD and FBRD registers, respectively.
+	// N = (System Clock Frequency) / (16 * Baud Rate), for example
+	// N = (50,000,000) / (16 * 9600) = 325.5208333 (IBRD = 325, FBRD = 33)
+	UART_BLE_Set_Baud_Rate();
 	
 	// Configure the data word length of the UART packet to be 8 bits by 
 	// writing a value of 0x3 to the WLEN field (Bits 6 to 5) in the LCRH register
@@ -102,25 +160,212 @@ void UART_BLE_Init(void)
 	
 	// Enable Digital Functionality for PB7
 	GPIOB->DEN |= 0x80;
+	
+	UART_BLE_RX_Head = 0;
+	UART_BLE_RX_Tail = 0;
+	UART_BLE_Frames_Received = 0;
+	UART_BLE_Frames_Read = 0;
+	UART_BLE_Frame_Length = 0;
+	UART_BLE_RX_Overflow = 0;
+	
+	// Timer 1A measures the idle time in the 32-bit one-shot mode, in system clock cycles.
+	// Its interrupt has the priority of UART1, so the two never preempt each other.
+	GPTM_Timer_Config idle_timer_config =
+	{
+		GPTM_TIMER_MODE_ONE_SHOT,
+		GPTM_TIMER_WIDTH_FULL,
+		0,
+		(SystemCoreClock / UART1_BAUD_RATE) * UART_BLE_IDLE_BIT_TIMES,
+		GPTM_TIMER_EDGE_RISING,
+		UART_BLE_Idle_Expired,
+		NULL,
+		INTERRUPT_PRIORITY_UART_BLE
+	};
+	GPTM_Timer_Init(UART_BLE_IDLE_TIMER, GPTM_TIMER_A, &idle_timer_config);
+	
+	// Raise the receive interrupt when the FIFO holds 2 characters (1/8 full) by
+	// clearing the RXIFLSEL field (Bits 5 to 3) in the IFLS register
+	UART1->IFLS &= ~0x38;
+	
+	// Enable the receive and receive time-out interrupts by setting
+	// the RXIM bit (Bit 4) and the RTIM bit (Bit 6) in the IM register
+	UART1->ICR = UART1_RX_INTERRUPT | UART1_RX_TIMEOUT_INTERRUPT;
+	UART1->IM |= UART1_RX_INTERRUPT | UART1_RX_TIMEOUT_INTERRUPT;
+	
+	NVIC_SetPriority(UART1_IRQn, INTERRUPT_PRIORITY_UART_BLE);
+	NVIC_EnableIRQ(UART1_IRQn);
+	
+	// Reprogram the baud rate divisors whenever the system clock changes
+	System_Clock_Register_Callback(UART_BLE_Clock_Changed);
+}
+
+/**
+ * @brief Starts the idle timer, or restarts it if it is already running.
+ *
+ * A time-out that expired while the caller was reading new characters is cleared,
+ * since the line was not idle.
+ *
+ * @param bit_times The idle time left in bit times.
+ */
+static void UART_BLE_Start_Idle_Timer(uint32_t bit_times)
+{
+	GPTM_Timer_Set_Period(UART_BLE_IDLE_TIMER, GPTM_TIMER_A, (SystemCoreClock / UART1_BAUD_RATE) * bit_times);
+	GPTM_Timer_Start(UART_BLE_IDLE_TIMER, GPTM_TIMER_A);
+}
+
+static void UART_BLE_Stop_Idle_Timer(void)
+{
+	GPTM_Timer_Stop(UART_BLE_IDLE_TIMER, GPTM_TIMER_A);
+}
+
+/**
+ * @brief Ends the frame in progress, which is given a line feed if it does not end with one.
+ *
+ * A character is only stored when it leaves one free slot in the ring buffer,
+ * so there is always room for the line feed of the frame in progress.
+ */
+static void UART_BLE_End_Frame(void)
+{
+	if (UART_BLE_Frame_Length == 0)
+	{
+		return;
+	}
+
+	uint32_t head = UART_BLE_RX_Head;
+	UART_BLE_RX_Buffer[head & (UART_BLE_RX_BUFFER_SIZE - 1)] = UART1_LF;
+	UART_BLE_RX_Head = head + 1;
+
+	UART_BLE_Frame_Length = 0;
+	UART_BLE_Frames_Received++;
+}
+
+/**
+ * @brief Moves the characters in the receive FIFO to the ring buffer.
+ *
+ * Null characters, such as the one sent by the BLE module after "OK", are discarded.
+ *
+ * @return The number of characters read from the FIFO.
+ */
+static uint32_t UART_BLE_Drain_FIFO(void)
+{
+	uint32_t count = 0;
+
+	while ((UART1->FR & UART1_RECEIVE_FIFO_EMPTY_BIT_MASK) == 0)
+	{
+		uint32_t data = UART1->DR;
+		uint8_t character = (uint8_t)(data & 0xFF);
+
+		// The characters read in one pass were all waiting in the FIFO
+		UART_Stats_Record_Receive(UART_STATS_BLE, data, count > 0);
+		count++;
+
+		if (character == UART1_LF)
+		{
+			UART_BLE_End_Frame();
+		}
+		else if (character != 0)
+		{
+			uint32_t head = UART_BLE_RX_Head;
+
+			if (UART_BLE_RX_BUFFER_SIZE - (head - UART_BLE_RX_Tail) >= 2)
+			{
+				UART_BLE_RX_Buffer[head & (UART_BLE_RX_BUFFER_SIZE - 1)] = character;
+				UART_BLE_RX_Head = head + 1;
+				UART_BLE_Frame_Length++;
+			}
+			else
+			{
+				UART_BLE_RX_Overflow = 1;
+			}
+		}
+	}
+
+	return count;
+}
+
+void UART1_Handler(void)
+{
+	uint32_t status = UART1->MIS;
+
+	UART_BLE_Drain_FIFO();
+	UART1->ICR = status & (UART1_RX_INTERRUPT | UART1_RX_TIMEOUT_INTERRUPT);
+
+	if (UART_BLE_Frame_Length == 0)
+	{
+		UART_BLE_Stop_Idle_Timer();
+	}
+
+	// On a receive time-out the line has already been idle for 32 bit times
+	else if (status & UART1_RX_TIMEOUT_INTERRUPT)
+	{
+		if (UART_BLE_IDLE_BIT_TIMES > UART1_RX_TIMEOUT_BIT_TIMES)
+		{
+			UART_BLE_Start_Idle_Timer(UART_BLE_IDLE_BIT_TIMES - UART1_RX_TIMEOUT_BIT_TIMES);
+		}
+		else
+		{
+			UART_BLE_Stop_Idle_Timer();
+			UART_BLE_End_Frame();
+		}
+	}
+
+	else
+	{
+		UART_BLE_Start_Idle_Timer(UART_BLE_IDLE_BIT_TIMES);
+	}
+}
+
+/**
+ * @brief Ends the current frame when the line has been idle, called from the Timer 1A handler.
+ *
+ * The characters below the receive interrupt trigger level are still in the FIFO when
+ * the idle timer expires; they are moved to the ring buffer and the idle timer restarts.
+ * A time-out cleared by UART1_Handler after it was pended does not get here.
+ */
+static void UART_BLE_Idle_Expired(void *context)
+{
+	// Characters below the trigger level arrived during the idle time, wait again
+	if (UART_BLE_Drain_FIFO() > 0 && UART_BLE_Frame_Length > 0)
+	{
+		UART_BLE_Start_Idle_Timer(UART_BLE_IDLE_BIT_TIMES);
+	}
+	else
+	{
+		UART_BLE_End_Frame();
+	}
 }
 
 char UART_BLE_Input_Character(void)
 {
-	while((UART1->FR & UART1_RECEIVE_FIFO_EMPTY_BIT_MASK) != 0);
+	uint32_t tail = UART_BLE_RX_Tail;
+	
+	while(UART_BLE_RX_Head == tail);
+	
+	char character = (char)UART_BLE_RX_Buffer[tail & (UART_BLE_RX_BUFFER_SIZE - 1)];
+	UART_BLE_RX_Tail = tail + 1;
 	
-	return (char)(UART1->DR & 0xFF);
+	return character;
 }
 
 void UART_BLE_Output_Character(char data)
 {
 	while((UART1->FR & UART1_TRANSMIT_FIFO_FULL_BIT_MASK) != 0);
 	UART1->DR = data;
+	UART_Stats_Record_Transmit(UART_STATS_BLE, 1);
+}
+
+uint8_t UART_BLE_Transmit_Empty(void)
+{
+	return (UART1->FR & UART1_TRANSMIT_FIFO_EMPTY_BIT_MASK) != 0;
 }
 
 int UART_BLE_Input_String(char *buffer_pointer, uint16_t buffer_size) 
 {
+	uint32_t profile_start = PROFILER_START();
+	TRACE(TRACE_UART_BLE_INPUT_BEGIN, 0);
 	int length = 0;
 	int string_size = 0;
+	uint8_t truncated = 0;
 	
 	// Read the last received data from the UART Receive Buffer
 	char character = UART_BLE_Input_Character();
@@ -141,39 +386,50 @@ int UART_BLE_Input_String(char *buffer_pointer, uint16_t buffer_size)
 			}
 		}
 		
-		// Otherwise, if there are more characters to be read, store them in the buffer
-		else if (length < buffer_size && character != UART1_CR)
+		// Otherwise, store the character if it fits with the null terminator
+		else if (length < buffer_size - 1 && character != UART1_CR)
 		{
 			*buffer_pointer = character;
 			buffer_pointer++;
 			length++;
 			string_size++;
 		}
+		
+		else if (character != UART1_CR)
+		{
+			truncated = 1;
+		}
 		character = UART_BLE_Input_Character();
 	}
 	*buffer_pointer = 0;
+	UART_BLE_Frames_Read++;
+	
+	// Characters that did not fit in the ring buffer were lost from this frame
+	if (UART_BLE_RX_Overflow)
+	{
+		UART_BLE_RX_Overflow = 0;
+		truncated = 1;
+	}
+	UART_Stats_Record_Line(UART_STATS_BLE, truncated);
 	
+	TRACE(TRACE_UART_BLE_INPUT_END, string_size);
+	PROFILER_STOP(PROFILER_SCOPE_UART_BLE_INPUT_STRING, profile_start);
 	return string_size;
 }
 
 void UART_BLE_Output_String(char *pt)
 {
+	uint32_t profile_start = PROFILER_START();
+	TRACE(TRACE_UART_BLE_OUTPUT_BEGIN, 0);
+	
 	while(*pt)
 	{
 		UART_BLE_Output_Character(*pt);
 		pt++;
 	}
-}
-
-void UART_BLE_Reset(void)
-{
-	GPIOB->DATA |= 0x80;
-	SysTick_Delay1ms(1000);
-	
-	UART_BLE_Output_String("ATZ\r\n");
-	SysTick_Delay1ms(3000);
 	
-	GPIOB->DATA &= ~0x80;
+	TRACE(TRACE_UART_BLE_OUTPUT_END, 0);
+	PROFILER_STOP(PROFILER_SCOPE_UART_BLE_OUTPUT_STRING, profile_start);
 }
 
 uint8_t Check_UART_BLE_Data(char UART_BLE_Buffer[], char *data_string)
@@ -189,5 +445,5 @@ uint8_t Check_UART_BLE_Data(char UART_BLE_Buffer[], char *data_string)
 	}
 }
 int UART_BLE_Available(void) {
-	return ((UART1->FR & UART1_RECEIVE_FIFO_EMPTY_BIT_MASK) == 0);
+	return (UART_BLE_Frames_Received != UART_BLE_Frames_Read);
 }
\ No newline at end of file
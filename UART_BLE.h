@@ -10,7 +10,7 @@
  * of the TM4C123GH6PM Microcontroller Datasheet.
  * Link: https://www.ti.com/lit/gpn/TM4C123GH6PM
  *
- * @note Assumes that the system clock (50 MHz) is used.
+ * @note The baud rate divisors follow the system clock (see System_Clock.h).
  *
  * The Adafruit BLE UART module uses the following pinout:
  *  - BLE UART MOD (Pin 1)  <-->  Tiva LaunchPad Pin PB7
@@ -26,6 +26,12 @@
  * to the following link.
  * - Link: https://www.adafruit.com/product/2479
  *
+ * Received characters are moved from the UART1 receive FIFO to a ring buffer by the
+ * UART1 receive and receive time-out interrupts. The characters are handed up to the
+ * main loop one frame at a time: a frame ends with a line feed, or when the line has
+ * been idle for UART_BLE_IDLE_BIT_TIMES, which is measured with Timer 1A in one-shot mode.
+ * A frame ended by the idle time-out is given a line feed so it reads like a line.
+ *
  * @author Aaron Nanas
  */
 
@@ -35,6 +41,25 @@
 
 #define UART1_RECEIVE_FIFO_EMPTY_BIT_MASK 0x10
 #define UART1_TRANSMIT_FIFO_FULL_BIT_MASK 0x20
+#define UART1_TRANSMIT_FIFO_EMPTY_BIT_MASK 0x80
+#define UART1_BUSY_BIT_MASK 0x08
+
+// Baud rate, the divisors are computed from the system clock
+#define UART1_BAUD_RATE 9600
+
+// Idle time that ends a frame without a line feed, in bit times (10 bit times per character)
+#ifndef UART_BLE_IDLE_BIT_TIMES
+#define UART_BLE_IDLE_BIT_TIMES           20
+#endif
+
+// Size of the receive ring buffer in characters, must be a power of two
+#ifndef UART_BLE_RX_BUFFER_SIZE
+#define UART_BLE_RX_BUFFER_SIZE           128
+#endif
+
+#if (UART_BLE_RX_BUFFER_SIZE & (UART_BLE_RX_BUFFER_SIZE - 1)) != 0
+#error "UART_BLE_RX_BUFFER_SIZE must be a power of two"
+#endif
 
 /**
  * @brief Carriage return character
@@ -75,15 +100,18 @@
  *
  * @note The PB1 (TX) and PB0 (RX) pins are used for UART communication via USB.
  *
+ * It also enables the UART1 receive and receive time-out interrupts, and configures
+ * Timer 1A as the one-shot idle timer that ends a frame.
+ *
  * @return None
  */
 void UART_BLE_Init(void);
 
 /**
- * @brief The UART_BLE_Input_Character function reads a character from the UART data register.
+ * @brief The UART_BLE_Input_Character function reads a character from the receive ring buffer.
  *
- * This function waits until a character is available in the UART receive buffer
- * from the serial terminal input and returns the received character as a char type.
+ * This function waits until a character received by the UART1 interrupt handler is available
+ * in the ring buffer and returns the received character as a char type.
  *
  * @param None
  *
@@ -108,7 +136,7 @@ void UART_BLE_Output_Character(char data);
  *
  * This function reads characters from the UART receive buffer in the serial terminal
  * until a line feed (LF) character is encountered.
- * The characters are stored in the provided buffer (buffer_pointer) up to the specified maximum length (buffer_size).
+ * The characters are stored in the provided buffer (buffer_pointer), at most buffer_size - 1 of them followed by the null terminator.
  * The function supports backspace (BS) character for deleting characters from the buffer.
  *
  * @param buffer_pointer Pointer to the buffer where the received string will be stored.
@@ -130,14 +158,6 @@ int UART_BLE_Input_String(char *buffer_pointer, uint16_t buffer_size);
  */
 void UART_BLE_Output_String(char *pt);
 
-/**
- * @brief The UART_BLE_Reset function issues a reset command by sending the ATZ string to the BLE module.
- *
- * @param None
- *
- * @return None
- */
-void UART_BLE_Reset(void);
 
 /**
  * @brief The Check_UART_BLE_Data function checks if the specified string (data_string) is 
@@ -150,4 +170,36 @@ void UART_BLE_Reset(void);
  */
 uint8_t Check_UART_BLE_Data(char UART_BLE_Data_Buffer[], char *data_string);
 
-int UART_BLE_Available(void);
\ No newline at end of file
+/**
+ * @brief The UART_BLE_Transmit_Empty function checks if the transmit FIFO is empty.
+ *
+ * Up to 16 characters can then be written without waiting.
+ *
+ * @param None
+ *
+ * @return Returns 1 if the transmit FIFO is empty. Otherwise, returns 0.
+ */
+uint8_t UART_BLE_Transmit_Empty(void);
+
+/**
+ * @brief The UART_BLE_Available function checks if a complete frame has been received.
+ *
+ * @param None
+ *
+ * @return Returns 1 if a frame ended by a line feed or by the idle time-out can be read
+ * with UART_BLE_Input_String. Otherwise, returns 0.
+ */
+int UART_BLE_Available(void);
+
+/**
+ * @brief The UART1_Handler function moves the received characters to the ring buffer.
+ *
+ * It is called on the receive interrupt (the FIFO holds 2 characters or more) and on the
+ * receive time-out interrupt (the FIFO is not empty and 32 bit times went by without a new
+ * character), and starts the idle timer while a frame is in progress.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void UART1_Handler(void);
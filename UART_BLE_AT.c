@@ -0,0 +1,232 @@
+/**
+ * @file UART_BLE_AT.c
+ *
+ * @brief Source code for the UART_BLE_AT module.
+ *
+ * The exchange is a state machine stepped by UART_BLE_AT_Process. Waits are measured
+ * with SysTick_Uptime_ms, so the main loop keeps serving the Arduino while the module
+ * restarts or answers.
+ */
+
+#include "UART_BLE_AT.h"
+#include "UART_BLE.h"
+#include "SysTick_Delay.h"
+#include "Number_Format.h"
+#include "Log.h"
+
+// MOD pin of the module: high for command mode, low for data mode
+#define UART_BLE_AT_MOD_PIN    0x80
+
+typedef enum
+{
+	UART_BLE_AT_IDLE,
+	UART_BLE_AT_SWITCHING,
+	UART_BLE_AT_WAITING,
+	UART_BLE_AT_LATE
+} UART_BLE_AT_State;
+
+typedef struct
+{
+	char command[UART_BLE_AT_COMMAND_SIZE + 3];
+	uint32_t timeout_ms;
+	UART_BLE_AT_Callback callback;
+} UART_BLE_AT_Request;
+
+static UART_BLE_AT_Request UART_BLE_AT_Queue[UART_BLE_AT_QUEUE_SIZE];
+static uint32_t UART_BLE_AT_Queue_Head;
+static uint32_t UART_BLE_AT_Queue_Tail;
+
+static UART_BLE_AT_State UART_BLE_AT_Current_State;
+
+// Uptime when the current state was entered
+static uint32_t UART_BLE_AT_State_Start;
+
+// Lines received before "OK" or "ERROR"
+static char UART_BLE_AT_Response[UART_BLE_AT_RESPONSE_SIZE + 1];
+static uint32_t UART_BLE_AT_Response_Length;
+
+// One frame read from the UART_BLE driver
+static char UART_BLE_AT_Line[UART_BLE_AT_RESPONSE_SIZE + 1];
+
+static void UART_BLE_AT_Enter(UART_BLE_AT_State state)
+{
+	UART_BLE_AT_Current_State = state;
+	UART_BLE_AT_State_Start = SysTick_Uptime_ms();
+}
+
+static uint32_t UART_BLE_AT_Elapsed_ms(void)
+{
+	return SysTick_Uptime_ms() - UART_BLE_AT_State_Start;
+}
+
+void UART_BLE_AT_Init(void)
+{
+	GPIOB->DATA &= ~UART_BLE_AT_MOD_PIN;
+
+	UART_BLE_AT_Queue_Head = 0;
+	UART_BLE_AT_Queue_Tail = 0;
+	UART_BLE_AT_Current_State = UART_BLE_AT_IDLE;
+}
+
+uint8_t UART_BLE_AT_Send(const char *command, uint32_t timeout_ms, UART_BLE_AT_Callback callback)
+{
+	if (UART_BLE_AT_Queue_Head - UART_BLE_AT_Queue_Tail >= UART_BLE_AT_QUEUE_SIZE
+		|| strlen(command) > UART_BLE_AT_COMMAND_SIZE)
+	{
+		return 0;
+	}
+
+	UART_BLE_AT_Request *request = &UART_BLE_AT_Queue[UART_BLE_AT_Queue_Head % UART_BLE_AT_QUEUE_SIZE];
+
+	// The CR LF is added here so the command can be sent with one call
+	strcpy(request->command, command);
+	strcat(request->command, "\r\n");
+	request->timeout_ms = timeout_ms;
+	request->callback = callback;
+	UART_BLE_AT_Queue_Head++;
+
+	return 1;
+}
+
+/**
+ * @brief Returns to data mode, then reports the result of the current request.
+ */
+static void UART_BLE_AT_Finish(UART_BLE_AT_Status status)
+{
+	UART_BLE_AT_Request *request = &UART_BLE_AT_Queue[UART_BLE_AT_Queue_Tail % UART_BLE_AT_QUEUE_SIZE];
+	UART_BLE_AT_Callback callback = request->callback;
+
+	GPIOB->DATA &= ~UART_BLE_AT_MOD_PIN;
+	UART_BLE_AT_Queue_Tail++;
+	UART_BLE_AT_Enter(UART_BLE_AT_IDLE);
+
+	if (callback)
+	{
+		callback(status, UART_BLE_AT_Response);
+	}
+}
+
+/**
+ * @brief Adds a response line to the response, separated from the previous one by a space.
+ */
+static void UART_BLE_AT_Append_Response(const char *line)
+{
+	if (UART_BLE_AT_Response_Length > 0 && UART_BLE_AT_Response_Length < UART_BLE_AT_RESPONSE_SIZE)
+	{
+		UART_BLE_AT_Response[UART_BLE_AT_Response_Length++] = ' ';
+	}
+
+	while (*line && UART_BLE_AT_Response_Length < UART_BLE_AT_RESPONSE_SIZE)
+	{
+		UART_BLE_AT_Response[UART_BLE_AT_Response_Length++] = *line++;
+	}
+	UART_BLE_AT_Response[UART_BLE_AT_Response_Length] = 0;
+}
+
+void UART_BLE_AT_Process(void)
+{
+	UART_BLE_AT_Request *request = &UART_BLE_AT_Queue[UART_BLE_AT_Queue_Tail % UART_BLE_AT_QUEUE_SIZE];
+
+	switch (UART_BLE_AT_Current_State)
+	{
+		case UART_BLE_AT_IDLE:
+			// Frames received in data mode are song commands, let the main loop read them first
+			if (UART_BLE_AT_Queue_Head != UART_BLE_AT_Queue_Tail && !UART_BLE_Available())
+			{
+				UART_BLE_AT_Response_Length = 0;
+				UART_BLE_AT_Response[0] = 0;
+				GPIOB->DATA |= UART_BLE_AT_MOD_PIN;
+				UART_BLE_AT_Enter(UART_BLE_AT_SWITCHING);
+			}
+			break;
+
+		case UART_BLE_AT_SWITCHING:
+			if (UART_BLE_AT_Elapsed_ms() >= UART_BLE_AT_MODE_SWITCH_MS)
+			{
+				if (strncmp(request->command, "ATZ\r", 4) == 0)
+				{
+					LOG(LOG_BLE_RESET_COMMAND);
+				}
+				UART_BLE_Output_String(request->command);
+				UART_BLE_AT_Enter(UART_BLE_AT_WAITING);
+			}
+			break;
+
+		case UART_BLE_AT_WAITING:
+			while (UART_BLE_Available())
+			{
+				UART_BLE_Input_String(UART_BLE_AT_Line, UART_BLE_AT_RESPONSE_SIZE);
+
+				if (strcmp(UART_BLE_AT_Line, "OK") == 0 || strcmp(UART_BLE_AT_Line, "ERROR") == 0)
+				{
+					LOG(LOG_BLE_RESPONSE);
+					UART_BLE_AT_Finish((UART_BLE_AT_Line[0] == 'O') ? UART_BLE_AT_OK : UART_BLE_AT_ERROR);
+					return;
+				}
+				UART_BLE_AT_Append_Response(UART_BLE_AT_Line);
+			}
+
+			if (UART_BLE_AT_Elapsed_ms() >= request->timeout_ms)
+			{
+				LOG(LOG_BLE_AT_TIMEOUT, request->command);
+				UART_BLE_AT_Enter(UART_BLE_AT_LATE);
+			}
+			break;
+
+		case UART_BLE_AT_LATE:
+			// Still in command mode: whatever arrives now is the late response
+			while (UART_BLE_Available())
+			{
+				UART_BLE_Input_String(UART_BLE_AT_Line, UART_BLE_AT_RESPONSE_SIZE);
+			}
+
+			if (UART_BLE_AT_Elapsed_ms() >= UART_BLE_AT_LATE_RESPONSE_MS)
+			{
+				UART_BLE_AT_Finish(UART_BLE_AT_TIMEOUT);
+			}
+			break;
+	}
+}
+
+uint8_t UART_BLE_AT_Busy(void)
+{
+	return (UART_BLE_AT_Current_State != UART_BLE_AT_IDLE);
+}
+
+uint8_t UART_BLE_AT_Reset(UART_BLE_AT_Callback callback)
+{
+	return UART_BLE_AT_Send("ATZ", UART_BLE_AT_RESET_TIMEOUT_MS, callback);
+}
+
+uint8_t UART_BLE_AT_Query_Connection(UART_BLE_AT_Callback callback)
+{
+	return UART_BLE_AT_Send("AT+GAPGETCONN", UART_BLE_AT_TIMEOUT_MS, callback);
+}
+
+uint8_t UART_BLE_AT_Set_TX_Power(int32_t dbm, UART_BLE_AT_Callback callback)
+{
+	char command[UART_BLE_AT_COMMAND_SIZE + 1] = "AT+BLEPOWERLEVEL=";
+	uint32_t length = strlen(command);
+
+	length += Format_Signed_Decimal(&command[length], dbm);
+	command[length] = 0;
+
+	return UART_BLE_AT_Send(command, UART_BLE_AT_TIMEOUT_MS, callback);
+}
+
+uint8_t UART_BLE_AT_Device_Name(const char *name, UART_BLE_AT_Callback callback)
+{
+	char command[UART_BLE_AT_COMMAND_SIZE + 1] = "AT+GAPDEVNAME";
+
+	if (name)
+	{
+		if (strlen(name) > UART_BLE_AT_COMMAND_SIZE - sizeof("AT+GAPDEVNAME=") + 1)
+		{
+			return 0;
+		}
+		strcat(command, "=");
+		strcat(command, name);
+	}
+
+	return UART_BLE_AT_Send(command, UART_BLE_AT_TIMEOUT_MS, callback);
+}
@@ -0,0 +1,141 @@
+/**
+ * @file UART_BLE_AT.h
+ *
+ * @brief Header file for the UART_BLE_AT module.
+ *
+ * This module sends AT commands to the Adafruit Bluefruit LE UART module without blocking
+ * the main loop. Commands are queued with a time-out and a callback, and UART_BLE_AT_Process,
+ * called from the main loop, runs one exchange at a time:
+ *  1. Wait until the main loop has read every frame received in data mode
+ *  2. Drive the MOD pin (PB7) high to enter command mode and let the module switch modes
+ *  3. Send the command followed by CR LF
+ *  4. Collect the response lines until "OK" or "ERROR", or until the time-out
+ *  5. Drive the MOD pin low to return to data mode and call the callback
+ *
+ * While an exchange is in progress, UART_BLE_AT_Busy returns 1 and every frame received on
+ * UART1 belongs to the exchange, so AT responses never reach the song commands. After a
+ * time-out, the module stays in command mode for UART_BLE_AT_LATE_RESPONSE_MS so a late
+ * response is read and discarded there as well.
+ *
+ * The callback runs in data mode, so it can send the result to the phone.
+ */
+
+#include "TM4C123GH6PM.h"
+
+// Requests that can wait in the queue
+#define UART_BLE_AT_QUEUE_SIZE          4
+
+// Longest command, without the CR LF, and longest response kept for the callback
+#define UART_BLE_AT_COMMAND_SIZE        40
+#define UART_BLE_AT_RESPONSE_SIZE       40
+
+// Time given to the module to switch between data mode and command mode
+#define UART_BLE_AT_MODE_SWITCH_MS      10
+
+// Time the module stays in command mode after a time-out to absorb a late response
+#define UART_BLE_AT_LATE_RESPONSE_MS    500
+
+// Default time-out of a command, and of ATZ which restarts the module
+#define UART_BLE_AT_TIMEOUT_MS          500
+#define UART_BLE_AT_RESET_TIMEOUT_MS    3000
+
+typedef enum
+{
+	UART_BLE_AT_OK,
+	UART_BLE_AT_ERROR,
+	UART_BLE_AT_TIMEOUT
+} UART_BLE_AT_Status;
+
+/**
+ * @brief Called when an exchange is over.
+ *
+ * @param status OK or ERROR as answered by the module, or TIMEOUT.
+ *
+ * @param response The lines received before "OK" or "ERROR", separated by spaces,
+ * or an empty string. It is only valid during the call.
+ */
+typedef void (*UART_BLE_AT_Callback)(UART_BLE_AT_Status status, const char *response);
+
+/**
+ * @brief Drives the MOD pin low (data mode) and clears the request queue.
+ *
+ * UART_BLE_Init must be called first, since it configures PB7.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void UART_BLE_AT_Init(void);
+
+/**
+ * @brief Queues an AT command.
+ *
+ * @param command The command without the CR LF, for example "AT+GAPGETCONN".
+ *
+ * @param timeout_ms Time allowed for the response once the command has been sent.
+ *
+ * @param callback Called when the exchange is over, can be NULL.
+ *
+ * @return 1 if the command was queued, 0 if the queue is full or the command is too long.
+ */
+uint8_t UART_BLE_AT_Send(const char *command, uint32_t timeout_ms, UART_BLE_AT_Callback callback);
+
+/**
+ * @brief Runs the current exchange. Must be called from the main loop, before the
+ * received frames are read as song commands.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void UART_BLE_AT_Process(void);
+
+/**
+ * @brief Checks if an exchange is in progress.
+ *
+ * @param None
+ *
+ * @return 1 while the received frames belong to an AT exchange, 0 otherwise.
+ */
+uint8_t UART_BLE_AT_Busy(void);
+
+/**
+ * @brief Queues ATZ, which restarts the module.
+ *
+ * @param callback Called when the module has restarted, can be NULL.
+ *
+ * @return 1 if the command was queued, 0 otherwise.
+ */
+uint8_t UART_BLE_AT_Reset(UART_BLE_AT_Callback callback);
+
+/**
+ * @brief Queues AT+GAPGETCONN. The response is "1" when a phone is connected, "0" otherwise.
+ *
+ * @param callback Called with the connection state.
+ *
+ * @return 1 if the command was queued, 0 otherwise.
+ */
+uint8_t UART_BLE_AT_Query_Connection(UART_BLE_AT_Callback callback);
+
+/**
+ * @brief Queues AT+BLEPOWERLEVEL to set the TX power.
+ *
+ * @param dbm The TX power in dBm: -40, -20, -16, -12, -8, -4, 0 or 4. The module answers
+ * ERROR for any other value.
+ *
+ * @param callback Called when the module has answered.
+ *
+ * @return 1 if the command was queued, 0 otherwise.
+ */
+uint8_t UART_BLE_AT_Set_TX_Power(int32_t dbm, UART_BLE_AT_Callback callback);
+
+/**
+ * @brief Queues AT+GAPDEVNAME to query or set the name the module advertises.
+ *
+ * @param name The new name, or NULL to query the current one.
+ *
+ * @param callback Called when the module has answered, with the name when it was queried.
+ *
+ * @return 1 if the command was queued, 0 otherwise.
+ */
+uint8_t UART_BLE_AT_Device_Name(const char *name, UART_BLE_AT_Callback callback);
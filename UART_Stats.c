@@ -0,0 +1,148 @@
+/**
+ * @file UART_Stats.c
+ *
+ * @brief Source code for the UART_Stats module.
+ *
+ * The counters of a link are updated by the contexts that use the link:
+ * - UART3: UART3_Handler receives the characters, and the main loop transmits and
+ *   ends the lines.
+ * - BLE: UART1_Handler and the idle timer callback receive the characters, and the
+ *   main loop transmits and ends the lines.
+ * - UART0: the main loop or the UART0 interrupt handler for the log frames, which never
+ *   run the same update at the same time (see Log.c).
+ *
+ * The main loop therefore clears the line error, resets the counters and copies them
+ * with interrupts masked, so a receive interrupt does not get lost in between.
+ */
+
+#include "UART_Stats.h"
+#include "Number_Format.h"
+
+#define UART_STATS_LINE_SIZE    96
+
+static const char *const UART_Stats_Link_Names[UART_STATS_LINK_COUNT] =
+{
+	"uart0",
+	"ble",
+	"uart3"
+};
+
+static UART_Stats_Counters UART_Stats_Links[UART_STATS_LINK_COUNT];
+
+// Characters read in a row without waiting for the receive FIFO
+static uint32_t UART_Stats_Run[UART_STATS_LINK_COUNT];
+
+// Set when a character of the current line was received with an error
+static uint8_t UART_Stats_Line_Error[UART_STATS_LINK_COUNT];
+
+uint8_t UART_Stats_Record_Receive(UART_Stats_Link link, uint32_t data, uint8_t was_waiting)
+{
+	UART_Stats_Counters *counters = &UART_Stats_Links[link];
+
+	counters->bytes_in++;
+
+	UART_Stats_Run[link] = was_waiting ? (UART_Stats_Run[link] + 1) : 1;
+	if (UART_Stats_Run[link] > counters->fifo_high_water)
+	{
+		counters->fifo_high_water = UART_Stats_Run[link];
+	}
+
+	if ((data & UART_STATS_DR_ERROR) == 0)
+	{
+		return 0;
+	}
+
+	UART_Stats_Line_Error[link] = 1;
+
+	if (data & UART_STATS_DR_OE)
+	{
+		counters->overruns++;
+	}
+	if (data & UART_STATS_DR_FE)
+	{
+		counters->framing_errors++;
+	}
+	if (data & UART_STATS_DR_PE)
+	{
+		counters->parity_errors++;
+	}
+	if (data & UART_STATS_DR_BE)
+	{
+		counters->break_errors++;
+	}
+
+	return 1;
+}
+
+void UART_Stats_Record_Transmit(UART_Stats_Link link, uint32_t count)
+{
+	UART_Stats_Links[link].bytes_out += count;
+}
+
+uint8_t UART_Stats_Record_Line(UART_Stats_Link link, uint8_t truncated)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	// An error received after this point belongs to the next line
+	uint8_t dropped = truncated || UART_Stats_Line_Error[link];
+	UART_Stats_Line_Error[link] = 0;
+
+	__set_PRIMASK(primask);
+
+	if (dropped)
+	{
+		UART_Stats_Links[link].dropped_lines++;
+	}
+
+	return dropped;
+}
+
+const UART_Stats_Counters *UART_Stats_Get(UART_Stats_Link link)
+{
+	return &UART_Stats_Links[link];
+}
+
+void UART_Stats_Reset(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+
+	for (int link = 0; link < UART_STATS_LINK_COUNT; link++)
+	{
+		UART_Stats_Links[link] = (UART_Stats_Counters){ 0 };
+		UART_Stats_Run[link] = 0;
+		UART_Stats_Line_Error[link] = 0;
+	}
+
+	__set_PRIMASK(primask);
+}
+
+void UART_Stats_Report(void)
+{
+	char line[UART_STATS_LINE_SIZE];
+
+	for (int link = 0; link < UART_STATS_LINK_COUNT; link++)
+	{
+		// Take a copy so the line is consistent while it is sent
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		UART_Stats_Counters counters = UART_Stats_Links[link];
+		__set_PRIMASK(primask);
+		char *limit = line + sizeof(line);
+		char *end = line;
+
+		end = Format_Append(end, limit, "STATS ");
+		end = Format_Append(end, limit, UART_Stats_Link_Names[link]);
+		end = Format_Append_Field(end, limit, " in ", counters.bytes_in);
+		end = Format_Append_Field(end, limit, " out ", counters.bytes_out);
+		end = Format_Append_Field(end, limit, " hw ", counters.fifo_high_water);
+		end = Format_Append_Field(end, limit, " oe ", counters.overruns);
+		end = Format_Append_Field(end, limit, " fe ", counters.framing_errors);
+		end = Format_Append_Field(end, limit, " pe ", counters.parity_errors);
+		end = Format_Append_Field(end, limit, " be ", counters.break_errors);
+		end = Format_Append_Field(end, limit, " drop ", counters.dropped_lines);
+
+		Format_Report_Line(line);
+	}
+}
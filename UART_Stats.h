@@ -0,0 +1,118 @@
+/**
+ * @file UART_Stats.h
+ *
+ * @brief Header file for the UART_Stats module.
+ *
+ * This module counts the traffic and the receive errors of the UART links:
+ *  - UART0: serial terminal
+ *  - UART1: Adafruit BLE UART module
+ *  - UART3: Arduino MKR Zero
+ *
+ * The UART drivers report every character they read with the value of the DR
+ * register, whose bits 11 to 8 flag an overrun, a break, a parity error and a
+ * framing error for that character, and every character they write.
+ *
+ * The FIFO high-water mark is the longest run of characters that were already
+ * waiting in the receive FIFO when the driver read them. It is a lower bound of
+ * the FIFO fill level; a value of 16 followed by overruns means the FIFO was full.
+ *
+ * A dropped line is a line that was cut short because it did not fit in the
+ * buffer, or that contains a character received with an error.
+ *
+ * The BLE command "STATS" sends one line per link to the phone and to UART0,
+ * and "STATS RESET" clears the counters:
+ *
+ *     STATS <link> in <bytes> out <bytes> hw <chars> oe <n> fe <n> pe <n> be <n> drop <lines>
+ */
+
+#include "TM4C123GH6PM.h"
+
+// Error bits of the UART DR register
+#define UART_STATS_DR_FE    0x100
+#define UART_STATS_DR_PE    0x200
+#define UART_STATS_DR_BE    0x400
+#define UART_STATS_DR_OE    0x800
+#define UART_STATS_DR_ERROR (UART_STATS_DR_FE | UART_STATS_DR_PE | UART_STATS_DR_BE | UART_STATS_DR_OE)
+
+typedef enum
+{
+	UART_STATS_UART0,
+	UART_STATS_BLE,
+	UART_STATS_UART3,
+	UART_STATS_LINK_COUNT
+} UART_Stats_Link;
+
+typedef struct
+{
+	uint32_t bytes_in;
+	uint32_t bytes_out;
+	uint32_t fifo_high_water;
+	uint32_t overruns;
+	uint32_t framing_errors;
+	uint32_t parity_errors;
+	uint32_t break_errors;
+	uint32_t dropped_lines;
+} UART_Stats_Counters;
+
+/**
+ * @brief Records a character read from the receive FIFO.
+ *
+ * @param link The link the character was read from.
+ *
+ * @param data The value read from the DR register, with the error bits.
+ *
+ * @param was_waiting 1 if the character was already in the FIFO when the driver started to read.
+ *
+ * @return 1 if the character was received with an error, 0 otherwise.
+ */
+uint8_t UART_Stats_Record_Receive(UART_Stats_Link link, uint32_t data, uint8_t was_waiting);
+
+/**
+ * @brief Records characters written to the transmit FIFO.
+ *
+ * @param link The link the characters were written to.
+ *
+ * @param count The number of characters.
+ *
+ * @return None
+ */
+void UART_Stats_Record_Transmit(UART_Stats_Link link, uint32_t count);
+
+/**
+ * @brief Records the end of a line, which is dropped if it was cut short or
+ * if one of its characters was received with an error.
+ *
+ * @param link The link the line was read from.
+ *
+ * @param truncated 1 if characters were discarded because the buffer was full.
+ *
+ * @return 1 if the line was dropped, 0 otherwise.
+ */
+uint8_t UART_Stats_Record_Line(UART_Stats_Link link, uint8_t truncated);
+
+/**
+ * @brief Returns the counters of a link.
+ *
+ * @param link The link.
+ *
+ * @return A pointer to the counters, which keep counting.
+ */
+const UART_Stats_Counters *UART_Stats_Get(UART_Stats_Link link);
+
+/**
+ * @brief Clears the counters of every link.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void UART_Stats_Reset(void);
+
+/**
+ * @brief Sends the counters of every link to the phone and to UART0.
+ *
+ * @param None
+ *
+ * @return None
+ */
+void UART_Stats_Report(void);
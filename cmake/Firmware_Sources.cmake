@@ -0,0 +1,31 @@
+# Firmware sources shared by the board build (../CMakeLists.txt) and the host simulator
+# (../Simulator/CMakeLists.txt). Keep in step with the Source Group of ECE425_Project.uvprojx.
+
+get_filename_component(FIRMWARE_DIR ${CMAKE_CURRENT_LIST_DIR}/.. ABSOLUTE)
+
+set(FIRMWARE_SOURCES
+	${FIRMWARE_DIR}/main.c
+	${FIRMWARE_DIR}/UART0.c
+	${FIRMWARE_DIR}/UART3.c
+	${FIRMWARE_DIR}/UART_BLE.c
+	${FIRMWARE_DIR}/UART_BLE_AT.c
+	${FIRMWARE_DIR}/Stepper_Motor.c
+	${FIRMWARE_DIR}/SysTick_Delay.c
+	${FIRMWARE_DIR}/GPTM_Timer.c
+	${FIRMWARE_DIR}/GPTM_Timer_Test.c
+	${FIRMWARE_DIR}/Latency_Benchmark.c
+	${FIRMWARE_DIR}/Profiler.c
+	${FIRMWARE_DIR}/Trace.c
+	${FIRMWARE_DIR}/Log.c
+	${FIRMWARE_DIR}/Number_Format.c
+	${FIRMWARE_DIR}/Number_Format_Benchmark.c
+	${FIRMWARE_DIR}/UART_Stats.c
+	${FIRMWARE_DIR}/System_Clock.c
+	${FIRMWARE_DIR}/Power_Idle.c
+	${FIRMWARE_DIR}/Stack_Monitor.c
+	${FIRMWARE_DIR}/Deferred_Work.c
+	${FIRMWARE_DIR}/EEPROM.c
+	${FIRMWARE_DIR}/Settings.c
+	${FIRMWARE_DIR}/Status_Publisher.c
+	${FIRMWARE_DIR}/RTE/Device/TM4C123GH6PM/system_TM4C123.c
+)
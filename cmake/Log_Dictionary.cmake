@@ -0,0 +1,19 @@
+# Generates log_dictionary.json, the host-side dictionary of the tokenized log messages
+# (Log_Messages.h), next to the firmware or simulator binaries. tools/log_decode.py uses
+# it to print the log frames sent on UART0.
+
+find_package(Python3 COMPONENTS Interpreter)
+
+if(Python3_Interpreter_FOUND)
+	add_custom_command(
+		OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/log_dictionary.json
+		COMMAND Python3::Interpreter ${FIRMWARE_DIR}/tools/log_dictionary.py
+			${FIRMWARE_DIR}/Log_Messages.h -o ${CMAKE_CURRENT_BINARY_DIR}/log_dictionary.json
+		DEPENDS ${FIRMWARE_DIR}/Log_Messages.h ${FIRMWARE_DIR}/tools/log_dictionary.py
+		COMMENT "Generating log_dictionary.json"
+		VERBATIM
+	)
+	add_custom_target(log_dictionary ALL DEPENDS ${CMAKE_CURRENT_BINARY_DIR}/log_dictionary.json)
+else()
+	message(STATUS "Python 3 not found, log_dictionary.json will not be generated")
+endif()
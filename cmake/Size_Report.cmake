@@ -0,0 +1,124 @@
+# Writes a size and symbol report for a firmware image, in the spirit of the
+# "Image component sizes" section of Listings/ECE425_Project.map.
+#
+#   cmake -DELF=<image.elf> -DOBJECTS=<a.o|b.o|...> -DSIZE=<size> -DNM=<nm>
+#         -DPROFILE=<name> -DOUTPUT=<report.txt> -P Size_Report.cmake
+#
+# Sections are counted the way armlink does:
+#   Code    .text*, .isr_vector, .init, .fini       RO Data  .rodata*, .ARM.exidx*, .init_array ...
+#   RW Data .data*                                  ZI Data  .bss*, COMMON, .stack
+
+set(FLASH_SIZE 262144)
+set(SRAM_SIZE 32768)
+
+# Sums the sections of one object or image into CODE, RO, RW and ZI in the caller's scope
+function(Sum_Sections file)
+	execute_process(COMMAND ${SIZE} -A -d ${file} OUTPUT_VARIABLE listing RESULT_VARIABLE result)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "${SIZE} failed on ${file}")
+	endif()
+
+	set(code 0)
+	set(ro 0)
+	set(rw 0)
+	set(zi 0)
+
+	string(REPLACE "\n" ";" lines "${listing}")
+	foreach(line IN LISTS lines)
+		if(line MATCHES "^(\\.[^ \t]+)[ \t]+([0-9]+)[ \t]+([0-9]+)")
+			set(name ${CMAKE_MATCH_1})
+			set(bytes ${CMAKE_MATCH_2})
+			if(name MATCHES "^\\.(text|isr_vector|init$|fini$)")
+				math(EXPR code "${code} + ${bytes}")
+			elseif(name MATCHES "^\\.(rodata|ARM\\.exidx|ARM\\.extab|init_array|preinit_array|fini_array)")
+				math(EXPR ro "${ro} + ${bytes}")
+			elseif(name MATCHES "^\\.data")
+				math(EXPR rw "${rw} + ${bytes}")
+			elseif(name MATCHES "^\\.(bss|stack)" OR name STREQUAL "COMMON")
+				math(EXPR zi "${zi} + ${bytes}")
+			endif()
+		endif()
+	endforeach()
+
+	set(CODE ${code} PARENT_SCOPE)
+	set(RO ${ro} PARENT_SCOPE)
+	set(RW ${rw} PARENT_SCOPE)
+	set(ZI ${zi} PARENT_SCOPE)
+endfunction()
+
+# Right-aligns a number in a column of the given width
+function(Pad value width variable)
+	string(LENGTH "${value}" length)
+	set(padded "${value}")
+	while(length LESS width)
+		set(padded " ${padded}")
+		math(EXPR length "${length} + 1")
+	endwhile()
+	set(${variable} "${padded}" PARENT_SCOPE)
+endfunction()
+
+function(Append_Row code ro rw zi name)
+	Pad(${code} 10 code)
+	Pad(${ro} 10 ro)
+	Pad(${rw} 10 rw)
+	Pad(${zi} 10 zi)
+	set(REPORT "${REPORT}${code}${ro}${rw}${zi}   ${name}\n" PARENT_SCOPE)
+endfunction()
+
+set(REPORT "Firmware image ${ELF} (profile ${PROFILE})\n\n")
+set(REPORT "${REPORT}Image component sizes\n\n")
+set(REPORT "${REPORT}      Code   RO Data   RW Data   ZI Data   Object Name\n\n")
+
+set(total_code 0)
+set(total_ro 0)
+set(total_rw 0)
+set(total_zi 0)
+
+# With LTO the objects also carry their regular code (-ffat-lto-objects), so these are
+# the sizes before link-time optimization and garbage collection
+string(REPLACE "|" ";" OBJECTS "${OBJECTS}")
+foreach(object IN LISTS OBJECTS)
+	Sum_Sections(${object})
+	get_filename_component(name ${object} NAME)
+	Append_Row(${CODE} ${RO} ${RW} ${ZI} ${name})
+	math(EXPR total_code "${total_code} + ${CODE}")
+	math(EXPR total_ro "${total_ro} + ${RO}")
+	math(EXPR total_rw "${total_rw} + ${RW}")
+	math(EXPR total_zi "${total_zi} + ${ZI}")
+endforeach()
+
+set(REPORT "${REPORT}\n    ------------------------------------------------------------\n")
+Append_Row(${total_code} ${total_ro} ${total_rw} ${total_zi} "Object Totals (before --gc-sections)")
+
+Sum_Sections(${ELF})
+Append_Row(${CODE} ${RO} ${RW} ${ZI} "Image Totals (after --gc-sections, with the C library)")
+
+math(EXPR flash "${CODE} + ${RO} + ${RW}")
+math(EXPR sram "${RW} + ${ZI}")
+math(EXPR flash_percent "${flash} * 100 / ${FLASH_SIZE}")
+math(EXPR sram_percent "${sram} * 100 / ${SRAM_SIZE}")
+
+set(REPORT "${REPORT}\n    Total ROM Size (Code + RO Data + RW Data)  ${flash} bytes (${flash_percent}% of 256 KB)\n")
+set(REPORT "${REPORT}    Total RAM Size (RW Data + ZI Data)         ${sram} bytes (${sram_percent}% of 32 KB, stack included)\n")
+
+# Every symbol that takes space in the image, largest first
+execute_process(COMMAND ${NM} --size-sort --reverse-sort --print-size --radix=d ${ELF}
+	OUTPUT_VARIABLE symbols RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+	message(FATAL_ERROR "${NM} failed on ${ELF}")
+endif()
+
+set(REPORT "${REPORT}\nSymbols by size\n\n      Size  Type   Address   Symbol\n\n")
+string(REPLACE "\n" ";" lines "${symbols}")
+foreach(line IN LISTS lines)
+	if(line MATCHES "^([0-9]+) ([0-9]+) ([A-Za-z]) (.+)$")
+		math(EXPR address "${CMAKE_MATCH_1}" OUTPUT_FORMAT HEXADECIMAL)
+		math(EXPR bytes "${CMAKE_MATCH_2}")
+		Pad(${bytes} 10 bytes)
+		Pad(${address} 12 address)
+		set(REPORT "${REPORT}${bytes}     ${CMAKE_MATCH_3}${address}   ${CMAKE_MATCH_4}\n")
+	endif()
+endforeach()
+
+file(WRITE ${OUTPUT} "${REPORT}")
+message(STATUS "${PROFILE}: ROM ${flash} bytes, RAM ${sram} bytes, report in ${OUTPUT}")
@@ -0,0 +1,26 @@
+# Toolchain file for the TM4C123GH6PM (Cortex-M4F) with the GNU Arm Embedded toolchain.
+#
+#   cmake -S . -B build-arm -DCMAKE_TOOLCHAIN_FILE=cmake/arm-none-eabi-gcc.cmake ...
+
+set(CMAKE_SYSTEM_NAME Generic)
+set(CMAKE_SYSTEM_PROCESSOR arm)
+
+set(TOOLCHAIN_PREFIX arm-none-eabi- CACHE STRING "Prefix of the cross compiler executables")
+
+set(CMAKE_C_COMPILER ${TOOLCHAIN_PREFIX}gcc)
+set(CMAKE_ASM_COMPILER ${TOOLCHAIN_PREFIX}gcc)
+set(CMAKE_OBJCOPY ${TOOLCHAIN_PREFIX}objcopy CACHE FILEPATH "objcopy of the cross toolchain")
+set(CMAKE_SIZE ${TOOLCHAIN_PREFIX}size CACHE FILEPATH "size of the cross toolchain")
+set(CMAKE_NM ${TOOLCHAIN_PREFIX}nm CACHE FILEPATH "nm of the cross toolchain")
+
+# There is nothing to run a test executable on, so only check that the compiler works
+set(CMAKE_TRY_COMPILE_TARGET_TYPE STATIC_LIBRARY)
+
+# Cortex-M4 with the single precision FPU, as the Keil target (FPU2, hard float ABI)
+set(CMAKE_C_FLAGS_INIT "-mcpu=cortex-m4 -mthumb -mfloat-abi=hard -mfpu=fpv4-sp-d16")
+set(CMAKE_ASM_FLAGS_INIT "-mcpu=cortex-m4 -mthumb -mfloat-abi=hard -mfpu=fpv4-sp-d16")
+set(CMAKE_EXE_LINKER_FLAGS_INIT "--specs=nano.specs --specs=nosys.specs")
+
+set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
+set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
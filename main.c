@@ -20,144 +20,866 @@
 
 #include "UART3.h"
 #include "UART_BLE.h"
+#include "UART_BLE_AT.h"
 #include "UART0.h"
 #include "stdio.h"
 #include "Stepper_Motor.h"
 
 #include "string.h"
-#include "Timer_0A_Interrupt.h"
+#include "Latency_Benchmark.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "Log.h"
+#include "Number_Format_Benchmark.h"
+#include "GPTM_Timer_Test.h"
+#include "UART_Stats.h"
+#include "System_Clock.h"
+#include "Number_Format.h"
+#include "Power_Idle.h"
+#include "Stack_Monitor.h"
+#include "Deferred_Work.h"
+#include "Settings.h"
+#include "Status_Publisher.h"
 
 #define BUFFER_SIZE   128
 
+// Volume of the Arduino: its level at power-up and the highest level it accepts
+#define VOLUME_DEFAULT   5
+#define VOLUME_MAX       20
+
+// Settings the BLE module is configured with: the TX power, then the name
+#define BLE_SETTINGS_COUNT   (1 + SETTINGS_STRING_WORDS)
+
 void Process_UART_BLE_Data(char UART_BLE_Buffer[]);
-void Timer_0A_Stepper_Motor(void);
-extern int motorActive;
+void Process_UART3_Data(char UART3_Buffer[]);
+void BLE_Module_Ready(UART_BLE_AT_Status status, const char *response);
+void BLE_Module_Report(UART_BLE_AT_Status status, const char *response);
+void Report_System_Clock(uint8_t switched);
+void Report_Stepper_Motor(void);
+void Restore_Settings(void);
+void Send_Volume(void);
+void Start_BLE_Module(void);
+void BLE_Module_Configured(UART_BLE_AT_Status status, const char *response);
+void BLE_Power_Saved(UART_BLE_AT_Status status, const char *response);
+void BLE_Name_Saved(UART_BLE_AT_Status status, const char *response);
+void Save_Song(const char *title);
+void Report_Motor_Setting(const char *name, uint8_t changed, const char *value);
+void Report_Boot(void);
+uint32_t Parse_Time_Seconds(const char *text);
+
+// Level last sent to the Arduino, it is not told when a level is out of range
+static uint32_t Volume = VOLUME_DEFAULT;
+
+// Title last sent to the Arduino, saved once the Arduino reports that the song started
+static char Song_Title[SETTINGS_STRING_SIZE];
+
+// Set once a song has played, until then RESUME plays the last song saved
+static uint8_t Song_Played = 0;
+
+// BLE module at boot: 1 when it was reset and configured, and the uptime when it was ready
+static uint8_t BLE_Reset_At_Boot = 0;
+static uint32_t BLE_Ready_ms = 0;
+
+// AT exchanges of the boot configuration still running, and whether one of them failed
+static uint8_t BLE_Configure_Pending = 0;
+static uint8_t BLE_Configure_Failed = 0;
+
+// Settings sent to the BLE module by the phone, saved once the module has answered OK
+static int32_t BLE_Pending_Power;
+static char BLE_Pending_Name[SETTINGS_STRING_SIZE];
+
+static const char *const Drive_Mode_Names[STEPPER_MOTOR_DRIVE_MODE_COUNT] = { "HALF", "FULL", "WAVE" };
 
 int main(void)
 {		
+	// Fill the unused stack with a pattern to measure its peak usage, printed with the STACK command
+	Stack_Monitor_Init();
+	
 	// Initialize the SysTick timer used to provide blocking delay functions
 	SysTick_Delay_Init();
 	
+	// Start the DWT cycle counter used to measure the command latencies
+	Latency_Benchmark_Init();
+	
+	// Clear the cycle counts of the profiled scopes, printed with the PROFILE command
+	Profiler_Init();
+	
+	// Load the settings saved in the EEPROM, they are applied once the drivers are running
+	uint8_t settings_loaded = Settings_Init();
+	
+	// Start recording events in the trace buffer, printed with the TRACE command
+	Trace_Init();
+	
+	// Run the work that the interrupt handlers post in PendSV, below every other interrupt
+	Deferred_Work_Init();
+	
+	// Push the playback status to the phone once the BLE module is ready
+	Status_Publisher_Init();
+	
 	UART3_Init();
 	
-	// Initialize an array to store the characters received from the Adafruit BLE UART module
-	char UART_BLE_Buffer[BUFFER_SIZE];
+	// Initialize an array to store the characters received from the Adafruit BLE UART module.
+	// Both buffers are static, on the 512 byte stack they would take half of it.
+	static char UART_BLE_Buffer[BUFFER_SIZE];
+	
+	// Initialize an array to store the lines received from the Arduino MKR Zero
+	static char UART3_Buffer[BUFFER_SIZE];
 
 	// Initialize the UART0 module which will be used to print characters on the serial terminal
 	UART0_Init();
 	
+	// Send the log messages in the background with the UART0 transmit interrupt
+	Log_Init();
+	
+	if (!settings_loaded)
+	{
+		LOG(LOG_EEPROM_FAILED);
+	}
 	
 	// Initialize the UART1 module which will be used to communicate with the Adafruit BLE UART module
 	UART_BLE_Init();
 	
-	//Initialize the pins used by the 28BYJ-48 Stepper Motor and the ULN2003 Stepper Motor Driver
+	//Initialize the pins used by the 28BYJ-48 Stepper Motor and the ULN2003 Stepper Motor Driver,
+	// and Timer 0A which steps it
 	Stepper_Motor_Init();
-	Timer_0A_Interrupt_Init(Timer_0A_Stepper_Motor);
 	
-	// Provide a short delay after initialization and reset the Adafruit BLE UART module
-	SysTick_Delay1ms(1000);
-	UART_BLE_Reset();
+	// Reset and configure the Adafruit BLE UART module in the background, unless it
+	// already has the saved settings. The main loop runs meanwhile.
+	UART_BLE_AT_Init();
+	Start_BLE_Module();
 	
-	// Send a message to the Adafruit BLE UART module to check if the connection is stable
-	UART_BLE_Output_String("UART BLE Active");
-	UART_BLE_Output_String(" ");
-	SysTick_Delay1ms(1000);
+	// Motor speed and drive mode, and the volume of the Arduino
+	Restore_Settings();
+	Status_Publisher_Set_Volume(Volume);
 	
 	Stop_Stepper_Motor();
 	
+	// Sleep with WFI when there is nothing to do, with the unused peripherals gated
+	Power_Idle_Init();
+	
+	// Set when a line from the Arduino MKR Zero waits for the end of an AT exchange
+	uint8_t UART3_Line_Pending = 0;
+	
 	while(1) {
+	
+	// The AT exchange with the BLE module owns the received frames while it is busy
+	UART_BLE_AT_Process();
 		
-	if(UART_BLE_Available())
+	if(!UART_BLE_AT_Busy() && UART_BLE_Available())
 	{
-		SysTick_Delay1ms(1000);
+		// The frame is complete: it ended with a line feed, or the line has been idle
+		Latency_Benchmark_Command_Arrived();
 		int string_size = UART_BLE_Input_String(UART_BLE_Buffer, BUFFER_SIZE);
 		
-		UART0_Output_String("String Size: ");
-		UART0_Output_Unsigned_Decimal(string_size);
-		UART0_Output_Newline();
-		
-		UART0_Output_String("UART BLE Data: ");
-		
-		for (int i = 0; i < string_size; i++)
-		{
-			if (UART_BLE_Buffer[i] == 0)
-			{
-				UART0_Output_Character('A');
-			}
-			else
-			{
-				UART0_Output_Character(UART_BLE_Buffer[i]);
-			}
-		}
-		UART0_Output_Newline();
+		LOG(LOG_BLE_COMMAND, UART_BLE_Buffer, string_size);
+		Log_Mark_Echo();
 		Process_UART_BLE_Data(UART_BLE_Buffer);
-		UART0_Output_Newline();
 	}
+	
+	if (!UART3_Line_Pending && UART3_Available())
+	{
+		UART3_Input_Line(UART3_Buffer, BUFFER_SIZE);
+		
+		LOG(LOG_UART3_LINE, UART3_Buffer);
+		UART3_Line_Pending = 1;
+	}
+	
+	// Messages for the phone would be read as AT commands in command mode, so they wait
+	if (UART3_Line_Pending && !UART_BLE_AT_Busy())
+	{
+		Process_UART3_Data(UART3_Buffer);
+		UART3_Line_Pending = 0;
+	}
+	
+	// Status frames for the phone, rate-limited and only into an empty transmit FIFO
+	if (!UART_BLE_AT_Busy())
+	{
+		Status_Publisher_Process();
+	}
+	
+	// Warn once when the stack is nearly full
+	Stack_Monitor_Check();
+	
+	// Sleep until the next interrupt when nothing is left to do. Interrupts are disabled
+	// for the check, so one that arrives after it ends the sleep at once.
+	__disable_irq();
+	
+	uint8_t Work_Pending = UART_BLE_Available() || (UART3_Line_Pending ? !UART_BLE_AT_Busy() : UART3_Available());
+	
+	if (!Work_Pending)
+	{
+		Power_Idle_Sleep();
+	}
+	
+	__enable_irq();
 }
 	
 }
 
 void Process_UART_BLE_Data(char UART_BLE_Buffer[])
 {
-	if (Check_UART_BLE_Data(UART_BLE_Buffer, "PAUSE"))
+	uint32_t profile_start = PROFILER_START();
+	TRACE(TRACE_COMMAND_BEGIN, 0);
+	
+	// BLE module settings, checked first so their arguments are not taken for other commands.
+	// The module answers through BLE_Module_Report once the AT exchange is over.
+	uint8_t at_queued = 1;
+	
+	if (Check_UART_BLE_Data(UART_BLE_Buffer, "BLE CONN?"))
+	{
+		at_queued = UART_BLE_AT_Query_Connection(BLE_Module_Report);
+	}
+	
+	// The power and the name are saved once the module has taken them
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "BLE POWER "))
+	{
+		BLE_Pending_Power = atoi(strstr(UART_BLE_Buffer, "BLE POWER ") + 10);
+		at_queued = UART_BLE_AT_Set_TX_Power(BLE_Pending_Power, BLE_Power_Saved);
+	}
+	
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "BLE NAME?"))
+	{
+		at_queued = UART_BLE_AT_Device_Name(NULL, BLE_Module_Report);
+	}
+	
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "BLE NAME "))
+	{
+		char *name = strstr(UART_BLE_Buffer, "BLE NAME ") + 9;
+		
+		// A name too long to be saved is still sent, the module answers ERROR if it is too long for it
+		BLE_Pending_Name[0] = 0;
+		if (strlen(name) < SETTINGS_STRING_SIZE)
+		{
+			strcpy(BLE_Pending_Name, name);
+		}
+		at_queued = UART_BLE_AT_Device_Name(name, BLE_Name_Saved);
+	}
+	
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "BLE RESET"))
+	{
+		at_queued = UART_BLE_AT_Reset(BLE_Module_Report);
+	}
+	
+	// System clock: "CLOCK?" reports the frequency, "CLOCK 80", "CLOCK 50" and "CLOCK 16" switch it
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "CLOCK?"))
+	{
+		Report_System_Clock(1);
+	}
+	
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "CLOCK "))
+	{
+		uint32_t clock_mhz = atoi(strstr(UART_BLE_Buffer, "CLOCK ") + 6);
+		
+		Report_System_Clock(System_Clock_Set_Frequency(clock_mhz * 1000000));
+	}
+	
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "PAUSE"))
 	{
 		UART3_Output_String("PAUSE");
+		UART3_Output_Newline();
+		Latency_Benchmark_Mark(LATENCY_STAGE_UART3_FORWARD);
 		SysTick_Delay1ms(1300);
 		Stop_Stepper_Motor();
+		
+		if (Status_Publisher_Get_State() == STATUS_PUBLISHER_PLAYING)
+		{
+			Status_Publisher_Set_State(STATUS_PUBLISHER_PAUSED);
+		}
 	}
 
+	// After power-up, nothing is loaded on the Arduino: RESUME plays the last song saved
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "RESUME") && !Song_Played
+		&& Settings_Get_String(SETTINGS_LAST_SONG, Song_Title))
+	{
+		UART3_Output_String(Song_Title);
+		UART3_Output_Newline();
+		Latency_Benchmark_Mark(LATENCY_STAGE_UART3_FORWARD);
+		SysTick_Delay1ms(1300);
+	}
+	
 	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "RESUME"))
 	{
 		UART3_Output_String("RESUME");
+		UART3_Output_Newline();
+		Latency_Benchmark_Mark(LATENCY_STAGE_UART3_FORWARD);
 		SysTick_Delay1ms(1300); 
 		Start_Stepper_Motor();
+		
+		if (Status_Publisher_Get_State() == STATUS_PUBLISHER_PAUSED)
+		{
+			Status_Publisher_Set_State(STATUS_PUBLISHER_PLAYING);
+		}
 	}
 	
+	// The level follows the Arduino's and is saved for the next power-up
 	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "VOLUME UP"))
 	{
 		UART3_Output_String("VOLUME UP");
+		UART3_Output_Newline();
+		Latency_Benchmark_Mark(LATENCY_STAGE_UART3_FORWARD);
+		
+		if (Volume < VOLUME_MAX)
+		{
+			Volume++;
+			Settings_Set(SETTINGS_VOLUME, Volume);
+			Status_Publisher_Set_Volume(Volume);
+		}
 	}
 	
 	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "VOLUME DOWN"))
 	{
 		UART3_Output_String("VOLUME DOWN");
+		UART3_Output_Newline();
+		Latency_Benchmark_Mark(LATENCY_STAGE_UART3_FORWARD);
+		
+		if (Volume > 0)
+		{
+			Volume--;
+			Settings_Set(SETTINGS_VOLUME, Volume);
+			Status_Publisher_Set_Volume(Volume);
+		}
 	}
+	
+	// Absolute level: "VOLUME <0 to 20>" replaces a run of VOLUME UP or VOLUME DOWN
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "VOLUME "))
+	{
+		char *level = strstr(UART_BLE_Buffer, "VOLUME ") + 7;
+		uint32_t value = atoi(level);
 		
-	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "ATZ"))
+		if (level[0] < '0' || level[0] > '9' || value > VOLUME_MAX)
+		{
+			UART_BLE_Output_String("VOLUME ERROR\n");
+		}
+		else
+		{
+			Volume = value;
+			Send_Volume();
+			Latency_Benchmark_Mark(LATENCY_STAGE_UART3_FORWARD);
+			Settings_Set(SETTINGS_VOLUME, Volume);
+			Status_Publisher_Set_Volume(Volume);
+		}
+	}
+	
+	// Playback position: "SEEK mm:ss" moves in the song and "POS?" asks where it is. The
+	// Arduino answers "SEEK m:ss" or "POS m:ss/m:ss", which go back to the phone.
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "SEEK ") || Check_UART_BLE_Data(UART_BLE_Buffer, "POS?"))
 	{
-		UART0_Output_String("UART BLE Reset Command Issued");
-		UART3_Output_Newline();
+		UART3_Output_Line(UART_BLE_Buffer);
+		Latency_Benchmark_Mark(LATENCY_STAGE_UART3_FORWARD);
 	}
 	
-	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "OK"))
+	// Status frames: "STATUS" sends every field again, for a phone that has just connected
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "STATUS"))
 	{
-		// Read the last received data from the UART Receive Buffer
+		Status_Publisher_Refresh();
+	}
 		
-		// Note: After a reset is issued and the module responds with "OK",
-		// the module transmits a null character. This prevents the null character
-		// from being added to the buffer when the user sends a command string for the first time
-		char character = UART_BLE_Input_Character();
+	// Playlist commands are handled by the Arduino, the motor follows its RESUME, TRACK
+	// and PAUSE events
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "ENQUEUE "))
+	{
+		UART3_Output_Line(UART_BLE_Buffer);
+		Latency_Benchmark_Mark(LATENCY_STAGE_UART3_FORWARD);
 		
-		UART0_Output_String("UART BLE Response Received");
-		UART3_Output_Newline();
+		// When nothing plays, the Arduino starts the song at once
+		Save_Song(strstr(UART_BLE_Buffer, "ENQUEUE ") + 8);
 	}
-
+	
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "ENQUEUE") || Check_UART_BLE_Data(UART_BLE_Buffer, "NEXT")
+		|| Check_UART_BLE_Data(UART_BLE_Buffer, "SHUFFLE") || Check_UART_BLE_Data(UART_BLE_Buffer, "CLEAR"))
+	{
+		UART3_Output_Line(UART_BLE_Buffer);
+		Latency_Benchmark_Mark(LATENCY_STAGE_UART3_FORWARD);
+	}
+	
+	// Latency benchmark: "LATENCY" prints the report on UART0, "LATENCY RESET" clears it
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "LATENCY RESET"))
+	{
+		Latency_Benchmark_Reset();
+	}
+	
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "LATENCY"))
+	{
+		Latency_Benchmark_Report();
+	}
+	
+	// Profiler: "PROFILE" prints the cycle counts of the profiled scopes on UART0 as CSV,
+	// "PROFILE RESET" clears them
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "PROFILE RESET"))
+	{
+		Profiler_Reset();
+	}
+	
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "PROFILE"))
+	{
+		Profiler_Report();
+	}
+	
+	// Trace buffer: "TRACE" prints the recorded events on UART0, "TRACE RESET" clears them
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "TRACE RESET"))
+	{
+		Trace_Reset();
+	}
+	
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "TRACE"))
+	{
+		Trace_Dump();
+	}
+	
+	// Number formatting: "FORMAT BENCH" compares the conversions with the former recursive ones
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "FORMAT BENCH"))
+	{
+		Number_Format_Benchmark_Run();
+	}
+	
+	// Timer driver: "TIMER TEST" checks the GPTM_Timer modes the motor and the BLE idle timer do not use
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "TIMER TEST"))
+	{
+		GPTM_Timer_Test_Run();
+	}
+	
+	// UART counters: "STATS" sends the traffic and error counts of each link to the phone
+	// and to UART0, "STATS RESET" clears them
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "STATS RESET"))
+	{
+		UART_Stats_Reset();
+	}
+	
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "STATS"))
+	{
+		UART_Stats_Report();
+	}
+	
+	// Idle time: "IDLE" sends the share of the time asleep and the wake-up latency and service time
+	// to the phone and to UART0, "IDLE RESET" clears them
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "IDLE RESET"))
+	{
+		Power_Idle_Reset();
+	}
+	
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "IDLE"))
+	{
+		Power_Idle_Report();
+	}
+	
+	// Deferred work: "DEFER" sends the PendSV runs, latency and longest run to the phone
+	// and to UART0, "DEFER RESET" clears them
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "DEFER RESET"))
+	{
+		Deferred_Work_Reset();
+	}
+	
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "DEFER"))
+	{
+		Deferred_Work_Report();
+	}
+	
+	// Motor settings, saved for the next power-up: "MOTOR SPEED <microseconds per step>",
+	// "MOTOR MODE HALF", "MOTOR MODE FULL" or "MOTOR MODE WAVE"
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "MOTOR SPEED "))
+	{
+		char period[FORMAT_DECIMAL_SIZE];
+		uint8_t changed = Stepper_Motor_Set_Step_Period(atoi(strstr(UART_BLE_Buffer, "MOTOR SPEED ") + 12));
+		
+		if (changed)
+		{
+			Settings_Set(SETTINGS_MOTOR_STEP_PERIOD, Stepper_Motor_Get_Step_Period());
+		}
+		
+		Format_Unsigned_Decimal(period, Stepper_Motor_Get_Step_Period());
+		Report_Motor_Setting("SPEED ", changed, period);
+	}
+	
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "MOTOR MODE "))
+	{
+		char *name = strstr(UART_BLE_Buffer, "MOTOR MODE ") + 11;
+		uint8_t changed = 0;
+		
+		for (uint32_t mode = 0; mode < STEPPER_MOTOR_DRIVE_MODE_COUNT; mode++)
+		{
+			if (strncmp(name, Drive_Mode_Names[mode], 4) == 0)
+			{
+				changed = Stepper_Motor_Set_Drive_Mode((Stepper_Motor_Drive_Mode)mode);
+				Settings_Set(SETTINGS_MOTOR_DRIVE_MODE, mode);
+			}
+		}
+		
+		Report_Motor_Setting("MODE ", changed, Drive_Mode_Names[Stepper_Motor_Get_Drive_Mode()]);
+	}
+	
+	// Motor state: "MOTOR?" sends "MOTOR ON <half step index> <half steps since power-up>", or OFF
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "MOTOR?"))
+	{
+		Report_Stepper_Motor();
+	}
+	
+	// Stack usage: "STACK" sends the peak stack usage to the phone and to UART0
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "STACK"))
+	{
+		Stack_Monitor_Report();
+	}
+	
+	// Saved settings: "SETTINGS" sends how many are stored and how long they took to load
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "SETTINGS"))
+	{
+		Settings_Report();
+	}
+	
+	// Boot time: "BOOT" sends the uptime when the BLE module was ready, and if it was reset
+	else if (Check_UART_BLE_Data(UART_BLE_Buffer, "BOOT"))
+	{
+		Report_Boot();
+	}
+	
 	else {
 		UART3_Output_String(UART_BLE_Buffer);
+		UART3_Output_Newline();
+		Latency_Benchmark_Mark(LATENCY_STAGE_UART3_FORWARD);
+		Save_Song(UART_BLE_Buffer);
 		SysTick_Delay1ms(1300);
 	} 
 	
+	if (!at_queued)
+	{
+		UART_BLE_Output_String("BLE BUSY\n");
+	}
+	
+	TRACE(TRACE_COMMAND_END, 0);
+	PROFILER_STOP(PROFILER_SCOPE_PROCESS_UART_BLE_DATA, profile_start);
+}
+void BLE_Module_Ready(UART_BLE_AT_Status status, const char *response)
+{
+	BLE_Ready_ms = SysTick_Uptime_ms();
+	LOG(LOG_BLE_READY, BLE_Ready_ms, status);
+	
+	// Send a message to the Adafruit BLE UART module to check if the connection is stable
+	UART_BLE_Output_String("UART BLE Active");
+	UART_BLE_Output_String("\n");
+	
+	// The module is in data mode from now on, the status frames follow the banner
+	Status_Publisher_Start();
+}
+
+void BLE_Module_Report(UART_BLE_AT_Status status, const char *response)
+{
+	static char *const status_names[] = { "OK", "ERROR", "TIMEOUT" };
+	
+	// A query answers with a value, a setting with OK
+	UART_BLE_Output_String("BLE ");
+	if (status == UART_BLE_AT_OK && response[0])
+	{
+		UART_BLE_Output_String((char *)response);
+	}
+	else
+	{
+		UART_BLE_Output_String(status_names[status]);
+	}
+	UART_BLE_Output_String("\n");
+}
+
+void Restore_Settings(void)
+{
+	uint32_t value;
+	
+	if (Settings_Get(SETTINGS_MOTOR_STEP_PERIOD, &value))
+	{
+		Stepper_Motor_Set_Step_Period(value);
+	}
+	
+	if (Settings_Get(SETTINGS_MOTOR_DRIVE_MODE, &value))
+	{
+		Stepper_Motor_Set_Drive_Mode((Stepper_Motor_Drive_Mode)value);
+	}
+	
+	// Sent now for an Arduino that is already running, and again when it reports READY
+	if (Settings_Get(SETTINGS_VOLUME, &value) && value <= VOLUME_MAX && value != VOLUME_DEFAULT)
+	{
+		Volume = value;
+		Send_Volume();
+	}
+}
+
+void Send_Volume(void)
+{
+	char line[7 + FORMAT_DECIMAL_SIZE] = "VOLUME ";
+	
+	Format_Unsigned_Decimal(&line[7], Volume);
+	UART3_Output_Line(line);
 }
-int step_index = 0;
-const uint8_t half_step[] = {0x04, 0x0C, 0x08, 0x18, 0x10, 0x30, 0x20, 0x24};
 
-	void Timer_0A_Stepper_Motor(void) {
-		if (motorActive) {
-			if (step_index >= 8)
+void Start_BLE_Module(void)
+{
+	uint32_t configured;
+	uint32_t power;
+	char name[SETTINGS_STRING_SIZE];
+	
+	// The module keeps its settings across a power cycle. If it has taken the saved ones,
+	// it is ready as it is and the reset, which takes about 1 s, is skipped.
+	if (Settings_Get(SETTINGS_BLE_CONFIG, &configured)
+		&& configured == Settings_Checksum(SETTINGS_BLE_TX_POWER, BLE_SETTINGS_COUNT))
+	{
+		BLE_Module_Ready(UART_BLE_AT_OK, "");
+		return;
+	}
+	
+	BLE_Reset_At_Boot = 1;
+	BLE_Configure_Pending = UART_BLE_AT_Reset(BLE_Module_Configured);
+	
+	if (Settings_Get(SETTINGS_BLE_TX_POWER, &power))
+	{
+		BLE_Configure_Pending += UART_BLE_AT_Set_TX_Power((int32_t)power, BLE_Module_Configured);
+	}
+	
+	if (Settings_Get_String(SETTINGS_BLE_NAME, name) && name[0])
+	{
+		BLE_Configure_Pending += UART_BLE_AT_Device_Name(name, BLE_Module_Configured);
+	}
+}
+
+void BLE_Module_Configured(UART_BLE_AT_Status status, const char *response)
+{
+	if (status != UART_BLE_AT_OK)
+	{
+		BLE_Configure_Failed = 1;
+	}
+	
+	if (--BLE_Configure_Pending > 0)
+	{
+		return;
+	}
+	
+	// Once every setting was taken, the next power-up skips the reset
+	if (!BLE_Configure_Failed)
+	{
+		Settings_Set(SETTINGS_BLE_CONFIG, Settings_Checksum(SETTINGS_BLE_TX_POWER, BLE_SETTINGS_COUNT));
+	}
+	
+	BLE_Module_Ready(status, response);
+}
+
+void BLE_Power_Saved(UART_BLE_AT_Status status, const char *response)
+{
+	if (status == UART_BLE_AT_OK)
+	{
+		Settings_Set(SETTINGS_BLE_TX_POWER, (uint32_t)BLE_Pending_Power);
+		Settings_Set(SETTINGS_BLE_CONFIG, Settings_Checksum(SETTINGS_BLE_TX_POWER, BLE_SETTINGS_COUNT));
+	}
+	
+	BLE_Module_Report(status, response);
+}
+
+void BLE_Name_Saved(UART_BLE_AT_Status status, const char *response)
+{
+	if (status == UART_BLE_AT_OK && BLE_Pending_Name[0])
+	{
+		Settings_Set_String(SETTINGS_BLE_NAME, BLE_Pending_Name);
+		Settings_Set(SETTINGS_BLE_CONFIG, Settings_Checksum(SETTINGS_BLE_TX_POWER, BLE_SETTINGS_COUNT));
+	}
+	
+	BLE_Module_Report(status, response);
+}
+
+void Save_Song(const char *title)
+{
+	// A title that does not fit is not remembered
+	Song_Title[0] = 0;
+	if (strlen(title) < SETTINGS_STRING_SIZE)
+	{
+		strcpy(Song_Title, title);
+	}
+}
+
+void Report_Motor_Setting(const char *name, uint8_t changed, const char *value)
+{
+	UART_BLE_Output_String("MOTOR ");
+	UART_BLE_Output_String((char *)name);
+	
+	if (changed == 0)
+	{
+		UART_BLE_Output_String("ERROR ");
+	}
+	
+	UART_BLE_Output_String((char *)value);
+	UART_BLE_Output_String("\n");
+}
+
+void Report_Boot(void)
+{
+	char ready[FORMAT_DECIMAL_SIZE];
+	
+	Format_Unsigned_Decimal(ready, BLE_Ready_ms);
+	
+	UART_BLE_Output_String("BOOT ready ");
+	UART_BLE_Output_String(ready);
+	
+	if (BLE_Reset_At_Boot)
+	{
+		UART_BLE_Output_String(" ms BLE RESET\n");
+	}
+	else
+	{
+		UART_BLE_Output_String(" ms BLE KEPT\n");
+	}
+}
+
+void Report_System_Clock(uint8_t switched)
+{
+	char frequency[FORMAT_DECIMAL_SIZE];
+	
+	Format_Unsigned_Decimal(frequency, System_Clock_Get_Frequency());
+	
+	UART_BLE_Output_String("CLOCK ");
+	
+	if (switched == 0)
+	{
+		UART_BLE_Output_String("ERROR ");
+	}
+	
+	UART_BLE_Output_String(frequency);
+	UART_BLE_Output_String("\n");
+}
+
+void Report_Stepper_Motor(void)
+{
+	Stepper_Motor_Status status;
+	char number[FORMAT_DECIMAL_SIZE];
+	
+	Stepper_Motor_Get_Status(&status);
+	
+	if (status.active)
+	{
+		UART_BLE_Output_String("MOTOR ON ");
+	}
+	else
+	{
+		UART_BLE_Output_String("MOTOR OFF ");
+	}
+	
+	Format_Unsigned_Decimal(number, status.step_index);
+	UART_BLE_Output_String(number);
+	UART_BLE_Output_String(" ");
+	
+	Format_Unsigned_Decimal(number, status.steps);
+	UART_BLE_Output_String(number);
+	UART_BLE_Output_String("\n");
+}
+
+void Process_UART3_Data(char UART3_Buffer[])
+{
+	// Song search results: "SUGGEST name1|name2|name3", empty when nothing is close
+	if (strncmp(UART3_Buffer, "SUGGEST", 7) == 0)
+	{
+		char *suggestions = &UART3_Buffer[7];
+		
+		while (*suggestions == ' ')
+		{
+			suggestions++;
+		}
+		
+		if (*suggestions == 0)
+		{
+			UART_BLE_Output_String("Song not found\n");
+		}
+		else
+		{
+			// Present the list as "a, b, c" on the phone
+			UART_BLE_Output_String("Did you mean: ");
+			while (*suggestions)
+			{
+				if (*suggestions == '|')
+				{
+					UART_BLE_Output_String(", ");
+				}
+				else
 				{
-			step_index = 0;
+					UART_BLE_Output_Character(*suggestions);
+				}
+				suggestions++;
+			}
+			UART_BLE_Output_String("?\n");
+		}
+	}
+	
+	// A queued song took over without a gap: keep the motor running and tell the phone
+	else if (strncmp(UART3_Buffer, "TRACK ", 6) == 0)
+	{
+		Start_Stepper_Motor();
+		Song_Played = 1;
+		if (strlen(&UART3_Buffer[6]) < SETTINGS_STRING_SIZE)
+		{
+			Settings_Set_String(SETTINGS_LAST_SONG, &UART3_Buffer[6]);
+		}
+		UART_BLE_Output_String("Now playing: ");
+		UART_BLE_Output_String(&UART3_Buffer[6]);
+		UART_BLE_Output_String("\n");
+		
+		Status_Publisher_Set_Title(&UART3_Buffer[6]);
+		Status_Publisher_Set_Position(0);
+		Status_Publisher_Set_State(STATUS_PUBLISHER_PLAYING);
+	}
+	
+	// The last song of the queue has finished
+	else if (strcmp(UART3_Buffer, "PAUSE") == 0)
+	{
+		Stop_Stepper_Motor();
+		Status_Publisher_Set_State(STATUS_PUBLISHER_STOPPED);
+	}
+	
+	// The Arduino has started and takes commands, at its default volume and with nothing playing
+	else if (strcmp(UART3_Buffer, "READY") == 0)
+	{
+		LOG(LOG_ARDUINO_READY, SysTick_Uptime_ms());
+		Stop_Stepper_Motor();
+		Status_Publisher_Set_State(STATUS_PUBLISHER_STOPPED);
+		
+		if (Volume != VOLUME_DEFAULT)
+		{
+			Send_Volume();
 		}
-		GPIOA->DATA = (GPIOA->DATA & ~0x3C) | half_step[step_index];
-		step_index = step_index + 1;
 	}
-}
\ No newline at end of file
+	
+	// Answers to SEEK and POS?
+	else if (strncmp(UART3_Buffer, "SEEK ", 5) == 0 || strncmp(UART3_Buffer, "POS ", 4) == 0)
+	{
+		UART_BLE_Output_String(UART3_Buffer);
+		UART_BLE_Output_String("\n");
+		
+		// "SEEK ERROR" and "POS NONE" leave the position as it was
+		char *time = strchr(UART3_Buffer, ' ') + 1;
+		if (time[0] >= '0' && time[0] <= '9')
+		{
+			Status_Publisher_Set_Position(Parse_Time_Seconds(time));
+		}
+	}
+	
+	// The first samples of a song went out: the title it was started with is the last song.
+	// An ENQUEUE that played at once only starts the motor here.
+	else if (strcmp(UART3_Buffer, "RESUME") == 0)
+	{
+		Start_Stepper_Motor();
+		Song_Played = 1;
+		if (Song_Title[0])
+		{
+			Settings_Set_String(SETTINGS_LAST_SONG, Song_Title);
+			Status_Publisher_Set_Title(Song_Title);
+			Song_Title[0] = 0;
+		}
+		
+		Status_Publisher_Set_Position(0);
+		Status_Publisher_Set_State(STATUS_PUBLISHER_PLAYING);
+	}
+}
+
+uint32_t Parse_Time_Seconds(const char *text)
+{
+	// "m:ss", the minutes are not limited to two digits
+	uint32_t seconds = atoi(text);
+	const char *colon = strchr(text, ':');
+	
+	if (colon != NULL)
+	{
+		seconds = seconds * 60 + atoi(colon + 1);
+	}
+	
+	return seconds;
+}
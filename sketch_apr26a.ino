@@ -7,135 +7,1504 @@
 * @note This project was created with assistance from ChatGPT and the following reference:
 * -Link:https://docs.arduino.cc/tutorials/generic/wave-playback/#troubleshoot
 *
+* @note Song titles are resolved through an in-RAM index of the .wav files on the
+* SD card. The index is sorted by normalized name (lowercase, no ".wav") so a
+* lookup is a binary search instead of a FAT directory scan. It is cached in
+* SONG_INDEX_FILE and checked against one pass over the root directory at startup:
+* it is rebuilt when the cache is missing, invalid, lists a different number of
+* .wav files or a different size or FAT write time for one of them, or a "REINDEX"
+* command is received while no song is loaded.
+*
+* @note WAV metadata (format, data offset, duration) is kept in a sidecar file
+* with one record per index entry. Songs are started through IndexedWaveFile,
+* which seeks straight to the cached data offset instead of having SDWaveFile
+* re-read and validate the RIFF header. When the index is rebuilt only files whose
+* size or write time changed (or that are new) get their headers parsed again.
+*
+* @note Unknown titles are answered with "SUGGEST a|b|c" on Serial1, which the
+* Tiva forwards to the phone. The sorted index doubles as a prefix trie: all
+* names sharing a prefix form one contiguous range, so a node is (depth, range)
+* and its children are found by binary search on the next character. The search
+* walks that trie with a Levenshtein row per depth and prunes every branch whose
+* row minimum exceeds the distance bound, so only near matches are visited.
+*
+* @note Commands are read by CommandReader: loop() only consumes the bytes Serial1
+* already holds, a line ends at CR/LF (or after COMMAND_IDLE_MS of silence), and
+* nothing on the command path allocates from the heap.
+*
+* @note "ENQUEUE <title>", "NEXT", "SHUFFLE" and "CLEAR" manage a playlist. The
+* song at the head of the queue is opened while the current one plays; the I2S
+* callback switches to it without stopping, and the Tiva gets "TRACK <name>" so
+* the motor keeps running. "PAUSE" is only sent when the queue runs dry.
+*
+* @note "VOLUME <0-20>" sets the level at once, "SEEK mm:ss" moves in the song and
+* "POS?" answers "POS m:ss/m:ss" (position/duration). A seek is computed from the cached
+* data offset and block alignment, so it is one file seek done in the I2S callback.
+*
+* @note Startup never blocks: setup() only brings up the link and sends "READY" to the
+* Tiva, then loop() mounts the SD card and loads the song index one phase per pass
+* while commands are already read. PAUSE, RESUME, VOLUME and POS? run at once;
+* the last command that needs the songs is held until the index is loaded, a newer one
+* replaces it. USB serial logging is optional (USB_LOG) and the box starts the same with
+* or without a serial monitor.
+*
 * @author Evelyn Dominguez & Chat GPT
 */
 
 #include <SD.h>
 #include <ArduinoSound.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// Uncomment to time SD.exists() against the index for every song at startup
+//#define SONG_INDEX_BENCHMARK
+
+#define SONG_INDEX_MAX_SONGS   1024
+#define SONG_INDEX_NAME_POOL   8192
+#define SONG_NAME_MAX          64
+#define SONG_INDEX_FILE        "/SONGIDX.BIN"
+#define SONG_INDEX_MAGIC       0x58444953UL  // "SIDX"
+#define SONG_INDEX_VERSION     4
+#define SONG_META_FILE_0       "/SONGMT0.BIN"
+#define SONG_META_FILE_1       "/SONGMT1.BIN"
+#define SONG_META_MAGIC        0x4154454DUL  // "META"
+#define SONG_META_VERSION      2
+#define SONG_META_NAME         24
+#define SEARCH_MAX_QUERY       32
+#define SEARCH_MAX_DISTANCE    2
+#define SEARCH_MAX_SUGGESTIONS 3
+#define COMMAND_MAX_LENGTH     96
+#define COMMAND_IDLE_MS        20
+#define PLAYLIST_MAX           32
+#define SD_RETRY_MS            1000
+
+// USB serial logging, set to 0 to leave Serial out. Nothing waits for a serial monitor:
+// lines logged while none is attached are dropped.
+#define USB_LOG                1
+
+// Uncomment to replay COMMAND_STRESS_COUNT commands through the reader at startup
+//#define COMMAND_STRESS_TEST
+#define COMMAND_STRESS_COUNT   5000
+
+#if USB_LOG
+#define Log Serial
+#else
+//swallows the log lines when USB serial is left out
+class NullLog : public Print {
+public:
+  virtual size_t write(uint8_t) { return 1; }
+  virtual size_t write(const uint8_t *, size_t size) { return size; }
+};
+NullLog Log;
+#endif
+
+//startup phases run from loop(), one per pass
+enum BootPhase {
+  BOOT_SD_MOUNT,
+  BOOT_SONG_INDEX,
+  BOOT_DONE
+};
+
+//one index entry per .wav file, names live in songNames[]
+struct SongEntry {
+  uint16_t nameOffset;  // byte offset of the normalized name in songNames[]
+  uint32_t size;        // file size in bytes
+  uint32_t modified;    // FAT write date in the high half, write time in the low half
+};
+
+//header of the cached index file, followed by the entries and the name pool
+struct SongIndexHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t count;
+  uint16_t namesUsed;
+  uint16_t metaSlot;    // which SONG_META_FILE_x matches this index
+  uint16_t files;       // .wav files on the card, more than count when the index is full
+};
+
+//one sidecar record per index entry, in index order
+struct WaveMeta {
+  char name[SONG_META_NAME];  // normalized name, matches records across rebuilds
+  uint32_t fileSize;          // a different size or write time means the header must be parsed again
+  uint32_t modified;          // SongEntry::modified of the file that was parsed
+  uint32_t sampleRate;
+  uint32_t dataOffset;        // first byte of the "data" chunk payload
+  uint32_t dataLength;
+  uint32_t durationMs;
+  uint16_t blockAlign;
+  uint8_t bitsPerSample;
+  uint8_t channels;
+};
+
+//header of the sidecar file, followed by count WaveMeta records
+struct WaveMetaHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t count;
+};
+
+//one .wav file of the root directory, as its FAT entry describes it
+struct SongFile {
+  char name[13];      // 8.3 name, as File::name() gives it
+  uint32_t size;
+  uint32_t modified;  // same layout as SongEntry::modified
+};
+
+bool readSongMeta(uint16_t song, WaveMeta &meta);
+void songFilename(uint16_t song, char *out, size_t outSize);
+
+//one open .wav payload
+struct WaveTrack {
+  File file;
+  WaveMeta meta;
+  uint32_t remaining;
+  int song;
+};
+
+//the I2S DMA interrupt runs read(); loop() masks it while it uses the SD card
+//during playback, so the two never access the card at the same time
+void sdLock() {
+  NVIC_DisableIRQ(DMAC_IRQn);
+}
+
+void sdUnlock() {
+  NVIC_EnableIRQ(DMAC_IRQn);
+}
+
+//plays the PCM payload of a .wav file using metadata from the sidecar,
+//so starting a song is one open() and one seek(). A second track can be
+//preloaded; when the current one runs out inside read() the next one is
+//swapped in within the same I2S buffer, so queued songs play gaplessly.
+//read() runs in the I2S callback and only reads and seeks open files: the
+//next track is opened, and the finished one closed, by loop() under sdLock().
+class IndexedWaveFile : public AudioIn {
+public:
+  IndexedWaveFile() : firstSampleMicros(0), trackChanges(0), _current(0), _seekOffset(-1), _nextReady(false), _skip(false) {
+    _tracks[0].song = -1;
+    _tracks[1].song = -1;
+  }
+
+  //only called while playback is stopped
+  bool open(int song, const char *filename, const WaveMeta &meta) {
+    close();
+    if (!openTrack(_tracks[_current], song, filename, meta)) {
+      close();
+      return false;
+    }
+    firstSampleMicros = 0;
+    return reset();
+  }
+
+  void close() {
+    closeTrack(_tracks[0]);
+    closeTrack(_tracks[1]);
+    _seekOffset = -1;
+    _nextReady = false;
+    _skip = false;
+  }
+
+  //opens song as the next track, or only drops the next one when song is -1.
+  //A different format cannot share the running I2S clock, loop() restarts
+  //playback instead.
+  void preload(int song) {
+    sdLock();
+    _nextReady = false;
+    WaveTrack &current = _tracks[_current];
+    WaveTrack &next = _tracks[_current ^ 1];
+    closeTrack(next);
+    if (song >= 0) {
+      WaveMeta meta;
+      char filename[SONG_NAME_MAX + 5];
+      songFilename(song, filename, sizeof(filename));
+      _nextReady = readSongMeta(song, meta)
+                   && meta.sampleRate == current.meta.sampleRate
+                   && meta.bitsPerSample == current.meta.bitsPerSample
+                   && meta.channels == current.meta.channels
+                   && openTrack(next, song, filename, meta);
+    }
+    sdUnlock();
+  }
+
+  //true once the requested next track is open and has the same format
+  bool nextReady() { return _nextReady; }
+
+  //ends the current track at the next read(), the preloaded one continues
+  void skip() { _skip = true; }
+
+  int currentSong() { return _tracks[_current].song; }
+
+  //metadata of the current track, valid while currentSong() >= 0
+  const WaveMeta &currentMeta() { return _tracks[_current].meta; }
+
+  //moves the current track to ms at the next read(), false if ms is past its end
+  bool seek(uint32_t ms) {
+    const WaveMeta &meta = _tracks[_current].meta;
+    if (_tracks[_current].song < 0 || ms > meta.durationMs) {
+      return false;
+    }
+    _seekOffset = (int32_t)((uint64_t)ms * meta.sampleRate / 1000 * meta.blockAlign);
+    return true;
+  }
+
+  //position of the current track in ms; a seek not done yet (while paused) counts as done
+  uint32_t positionMs() {
+    const WaveMeta &meta = _tracks[_current].meta;
+    int32_t seekOffset = _seekOffset;
+    uint32_t played = seekOffset >= 0 ? (uint32_t)seekOffset : meta.dataLength - _tracks[_current].remaining;
+    return (uint32_t)((uint64_t)(played / meta.blockAlign) * 1000 / meta.sampleRate);
+  }
+
+  virtual long sampleRate() { return _tracks[_current].meta.sampleRate; }
+  virtual int bitsPerSample() { return _tracks[_current].meta.bitsPerSample; }
+  virtual int channels() { return _tracks[_current].meta.channels; }
+
+  //micros() when I2S first asked for samples, 0 until then
+  volatile unsigned long firstSampleMicros;
+  //incremented by read() every time it moves on to the preloaded track
+  volatile uint8_t trackChanges;
+
+protected:
+  virtual int begin() { return reset(); }
+  virtual void end() { }
+
+  virtual int read(void *buffer, size_t size) {
+    if (firstSampleMicros == 0) {
+      firstSampleMicros = micros();
+    }
+    if (_seekOffset >= 0) {
+      WaveTrack &track = _tracks[_current];
+      if (track.file && track.file.seek(track.meta.dataOffset + _seekOffset)) {
+        track.remaining = track.meta.dataLength - _seekOffset;
+      }
+      _seekOffset = -1;
+    }
+    if (_skip) {
+      _tracks[_current].remaining = 0;
+      _skip = false;
+    }
+
+    uint8_t *out = (uint8_t *)buffer;
+    int total = 0;
+    while (size > 0) {
+      WaveTrack &track = _tracks[_current];
+      if (track.remaining == 0) {
+        if (!_nextReady) {
+          break;
+        }
+        //the finished track stays open until loop() preloads the next one
+        _current ^= 1;
+        _nextReady = false;
+        trackChanges++;
+        continue;
+      }
+      size_t chunk = size < track.remaining ? size : track.remaining;
+      int count = track.file.read(out, chunk);
+      if (count <= 0) {
+        track.remaining = 0;
+        continue;
+      }
+      track.remaining -= count;
+      out += count;
+      size -= count;
+      total += count;
+    }
+    return total;
+  }
+
+  virtual int reset() {
+    WaveTrack &track = _tracks[_current];
+    if (!track.file || !track.file.seek(track.meta.dataOffset)) {
+      return 0;
+    }
+    track.remaining = track.meta.dataLength;
+    return 1;
+  }
+
+private:
+  bool openTrack(WaveTrack &track, int song, const char *filename, const WaveMeta &meta) {
+    track.file = SD.open(filename);
+    if (!track.file || track.file.size() != meta.fileSize || !track.file.seek(meta.dataOffset)) {
+      closeTrack(track);
+      return false;
+    }
+    track.meta = meta;
+    track.remaining = meta.dataLength;
+    track.song = song;
+    return true;
+  }
+
+  void closeTrack(WaveTrack &track) {
+    if (track.file) {
+      track.file.close();
+    }
+    track.file = File();
+    track.remaining = 0;
+    track.song = -1;
+  }
+
+  WaveTrack _tracks[2];
+  uint8_t _current;
+  volatile int32_t _seekOffset;   // bytes into the data chunk, -1 when no seek is pending
+  volatile bool _nextReady;
+  volatile bool _skip;
+};
+
+SongEntry songIndex[SONG_INDEX_MAX_SONGS];
+char songNames[SONG_INDEX_NAME_POOL];
+uint16_t songCount = 0;
+uint16_t songFiles = 0;
+uint16_t songNamesUsed = 0;
+uint16_t songMetaSlot = 0;
+File songMeta;
+
+//assembles Serial1 bytes into a command line without blocking or allocating
+struct CommandReader {
+  char buffer[COMMAND_MAX_LENGTH + 1];
+  uint8_t length;
+  bool overflow;                 // line exceeded COMMAND_MAX_LENGTH, dropped at its end
+  unsigned long lastByteMillis;
+};
+
+CommandReader commandReader;
+
+//songs waiting to be played, the head is the one being preloaded
+uint16_t playQueue[PLAYLIST_MAX];
+uint8_t queueHead = 0;
+uint8_t queueCount = 0;
+uint8_t seenTrackChanges = 0;
+bool playingIndexed = false;
 
 SDWaveFile waveFile;
+IndexedWaveFile indexedWave;
 
-String currentSong = "";
+char currentSong[SONG_NAME_MAX + 5] = "";
 bool isPaused = false;
 bool songDone = false;
 int currentVol = 5; 
+bool songStarted = false;
+unsigned long commandMicros = 0;
 
+BootPhase bootPhase = BOOT_SD_MOUNT;
+unsigned long bootLinkMicros = 0;       // setup(): serial ports and audio output
+unsigned long bootMountMicros = 0;      // SD.begin(), retries included
+unsigned long bootIndexMicros = 0;      // song index and metadata
+unsigned long sdFailedMillis = 0;
+uint8_t sdAttempts = 0;
+char heldCommand[COMMAND_MAX_LENGTH + 1] = "";  // the last command that needs the songs, run once they are indexed
 
-void setup() {
-  Serial.begin(9600);//115200
-  Serial1.begin(9600);
-  //Serial1.println("PAUSE");
+//lowercases, trims and strips a trailing ".wav" so "  Song.WAV" and "song" match
+//returns the normalized length
+size_t normalizeSongName(const char *in, char *out, size_t outSize) {
+  while (*in == ' ' || *in == '\t') {
+    in++;
+  }
+  size_t len = 0;
+  while (in[len] != '\0' && len < outSize - 1) {
+    out[len] = tolower((unsigned char)in[len]);
+    len++;
+  }
+  while (len > 0 && (out[len - 1] == ' ' || out[len - 1] == '\t' || out[len - 1] == '\r' || out[len - 1] == '\n')) {
+    len--;
+  }
+  if (len >= 4 && strncmp(&out[len - 4], ".wav", 4) == 0) {
+    len -= 4;
+  }
+  out[len] = '\0';
+  return len;
+}
+
+const char *songName(uint16_t song) {
+  return &songNames[songIndex[song].nameOffset];
+}
+
+//builds "<name>.wav" for SD.open(); FAT names are case-insensitive
+void songFilename(uint16_t song, char *out, size_t outSize) {
+  snprintf(out, outSize, "%s.wav", songName(song));
+}
+
+int compareSongEntries(const void *a, const void *b) {
+  return strcmp(&songNames[((const SongEntry *)a)->nameOffset],
+                &songNames[((const SongEntry *)b)->nameOffset]);
+}
+
+//binary search over the sorted index, returns the entry or -1
+int findSong(const char *title) {
+  char key[SONG_NAME_MAX];
+  normalizeSongName(title, key, sizeof(key));
+
+  int low = 0;
+  int high = (int)songCount - 1;
+  while (low <= high) {
+    int mid = (low + high) >> 1;
+    int cmp = strcmp(key, songName(mid));
+    if (cmp == 0) {
+      return mid;
+    }
+    if (cmp < 0) {
+      high = mid - 1;
+    } else {
+      low = mid + 1;
+    }
+  }
+  return -1;
+}
+
+//search results, best first
+struct Suggestion {
+  uint16_t song;
+  uint8_t score;   // edit distance between the query and the closest prefix of the name
+  uint8_t length;  // shorter names rank first on equal score
+};
 
-  while (!Serial) {
-    ; // Wait for Serial Monitor
+Suggestion suggestions[SEARCH_MAX_SUGGESTIONS];
+uint8_t suggestionCount = 0;
+//one Levenshtein row per trie depth; rows deeper than query + bound are never needed
+uint8_t searchRows[SEARCH_MAX_QUERY + SEARCH_MAX_DISTANCE + 2][SEARCH_MAX_QUERY + 1];
+char searchQuery[SEARCH_MAX_QUERY + 1];
+uint8_t searchQueryLength = 0;
+uint8_t searchBound = 0;
+
+void addSuggestion(uint16_t song, uint8_t score, uint8_t length) {
+  if (score > searchBound) {
+    return;
   }
-  Serial.print("Initializing SD card...");
-  if (!SD.begin()) {
-    Serial.println("SD initialization failed!");
-    while (1);
+  int position = suggestionCount;
+  while (position > 0 && (suggestions[position - 1].score > score
+         || (suggestions[position - 1].score == score && suggestions[position - 1].length > length))) {
+    position--;
+  }
+  if (position >= SEARCH_MAX_SUGGESTIONS) {
+    return;
+  }
+  if (suggestionCount < SEARCH_MAX_SUGGESTIONS) {
+    suggestionCount++;
+  }
+  memmove(&suggestions[position + 1], &suggestions[position], (suggestionCount - 1 - position) * sizeof(Suggestion));
+  suggestions[position].song = song;
+  suggestions[position].score = score;
+  suggestions[position].length = length;
+
+  //a full list only lets branches that can tie or beat the last entry through
+  if (suggestionCount == SEARCH_MAX_SUGGESTIONS && suggestions[SEARCH_MAX_SUGGESTIONS - 1].score < searchBound) {
+    searchBound = suggestions[SEARCH_MAX_SUGGESTIONS - 1].score;
   }
-  Serial.println("SD card initialized.");
-  AudioOutI2S.volume(currentVol); // default volume
 }
-//equalIgnorecase: ignores differences in uppercase and lowercase letters
-void loop() {
-  if (Serial1.available()) {
-    String incomingCommand = Serial1.readStringUntil('\n'); //'\n'
-    incomingCommand.trim(); // Remove \r, \n, spaces at start and end
-    //if empty command is recieved it ignores it
-    if (incomingCommand.length() == 0) {
-      return;
+
+//first entry in [low, high) whose character at depth sorts after c
+uint16_t searchRangeEnd(uint16_t low, uint16_t high, uint8_t depth, char c) {
+  while (low < high) {
+    uint16_t mid = (low + high) >> 1;
+    if ((uint8_t)songName(mid)[depth] <= (uint8_t)c) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+//visits the trie node made of the entries [low, high) that share depth characters;
+//pathBest is the lowest distance between the query and any prefix on the way here
+void searchNode(uint8_t depth, uint16_t low, uint16_t high, uint8_t pathBest) {
+  const uint8_t *row = searchRows[depth];
+  uint16_t i = low;
+  while (i < high) {
+    char c = songName(i)[depth];
+    if (c == '\0') {
+      //a name ends at this node, it sorts before its longer siblings
+      addSuggestion(i, pathBest, depth);
+      i++;
+      continue;
+    }
+    uint16_t end = searchRangeEnd(i, high, depth, c);
+
+    uint8_t *next = searchRows[depth + 1];
+    next[0] = row[0] + 1;
+    uint8_t rowMin = next[0];
+    for (uint8_t j = 1; j <= searchQueryLength; j++) {
+      uint8_t substitute = row[j - 1] + (searchQuery[j - 1] == c ? 0 : 1);
+      uint8_t remove = row[j] + 1;
+      uint8_t insert = next[j - 1] + 1;
+      uint8_t value = substitute < remove ? substitute : remove;
+      next[j] = value < insert ? value : insert;
+      if (next[j] < rowMin) {
+        rowMin = next[j];
+      }
+    }
+    uint8_t best = next[searchQueryLength] < pathBest ? next[searchQueryLength] : pathBest;
+
+    if (rowMin <= searchBound && depth + 2 < (uint8_t)(sizeof(searchRows) / sizeof(searchRows[0]))) {
+      searchNode(depth + 1, i, end, best);
+    }
+    else if (best <= searchBound) {
+      //no deeper prefix can get closer, every name below scores best
+      for (uint16_t song = i; song < end; song++) {
+        addSuggestion(song, best, strlen(songName(song)));
+      }
+    }
+    i = end;
+  }
+}
+
+//fills suggestions[] with the closest titles, returns how many were found
+uint8_t searchSongs(const char *title) {
+  char normalized[SONG_NAME_MAX];
+  size_t length = normalizeSongName(title, normalized, sizeof(normalized));
+  if (length > SEARCH_MAX_QUERY) {
+    length = SEARCH_MAX_QUERY;
+  }
+  memcpy(searchQuery, normalized, length);
+  searchQuery[length] = '\0';
+  searchQueryLength = length;
+  suggestionCount = 0;
+  if (length == 0 || songCount == 0) {
+    return 0;
+  }
+
+  //short queries only complete prefixes, longer ones tolerate typos
+  searchBound = length <= 2 ? 0 : (length <= 5 ? 1 : SEARCH_MAX_DISTANCE);
+  for (uint8_t j = 0; j <= length; j++) {
+    searchRows[0][j] = j;
+  }
+  searchNode(0, 0, songCount, length);
+  return suggestionCount;
+}
+
+//answers the Tiva with "SUGGEST a|b|c" (empty list when nothing is close)
+void sendSuggestions(const char *title) {
+  unsigned long start = micros();
+  uint8_t count = searchSongs(title);
+  unsigned long elapsed = micros() - start;
+
+  Serial1.print("SUGGEST ");
+  for (uint8_t i = 0; i < count; i++) {
+    if (i > 0) {
+      Serial1.print("|");
+    }
+    Serial1.print(songName(suggestions[i].song));
+  }
+  Serial1.println();
+
+  Log.print("Search: ");
+  Log.print(count);
+  Log.print(" suggestions in ");
+  Log.print(elapsed);
+  Log.println(" us");
+}
+
+bool loadSongIndex() {
+  File cache = SD.open(SONG_INDEX_FILE);
+  if (!cache) {
+    return false;
+  }
+  SongIndexHeader header;
+  bool ok = cache.read((uint8_t *)&header, sizeof(header)) == sizeof(header)
+            && header.magic == SONG_INDEX_MAGIC
+            && header.version == SONG_INDEX_VERSION
+            && header.count <= SONG_INDEX_MAX_SONGS
+            && header.namesUsed <= SONG_INDEX_NAME_POOL;
+  if (ok) {
+    size_t entryBytes = header.count * sizeof(SongEntry);
+    ok = cache.read((uint8_t *)songIndex, entryBytes) == (int)entryBytes
+         && cache.read((uint8_t *)songNames, header.namesUsed) == header.namesUsed;
+  }
+  cache.close();
+
+  songCount = ok ? header.count : 0;
+  songNamesUsed = ok ? header.namesUsed : 0;
+  songMetaSlot = ok ? (header.metaSlot & 1) : 0;
+  songFiles = ok ? header.files : 0;
+  return ok;
+}
+
+void saveSongIndex() {
+  SD.remove(SONG_INDEX_FILE);
+  File cache = SD.open(SONG_INDEX_FILE, FILE_WRITE);
+  if (!cache) {
+    Log.println("Cannot write song index cache");
+    return;
+  }
+  SongIndexHeader header = { SONG_INDEX_MAGIC, SONG_INDEX_VERSION, songCount, songNamesUsed, songMetaSlot, songFiles };
+  cache.write((const uint8_t *)&header, sizeof(header));
+  cache.write((const uint8_t *)songIndex, songCount * sizeof(SongEntry));
+  cache.write((const uint8_t *)songNames, songNamesUsed);
+  cache.close();
+}
+
+uint16_t le16(const uint8_t *p) {
+  return p[0] | (p[1] << 8);
+}
+
+uint32_t le32(const uint8_t *p) {
+  return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+//walks the RIFF chunks for "fmt " and "data", only PCM is accepted
+bool parseWaveHeader(File &file, WaveMeta &meta) {
+  uint8_t riff[12];
+  if (file.read(riff, sizeof(riff)) != sizeof(riff) || memcmp(riff, "RIFF", 4) != 0 || memcmp(&riff[8], "WAVE", 4) != 0) {
+    return false;
+  }
+  uint32_t fileSize = file.size();
+  uint32_t position = sizeof(riff);
+  bool haveFormat = false;
+  while (position + 8 <= fileSize) {
+    uint8_t chunk[8];
+    if (!file.seek(position) || file.read(chunk, sizeof(chunk)) != sizeof(chunk)) {
+      return false;
+    }
+    uint32_t chunkSize = le32(&chunk[4]);
+    if (memcmp(chunk, "fmt ", 4) == 0) {
+      uint8_t format[16];
+      if (chunkSize < sizeof(format) || file.read(format, sizeof(format)) != sizeof(format) || le16(&format[0]) != 1) {
+        return false;
+      }
+      meta.channels = le16(&format[2]);
+      meta.sampleRate = le32(&format[4]);
+      meta.blockAlign = le16(&format[12]);
+      meta.bitsPerSample = le16(&format[14]);
+      haveFormat = meta.blockAlign != 0 && meta.sampleRate != 0;
+    }
+    else if (memcmp(chunk, "data", 4) == 0) {
+      if (!haveFormat) {
+        return false;
+      }
+      meta.dataOffset = position + 8;
+      meta.dataLength = chunkSize < fileSize - meta.dataOffset ? chunkSize : fileSize - meta.dataOffset;
+      meta.dataLength -= meta.dataLength % meta.blockAlign;
+      meta.durationMs = (uint32_t)((uint64_t)(meta.dataLength / meta.blockAlign) * 1000 / meta.sampleRate);
+      return true;
+    }
+    position += 8 + chunkSize + (chunkSize & 1);
+  }
+  return false;
+}
+
+//fills a sidecar record from the file itself, channels stays 0 if it cannot be played
+void parseSongMeta(uint16_t song, WaveMeta &meta) {
+  memset(&meta, 0, sizeof(meta));
+  strncpy(meta.name, songName(song), SONG_META_NAME - 1);
+  meta.fileSize = songIndex[song].size;
+  meta.modified = songIndex[song].modified;
+
+  char filename[SONG_NAME_MAX + 5];
+  songFilename(song, filename, sizeof(filename));
+  File file = SD.open(filename);
+  if (!file) {
+    return;
+  }
+  meta.fileSize = file.size();
+  if (!parseWaveHeader(file, meta)) {
+    meta.channels = 0;
+  }
+  file.close();
+}
+
+const char *songMetaFilename(uint16_t slot) {
+  return slot ? SONG_META_FILE_1 : SONG_META_FILE_0;
+}
+
+//opens the sidecar that belongs to the current index, false if it does not match
+bool openSongMeta() {
+  if (songMeta) {
+    songMeta.close();
+  }
+  songMeta = SD.open(songMetaFilename(songMetaSlot));
+  if (!songMeta) {
+    return false;
+  }
+  WaveMetaHeader header;
+  if (songMeta.read((uint8_t *)&header, sizeof(header)) != sizeof(header)
+      || header.magic != SONG_META_MAGIC
+      || header.version != SONG_META_VERSION
+      || header.count != songCount) {
+    songMeta.close();
+    songMeta = File();
+    return false;
+  }
+  return true;
+}
+
+bool readSongMeta(uint16_t song, WaveMeta &meta) {
+  if (!songMeta || !songMeta.seek(sizeof(WaveMetaHeader) + (uint32_t)song * sizeof(WaveMeta))
+      || songMeta.read((uint8_t *)&meta, sizeof(meta)) != sizeof(meta)) {
+    return false;
+  }
+  return strncmp(meta.name, songName(song), SONG_META_NAME - 1) == 0;
+}
+
+//writes the sidecar for the current index into the other slot; records of
+//unchanged files are copied from the old sidecar (both are sorted by name),
+//only new files and files with a new size or write time are opened and parsed
+void rebuildSongMeta() {
+  unsigned long start = micros();
+  if (songMeta) {
+    songMeta.close();
+  }
+  File old = SD.open(songMetaFilename(songMetaSlot));
+  WaveMetaHeader oldHeader;
+  uint16_t oldRemaining = 0;
+  if (old && old.read((uint8_t *)&oldHeader, sizeof(oldHeader)) == sizeof(oldHeader)
+      && oldHeader.magic == SONG_META_MAGIC && oldHeader.version == SONG_META_VERSION) {
+    oldRemaining = oldHeader.count;
+  }
+
+  uint16_t newSlot = songMetaSlot ^ 1;
+  SD.remove(songMetaFilename(newSlot));
+  File out = SD.open(songMetaFilename(newSlot), FILE_WRITE);
+  if (!out) {
+    Log.println("Cannot write song metadata");
+    if (old) {
+      old.close();
+    }
+    return;
+  }
+  WaveMetaHeader header = { SONG_META_MAGIC, SONG_META_VERSION, songCount };
+  out.write((const uint8_t *)&header, sizeof(header));
+
+  WaveMeta oldRecord;
+  bool haveOld = false;
+  uint16_t reused = 0;
+  for (uint16_t song = 0; song < songCount; song++) {
+    const char *name = songName(song);
+    while (true) {
+      if (!haveOld && oldRemaining > 0) {
+        haveOld = old.read((uint8_t *)&oldRecord, sizeof(oldRecord)) == sizeof(oldRecord);
+        oldRemaining = haveOld ? oldRemaining - 1 : 0;
+      }
+      if (!haveOld || strncmp(oldRecord.name, name, SONG_META_NAME - 1) >= 0) {
+        break;
+      }
+      haveOld = false;
+    }
+
+    WaveMeta record;
+    if (haveOld && strncmp(oldRecord.name, name, SONG_META_NAME - 1) == 0 && oldRecord.fileSize == songIndex[song].size
+        && oldRecord.modified == songIndex[song].modified) {
+      record = oldRecord;
+      reused++;
+    } else {
+      parseSongMeta(song, record);
+    }
+    out.write((const uint8_t *)&record, sizeof(record));
+  }
+  out.close();
+  if (old) {
+    old.close();
+  }
+
+  songMetaSlot = newSlot;
+  openSongMeta();
+
+  Log.print("Song metadata: ");
+  Log.print(reused);
+  Log.print(" reused, ");
+  Log.print(songCount - reused);
+  Log.print(" parsed in ");
+  Log.print(micros() - start);
+  Log.println(" us");
+}
+
+//reads the root directory up to its next .wav file, false at its end. File has no
+//write time, so the 32-byte FAT entries are read from the directory file itself.
+bool nextSongFile(File &root, SongFile &file) {
+  dir_t entry;
+  while (root.read((uint8_t *)&entry, sizeof(entry)) == sizeof(entry)) {
+    if (entry.name[0] == DIR_NAME_FREE) {
+      return false;
+    }
+    if (entry.name[0] != DIR_NAME_DELETED && DIR_IS_FILE(&entry) && memcmp(&entry.name[8], "WAV", 3) == 0) {
+      SdFile::dirName(entry, file.name);
+      file.size = entry.fileSize;
+      file.modified = ((uint32_t)entry.lastWriteDate << 16) | entry.lastWriteTime;
+      return true;
     }
+  }
+  return false;
+}
 
-    Serial.print("Received command: ");
-    Serial.println(incomingCommand);
+//scans the root directory once and sorts the .wav files by normalized name
+void buildSongIndex() {
+  songCount = 0;
+  songNamesUsed = 0;
+  songFiles = 0;
 
-    if (incomingCommand.equalsIgnoreCase("PAUSE")) {
-      if (AudioOutI2S.isPlaying()) {
-        AudioOutI2S.pause();
-        isPaused = true;
-        Serial.println();
-        Serial.println("Playback paused.");
+  File root = SD.open("/");
+  if (!root) {
+    Log.println("Cannot open SD root directory");
+    return;
+  }
+  SongFile file;
+  while (nextSongFile(root, file)) {
+    char normalized[SONG_NAME_MAX];
+    size_t len = normalizeSongName(file.name, normalized, sizeof(normalized));
+    //the files that do not fit are still counted, the check at startup compares the count
+    if (songCount < songFiles || songCount >= SONG_INDEX_MAX_SONGS || songNamesUsed + len + 1 > SONG_INDEX_NAME_POOL) {
+      if (songCount == songFiles) {
+        Log.println("Song index full, remaining files skipped");
       }
+    }
+    else {
+      songIndex[songCount].nameOffset = songNamesUsed;
+      songIndex[songCount].size = file.size;
+      songIndex[songCount].modified = file.modified;
+      memcpy(&songNames[songNamesUsed], normalized, len + 1);
+      songNamesUsed += len + 1;
+      songCount++;
+    }
+    songFiles++;
+  }
+  root.close();
+
+  qsort(songIndex, songCount, sizeof(SongEntry), compareSongEntries);
+  rebuildSongMeta();
+  saveSongIndex();
+}
+
+//one pass over the root directory: false if a .wav file was added, removed, renamed,
+//resized or rewritten since the index was built. When the index is full, a renamed file that
+//it skipped goes unnoticed.
+bool songIndexCurrent() {
+  File root = SD.open("/");
+  if (!root) {
+    return false;
+  }
+  bool current = true;
+  uint16_t files = 0;
+  SongFile file;
+  while (current && nextSongFile(root, file)) {
+    int song = findSong(file.name);
+    if (song >= 0) {
+      current = songIndex[song].size == file.size && songIndex[song].modified == file.modified;
+    }
+    else {
+      current = songCount < songFiles;
+    }
+    files++;
+  }
+  root.close();
+  return current && files == songFiles;
+}
+
+void initSongIndex(bool forceRebuild) {
+  unsigned long start = micros();
+  bool cached = !forceRebuild && loadSongIndex();
+  if (cached && !songIndexCurrent()) {
+    Log.println("Song index out of date, rebuilding");
+    cached = false;
+  }
+  if (!cached) {
+    buildSongIndex();
+  }
+  else if (!openSongMeta()) {
+    rebuildSongMeta();
+    saveSongIndex();
+  }
+  unsigned long elapsed = micros() - start;
+
+  Log.print(cached ? "Song index loaded from cache: " : "Song index built: ");
+  Log.print(songCount);
+  Log.print(" songs in ");
+  Log.print(elapsed);
+  Log.println(" us");
+
+#ifdef SONG_INDEX_BENCHMARK
+  //compare the old per-command path (SD.exists) with the index lookup
+  unsigned long existsTotal = 0;
+  unsigned long indexTotal = 0;
+  for (uint16_t song = 0; song < songCount; song++) {
+    char filename[SONG_NAME_MAX + 5];
+    songFilename(song, filename, sizeof(filename));
+    unsigned long t0 = micros();
+    SD.exists(filename);
+    unsigned long t1 = micros();
+    findSong(songName(song));
+    unsigned long t2 = micros();
+    existsTotal += t1 - t0;
+    indexTotal += t2 - t1;
+  }
+  if (songCount > 0) {
+    Log.print("Average SD.exists(): ");
+    Log.print(existsTotal / songCount);
+    Log.print(" us, average index lookup: ");
+    Log.print(indexTotal / songCount);
+    Log.println(" us");
+  }
+#endif
+}
+
+//logs command-to-first-sample time and lets the Tiva start the motor
+void reportSongStart(unsigned long firstSample, const char *path) {
+  Log.print("Playing: ");
+  Log.println(currentSong);
+  Log.print("Command to first sample: ");
+  Log.print(firstSample - commandMicros);
+  Log.print(" us (");
+  Log.print(path);
+  Log.println(")");
+  Serial1.println("RESUME");
+  Log.println();
+}
+
+bool queuePush(uint16_t song) {
+  if (queueCount >= PLAYLIST_MAX) {
+    return false;
+  }
+  playQueue[(queueHead + queueCount) % PLAYLIST_MAX] = song;
+  queueCount++;
+  return true;
+}
+
+int queueFront() {
+  return queueCount > 0 ? playQueue[queueHead] : -1;
+}
+
+int queuePop() {
+  if (queueCount == 0) {
+    return -1;
+  }
+  uint16_t song = playQueue[queueHead];
+  queueHead = (queueHead + 1) % PLAYLIST_MAX;
+  queueCount--;
+  return song;
+}
+
+//Fisher-Yates over the queue, starting at position first
+void queueShuffle(uint8_t first) {
+  for (uint8_t i = queueCount; i > first + 1; i--) {
+    uint8_t j = first + random(i - first);
+    uint16_t *a = &playQueue[(queueHead + i - 1) % PLAYLIST_MAX];
+    uint16_t *b = &playQueue[(queueHead + j) % PLAYLIST_MAX];
+    uint16_t song = *a;
+    *a = *b;
+    *b = song;
+  }
+}
+
+//opens the head of the queue while the current song plays so the transition is gapless
+void preloadQueueHead() {
+  if (playingIndexed) {
+    indexedWave.preload(queueFront());
+  }
+}
+
+void announceTrack(int song) {
+  Serial1.print("TRACK ");
+  Serial1.println(songName(song));
+  Log.print("Now playing: ");
+  Log.println(songName(song));
+}
+
+void commandReaderReset(CommandReader &reader) {
+  reader.length = 0;
+  reader.overflow = false;
+  reader.buffer[0] = '\0';
+}
+
+//terminates and trims the pending line, true if it holds a command
+bool commandReaderFinish(CommandReader &reader) {
+  uint8_t length = reader.length;
+  while (length > 0 && (reader.buffer[length - 1] == ' ' || reader.buffer[length - 1] == '\t')) {
+    length--;
+  }
+  reader.buffer[length] = '\0';
+  uint8_t start = 0;
+  while (start < length && (reader.buffer[start] == ' ' || reader.buffer[start] == '\t')) {
+    start++;
+  }
+  if (start > 0) {
+    memmove(reader.buffer, &reader.buffer[start], length - start + 1);
+    length -= start;
+  }
+  reader.length = length;
+
+  if (reader.overflow) {
+    Log.println("Command too long, dropped");
+    commandReaderReset(reader);
+    return false;
+  }
+  return length > 0;
+}
+
+//adds one received byte, true when a complete command is ready
+bool commandReaderPush(CommandReader &reader, char c) {
+  reader.lastByteMillis = millis();
+  if (c == '\n' || c == '\r') {
+    if (reader.length == 0 && !reader.overflow) {
+      return false;
+    }
+    return commandReaderFinish(reader);
+  }
+  if (reader.length < COMMAND_MAX_LENGTH) {
+    reader.buffer[reader.length++] = c;
+  } else {
+    reader.overflow = true;
+  }
+  return false;
+}
+
+//never blocks: consumes what Serial1 has buffered and returns true once a line is complete
+bool pollCommand(CommandReader &reader) {
+  int pending = Serial1.available();
+  while (pending-- > 0) {
+    if (commandReaderPush(reader, (char)Serial1.read())) {
+      return true;
+    }
+  }
+  //commands without a line ending are ended by a quiet line
+  if ((reader.length > 0 || reader.overflow) && millis() - reader.lastByteMillis >= COMMAND_IDLE_MS) {
+    return commandReaderFinish(reader);
+  }
+  return false;
+}
+
+//true once the song is playing or, for an indexed song, starting
+bool playSong(int song, const char *command) {
+  char filename[SONG_NAME_MAX + 5];
+  if (song < 0) {
+    normalizeSongName(command, filename, SONG_NAME_MAX);
+    strcat(filename, ".wav");
+    Log.print("File not found on SD: ");
+    Log.println(filename);
+    sendSuggestions(command);
+    return false;
+  }
+  songFilename(song, filename, sizeof(filename));
+
+  if (AudioOutI2S.isPlaying() || isPaused) {
+    AudioOutI2S.stop();
+    delay(100); // Allow I2S hardware to reset
+    isPaused = false;
+  }
+  Log.print("Loading new song: ");
+  Log.println(filename);
+  WaveMeta meta;
+  //cached metadata: seek to the data offset, RESUME is sent once I2S pulls samples
+  if (readSongMeta(song, meta) && meta.channels == 2 && indexedWave.open(song, filename, meta)
+      && AudioOutI2S.canPlay(indexedWave) && AudioOutI2S.play(indexedWave)) {
+    songDone = false;
+    songStarted = false;
+    strcpy(currentSong, filename);
+    isPaused = false;
+    playingIndexed = true;
+    seenTrackChanges = indexedWave.trackChanges;
+    preloadQueueHead();
+    return true;
+  }
+  //no usable metadata (mono, resized file...): let SDWaveFile parse the header
+  else {
+    indexedWave.close();
+    playingIndexed = false;
+    waveFile = SDWaveFile(filename);
+    if (waveFile && AudioOutI2S.canPlay(waveFile)) {
+      AudioOutI2S.play(waveFile);
+      songDone = false;
+      delay(200);
+      while (!AudioOutI2S.isPlaying()){
+        delay(10);
+      }
+      strcpy(currentSong, filename);
+      isPaused = false;
+      songStarted = true;
+      reportSongStart(micros(), "header parse");
+      return true;
     } 
-    else if (incomingCommand.equalsIgnoreCase("RESUME")) {
-      if (isPaused && !currentSong.isEmpty()) {
-        Serial.println("Resuming song...");
-        if (AudioOutI2S.resume()) {
-          isPaused = false;
-          Serial.println();
-          Serial.println("Playback resumed.");
-        }
-        }
+    Log.println("Cannot play the wave file!");
+  }
+  return false;
+}
+
+//"mm:ss" or "ss" to milliseconds, false if it is not a time
+bool parseTime(const char *text, uint32_t &ms) {
+  if (!isdigit((unsigned char)*text)) {
+    return false;
+  }
+  char *end;
+  uint32_t seconds = strtoul(text, &end, 10);
+  if (*end == ':') {
+    if (!isdigit((unsigned char)end[1])) {
+      return false;
+    }
+    uint32_t part = strtoul(end + 1, &end, 10);
+    if (part >= 60) {
+      return false;
+    }
+    seconds = seconds * 60 + part;
+  }
+  ms = seconds * 1000;
+  return *end == '\0';
+}
+
+//sends ms as "m:ss"
+void sendTime(uint32_t ms) {
+  uint32_t seconds = ms / 1000;
+  Serial1.print(seconds / 60);
+  Serial1.print(seconds % 60 < 10 ? ":0" : ":");
+  Serial1.print(seconds % 60);
+}
+
+//strcasecmp: ignores differences in uppercase and lowercase letters
+void handleCommand(const char *command) {
+  commandMicros = micros();
+  Log.print("Received command: ");
+  Log.println(command);
+
+  if (strcasecmp(command, "PAUSE") == 0) {
+    if (AudioOutI2S.isPlaying()) {
+      AudioOutI2S.pause();
+      isPaused = true;
+      Log.println();
+      Log.println("Playback paused.");
+    }
+  } 
+  else if (strcasecmp(command, "RESUME") == 0) {
+    if (isPaused && currentSong[0] != '\0') {
+      Log.println("Resuming song...");
+      if (AudioOutI2S.resume()) {
+        isPaused = false;
+        Log.println();
+        Log.println("Playback resumed.");
       }
-    
-    //control volume: AudioOutI2S.volume(level) 
-    //level is between 0 and 20
-    else if (incomingCommand.equalsIgnoreCase("VOLUME UP")) {
-      if (currentVol < 20){
-      currentVol ++;
+    }
+  }
+  
+  //control volume: AudioOutI2S.volume(level) 
+  //level is between 0 and 20
+  else if (strcasecmp(command, "VOLUME UP") == 0) {
+    if (currentVol < 20){
+    currentVol ++;
+    AudioOutI2S.volume(currentVol);
+    Log.print("Volume increase to: \n");
+    Log.println(currentVol);
+    }
+  }
+  else if (strcasecmp(command, "VOLUME DOWN") == 0) {
+    //lowers volume
+    if (currentVol > 0) {
+      currentVol --;
       AudioOutI2S.volume(currentVol);
-      Serial.print("Volume increase to: \n");
-      Serial.println(currentVol);
+      Log.println();
+      Log.println("Volume decrease to: ");
+      Log.println(currentVol);
+    }
+  }
+  //"VOLUME <level>" is sent by the Tiva at power-up with the level it saved
+  else if (strncasecmp(command, "VOLUME ", 7) == 0 && isdigit((unsigned char)command[7])) {
+    currentVol = constrain(atoi(command + 7), 0, 20);
+    AudioOutI2S.volume(currentVol);
+    Log.print("Volume set to: ");
+    Log.println(currentVol);
+  }
+
+  //"SEEK mm:ss" answers "SEEK m:ss" with the new position, or "SEEK ERROR"
+  else if (strncasecmp(command, "SEEK ", 5) == 0) {
+    uint32_t ms;
+    if (playingIndexed && currentSong[0] != '\0' && parseTime(command + 5, ms) && indexedWave.seek(ms)) {
+      Serial1.print("SEEK ");
+      sendTime(ms);
+      Serial1.println();
+      Log.print("Seek to ");
+      Log.print(ms);
+      Log.println(" ms");
+    }
+    else {
+      Serial1.println("SEEK ERROR");
+    }
+  }
+
+  //"POS?" answers "POS m:ss/m:ss", or "POS NONE" when no song is loaded
+  else if (strcasecmp(command, "POS?") == 0) {
+    if (playingIndexed && currentSong[0] != '\0') {
+      Serial1.print("POS ");
+      sendTime(indexedWave.positionMs());
+      Serial1.print("/");
+      sendTime(indexedWave.currentMeta().durationMs);
+      Serial1.println();
+    }
+    else {
+      Serial1.println("POS NONE");
+    }
+  }
+
+  //"ENQUEUE <title>" plays right away when idle, otherwise it joins the queue
+  else if (strncasecmp(command, "ENQUEUE ", 8) == 0) {
+    int song = findSong(command + 8);
+    if (song < 0) {
+      sendSuggestions(command + 8);
+    }
+    else if (currentSong[0] == '\0' && !isPaused) {
+      playSong(song, command + 8);
+    }
+    else if (!queuePush(song)) {
+      Log.println("Queue is full");
+    }
+    else {
+      if (queueCount == 1) {
+        preloadQueueHead();
       }
+      Log.print("Queued: ");
+      Log.print(songName(song));
+      Log.print(" (");
+      Log.print(queueCount);
+      Log.println(" in queue)");
+    }
+  }
+
+  else if (strcasecmp(command, "NEXT") == 0) {
+    if (queueCount == 0) {
+      Log.println("Queue is empty");
+    }
+    //the preloaded track takes over inside the I2S callback
+    else if (playingIndexed && !isPaused && indexedWave.nextReady()) {
+      indexedWave.skip();
     }
-   else if (incomingCommand.equalsIgnoreCase("VOLUME DOWN")) {
-      //lowers volume
-      if (currentVol >= 0) {
-        currentVol --;
-        AudioOutI2S.volume(currentVol);
-        Serial.println();
-        Serial.println("Volume decrease to: ");
-        Serial.println(currentVol);
+    else {
+      int song = queuePop();
+      if (playSong(song, songName(song))) {
+        announceTrack(song);
       }
     }
+  }
+
+  //the head stays put while it is being preloaded
+  else if (strcasecmp(command, "SHUFFLE") == 0) {
+    queueShuffle(playingIndexed ? 1 : 0);
+    Log.println("Queue shuffled");
+  }
+
+  else if (strcasecmp(command, "CLEAR") == 0) {
+    queueCount = 0;
+    indexedWave.preload(-1);
+    Log.println("Queue cleared");
+  }
 
+  //rescan the SD card after songs were added or removed. The rescan rewrites
+  //the index and the metadata the playing song and the queue rely on.
+  else if (strcasecmp(command, "REINDEX") == 0) {
+    if (currentSong[0] != '\0' || isPaused) {
+      Log.println("Cannot reindex while a song is playing");
+    }
     else {
-      // Assume new song name
-      String filename = incomingCommand + ".wav";
-      if (SD.exists(filename.c_str())) {
-        if (AudioOutI2S.isPlaying() || isPaused) {
-          AudioOutI2S.stop();
-          delay(100); // Allow I2S hardware to reset
-          isPaused = false;
-        }
-        Serial.println("Loading new song: " + filename);
-        waveFile = SDWaveFile(filename.c_str());
-        if (waveFile && AudioOutI2S.canPlay(waveFile)) {
-          AudioOutI2S.play(waveFile);
-          songDone = false;
-          delay(200);
-          while (!AudioOutI2S.isPlaying()){
-            delay(10);
-          }
-          currentSong = filename;
-          isPaused = false;
-          Serial.println("Playing: " + filename);
-          Serial1.println("RESUME");
-          Serial.println();
-        } 
-        else {
-          Serial.println("Cannot play the wave file!");
+      initSongIndex(true);
+    }
+  }
+
+  //"SEARCH <text>" only returns suggestions, nothing is played
+  else if (strncasecmp(command, "SEARCH ", 7) == 0) {
+    sendSuggestions(command + 7);
+  }
+
+  else {
+    // Assume new song name
+    unsigned long lookupStart = micros();
+    int song = findSong(command);
+    unsigned long lookupTime = micros() - lookupStart;
+    Log.print("Index lookup: ");
+    Log.print(lookupTime);
+    Log.println(" us");
+    playSong(song, command);
+  }
+}
+
+#ifdef COMMAND_STRESS_TEST
+extern "C" char *sbrk(int increment);
+
+int freeHeap() {
+  char top;
+  return &top - sbrk(0);
+}
+
+//replays COMMAND_STRESS_COUNT commands through the same reader and dispatcher,
+//split into random chunks, and reports heap and the slowest reader/dispatch call
+void runCommandStressTest() {
+  static const char *const commands[] = {
+    "VOLUME UP\n", "VOLUME DOWN\r\n", "PAUSE\n", "RESUME\n", "  volume up  \n",
+    "no such song\n", "SEARCH hap\n", "REINDEX-NOT\n",
+    "this line is far too long to be a command and must be dropped without touching the heap at all\n"
+  };
+  const int commandTypes = sizeof(commands) / sizeof(commands[0]);
+  CommandReader reader;
+  commandReaderReset(reader);
+
+  int heapBefore = freeHeap();
+  unsigned long worstStall = 0;
+  unsigned long start = millis();
+  randomSeed(analogRead(A0));
+
+  for (long i = 0; i < COMMAND_STRESS_COUNT; i++) {
+    //searches write to Serial1, keep them rare so the link does not dominate
+    int type = random(commandTypes);
+    if ((type == 5 || type == 6) && random(50) != 0) {
+      type = 0;
+    }
+    const char *text = commands[type];
+    size_t length = strlen(text);
+    size_t sent = 0;
+    while (sent < length) {
+      size_t chunk = 1 + random(8);
+      unsigned long t0 = micros();
+      for (size_t k = 0; k < chunk && sent < length; k++, sent++) {
+        if (commandReaderPush(reader, text[sent])) {
+          handleCommand(reader.buffer);
+          commandReaderReset(reader);
         }
-      } 
-      else {
-        Serial.println("File not found on SD: " + filename);
+      }
+      unsigned long elapsed = micros() - t0;
+      if (elapsed > worstStall) {
+        worstStall = elapsed;
       }
     }
   }
 
-  // Check if song ended naturally
-  if (!AudioOutI2S.isPlaying() && !isPaused && !currentSong.isEmpty() && !songDone) {
-    Serial1.println("PAUSE");
-    Serial.println("Finished playing: " + currentSong);
-    currentSong = "";
-    waveFile = SDWaveFile(); 
-    songDone = true;
+  Log.print("Stress test: ");
+  Log.print(COMMAND_STRESS_COUNT);
+  Log.print(" commands in ");
+  Log.print(millis() - start);
+  Log.print(" ms, free heap before/after: ");
+  Log.print(heapBefore);
+  Log.print("/");
+  Log.print(freeHeap());
+  Log.print(" bytes, worst stall: ");
+  Log.print(worstStall);
+  Log.println(" us");
+}
+#endif
+
+//PAUSE, RESUME, VOLUME and POS? work before the SD card is mounted, the rest waits for the index
+bool commandNeedsSongs(const char *command) {
+  return strcasecmp(command, "PAUSE") != 0 && strcasecmp(command, "RESUME") != 0
+         && strncasecmp(command, "VOLUME", 6) != 0 && strcasecmp(command, "POS?") != 0;
+}
+
+void reportBoot() {
+  Log.print("Boot: link ");
+  Log.print(bootLinkMicros);
+  Log.print(" us, SD mount ");
+  Log.print(bootMountMicros);
+  Log.print(" us (");
+  Log.print(sdAttempts);
+  Log.print(" attempts), song index ");
+  Log.print(bootIndexMicros);
+  Log.print(" us, songs playable ");
+  Log.print(millis());
+  Log.println(" ms after power-up");
+}
+
+//runs one startup phase; the SD card is retried every SD_RETRY_MS until it mounts
+void bootStep() {
+  unsigned long start = micros();
+  switch (bootPhase) {
+    case BOOT_SD_MOUNT:
+      if (sdAttempts > 0 && millis() - sdFailedMillis < SD_RETRY_MS) {
+        return;
+      }
+      sdAttempts++;
+      if (!SD.begin()) {
+        sdFailedMillis = millis();
+        bootMountMicros += micros() - start;
+        Log.println("SD initialization failed, retrying");
+        return;
+      }
+      bootMountMicros += micros() - start;
+      Log.println("SD card initialized.");
+      bootPhase = BOOT_SONG_INDEX;
+      break;
+
+    case BOOT_SONG_INDEX:
+      initSongIndex(false);
+      bootIndexMicros = micros() - start;
+      bootPhase = BOOT_DONE;
+      reportBoot();
+#ifdef COMMAND_STRESS_TEST
+      runCommandStressTest();
+#endif
+      break;
+
+    case BOOT_DONE:
+      break;
   }
 }
 
+void setup() {
+  unsigned long start = micros();
+#if USB_LOG
+  Serial.begin(9600);//115200
+#endif
+  Serial1.begin(9600);
+  AudioOutI2S.volume(currentVol); // default volume
+  commandReaderReset(commandReader);
+  randomSeed(analogRead(A0));
+
+  //goes out while the SD card mounts, the Tiva can send commands straight away
+  Serial1.println("READY");
+  bootLinkMicros = micros() - start;
+}
+
+void loop() {
+  if (bootPhase != BOOT_DONE) {
+    bootStep();
+  }
 
+  if (bootPhase == BOOT_DONE && heldCommand[0] != '\0') {
+    handleCommand(heldCommand);
+    heldCommand[0] = '\0';
+  }
 
+  //reading goes on during startup, only the last command that needs the songs is held
+  if (pollCommand(commandReader)) {
+    if (bootPhase != BOOT_DONE && commandNeedsSongs(commandReader.buffer)) {
+      if (heldCommand[0] != '\0') {
+        Log.print("Held command replaced: ");
+        Log.println(heldCommand);
+      }
+      strcpy(heldCommand, commandReader.buffer);
+    }
+    else {
+      handleCommand(commandReader.buffer);
+    }
+    commandReaderReset(commandReader);
+  }
 
+  // Indexed songs start asynchronously, tell the Tiva once audio is flowing
+  if (!songStarted && currentSong[0] != '\0' && indexedWave.firstSampleMicros != 0) {
+    songStarted = true;
+    reportSongStart(indexedWave.firstSampleMicros, "cached metadata");
+  }
+
+  // The I2S callback moved on to the preloaded song without stopping
+  if (indexedWave.trackChanges != seenTrackChanges) {
+    seenTrackChanges = indexedWave.trackChanges;
+    queuePop();
+    int song = indexedWave.currentSong();
+    songFilename(song, currentSong, sizeof(currentSong));
+    announceTrack(song);
+    preloadQueueHead();
+  }
 
+  // Check if song ended naturally
+  if (songStarted && !AudioOutI2S.isPlaying() && !isPaused && currentSong[0] != '\0' && !songDone) {
+    Log.print("Finished playing: ");
+    Log.println(currentSong);
+    currentSong[0] = '\0';
+    waveFile = SDWaveFile(); 
+    indexedWave.close();
+    playingIndexed = false;
+    songDone = true;
 
+    //queued songs that could not be chained (other format) restart playback
+    int song = queuePop();
+    if (song >= 0) {
+      commandMicros = micros();
+      if (playSong(song, songName(song))) {
+        announceTrack(song);
+      }
+      else {
+        Serial1.println("PAUSE");
+      }
+    }
+    else {
+      Serial1.println("PAUSE");
+    }
+  }
+}
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+"""Decodes the tokenized log frames of the music box firmware.
+
+UART0 carries log frames (see Log.h) mixed with plain text reports. Read a capture
+of the raw bytes, or the serial port itself, and print the messages as text:
+
+    python3 tools/log_decode.py capture.bin
+    stty -F /dev/ttyACM0 115200 raw && python3 tools/log_decode.py /dev/ttyACM0
+    music_box_sim --capture console.bin Simulator/Scenarios/log.sim
+    python3 tools/log_decode.py console.bin --dictionary build/log_dictionary.json
+
+The messages come from the log_dictionary.json generated by the build, or from
+Log_Messages.h directly when no dictionary is given.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+import log_dictionary
+
+LOG_MESSAGES = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "Log_Messages.h")
+FRAME_SYNC = 0xFE
+
+
+def read_varint(payload, position):
+	value = 0
+	shift = 0
+	while True:
+		if position >= len(payload):
+			raise ValueError("truncated varint")
+		byte = payload[position]
+		position += 1
+		value |= (byte & 0x7F) << shift
+		shift += 7
+		if byte < 0x80:
+			return value, position
+
+
+def format_message(message, payload):
+	arguments = []
+	position = 0
+	for kind in message["types"]:
+		if kind == "s":
+			length, position = read_varint(payload, position)
+			arguments.append(payload[position:position + length].decode("latin-1"))
+			position += length
+		else:
+			value, position = read_varint(payload, position)
+			if kind == "d":
+				value = (value >> 1) ^ -(value & 1)
+			arguments.append(value)
+	if position != len(payload):
+		raise ValueError("%d bytes left over" % (len(payload) - position))
+
+	# %u is not a Python conversion
+	text = re.sub(r"%([-+ #0]*\d*)u", r"%\1d", message["format"])
+	return "[%s] %s" % (message["level"], text % tuple(arguments))
+
+
+class Decoder:
+	def __init__(self, messages, output):
+		self.messages = {message["token"]: message for message in messages}
+		self.output = output
+		self.pending = bytearray()
+		self.text = bytearray()
+
+	def flush_text(self):
+		if self.text:
+			self.output.write(self.text.decode("latin-1"))
+			self.text.clear()
+
+	def feed(self, data):
+		self.pending += data
+		while self.pending:
+			if self.pending[0] != FRAME_SYNC:
+				byte = self.pending.pop(0)
+				if byte != 0x0D:
+					self.text.append(byte)
+				if byte == 0x0A:
+					self.flush_text()
+				continue
+
+			if len(self.pending) < 3 or len(self.pending) < 3 + self.pending[2]:
+				return
+
+			token = self.pending[1]
+			payload = bytes(self.pending[3:3 + self.pending[2]])
+			del self.pending[:3 + len(payload)]
+
+			# A frame can interrupt a text line only if the firmware logged from an interrupt
+			self.flush_text()
+			message = self.messages.get(token)
+			try:
+				if message is None:
+					raise ValueError("unknown token %d" % token)
+				line = format_message(message, payload)
+			except ValueError as error:
+				line = "[?] undecodable frame %s (%s)" % (payload.hex(), error)
+			self.output.write(line + "\n")
+			self.output.flush()
+
+	def finish(self):
+		self.flush_text()
+		if self.pending:
+			self.output.write("[?] %d bytes of an incomplete frame\n" % len(self.pending))
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Decode the tokenized UART0 log of the music box")
+	parser.add_argument("input", help="capture file or serial device, - for stdin")
+	parser.add_argument("--dictionary", help="log_dictionary.json generated by the build")
+	parser.add_argument("--messages", default=LOG_MESSAGES, help="Log_Messages.h, used without --dictionary")
+	args = parser.parse_args()
+
+	if args.dictionary:
+		with open(args.dictionary) as file:
+			messages = json.load(file)["messages"]
+	else:
+		messages = log_dictionary.load(args.messages)
+
+	decoder = Decoder(messages, sys.stdout)
+	stream = sys.stdin.buffer if args.input == "-" else open(args.input, "rb", buffering=0)
+	try:
+		while True:
+			data = stream.read(256)
+			if not data:
+				break
+			decoder.feed(data)
+	except KeyboardInterrupt:
+		pass
+	decoder.finish()
+
+
+if __name__ == "__main__":
+	main()
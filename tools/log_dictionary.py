@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+"""Builds the host-side dictionary of the tokenized log messages.
+
+Reads the LOG_MESSAGE entries of Log_Messages.h and writes them as JSON, indexed by
+token, for tools/log_decode.py:
+
+    python3 tools/log_dictionary.py Log_Messages.h -o log_dictionary.json
+
+The CMake builds run it on every change of Log_Messages.h. It fails when the argument
+types of a message do not match the conversions of its format string.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+ENTRY = re.compile(r'^\s*LOG_MESSAGE\(\s*(\w+)\s*,\s*(\w+)\s*,\s*"([uds]*)"\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', re.M)
+CONVERSION = re.compile(r"%(%|[-+ #0]*\d*[a-z])")
+
+# Argument type expected by each printf conversion
+CONVERSION_TYPES = {"u": "u", "x": "u", "X": "u", "d": "d", "i": "d", "s": "s"}
+
+
+def load(path):
+	"""Returns the messages of Log_Messages.h as a list of dictionaries, in token order."""
+	with open(path) as file:
+		text = file.read()
+
+	messages = []
+	errors = []
+	for match in ENTRY.finditer(text):
+		name, level, types, format_string = match.groups()
+		format_string = bytes(format_string, "utf-8").decode("unicode_escape")
+
+		expected = ""
+		for conversion in CONVERSION.findall(format_string):
+			if conversion != "%":
+				expected += CONVERSION_TYPES.get(conversion[-1], "?")
+		if expected != types:
+			errors.append('%s: argument types "%s" do not match the format "%s"' % (name, types, format_string))
+
+		messages.append({
+			"token": len(messages),
+			"name": name,
+			"level": level.replace("LOG_LEVEL_", ""),
+			"types": types,
+			"format": format_string,
+		})
+
+	if not messages:
+		errors.append("no LOG_MESSAGE entries found")
+	if errors:
+		sys.exit("\n".join("%s: %s" % (path, error) for error in errors))
+	return messages
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Generate log_dictionary.json from Log_Messages.h")
+	parser.add_argument("messages", help="path to Log_Messages.h")
+	parser.add_argument("-o", "--output", required=True, help="JSON file to write")
+	args = parser.parse_args()
+
+	messages = load(args.messages)
+	with open(args.output, "w") as file:
+		json.dump({"source": "Log_Messages.h", "messages": messages}, file, indent=1)
+		file.write("\n")
+
+
+if __name__ == "__main__":
+	main()
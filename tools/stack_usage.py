@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+"""Computes the worst-case stack depth of the music box firmware from the call graph.
+
+GCC writes a .ci file next to each object when it compiles with
+-fcallgraph-info=su: the functions defined in the file with their frame size, and
+the calls they make. The board build of CMakeLists.txt compiles with it and runs
+
+    python3 tools/stack_usage.py --stack-size 0x200 -o music_box_O0_stack.txt <objects or .ci files>
+
+The worst case of each entry point (main and every *_Handler) is its own frame
+plus the deepest of its callees. A handler can preempt main and the handlers of a
+lower priority, and the core pushes an exception frame on the stack each time.
+Handlers of the same priority never preempt each other, so the total adds to main
+the deepest handler of each priority in PRIORITIES and its frame. A handler that is
+not in PRIORITIES is counted as a priority of its own, which is the worst case,
+except the timer handlers: GPTM_Timer.c defines all 24, and those of the sub-timers
+that are not in use are left out. Keep PRIORITIES in step with Interrupt_Priorities.h.
+
+Calls through a function pointer are resolved with INDIRECT_CALLS below; update it
+when a new callback is registered. Library functions (strstr, atoi, ...) are not in
+the call graph and are listed as not analyzed.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+# Functions called through a pointer, by the function that makes the call
+INDIRECT_CALLS = {
+	"System_Clock_Notify": ["UART0_Clock_Changed", "UART3_Clock_Changed", "UART_BLE_Clock_Changed", "Stepper_Motor_Clock_Changed"],
+	"GPTM_Timer_Handle": ["Stepper_Motor_Timer_Expired", "UART_BLE_Idle_Expired"],
+	"UART_BLE_AT_Finish": ["BLE_Module_Ready", "BLE_Module_Report", "BLE_Module_Configured",
+		"BLE_Power_Saved", "BLE_Name_Saved"],
+	"PendSV_Handler": ["Stepper_Motor_Deferred"],
+}
+
+# Priority of each handler in use, from Interrupt_Priorities.h
+PRIORITIES = {
+	"SysTick_Handler": 0,
+	"TIMER0A_Handler": 1,
+	"UART1_Handler": 2,
+	"TIMER1A_Handler": 2,
+	"UART0_Handler": 3,
+	"PendSV_Handler": 7,
+}
+
+UNUSED_TIMER = re.compile(r"W?TIMER\d[AB]_Handler$")
+
+# Bytes pushed by the core on exception entry: R0 to R3, R12, LR, PC and xPSR, and
+# S0 to S15 and FPSCR as well when the interrupted code has used the FPU
+EXCEPTION_FRAME = 32
+EXCEPTION_FRAME_FPU = 104
+
+NODE = re.compile(r'node: \{ title: "([^"]*)" label: "([^"]*)"')
+EDGE = re.compile(r'edge: \{ sourcename: "([^"]*)" targetname: "([^"]*)"')
+FRAME = re.compile(r"(\d+) bytes \(([a-z,]+)\)")
+
+
+class Function:
+	def __init__(self, title, name):
+		self.title = title
+		self.name = name
+		self.frame = None
+		self.dynamic = False
+		self.callees = []
+
+
+def function_name(title, label):
+	"""Returns the plain name of a function from its label, without the signature."""
+	first = label.split("\\n")[0]
+	match = re.search(r"([A-Za-z_]\w*)\s*\(", first)
+	if match:
+		return match.group(1)
+	return title.split(":")[-1]
+
+
+def read_call_graph(paths):
+	functions = {}
+	edges = []
+
+	for path in paths:
+		with open(path) as file:
+			for line in file:
+				node = NODE.search(line)
+				if node:
+					title, label = node.groups()
+					function = functions.get(title)
+					if function is None:
+						function = functions[title] = Function(title, function_name(title, label))
+					frame = FRAME.search(label)
+					if frame:
+						function.frame = int(frame.group(1))
+						function.dynamic = frame.group(2) == "dynamic"
+					continue
+
+				edge = EDGE.search(line)
+				if edge:
+					edges.append(edge.groups())
+
+	by_name = {}
+	for function in functions.values():
+		if function.frame is not None:
+			by_name.setdefault(function.name, function)
+
+	unresolved = set()
+	for source, target in edges:
+		caller = functions.get(source)
+		if caller is None:
+			continue
+
+		if target == "__indirect_call":
+			targets = INDIRECT_CALLS.get(caller.name)
+			if targets is None:
+				unresolved.add("indirect call in %s" % caller.name)
+				continue
+		else:
+			callee = functions.get(target)
+			targets = [callee.name if callee else target.split(":")[-1]]
+
+		for name in targets:
+			callee = functions.get(target) if target != "__indirect_call" else None
+			if callee is None or callee.frame is None:
+				callee = by_name.get(name)
+			if callee is None:
+				unresolved.add("%s (not analyzed)" % name)
+				continue
+			if callee not in caller.callees:
+				caller.callees.append(callee)
+
+	return by_name, unresolved
+
+
+def worst_case(function, depths, active, problems):
+	"""Returns (bytes, path) of the deepest call chain starting at function."""
+	if function.title in depths:
+		return depths[function.title]
+
+	if function.title in active:
+		problems.add("recursion through %s" % function.name)
+		return 0, []
+	if function.dynamic:
+		problems.add("%s has a dynamic frame" % function.name)
+
+	active.add(function.title)
+	deepest, deepest_path = 0, []
+	for callee in function.callees:
+		depth, path = worst_case(callee, depths, active, problems)
+		if depth > deepest:
+			deepest, deepest_path = depth, path
+	active.discard(function.title)
+
+	result = (function.frame + deepest, [function.name] + deepest_path)
+	depths[function.title] = result
+	return result
+
+
+def ci_path(path):
+	"""Maps an object file to the .ci file GCC wrote next to it."""
+	if path.endswith(".ci"):
+		return path
+	return os.path.splitext(path)[0] + ".ci"
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+	parser.add_argument("inputs", nargs="+", help="object files or .ci files")
+	parser.add_argument("--stack-size", type=lambda value: int(value, 0), help="size of the stack to check against")
+	parser.add_argument("--fpu-frames", action="store_true", help="count exception frames with the floating-point context")
+	parser.add_argument("-o", "--output", help="write the report to this file instead of stdout")
+	args = parser.parse_args()
+
+	paths = []
+	for entry in args.inputs:
+		for path in entry.split("|"):
+			if path:
+				paths.append(ci_path(path))
+	missing = [path for path in paths if not os.path.exists(path)]
+	if missing:
+		sys.exit("no call graph for %s, compile with -fcallgraph-info=su" % ", ".join(missing))
+
+	functions, unresolved = read_call_graph(paths)
+	if "main" not in functions:
+		sys.exit("main not found in the call graph")
+
+	entries = [functions["main"]] + sorted(
+		(function for name, function in functions.items() if name.endswith("_Handler") and name != "Reset_Handler"
+			and (name in PRIORITIES or not UNUSED_TIMER.match(name))),
+		key=lambda function: function.name)
+
+	depths = {}
+	problems = set()
+	results = [(function.name,) + worst_case(function, depths, set(), problems) for function in entries]
+
+	frame = EXCEPTION_FRAME_FPU if args.fpu_frames else EXCEPTION_FRAME
+	main_depth = results[0][1]
+	levels = {}
+	for name, depth, path in results[1:]:
+		level = PRIORITIES.get(name, name)
+		levels[level] = max(levels.get(level, 0), depth)
+	handler_depth = sum(levels.values())
+	frames = frame * len(levels)
+	total = main_depth + handler_depth + frames
+
+	lines = ["%-28s %6s  %s" % ("Entry point", "Bytes", "Deepest path")]
+	for name, depth, path in results:
+		lines.append("%-28s %6d  %s" % (name, depth, " > ".join(path)))
+	lines.append("")
+	lines.append("Worst case: main %d + handlers %d + %d exception frames of %d bytes = %d bytes"
+		% (main_depth, handler_depth, len(levels), frame, total))
+
+	if args.stack_size:
+		if total <= args.stack_size:
+			lines.append("Stack size: %d bytes, %d bytes to spare" % (args.stack_size, args.stack_size - total))
+		else:
+			lines.append("Stack size: %d bytes, DOES NOT FIT by %d bytes" % (args.stack_size, total - args.stack_size))
+
+	for problem in sorted(problems | unresolved):
+		lines.append("Warning: %s" % problem)
+
+	report = "\n".join(lines) + "\n"
+	if args.output:
+		with open(args.output, "w") as file:
+			file.write(report)
+	else:
+		sys.stdout.write(report)
+
+
+if __name__ == "__main__":
+	main()
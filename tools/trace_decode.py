@@ -0,0 +1,201 @@
+#!/usr/bin/env python3
+"""Turns a TRACE dump of the music box firmware into a Chrome trace.
+
+The firmware prints its trace buffer over UART0 when it receives the BLE command
+"TRACE" (see Trace.h). Capture the serial terminal, or the --trace output of the
+simulator, to a file and convert it:
+
+    python3 tools/trace_decode.py capture.log -o trace.json
+
+Open trace.json in chrome://tracing or https://ui.perfetto.dev. Each exception
+(thread mode, SysTick, Timer 0A, ...) gets its own track, events ending in _BEGIN /
+_END become durations, and the interval between stepper steps is plotted as a
+counter so its jitter can be compared with the UART activity.
+
+The event names are read from the Trace_Event_ID enum in Trace.h. When the capture
+holds several dumps, the last one is used.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+TRACE_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "Trace.h")
+
+# Exception numbers of the TM4C123GH6PM used by the firmware, others are shown as IRQ n
+EXCEPTION_NAMES = {
+	0: "Thread mode",
+	11: "SVCall",
+	14: "PendSV",
+	15: "SysTick",
+	16 + 5: "UART0",
+	16 + 6: "UART1 (BLE)",
+	16 + 19: "Timer 0A",
+	16 + 59: "UART3",
+}
+
+
+def read_event_names(header):
+	"""Returns the event names of the Trace_Event_ID enum, indexed by their value."""
+	with open(header) as file:
+		text = file.read()
+
+	match = re.search(r"typedef enum\s*\{(.*?)\}\s*Trace_Event_ID;", text, re.S)
+	if not match:
+		sys.exit("%s: Trace_Event_ID enum not found" % header)
+
+	names = []
+	for line in match.group(1).splitlines():
+		line = line.split("//")[0].strip().rstrip(",")
+		if line and line != "TRACE_EVENT_COUNT":
+			names.append(line)
+	return names
+
+
+def read_dump(lines):
+	"""Returns the clock frequency and the records (timestamp, event, context, argument) of the last dump."""
+	dump = None
+	clock = None
+	records = None
+
+	for line in lines:
+		begin = re.search(r"TRACE BEGIN (\d+) (\d+) (\d+)", line)
+		if begin:
+			clock = int(begin.group(1))
+			dump = []
+			continue
+
+		if dump is None:
+			continue
+
+		if "TRACE END" in line:
+			records = dump
+			dump = None
+			continue
+
+		record = re.search(r"\bT ([0-9A-Fa-f]+) (\d+) (\d+) (\d+)", line)
+		if record:
+			dump.append((int(record.group(1), 16), int(record.group(2)), int(record.group(3)), int(record.group(4))))
+
+	if records is None:
+		sys.exit("no complete TRACE BEGIN / TRACE END dump found")
+	return clock, records
+
+
+def unwrap(records):
+	"""Extends the 32-bit cycle counter to 64 bits.
+
+	The records are in the order their slots were claimed, so a timestamp can be a few
+	cycles older than the one before it. The signed difference handles both that and
+	the wrap of the counter, as long as consecutive records are less than 2^31 cycles apart.
+	"""
+	cycles = 0
+	previous = None
+	unwrapped = []
+
+	for timestamp, event, context, argument in records:
+		if previous is not None:
+			delta = (timestamp - previous) & 0xFFFFFFFF
+			if delta >= 0x80000000:
+				delta -= 0x100000000
+			cycles += delta
+		previous = timestamp
+		unwrapped.append((cycles, event, context, argument))
+
+	unwrapped.sort(key=lambda record: record[0])
+	return unwrapped
+
+
+def context_name(context):
+	if context in EXCEPTION_NAMES:
+		return EXCEPTION_NAMES[context]
+	if context >= 16:
+		return "IRQ %d" % (context - 16)
+	return "Exception %d" % context
+
+
+def convert(clock, records, names):
+	cycles_per_us = clock / 1e6
+	events = []
+	open_scopes = {}
+	contexts = set()
+	previous_step = None
+	step_intervals = []
+
+	for cycles, event, context, argument in unwrap(records):
+		name = names[event] if event < len(names) else "EVENT_%d" % event
+		timestamp = cycles / cycles_per_us
+		contexts.add(context)
+		entry = {"ts": round(timestamp, 3), "pid": 1, "tid": context}
+
+		if name.endswith("_BEGIN"):
+			scope = name[len("TRACE_"):-len("_BEGIN")].lower()
+			open_scopes.setdefault(context, []).append(scope)
+			entry.update(name=scope, ph="B", args={"argument": argument})
+		elif name.endswith("_END"):
+			scope = name[len("TRACE_"):-len("_END")].lower()
+			stack = open_scopes.get(context, [])
+			# The matching begin may have been overwritten in the ring buffer
+			if scope not in stack:
+				continue
+			while stack and stack.pop() != scope:
+				pass
+			entry.update(name=scope, ph="E", args={"argument": argument})
+		else:
+			entry.update(name=name[len("TRACE_"):].lower(), ph="i", s="t", args={"argument": argument})
+
+		events.append(entry)
+
+		if name == "TRACE_STEP":
+			if previous_step is not None:
+				interval = timestamp - previous_step
+				step_intervals.append(interval)
+				events.append({"name": "step interval (us)", "ph": "C", "ts": entry["ts"], "pid": 1,
+					"args": {"interval": round(interval, 3)}})
+			previous_step = timestamp
+
+	for context in sorted(contexts):
+		events.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": context,
+			"args": {"name": context_name(context)}})
+		events.append({"name": "thread_sort_index", "ph": "M", "pid": 1, "tid": context,
+			"args": {"sort_index": context}})
+	events.append({"name": "process_name", "ph": "M", "pid": 1, "args": {"name": "TM4C123 music box"}})
+
+	return events, step_intervals
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Convert a TRACE dump into Chrome trace JSON")
+	parser.add_argument("capture", help="serial or simulator log holding a TRACE dump, - for stdin")
+	parser.add_argument("-o", "--output", default="-", help="JSON file to write (default: stdout)")
+	parser.add_argument("--header", default=TRACE_HEADER, help="Trace.h with the event IDs")
+	args = parser.parse_args()
+
+	names = read_event_names(args.header)
+	if args.capture == "-":
+		clock, records = read_dump(sys.stdin)
+	else:
+		with open(args.capture, errors="replace") as file:
+			clock, records = read_dump(file)
+
+	events, step_intervals = convert(clock, records, names)
+	trace = {"traceEvents": events, "displayTimeUnit": "ms"}
+
+	if args.output == "-":
+		json.dump(trace, sys.stdout)
+		sys.stdout.write("\n")
+	else:
+		with open(args.output, "w") as file:
+			json.dump(trace, file)
+
+	summary = "%d records at %d Hz" % (len(records), clock)
+	if step_intervals:
+		summary += ", step interval %.3f / %.3f / %.3f us (min / mean / max)" % (min(step_intervals),
+			sum(step_intervals) / len(step_intervals), max(step_intervals))
+	print(summary, file=sys.stderr)
+
+
+if __name__ == "__main__":
+	main()